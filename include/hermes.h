@@ -1,17 +1,23 @@
 #ifndef HERMES_H
 #define HERMES_H
 
+#include "hermes/BinaryCache.h"
 #include "hermes/CacheTools.h"
 #include "hermes/Common.h"
 #include "hermes/FITSWrapper.h"
+#include "hermes/GSLWorkspace.h"
 #include "hermes/Grid.h"
 #include "hermes/GridTools.h"
 #include "hermes/HEALPixBits.h"
 #include "hermes/Hdf5Reader.h"
+#include "hermes/LookupGrid.h"
+#include "hermes/MemoryPlacement.h"
 #include "hermes/ParticleID.h"
 #include "hermes/ProgressBar.h"
 #include "hermes/Random.h"
 #include "hermes/Signals.h"
+#include "hermes/SpectralGrid.h"
+#include "hermes/ThreadPool.h"
 #include "hermes/Units.h"
 #include "hermes/Vector3.h"
 #include "hermes/Vector3Quantity.h"
@@ -29,14 +35,19 @@
 #include "hermes/darkmatter/NFWGProfile.h"
 #include "hermes/darkmatter/PPPC4DMIDSpectrum.h"
 #include "hermes/integrators/BremsstrahlungIntegrator.h"
+#include "hermes/integrators/CacheTableStore.h"
 #include "hermes/integrators/DarkMatterIntegrator.h"
 #include "hermes/integrators/DispersionMeasureIntegrator.h"
 #include "hermes/integrators/FreeFreeIntegrator.h"
 #include "hermes/integrators/IntegratorTemplate.h"
 #include "hermes/integrators/InverseComptonIntegrator.h"
 #include "hermes/integrators/LOSIntegrationMethods.h"
+#include "hermes/integrators/LOSSampleStore.h"
+#include "hermes/integrators/OpacityGrid.h"
+#include "hermes/integrators/OpacityTable.h"
 #include "hermes/integrators/PiZeroAbsorptionIntegrator.h"
 #include "hermes/integrators/PiZeroIntegrator.h"
+#include "hermes/integrators/RayTable.h"
 #include "hermes/integrators/RotationMeasureIntegrator.h"
 #include "hermes/integrators/SynchroAbsorptionIntegrator.h"
 #include "hermes/integrators/SynchroIntegrator.h"
@@ -52,10 +63,12 @@
 #include "hermes/interactions/KelnerAharonianGamma.h"
 #include "hermes/interactions/KelnerAharonianNeutrino.h"
 #include "hermes/interactions/KleinNishina.h"
+#include "hermes/ionizedgas/GriddedIonizedGasDensity.h"
 #include "hermes/ionizedgas/HII_Cordes91.h"
 #include "hermes/ionizedgas/IonizedGasDensity.h"
 #include "hermes/ionizedgas/NE2001Simple.h"
 #include "hermes/ionizedgas/YMW16.h"
+#include "hermes/magneticfields/GriddedMagneticField.h"
 #include "hermes/magneticfields/JF12.h"
 #include "hermes/magneticfields/MagneticField.h"
 #include "hermes/magneticfields/MagneticFieldGrid.h"
@@ -79,6 +92,7 @@
 #include "hermes/skymaps/RadioSkymapRange.h"
 #include "hermes/skymaps/RotationMeasureSkymap.h"
 #include "hermes/skymaps/Skymap.h"
+#include "hermes/skymaps/SkymapCheckpoint.h"
 #include "hermes/skymaps/SkymapMask.h"
 #include "hermes/skymaps/SkymapTemplate.h"
 
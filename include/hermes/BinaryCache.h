@@ -0,0 +1,112 @@
+#ifndef HERMES_BINARYCACHE_H
+#define HERMES_BINARYCACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ @file
+ @brief On-disk, memory-mapped cache of parsed input data (e.g., density
+ grids decoded from FITS files)
+ */
+
+namespace hermes {
+/**
+ * \addtogroup Core
+ * @{
+ */
+
+/**
+    Directory of the binary cache, taken from the environment variable
+    HERMES_CACHE_PATH; an empty string means the cache is disabled
+*/
+std::string getBinaryCachePath();
+
+/**
+    64-bit FNV-1a hash of the content of a file
+*/
+std::uint64_t fileContentHash(const std::string &filename);
+
+/**
+    64-bit FNV-1a hash of the path, size and modification time of a file;
+    a cheap key for large datasets which are replaced rather than edited
+    in place
+*/
+std::uint64_t fileManifestHash(const std::string &filename);
+
+/**
+    64-bit FNV-1a hash of a string (e.g., a model name for the keys of a
+    BinaryCache)
+*/
+std::uint64_t stringHash(const std::string &s);
+
+/**
+ \class BinaryCache
+ \brief A versioned native file holding a small metadata vector and a
+ payload in its final in-memory layout, keyed by a tag and the content
+ hash of the source file(s) it was parsed from.
+
+ A loaded entry is mapped read-only and shared, so the payload is used
+ in place (zero-copy) and its pages are shared by all processes on a node
+ that read the same entry. Entries are written to a temporary file and
+ renamed, which makes concurrent writers safe.
+
+ \code
+ BinaryCache cache("Dragon3D_1000010010", {fileContentHash(filename)});
+ if (cache.isEnabled() && cache.load()) {
+     // use cache.getMetadata() and cache.getPayload()
+ } else {
+     // parse the source, then cache.store(metadata, data, bytes)
+ }
+ \endcode
+ */
+class BinaryCache {
+  private:
+	std::string filename;
+	std::uint64_t key;
+
+	void *mapping;
+	std::size_t mappingSize;
+	std::vector<double> metadata;
+	const void *payload;
+	std::size_t payloadSize;
+
+	void unmap();
+
+  public:
+	/**
+	    \param tag         name of the cached object (file name friendly)
+	    \param sourceHashes content hashes of the source files
+	*/
+	BinaryCache(const std::string &tag, const std::vector<std::uint64_t> &sourceHashes);
+	~BinaryCache();
+
+	BinaryCache(const BinaryCache &) = delete;
+	BinaryCache &operator=(const BinaryCache &) = delete;
+
+	/** True if HERMES_CACHE_PATH is set */
+	bool isEnabled() const { return !filename.empty(); }
+	std::string getFilename() const { return filename; }
+
+	/**
+	    Maps an existing entry; returns false if there is none or it does
+	    not match (format version, key)
+	*/
+	bool load();
+	/**
+	    Writes a new entry; failures are reported but not fatal
+	*/
+	bool store(const std::vector<double> &metadata, const void *data, std::size_t bytes);
+
+	const std::vector<double> &getMetadata() const { return metadata; }
+	const void *getPayload() const { return payload; }
+	std::size_t getPayloadSize() const { return payloadSize; }
+};
+
+/** @}*/
+}  // namespace hermes
+
+#endif  // HERMES_BINARYCACHE_H
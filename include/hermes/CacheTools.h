@@ -1,17 +1,24 @@
 #ifndef HERMES_CACHETOOLS_H
 #define HERMES_CACHETOOLS_H
 
+#include <algorithm>
 #include <array>
 #include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <functional>
 #include <iostream>
+#include <limits>
 #include <map>
 #include <mutex>
+#include <shared_mutex>
 #include <tuple>
 #include <unordered_map>
 #include <vector>
 
 #include "hermes/Common.h"
+#include "hermes/ThreadPool.h"
 #include "hermes/Units.h"
 
 namespace hermes {
@@ -102,10 +109,34 @@ struct tuple_equal {
 	}
 };
 
+/**
+ \class CacheStorage2Args
+ \brief Common interface of the caches of two-argument functions
+ */
 template <typename Q1, typename Q2, typename V>
-class CacheStorageWith2Args {
+class CacheStorage2Args {
+  public:
+	virtual ~CacheStorage2Args() {}
+	virtual void setFunction(std::function<V(Q1, Q2)> f_) = 0;
+	virtual V getValue(Q1 q1, Q2 q2) = 0;
+};
+
+/**
+ \class CacheStorage3Args
+ \brief Common interface of the caches of three-argument functions
+ */
+template <typename Q1, typename Q2, typename Q3, typename V>
+class CacheStorage3Args {
+  public:
+	virtual ~CacheStorage3Args() {}
+	virtual void setFunction(std::function<V(Q1, Q2, Q3)> f_) = 0;
+	virtual V getValue(Q1 q1, Q2 q2, Q3 q3) = 0;
+};
+
+template <typename Q1, typename Q2, typename V>
+class CacheStorageWith2Args : public CacheStorage2Args<Q1, Q2, V> {
   private:
-	using MutexType = std::mutex;
+	using MutexType = std::shared_mutex;
 	typedef std::pair<double, double> tPairKey;
 	std::unordered_map<tPairKey, V, pair_hash, pair_equal> cachedValues;
 	// std::array<std::map<tPairKey, V>, 8> cachedValues;
@@ -116,35 +147,45 @@ class CacheStorageWith2Args {
 	CacheStorageWith2Args() {};
 	~CacheStorageWith2Args() { cachedValues.clear(); };
 	CacheStorageWith2Args(CacheStorageWith2Args &&other) {  // Move declaration
-		std::unique_lock<MutexType>(other.mtx);
+		std::unique_lock<MutexType> lock(other.mtx);
+		cachedValues = std::move(other.cachedValues);
+		f = std::move(other.f);
 	}
 	CacheStorageWith2Args &operator=(CacheStorageWith2Args &&other) = delete;       // Move assignment
 	CacheStorageWith2Args(const CacheStorageWith2Args &other) = delete;             // Copy declaration
 	CacheStorageWith2Args &operator=(const CacheStorageWith2Args &other) = delete;  // Copy Assignment
 
-	void setFunction(std::function<V(Q1, Q2)> f_) { f = f_; }
+	void setFunction(std::function<V(Q1, Q2)> f_) override { f = f_; }
 
-	void cacheValue(const tPairKey &key, V value) { cachedValues[key] = value; }
+	void cacheValue(const tPairKey &key, V value) {
+		std::unique_lock<MutexType> lock(mtx);
+		cachedValues.emplace(key, value);
+	}
 
-	V getValue(Q1 q1, Q2 q2) {
-		V result(0);
+	V getValue(Q1 q1, Q2 q2) override {
 		auto key = std::make_pair(static_cast<double>(q1), static_cast<double>(q2));
-		auto it = cachedValues.find(key);
-		if (it == cachedValues.end()) {
-			result = f(q1, q2);
-			std::lock_guard<std::mutex> guard(mtx);
-			cacheValue(key, result);
+		{
+			std::shared_lock<MutexType> lock(mtx);
+			auto it = cachedValues.find(key);
+			if (it != cachedValues.end()) return it->second;
 		}
-		return cachedValues[key];
+		// evaluated outside of the lock, concurrent misses of the same key
+		// compute the same value and only the first one is stored
+		V result = f(q1, q2);
+		cacheValue(key, result);
+		return result;
 	}
 
-	V operator[](const std::pair<double, double> &key) const { return cachedValues[key]; }
+	V operator[](const std::pair<double, double> &key) const {
+		std::shared_lock<MutexType> lock(mtx);
+		return cachedValues.at(key);
+	}
 };
 
 template <typename Q1, typename Q2, typename Q3, typename V>
-class CacheStorageWith3Args {
+class CacheStorageWith3Args : public CacheStorage3Args<Q1, Q2, Q3, V> {
   private:
-	using MutexType = std::mutex;
+	using MutexType = std::shared_mutex;
 	// typedef std::tuple<double, double, double> tTupleKey;
 	typedef std::array<double, 3> tTupleKey;
 	// map is much slower than unordered_map (!)
@@ -158,30 +199,200 @@ class CacheStorageWith3Args {
 	CacheStorageWith3Args() {};
 	~CacheStorageWith3Args() { cachedValues.clear(); };
 	CacheStorageWith3Args(CacheStorageWith3Args &&other) {  // Move declaration
-		std::unique_lock<MutexType>(other.mtx);
+		std::unique_lock<MutexType> lock(other.mtx);
+		cachedValues = std::move(other.cachedValues);
+		f = std::move(other.f);
 	}
 	CacheStorageWith3Args &operator=(CacheStorageWith3Args &&other) = delete;       // Move assignment
 	CacheStorageWith3Args(const CacheStorageWith3Args &other) = delete;             // Copy declaration
 	CacheStorageWith3Args &operator=(const CacheStorageWith3Args &other) = delete;  // Copy Assignment
 
-	void setFunction(std::function<V(Q1, Q2, Q3)> f_) { f = f_; }
+	void setFunction(std::function<V(Q1, Q2, Q3)> f_) override { f = f_; }
 
-	void cacheValue(const tTupleKey &key, V value) { cachedValues[key] = value; }
+	void cacheValue(const tTupleKey &key, V value) {
+		std::unique_lock<MutexType> lock(mtx);
+		cachedValues.emplace(key, value);
+	}
 
-	V getValue(Q1 q1, Q2 q2, Q3 q3) {
-		V result(0);
-		/*auto key = std::make_tuple(
-		        static_cast<double>(q1),
-		        static_cast<double>(q2),
-		        static_cast<double>(q3));*/
+	V getValue(Q1 q1, Q2 q2, Q3 q3) override {
 		tTupleKey key = {{static_cast<double>(q1), static_cast<double>(q2), static_cast<double>(q3)}};
-		auto it = cachedValues.find(key);
-		if (it == cachedValues.end()) {
-			result = f(q1, q2, q3);
-			cacheValue(key, result);
+		{
+			std::shared_lock<MutexType> lock(mtx);
+			auto it = cachedValues.find(key);
+			if (it != cachedValues.end()) return it->second;
 		}
-		return cachedValues[key];
+		V result = f(q1, q2, q3);
+		cacheValue(key, result);
+		return result;
+	}
+};
+
+/**
+ \class CacheTableAxis
+ \brief A sorted grid of keys with an index lookup; used by the
+ precomputed cache tables
+
+ Keys that are bit-identical to a node (the usual case, since callers
+ iterate over the same energy axes the table was built from) are found
+ through a small open-addressing hash of the bit pattern; other keys
+ fall back to a binary search with a relative tolerance.
+ */
+class CacheTableAxis {
+  private:
+	std::vector<double> nodes;
+	std::vector<std::uint64_t> slotKeys;
+	std::vector<std::size_t> slotIndices;
+	std::uint64_t slotMask = 0;
+
+	static std::uint64_t bits(double x) {
+		std::uint64_t b;
+		std::memcpy(&b, &x, sizeof(b));
+		return b;
+	}
+	static std::uint64_t slot(std::uint64_t b) { return (b * 0x9e3779b97f4a7c15ULL) >> 32; }
+
+	void buildSlots() {
+		std::size_t nSlots = 4;
+		while (nSlots < 4 * nodes.size()) nSlots *= 2;
+		slotMask = nSlots - 1;
+		slotKeys.assign(nSlots, bits(std::numeric_limits<double>::quiet_NaN()));
+		slotIndices.assign(nSlots, 0);
+		for (std::size_t i = 0; i < nodes.size(); ++i) {
+			std::uint64_t b = bits(nodes[i]);
+			std::uint64_t s = slot(b) & slotMask;
+			while (slotKeys[s] != bits(std::numeric_limits<double>::quiet_NaN())) s = (s + 1) & slotMask;
+			slotKeys[s] = b;
+			slotIndices[s] = i;
+		}
+	}
+
+  public:
+	CacheTableAxis() {}
+	template <typename Q>
+	explicit CacheTableAxis(const std::vector<Q> &axis) {
+		nodes.reserve(axis.size());
+		for (const auto &q : axis) nodes.push_back(static_cast<double>(q));
+		std::sort(nodes.begin(), nodes.end());
+		nodes.erase(std::unique(nodes.begin(), nodes.end()), nodes.end());
+		buildSlots();
 	}
+
+	std::size_t size() const { return nodes.size(); }
+	double operator[](std::size_t i) const { return nodes[i]; }
+
+	/**
+	    Sets \p idx to the index of the node equal to x and returns true,
+	    returns false if x is not on the grid
+	*/
+	bool find(double x, std::size_t &idx) const {
+		const std::uint64_t empty = bits(std::numeric_limits<double>::quiet_NaN());
+		std::uint64_t b = bits(x);
+		for (std::uint64_t s = slot(b) & slotMask; slotKeys[s] != empty; s = (s + 1) & slotMask) {
+			if (slotKeys[s] == b) {
+				idx = slotIndices[s];
+				return true;
+			}
+		}
+
+		constexpr double relTolerance = 1e-12;
+		auto it = std::lower_bound(nodes.begin(), nodes.end(), x);
+		if (it != nodes.end() && std::fabs(*it - x) <= relTolerance * std::fabs(x)) {
+			idx = it - nodes.begin();
+			return true;
+		}
+		if (it != nodes.begin() && std::fabs(*(it - 1) - x) <= relTolerance * std::fabs(x)) {
+			idx = it - nodes.begin() - 1;
+			return true;
+		}
+		return false;
+	}
+};
+
+/**
+ \class CacheStorageTableWith2Args
+ \brief Dense table of f(q1, q2) precomputed on the product of two grids
+
+ The table is filled in parallel by setFunction() and never modified
+ afterwards, so getValue() on grid points is an index lookup of the key's
+ bit pattern per axis (see CacheTableAxis) and a read from contiguous
+ memory without any locking. Keys outside the grids are evaluated
+ directly or, if lazy filling is enabled, memoised in a
+ CacheStorageWith2Args owned by the table.
+ */
+template <typename Q1, typename Q2, typename V>
+class CacheStorageTableWith2Args : public CacheStorage2Args<Q1, Q2, V> {
+  private:
+	CacheTableAxis axis1, axis2;
+	std::vector<V> table;
+	std::function<V(Q1, Q2)> f;
+	bool lazyFill;
+	CacheStorageWith2Args<Q1, Q2, V> offGrid;
+
+  public:
+	CacheStorageTableWith2Args(const std::vector<Q1> &axis1_, const std::vector<Q2> &axis2_, bool lazyFill_ = true)
+	    : axis1(axis1_), axis2(axis2_), lazyFill(lazyFill_) {}
+
+	void setFunction(std::function<V(Q1, Q2)> f_) override {
+		f = f_;
+		offGrid.setFunction(f_);
+		table.assign(axis1.size() * axis2.size(), V(0));
+		auto pool = getThreadPool();
+		pool->parallelFor(table.size(), [this](std::size_t n) {
+			std::size_t i = n / axis2.size(), j = n % axis2.size();
+			table[n] = f(Q1(axis1[i]), Q2(axis2[j]));
+		});
+	}
+
+	V getValue(Q1 q1, Q2 q2) override {
+		std::size_t i, j;
+		if (axis1.find(static_cast<double>(q1), i) && axis2.find(static_cast<double>(q2), j))
+			return table[i * axis2.size() + j];
+		return lazyFill ? offGrid.getValue(q1, q2) : f(q1, q2);
+	}
+
+	std::size_t size() const { return table.size(); }
+};
+
+/**
+ \class CacheStorageTableWith3Args
+ \brief Dense table of f(q1, q2, q3) precomputed on the product of three
+ grids; see CacheStorageTableWith2Args
+ */
+template <typename Q1, typename Q2, typename Q3, typename V>
+class CacheStorageTableWith3Args : public CacheStorage3Args<Q1, Q2, Q3, V> {
+  private:
+	CacheTableAxis axis1, axis2, axis3;
+	std::vector<V> table;
+	std::function<V(Q1, Q2, Q3)> f;
+	bool lazyFill;
+	CacheStorageWith3Args<Q1, Q2, Q3, V> offGrid;
+
+  public:
+	CacheStorageTableWith3Args(const std::vector<Q1> &axis1_, const std::vector<Q2> &axis2_,
+	                           const std::vector<Q3> &axis3_, bool lazyFill_ = true)
+	    : axis1(axis1_), axis2(axis2_), axis3(axis3_), lazyFill(lazyFill_) {}
+
+	void setFunction(std::function<V(Q1, Q2, Q3)> f_) override {
+		f = f_;
+		offGrid.setFunction(f_);
+		table.assign(axis1.size() * axis2.size() * axis3.size(), V(0));
+		auto pool = getThreadPool();
+		pool->parallelFor(table.size(), [this](std::size_t n) {
+			std::size_t k = n % axis3.size(), j = (n / axis3.size()) % axis2.size(),
+			            i = n / (axis2.size() * axis3.size());
+			table[n] = f(Q1(axis1[i]), Q2(axis2[j]), Q3(axis3[k]));
+		});
+	}
+
+	V getValue(Q1 q1, Q2 q2, Q3 q3) override {
+		std::size_t i, j, k;
+		if (axis1.find(static_cast<double>(q1), i) && axis2.find(static_cast<double>(q2), j) &&
+		    axis3.find(static_cast<double>(q3), k))
+			return table[(i * axis2.size() + j) * axis3.size() + k];
+		return lazyFill ? offGrid.getValue(q1, q2, q3) : f(q1, q2, q3);
+	}
+
+	std::size_t size() const { return table.size(); }
 };
 
 class CacheStorageIC2 {
@@ -210,6 +421,9 @@ class CacheStorageIC2 {
 typedef CacheStorageWith3Args<int, int, QEnergy, QGREmissivity> CacheStorageIC;
 typedef CacheStorageWith2Args<QEnergy, QEnergy, QDiffCrossSection> CacheStorageCrossSection;
 typedef CacheStorageWith3Args<QEnergy, QEnergy, QEnergy, QDiffCrossSection> CacheStorageCrossSection3Args;
+typedef CacheStorage2Args<QEnergy, QEnergy, QDiffCrossSection> CacheStorageCrossSectionBase;
+typedef CacheStorageTableWith2Args<QEnergy, QEnergy, QDiffCrossSection> CacheStorageCrossSectionTable;
+typedef CacheStorageTableWith3Args<QEnergy, QEnergy, QEnergy, QDiffCrossSection> CacheStorageCrossSectionTable3Args;
 
 }  // namespace hermes
 
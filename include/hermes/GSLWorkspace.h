@@ -0,0 +1,61 @@
+#ifndef HERMES_GSLWORKSPACE_H
+#define HERMES_GSLWORKSPACE_H
+
+#include <gsl/gsl_integration.h>
+
+#include <cstddef>
+
+/**
+ @file
+ @brief Per-thread pool of GSL integration workspaces
+ */
+
+namespace hermes {
+/**
+ * \addtogroup Core
+ * @{
+ */
+
+/**
+ \class GSLWorkspace
+ \brief Handle of a gsl_integration_workspace borrowed from a pool owned
+ by the calling thread
+
+ The QAG/QAGS routines of GSL need a workspace of at least \p limit
+ intervals; allocating one for every integral costs more than the
+ integral itself for short lines of sight. A handle takes a free workspace
+ of the requested limit from the thread-local pool (allocating one only
+ if there is none) and returns it on destruction; the pool is released
+ when the thread exits. Nested integrations on the same thread get
+ distinct workspaces, so a handle is safe to use within an integrand.
+
+ \code
+ GSLWorkspace w(GSL_LIMIT);
+ gsl_integration_qag(&F, a, b, 0, 1e-3, GSL_LIMIT, key, w.get(), &result, &error);
+ \endcode
+ */
+class GSLWorkspace {
+  private:
+	gsl_integration_workspace *workspace;
+	std::size_t limit;
+
+  public:
+	explicit GSLWorkspace(std::size_t limit);
+	~GSLWorkspace();
+
+	GSLWorkspace(const GSLWorkspace &) = delete;
+	GSLWorkspace &operator=(const GSLWorkspace &) = delete;
+
+	gsl_integration_workspace *get() const { return workspace; }
+	std::size_t getLimit() const { return limit; }
+
+	/** Number of idle workspaces of the calling thread (of all limits) */
+	static std::size_t getPoolSize();
+	/** Number of workspaces the calling thread has allocated so far */
+	static std::size_t getNumberOfAllocations();
+};
+
+/** @}*/
+}  // namespace hermes
+
+#endif  // HERMES_GSLWORKSPACE_H
@@ -10,6 +10,7 @@
 #include <memory>
 #include <vector>
 
+#include "hermes/MemoryPlacement.h"
 #include "hermes/Vector3.h"
 #include "hermes/Vector3Quantity.h"
 
@@ -108,7 +109,7 @@ class Grid2D {
 	void setGridSize(size_t Nx, size_t Ny) {
 		this->Nx = Nx;
 		this->Ny = Ny;
-		grid.resize(Nx * Ny);
+		resizePlaced(grid, Nx * Ny);
 		setOrigin(origin);
 	}
 
@@ -292,7 +293,7 @@ class Grid {
 		this->Nx = Nx;
 		this->Ny = Ny;
 		this->Nz = Nz;
-		grid.resize(Nx * Ny * Nz);
+		resizePlaced(grid, Nx * Ny * Nz);
 		setOrigin(origin);
 	}
 
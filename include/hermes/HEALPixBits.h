@@ -20,6 +20,17 @@ QDirection pix2ang_ring(unsigned int nside, unsigned int ipix);
 unsigned int ang2pix_ring(unsigned int nside, const QDirection &thetaphi);
 unsigned int loc2pix(unsigned int nside, double z, double phi, double sth,
                      bool have_sth);
+// The ring iring (1 ... 4 * nside - 1, counted from the north pole) holds
+// the RING pixels startpix ... startpix + ringpix - 1, equally spaced in phi
+void ring_info(unsigned int nside, unsigned int iring, unsigned int &startpix,
+               unsigned int &ringpix);
+
+// Conversion between the RING and NESTED schemes, adopted from HEALPix
+// (nest2xyf, xyf2ring, ring2xyf, xyf2nest); nside has to be a power of 2.
+// In the NESTED scheme the children of pixel p at 2*nside are 4p ... 4p+3.
+unsigned int nest2ring(unsigned int nside, unsigned int ipix);
+unsigned int ring2nest(unsigned int nside, unsigned int ipix);
+QDirection pix2ang_nest(unsigned int nside, unsigned int ipix);
 
 }  // namespace hermes
 
@@ -0,0 +1,281 @@
+#ifndef HERMES_LOOKUPGRID_H
+#define HERMES_LOOKUPGRID_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "hermes/BinaryCache.h"
+#include "hermes/MemoryPlacement.h"
+#include "hermes/ThreadPool.h"
+#include "hermes/Units.h"
+#include "hermes/Vector3.h"
+
+/**
+ @file
+ @brief Rectilinear grid of precomputed model values with trilinear
+ interpolation, used by the gridded model decorators
+ */
+
+namespace hermes {
+/**
+ * \addtogroup Core
+ * @{
+ */
+
+/**
+    n equidistant nodes from \p min to \p max (both included)
+*/
+inline std::vector<QLength> uniformAxis(QLength min, QLength max,
+                                        std::size_t n) {
+	if (n < 2 || !(max > min))
+		throw std::runtime_error(
+		    "hermes::uniformAxis: requires n >= 2 and max > min");
+	std::vector<QLength> axis(n);
+	for (std::size_t i = 0; i < n; ++i)
+		axis[i] = min + (max - min) * (static_cast<double>(i) / (n - 1));
+	return axis;
+}
+
+/**
+    n nodes from -halfWidth to halfWidth, symmetric around 0, which are
+    spaced by about \p scale * dx near 0 and become sparser away from it
+    (z_i = scale * sinh(u_i) with equidistant u_i); suited to the z axis of
+    thin galactic disks
+*/
+inline std::vector<QLength> sinhAxis(QLength halfWidth, std::size_t n,
+                                     QLength scale) {
+	if (n < 2 || !(halfWidth > 0_m) || !(scale > 0_m))
+		throw std::runtime_error(
+		    "hermes::sinhAxis: requires n >= 2 and positive lengths");
+	const double umax = std::asinh(static_cast<double>(halfWidth / scale));
+	std::vector<QLength> axis(n);
+	for (std::size_t i = 0; i < n; ++i)
+		axis[i] =
+		    scale * std::sinh(umax * (2. * static_cast<double>(i) / (n - 1) - 1.));
+	axis.front() = -halfWidth;
+	axis.back() = halfWidth;
+	return axis;
+}
+
+inline double lookupGridNorm(double v) { return std::fabs(v); }
+inline double lookupGridNorm(const Vector3d &v) { return v.getR(); }
+
+/**
+ \struct LookupGridAccuracy
+ \brief Deviation of a gridded model from the model it samples, measured
+ at random positions inside the grid
+ */
+struct LookupGridAccuracy {
+	std::size_t nSamples = 0;
+	/** largest absolute deviation (in SI units) */
+	double maxError = 0;
+	/** root mean square of the deviation */
+	double rmsError = 0;
+	/** root mean square of the model values */
+	double rmsValue = 0;
+
+	/** rmsError / rmsValue */
+	double getRelativeError() const {
+		return (rmsValue > 0) ? rmsError / rmsValue : 0;
+	}
+};
+
+inline std::ostream &operator<<(std::ostream &out,
+                                const LookupGridAccuracy &a) {
+	out << "samples: " << a.nSamples << ", max error: " << a.maxError
+	    << ", rms error: " << a.rmsError << ", rms value: " << a.rmsValue
+	    << ", relative rms error: " << a.getRelativeError();
+	return out;
+}
+
+/**
+ @class LookupGrid
+ @brief Values of a model at the nodes of a rectilinear grid, interpolated
+ trilinearly
+
+ Unlike Grid, the nodes lie on the boundaries of the volume and every axis
+ may be non-uniform (e.g., sinhAxis() for z); lookups on uniform axes need
+ no search. The values are stored with z innermost, so a column of nodes
+ along z is filled by one batch call of the model.
+ */
+template <typename T>
+class LookupGrid {
+	std::array<std::vector<double>, 3> axes; /**< Node positions in m */
+	std::array<bool, 3> uniform;             /**< Equidistant axes */
+	std::vector<T> values;
+
+	/** Index of the lower node and fraction towards the upper one */
+	void locate(std::size_t d, double v, std::size_t &i, double &f) const {
+		const std::vector<double> &a = axes[d];
+		const std::size_t n = a.size();
+		if (uniform[d]) {
+			double r = (v - a.front()) / (a[1] - a[0]);
+			i = static_cast<std::size_t>(
+			    std::min(std::max(std::floor(r), 0.), double(n - 2)));
+		} else {
+			i = std::upper_bound(a.begin() + 1, a.end() - 1, v) - a.begin() - 1;
+		}
+		f = (v - a[i]) / (a[i + 1] - a[i]);
+	}
+
+	std::size_t offset(std::size_t ix, std::size_t iy, std::size_t iz) const {
+		return (ix * axes[1].size() + iy) * axes[2].size() + iz;
+	}
+
+  public:
+	LookupGrid(const std::vector<QLength> &x, const std::vector<QLength> &y,
+	           const std::vector<QLength> &z) {
+		const std::vector<QLength> *in[3] = {&x, &y, &z};
+		for (std::size_t d = 0; d < 3; ++d) {
+			if (in[d]->size() < 2)
+				throw std::runtime_error(
+				    "hermes::LookupGrid: every axis needs at least 2 nodes");
+			for (const auto &v : *in[d])
+				axes[d].push_back(static_cast<double>(v));
+			const std::vector<double> &a = axes[d];
+			const double h = (a.back() - a.front()) / (a.size() - 1);
+			uniform[d] = true;
+			for (std::size_t i = 1; i < a.size(); ++i) {
+				if (!(a[i] > a[i - 1]))
+					throw std::runtime_error(
+					    "hermes::LookupGrid: axis nodes must be increasing");
+				if (std::fabs(a[i] - a[0] - h * i) > 1e-9 * std::fabs(h))
+					uniform[d] = false;
+			}
+		}
+		resizePlaced(values, axes[0].size() * axes[1].size() * axes[2].size());
+	}
+
+	const std::vector<double> &getAxis(std::size_t d) const {
+		return axes.at(d);
+	}
+	bool isUniform(std::size_t d) const { return uniform.at(d); }
+	std::size_t getGridSize() const { return values.size(); }
+	std::size_t getMemoryUsage() const { return values.size() * sizeof(T); }
+	std::vector<T> &getGrid() { return values; }
+	const std::vector<T> &getGrid() const { return values; }
+
+	const T &get(std::size_t ix, std::size_t iy, std::size_t iz) const {
+		return values[offset(ix, iy, iz)];
+	}
+
+	bool contains(const Vector3d &pos) const {
+		return pos.x >= axes[0].front() && pos.x <= axes[0].back() &&
+		       pos.y >= axes[1].front() && pos.y <= axes[1].back() &&
+		       pos.z >= axes[2].front() && pos.z <= axes[2].back();
+	}
+
+	/**
+	    Fill the grid in parallel, one z-column per task
+	    \param f callable f(const Vector3d *pos, T *out, std::size_t n)
+	             evaluating the model at the n nodes of a column
+	*/
+	template <typename F>
+	void fill(F f) {
+		const std::size_t ny = axes[1].size(), nz = axes[2].size();
+		getThreadPool()->parallelFor(axes[0].size() * ny, [&](std::size_t c) {
+			std::vector<Vector3d> pos(nz);
+			for (std::size_t iz = 0; iz < nz; ++iz)
+				pos[iz] = Vector3d(axes[0][c / ny], axes[1][c % ny], axes[2][iz]);
+			f(pos.data(), values.data() + c * nz, nz);
+		});
+	}
+
+	/** Key of the binary cache entry: the bit patterns of the axes */
+	std::vector<std::uint64_t> getCacheKeys() const {
+		std::vector<std::uint64_t> keys;
+		for (const auto &a : axes)
+			for (double v : a) {
+				std::uint64_t bits;
+				std::memcpy(&bits, &v, sizeof(double));
+				keys.push_back(bits);
+			}
+		return keys;
+	}
+
+	/**
+	    Like fill(), but first tries to load the values from the binary
+	    cache (see BinaryCache) and stores them there after filling
+	    \param tag name of the entry; it must identify the model and its
+	               parameters, the axes are part of the key
+	*/
+	template <typename F>
+	void fillCached(const std::string &tag, F f) {
+		BinaryCache cache(tag, getCacheKeys());
+		if (cache.isEnabled() && cache.load() &&
+		    cache.getPayloadSize() == values.size() * sizeof(T)) {
+			std::memcpy(static_cast<void *>(values.data()), cache.getPayload(),
+			            cache.getPayloadSize());
+			return;
+		}
+		fill(f);
+		if (cache.isEnabled())
+			cache.store({}, values.data(), values.size() * sizeof(T));
+	}
+
+	/** Trilinear interpolation; \p pos has to be inside the grid */
+	T interpolate(const Vector3d &pos) const {
+		std::size_t ix, iy, iz;
+		double fx, fy, fz;
+		locate(0, pos.x, ix, fx);
+		locate(1, pos.y, iy, fy);
+		locate(2, pos.z, iz, fz);
+		const double fX = 1 - fx, fY = 1 - fy, fZ = 1 - fz;
+
+		const std::size_t nz = axes[2].size(), nyz = axes[1].size() * nz;
+		const T *v = values.data() + offset(ix, iy, iz);
+		T b = v[0] * (fX * fY * fZ);
+		b += v[1] * (fX * fY * fz);
+		b += v[nz] * (fX * fy * fZ);
+		b += v[nz + 1] * (fX * fy * fz);
+		b += v[nyz] * (fx * fY * fZ);
+		b += v[nyz + 1] * (fx * fY * fz);
+		b += v[nyz + nz] * (fx * fy * fZ);
+		b += v[nyz + nz + 1] * (fx * fy * fz);
+		return b;
+	}
+
+	/**
+	    Compare interpolate() with \p exact (a callable returning T for a
+	    Vector3d) at \p nSamples random positions inside the grid
+	*/
+	template <typename F>
+	LookupGridAccuracy measureAccuracy(F exact, std::size_t nSamples,
+	                                   unsigned seed = 0) const {
+		std::mt19937_64 rng(seed);
+		std::uniform_real_distribution<double> u(0., 1.);
+		LookupGridAccuracy a;
+		a.nSamples = nSamples;
+		double sumError2 = 0, sumValue2 = 0;
+		for (std::size_t i = 0; i < nSamples; ++i) {
+			Vector3d pos;
+			pos.x = axes[0].front() + u(rng) * (axes[0].back() - axes[0].front());
+			pos.y = axes[1].front() + u(rng) * (axes[1].back() - axes[1].front());
+			pos.z = axes[2].front() + u(rng) * (axes[2].back() - axes[2].front());
+			const T value = exact(pos);
+			const double error = lookupGridNorm(interpolate(pos) - value);
+			const double norm = lookupGridNorm(value);
+			a.maxError = std::max(a.maxError, error);
+			sumError2 += error * error;
+			sumValue2 += norm * norm;
+		}
+		if (nSamples > 0) {
+			a.rmsError = std::sqrt(sumError2 / nSamples);
+			a.rmsValue = std::sqrt(sumValue2 / nSamples);
+		}
+		return a;
+	}
+};
+
+/** @}*/
+}  // namespace hermes
+
+#endif  // HERMES_LOOKUPGRID_H
@@ -0,0 +1,74 @@
+#ifndef HERMES_MEMORYPLACEMENT_H
+#define HERMES_MEMORYPLACEMENT_H
+
+#include <cstddef>
+#include <vector>
+
+/**
+ @file
+ @brief Optional placement of worker threads and large grids on
+ multi-socket (NUMA) machines
+ */
+
+namespace hermes {
+/**
+ * \addtogroup Core
+ * @{
+ */
+
+/**
+    Pin every worker of the thread pool to one CPU of the process' CPU set
+    (worker i on the i-th allowed CPU); taken from the environment variable
+    HERMES_PIN_THREADS (default off) unless set with setThreadPinning().
+    Changing it recreates the pool of getThreadPool().
+*/
+bool getThreadPinning();
+void setThreadPinning(bool enable);
+
+/**
+    Back large grids (see placeLargeAllocation()) with transparent huge
+    pages; HERMES_HUGE_PAGES (default off) unless set with setHugePages()
+*/
+bool getHugePages();
+void setHugePages(bool enable);
+
+/**
+    Interleave the pages of large grids over all NUMA nodes, so that the
+    lookups of all threads share the memory bandwidth of every socket
+    instead of crossing to the node of the thread which allocated them;
+    HERMES_NUMA_INTERLEAVE (default off) unless set with setNumaInterleave()
+*/
+bool getNumaInterleave();
+void setNumaInterleave(bool enable);
+
+/**
+    Pin the calling thread to the \p index-th CPU (modulo their number) of
+    the CPUs it is allowed to run on; returns false if not supported
+*/
+bool pinCurrentThread(std::size_t index);
+
+/**
+    Apply the enabled policies (huge pages, NUMA interleaving) to
+    [data, data + bytes); must be called before the memory is first
+    touched. Allocations smaller than a huge page are left alone.
+*/
+void placeLargeAllocation(void *data, std::size_t bytes);
+
+/**
+    Resize \p v to \p n elements like std::vector::resize(); the buffer of
+    an empty vector is placed with placeLargeAllocation() before it is
+    touched
+*/
+template <typename T>
+void resizePlaced(std::vector<T> &v, std::size_t n) {
+	if (v.empty() && v.capacity() < n) {
+		v.reserve(n);
+		placeLargeAllocation(static_cast<void *>(v.data()), n * sizeof(T));
+	}
+	v.resize(n);
+}
+
+/** @}*/
+}  // namespace hermes
+
+#endif  // HERMES_MEMORYPLACEMENT_H
@@ -6,10 +6,16 @@
 #ifndef HERMES_PROGRESSBAR_H
 #define HERMES_PROGRESSBAR_H
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <ctime>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 
 namespace hermes {
 
@@ -17,38 +23,116 @@ namespace hermes {
  * \addtogroup Core
  * @{
  */
+
+/**
+    File to which every ProgressBar writes a snapshot of its progress
+    (done, rate, ETA and per-thread rates), refreshed by the reporter;
+    JSON if the name ends in ".json", otherwise "key value" lines. Taken
+    from the environment variable HERMES_PROGRESS_FILE unless set with
+    setProgressMetricsFile(); empty disables the snapshots.
+*/
+std::string getProgressMetricsFile();
+void setProgressMetricsFile(const std::string &filename);
+
+/**
+ \class ProgressBar
+ \brief Progress of a parallel loop, shown in the terminal and
+ optionally written to a metrics file
+
+ update() only increments an atomic counter of the calling thread (one
+ cache line per worker of the ThreadPool); a reporter thread started by
+ start() sums the counters every report interval, draws the bar and
+ writes the metrics file. stop() (or the destructor) ends the reporter
+ with a final report.
+ */
 class ProgressBar {
   private:
+	struct alignas(64) Counter {
+		std::atomic<unsigned long> count{0};
+	};
+
 	unsigned long _steps;
-	unsigned long _currentCount;
 	unsigned long _maxbarLength;
-	unsigned long _nextStep;
 	unsigned long _updateSteps;
+	std::size_t nCounters;
+	std::unique_ptr<Counter[]> counters;
 	time_t _startTime;
+	std::chrono::steady_clock::time_point startClock;
+	std::string title;
 	std::string stringTmpl;
 	std::string arrow;
-	bool mutexSet;
-	std::shared_ptr<std::mutex> _mutex;
+	std::string metricsFilename;
+	double reportInterval;
+	bool finished;
+
+	std::thread reporter;
+	std::mutex reporterMutex;
+	std::condition_variable reporterWakeup;
+	bool stopping;
+
+	void reporterLoop();
+	void report();
+	void writeMetrics(unsigned long position,
+	                  const std::vector<unsigned long> &perThread) const;
 
   public:
 	/// Initialize a ProgressBar with [steps] number of steps, updated at
 	/// [updateSteps] intervalls
 	ProgressBar(unsigned long steps = 0, unsigned long updateSteps = 100);
-	/// Set mutex when used inside std::thread
-	void setMutex(std::shared_ptr<std::mutex> mutex);
-	/// Print a given title
+	~ProgressBar();
+
+	ProgressBar(const ProgressBar &) = delete;
+	ProgressBar &operator=(const ProgressBar &) = delete;
+
+	/// Kept for compatibility; update() needs no mutex, the argument is
+	/// ignored
+	void setMutex(std::shared_ptr<std::mutex> /* mutex */);
+	/// Metrics file of this bar (default: getProgressMetricsFile())
+	void setMetricsFile(const std::string &filename);
+	std::string getMetricsFile() const { return metricsFilename; }
+	/// Seconds between two reports (default: 1)
+	void setReportInterval(double seconds);
+	/// Print a given title and start the reporter
 	void start(const std::string &title);
+	/// Stop the reporter after a final report
+	void stop();
+	/// True between start() and stop()
+	bool isRunning() const { return reporter.joinable(); }
 
 	/// update the progressbar
-	/// should be called steps times in a loop
+	/// should be called steps times in a loop, from any thread
 	void update();
 
+	/// Number of updates so far
+	unsigned long getCount() const;
+	/// Updates per counter: the first one counts the threads outside of
+	/// the ThreadPool, counter i + 1 the worker i
+	std::vector<unsigned long> getThreadCounts() const;
+
 	// sets the position of the bar to a given value
 	void setPosition(unsigned long position);
 
 	/// Mark the progressbar with an error
 	void setError();
 };
+
+/**
+ \class ProgressBarGuard
+ \brief Stops a started ProgressBar when it goes out of scope, so that the
+ reporter also ends if the loop it reports on throws
+ */
+class ProgressBarGuard {
+  private:
+	std::shared_ptr<ProgressBar> bar;
+
+  public:
+	explicit ProgressBarGuard(std::shared_ptr<ProgressBar> bar_)
+	    : bar(std::move(bar_)) {}
+	~ProgressBarGuard() { bar->stop(); }
+
+	ProgressBarGuard(const ProgressBarGuard &) = delete;
+	ProgressBarGuard &operator=(const ProgressBarGuard &) = delete;
+};
 /** @}*/
 
 }  // namespace hermes
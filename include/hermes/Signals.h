@@ -9,9 +9,39 @@ typedef void (*sighandler_t)(int);
 
 namespace hermes {
 
-extern int g_cancel_signal_flag;
+extern volatile std::sig_atomic_t g_cancel_signal_flag;
 void g_cancel_signal_callback(int sig);
 
+/**
+ \class CancelSignalGuard
+ \brief Installs g_cancel_signal_callback() for SIGINT and SIGTERM for the
+ lifetime of the object (e.g., during Skymap::compute()) and restores the
+ previous handlers afterwards
+
+ Long loops poll g_cancel_signal_flag and stop early; once the partial
+ result is secured, raisePending() hands the signal over to the previous
+ handler, which terminates the program or, in Python, raises
+ KeyboardInterrupt.
+ */
+class CancelSignalGuard {
+  private:
+	sighandler_t oldSigIntHandler;
+	sighandler_t oldSigTermHandler;
+	bool installed;
+
+  public:
+	CancelSignalGuard();
+	~CancelSignalGuard();
+
+	CancelSignalGuard(const CancelSignalGuard &) = delete;
+	CancelSignalGuard &operator=(const CancelSignalGuard &) = delete;
+
+	/** True if SIGINT or SIGTERM was received since construction */
+	bool isCancelled() const;
+	/** Restores the previous handlers and re-raises a received signal */
+	void raisePending();
+};
+
 }  // namespace hermes
 
 #endif  // HERMES_SIGNALS_H
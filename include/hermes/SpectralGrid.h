@@ -0,0 +1,226 @@
+#ifndef HERMES_SPECTRALGRID_H
+#define HERMES_SPECTRALGRID_H
+
+#include <array>
+#include <cmath>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "hermes/Grid.h"
+#include "hermes/MemoryPlacement.h"
+#include "hermes/Vector3.h"
+#include "hermes/Vector3Quantity.h"
+
+namespace hermes {
+/**
+ * \addtogroup Core
+ * @{
+ */
+
+/**
+ @class SpectralGrid
+ @brief A 3D grid of spectra with the energy axis stored innermost
+
+ Geometry and interpolation follow Grid (trilinear interpolation, periodic
+ or reflective extension, sample positions at the centres of the cells),
+ but every voxel holds a contiguous spectrum of NE values. The cell
+ indices and the 8 corner weights are therefore computed once per
+ position and the whole spectrum is interpolated in a single pass over
+ 8 contiguous rows, which the compiler can vectorise.
+
+ The values can also be attached from external, read-only memory (e.g.,
+ a memory-mapped BinaryCache entry) without copying them; such a grid
+ is read-only and its mutators throw.
+ */
+template <typename T>
+class SpectralGrid {
+	std::vector<T> grid;
+	std::shared_ptr<const void> externalOwner; /**< Keeps attached values
+	              alive */
+	const T *values;       /**< grid.data() or attached values */
+	size_t Nx, Ny, Nz, NE; /**< Number of grid points and of energies */
+	Vector3d origin;       /**< Origin of the volume that is represented by
+	              the grid. */
+	Vector3d gridOrigin;   /**< Grid origin */
+	Vector3d spacing;      /**< Distance between grid points */
+	bool reflective;       /**< If set to true, the grid is repeated
+	              reflectively instead of periodically */
+
+	size_t offset(size_t ix, size_t iy, size_t iz) const {
+		return ((ix * Ny + iy) * Nz + iz) * NE;
+	}
+
+	/** The owned values; throws if the values are attached */
+	std::vector<T> &ownGrid() {
+		if (isAttached())
+			throw std::runtime_error(
+			    "hermes::SpectralGrid: the grid is attached to read-only "
+			    "memory and cannot be modified");
+		return grid;
+	}
+
+	/** Offsets of the 8 neighbouring spectra and their trilinear weights */
+	void corners(const Vector3d &position, std::array<size_t, 8> &offsets,
+	             std::array<double, 8> &weights) const {
+		// position on a unit grid
+		Vector3d r = (position - gridOrigin) / spacing;
+
+		// indices of lower and upper neighbors
+		int ix, iX, iy, iY, iz, iZ;
+		if (reflective) {
+			reflectiveClamp(r.x, Nx, ix, iX);
+			reflectiveClamp(r.y, Ny, iy, iY);
+			reflectiveClamp(r.z, Nz, iz, iZ);
+		} else {
+			periodicClamp(r.x, Nx, ix, iX);
+			periodicClamp(r.y, Ny, iy, iY);
+			periodicClamp(r.z, Nz, iz, iZ);
+		}
+
+		// linear fraction to lower and upper neighbors
+		double fx = r.x - floor(r.x);
+		double fX = 1 - fx;
+		double fy = r.y - floor(r.y);
+		double fY = 1 - fy;
+		double fz = r.z - floor(r.z);
+		double fZ = 1 - fz;
+
+		// same corner order as Grid::interpolate()
+		offsets = {offset(ix, iy, iz), offset(iX, iy, iz), offset(ix, iY, iz),
+		           offset(ix, iy, iZ), offset(iX, iy, iZ), offset(ix, iY, iZ),
+		           offset(iX, iY, iz), offset(iX, iY, iZ)};
+		weights = {fX * fY * fZ, fx * fY * fZ, fX * fy * fZ, fX * fY * fz,
+		           fx * fY * fz, fX * fy * fz, fx * fy * fZ, fx * fy * fz};
+	}
+
+  public:
+	/** Constructor
+	 @param	origin	Position of the lower left front corner of the volume
+	 @param	Nx		Number of grid points in x-direction
+	 @param	Ny		Number of grid points in y-direction
+	 @param	Nz		Number of grid points in z-direction
+	 @param spacing	Spacing vector between grid points
+	 @param	NE		Number of energies per grid point
+	 */
+	SpectralGrid(Vector3d origin, size_t Nx, size_t Ny, size_t Nz,
+	             Vector3d spacing, size_t NE)
+	    : Nx(Nx), Ny(Ny), Nz(Nz), NE(NE), reflective(false) {
+		this->spacing = spacing;
+		setOrigin(origin);
+		resizePlaced(grid, Nx * Ny * Nz * NE);
+		values = grid.data();
+	}
+
+	/** Constructor for a grid of values stored elsewhere in the same
+	 layout (e.g., a memory-mapped BinaryCache entry); see attach()
+	 */
+	SpectralGrid(Vector3d origin, size_t Nx, size_t Ny, size_t Nz,
+	             Vector3d spacing, size_t NE, std::shared_ptr<const void> owner,
+	             const T *data)
+	    : Nx(Nx), Ny(Ny), Nz(Nz), NE(NE), reflective(false) {
+		this->spacing = spacing;
+		setOrigin(origin);
+		attach(std::move(owner), data);
+	}
+
+	SpectralGrid(const SpectralGrid &) = delete;
+	SpectralGrid &operator=(const SpectralGrid &) = delete;
+	SpectralGrid(SpectralGrid &&) = default;
+	SpectralGrid &operator=(SpectralGrid &&) = default;
+
+	/** Use Nx * Ny * Nz * NE values stored elsewhere in the same layout
+	 @param	owner	Object owning the memory, kept alive by the grid
+	 @param	data	Pointer to the values
+	 */
+	void attach(std::shared_ptr<const void> owner, const T *data) {
+		grid.clear();
+		grid.shrink_to_fit();
+		externalOwner = std::move(owner);
+		values = data;
+	}
+
+	/** Pointer to the values in their storage layout */
+	const T *data() const { return values; }
+	/** True if the values are stored elsewhere, see attach() */
+	bool isAttached() const { return values != grid.data(); }
+
+	void setOrigin(Vector3d origin) {
+		this->origin = origin;
+		this->gridOrigin = origin + spacing / 2;
+	}
+
+	Vector3d getOrigin() const { return origin; }
+	Vector3d getSpacing() const { return spacing; }
+	size_t getNx() const { return Nx; }
+	size_t getNy() const { return Ny; }
+	size_t getNz() const { return Nz; }
+	size_t getNE() const { return NE; }
+	size_t getGridSize() const { return Nx * Ny * Nz * NE; }
+
+	void setReflective(bool b) { reflective = b; }
+	bool isReflective() const { return reflective; }
+
+	/** Inspector & Mutator */
+	T &get(size_t ix, size_t iy, size_t iz, size_t iE) {
+		return ownGrid()[offset(ix, iy, iz) + iE];
+	}
+
+	/** Inspector */
+	const T &get(size_t ix, size_t iy, size_t iz, size_t iE) const {
+		return values[offset(ix, iy, iz) + iE];
+	}
+
+	void setValue(size_t ix, size_t iy, size_t iz, size_t iE, T value) {
+		ownGrid()[offset(ix, iy, iz) + iE] = value;
+	}
+
+	void addValue(size_t ix, size_t iy, size_t iz, size_t iE, T value) {
+		ownGrid()[offset(ix, iy, iz) + iE] += value;
+	}
+
+	/** Return a reference to the grid values (not for attached grids) */
+	std::vector<T> &getGrid() { return ownGrid(); }
+
+	/** Interpolate a single energy bin at a given position */
+	T interpolate(const Vector3d &position, size_t iE) const {
+		std::array<size_t, 8> offsets;
+		std::array<double, 8> weights;
+		corners(position, offsets, weights);
+
+		T b(0.);
+		for (size_t c = 0; c < 8; ++c) b += values[offsets[c] + iE] * weights[c];
+		return b;
+	}
+
+	/** Interpolate the whole spectrum at a given position
+	 @param	position	Position
+	 @param	out			Output array of (at least) NE values
+	 */
+	void interpolateSpectrum(const Vector3d &position, T *out) const {
+		std::array<size_t, 8> offsets;
+		std::array<double, 8> weights;
+		corners(position, offsets, weights);
+
+		for (size_t iE = 0; iE < NE; ++iE) out[iE] = T(0.);
+		for (size_t c = 0; c < 8; ++c) {
+			const T *row = values + offsets[c];
+			const double w = weights[c];
+			for (size_t iE = 0; iE < NE; ++iE) out[iE] += row[iE] * w;
+		}
+	}
+
+	void interpolateSpectrum(const Vector3d &position,
+	                         std::vector<T> &out) const {
+		out.resize(NE);
+		interpolateSpectrum(position, out.data());
+	}
+};
+
+typedef SpectralGrid<QPDensityPerEnergy> SpectralGridQPDensityPerEnergy;
+
+/** @}*/
+
+}  // namespace hermes
+
+#endif  // HERMES_SPECTRALGRID_H
@@ -0,0 +1,153 @@
+#ifndef HERMES_THREADPOOL_H
+#define HERMES_THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+/**
+ @file
+ @brief Persistent work-stealing thread pool used for pixel and cache-table
+ loops
+ */
+
+namespace hermes {
+/**
+ * \addtogroup Core
+ * @{
+ */
+
+/**
+ \struct LoadStatistics
+ \brief Per-run statistics of a ThreadPool::parallelFor() call
+ */
+struct LoadStatistics {
+	/** wall-clock time of the whole run (in seconds) */
+	double wallTime = 0;
+	/** time each worker spent executing tasks (in seconds) */
+	std::vector<double> busyTime;
+	/** number of indices executed by each worker */
+	std::vector<std::size_t> tasks;
+	/** number of successful steals performed by each worker */
+	std::vector<std::size_t> steals;
+
+	std::size_t getTotalTasks() const;
+	std::size_t getTotalSteals() const;
+	/**
+	    Ratio of the maximum to the mean busy time of workers;
+	    1 means perfectly balanced
+	*/
+	double getImbalance() const;
+	/**
+	    Fraction of the available CPU time (workers x wall time)
+	    spent on actual work
+	*/
+	double getEfficiency() const;
+};
+
+std::ostream &operator<<(std::ostream &out, const LoadStatistics &s);
+
+/**
+ \class ThreadPool
+ \brief A persistent pool of worker threads with per-thread work queues.
+
+ Every call to parallelFor() splits the index range [0, n) into one
+ contiguous block per worker. A worker consumes its own block from the
+ front in small chunks (of size \p grain); when it runs dry it steals the
+ back half of the largest remaining block of another worker. Expensive
+ indices therefore migrate to idle threads at run time instead of being
+ fixed by an up-front split.
+
+ Calls to parallelFor() from within a task are executed serially by the
+ calling worker, so nested use (e.g., a cache table filled from inside
+ Skymap::compute()) is safe.
+ */
+class ThreadPool {
+  private:
+	struct alignas(64) WorkerQueue {
+		std::mutex mtx;
+		std::size_t begin = 0;
+		std::size_t end = 0;
+	};
+
+	std::vector<std::thread> workers;
+	std::unique_ptr<WorkerQueue[]> queues;
+	std::size_t nThreads;
+	bool pinned;
+
+	std::mutex runMutex;  // serialises concurrent parallelFor() callers
+	std::mutex poolMutex;
+	std::condition_variable workAvailable;
+	std::condition_variable workDone;
+	std::size_t generation;
+	std::size_t activeWorkers;
+	bool stopping;
+
+	// state of the current run
+	const std::function<void(std::size_t)> *job;
+	std::size_t grain;
+	std::atomic<bool> aborted;
+	std::exception_ptr firstException;
+	LoadStatistics stats;
+
+	void workerLoop(std::size_t id);
+	void runWorker(std::size_t id);
+	bool popLocal(std::size_t id, std::size_t &begin, std::size_t &end);
+	bool steal(std::size_t id);
+
+  public:
+	/**
+	    \param nThreads number of worker threads
+	    \param pinned   pin worker i to the i-th allowed CPU (see
+	                    pinCurrentThread())
+	*/
+	explicit ThreadPool(std::size_t nThreads, bool pinned = false);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool &) = delete;
+	ThreadPool &operator=(const ThreadPool &) = delete;
+
+	/**
+	    Number of worker threads
+	*/
+	std::size_t size() const;
+	/** True if the workers are pinned to CPUs */
+	bool isPinned() const;
+
+	/**
+	    Execute f(i) for every i in [0, n) and block until all are done;
+	    the first exception thrown by a task is rethrown in the caller
+	    \param n     number of indices
+	    \param f     task, called once per index
+	    \param grain number of indices a worker takes from its queue at once
+	                 (0 = chosen automatically)
+	*/
+	LoadStatistics parallelFor(std::size_t n,
+	                           const std::function<void(std::size_t)> &f,
+	                           std::size_t grain = 0);
+
+	/**
+	    Index of the calling worker in its pool, or -1 if the calling
+	    thread does not belong to any pool
+	*/
+	static int getWorkerIndex();
+};
+
+/**
+    Returns the process-wide pool, (re)created with getThreadsNumber()
+    workers, pinned according to getThreadPinning(), whenever one of them
+    changes
+*/
+std::shared_ptr<ThreadPool> getThreadPool();
+
+/** @}*/
+}  // namespace hermes
+
+#endif  // HERMES_THREADPOOL_H
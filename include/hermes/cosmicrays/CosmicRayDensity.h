@@ -3,8 +3,12 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cstdint>
 #include <set>
+#include <string>
+#include <vector>
 
+#include "hermes/BinaryCache.h"
 #include "hermes/Grid.h"
 #include "hermes/ParticleID.h"
 #include "hermes/Units.h"
@@ -22,12 +26,21 @@ class CosmicRayDensity {
 	bool scaleFactorFlag;
 	double energyScaleFactor;
 	std::set<PID> setOfPIDs;
+	std::vector<std::string> sourceFiles; /**< see getSourceHashes() */
+	mutable std::vector<std::uint64_t> sourceHashes;
 
 	void enablePID(const PID &pid_) { setOfPIDs.insert(pid_); }
 	void disablePID(const PID &pid_) { setOfPIDs.erase(setOfPIDs.find(pid_)); }
 	bool isPIDEnabled(const PID &pid_) const {
 		return (setOfPIDs.count(pid_) > 0);
 	}
+	/** Enabled species as a file name friendly string, e.g., for caches */
+	std::string getPIDsAsString() const {
+		std::string s;
+		for (const auto &p : setOfPIDs)
+			s += (s.empty() ? "" : "_") + std::to_string(p.getID());
+		return s;
+	}
 
   public:
 	typedef tEnergyRange::iterator iterator;
@@ -43,6 +56,17 @@ class CosmicRayDensity {
 
 	virtual QPDensityPerEnergy getDensityPerEnergy(
 	    const QEnergy &E_, const Vector3QLength &pos_) const = 0;
+	/**
+	    Fills \p out with the density at every energy of getEnergyAxis();
+	    gridded models override it to interpolate the whole spectrum at once
+	*/
+	virtual void getDensitySpectrum(
+	    const Vector3QLength &pos_,
+	    std::vector<QPDensityPerEnergy> &out) const {
+		out.resize(energyRange.size());
+		for (std::size_t i = 0; i < energyRange.size(); ++i)
+			out[i] = getDensityPerEnergy(energyRange[i], pos_);
+	}
 	std::size_t getIndexOfE(const QEnergy &E_) const {
 		const_iterator it = std::find_if(
 		    begin(), end(), [E_](const auto &a) { return a == E_; });
@@ -53,6 +77,22 @@ class CosmicRayDensity {
 	double getEnergyScaleFactor() const { return energyScaleFactor; }
 
 	tEnergyRange getEnergyAxis() const { return energyRange; }
+	/**
+	    Content hashes of the files the model was read from (see
+	    fileContentHash()), empty for analytic models; part of the keys
+	    of the caches derived from the model, e.g., CacheTableStore.
+	    The files are only read on the first call, which has to come
+	    from a single thread (the caches are set up before the pixels
+	    are computed).
+	*/
+	const std::vector<std::uint64_t> &getSourceHashes() const {
+		if (sourceHashes.size() != sourceFiles.size()) {
+			sourceHashes.clear();
+			for (const auto &f : sourceFiles)
+				sourceHashes.push_back(fileContentHash(f));
+		}
+		return sourceHashes;
+	}
 
 	PID getPID() const { return *setOfPIDs.begin(); }
 
@@ -8,7 +8,9 @@
 #include <memory>
 #include <set>
 
+#include "hermes/BinaryCache.h"
 #include "hermes/FITSWrapper.h"
+#include "hermes/SpectralGrid.h"
 #include "hermes/cosmicrays/CosmicRayDensity.h"
 
 namespace hermes { namespace cosmicrays {
@@ -26,6 +28,8 @@ class Dragon3D : public CosmicRayDensity {
 	void readEnergyAxis();
 	void readSpatialGrid3D();
 	void readDensity3D();
+	bool loadBinaryCache(const std::shared_ptr<BinaryCache> &cache);
+	void storeBinaryCache(BinaryCache &cache) const;
 	std::size_t calcArrayIndex2D(std::size_t iE, std::size_t ir,
 	                             std::size_t iz);
 
@@ -33,7 +37,7 @@ class Dragon3D : public CosmicRayDensity {
 	QLength xmin, xmax, ymin, ymax;
 	int dimE;
 	int dimx, dimy, dimz, dimr;
-	std::vector<std::unique_ptr<ScalarGridQPDensityPerEnergy>> grid;
+	std::unique_ptr<SpectralGridQPDensityPerEnergy> grid;
 
 	// TODO: implement as std::unordered_map
 	std::map<QEnergy, std::size_t> energyIndex;
@@ -47,6 +51,9 @@ class Dragon3D : public CosmicRayDensity {
 	    const QEnergy &E_, const Vector3QLength &pos_) const override;
 	QPDensityPerEnergy getDensityPerEnergy(int iE_,
 	                                       const Vector3QLength &pos_) const;
+	void getDensitySpectrum(
+	    const Vector3QLength &pos_,
+	    std::vector<QPDensityPerEnergy> &out) const override;
     std::array<QLength, 2> getXBoundaries() const;
     std::array<QLength, 2> getYBoundaries() const;
     std::array<QLength, 2> getZBoundaries() const;
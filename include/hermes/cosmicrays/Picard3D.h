@@ -8,7 +8,9 @@
 #include <memory>
 #include <set>
 
+#include "hermes/BinaryCache.h"
 #include "hermes/FITSWrapper.h"
+#include "hermes/SpectralGrid.h"
 #include "hermes/Hdf5Reader.h"
 #include "hermes/cosmicrays/CosmicRayDensity.h"
 
@@ -30,6 +32,9 @@ class Picard3D : public CosmicRayDensity {
 	void evaluateEnergyScaleFactor();
 	void readSpatialGrid3D();
 	void readDensity3D();
+	std::vector<std::string> listSpeciesFiles() const;
+	bool loadBinaryCache(const std::shared_ptr<BinaryCache> &cache);
+	void storeBinaryCache(BinaryCache &cache) const;
 	std::size_t getArrayIndex3D(std::size_t xIndex, std::size_t yIndex,
 	                            std::size_t zIndex) const;
 	std::string getDatasetName(std::size_t energyIndex);
@@ -43,7 +48,7 @@ class Picard3D : public CosmicRayDensity {
 	size_t numberOfYValues{};
 	size_t numberOfZValues{};
 
-	std::vector<std::unique_ptr<ScalarGridQPDensityPerEnergy>> grid;
+	std::unique_ptr<SpectralGridQPDensityPerEnergy> grid;
 
 	// TODO: implement as std::unordered_map
 	std::map<QEnergy, std::size_t> energyToIndex;
@@ -78,6 +83,9 @@ class Picard3D : public CosmicRayDensity {
 	    const QEnergy &energy, const Vector3QLength &position) const override;
 	QPDensityPerEnergy getDensityPerEnergy(
 	    int energyIndex, const Vector3QLength &position) const;
+	void getDensitySpectrum(
+	    const Vector3QLength &position,
+	    std::vector<QPDensityPerEnergy> &out) const override;
 	std::array<QLength, 2> getXBoundaries() const;
 	std::array<QLength, 2> getYBoundaries() const;
 	std::array<QLength, 2> getZBoundaries() const;
@@ -25,8 +25,14 @@ class BremsstrahlungIntegrator : public PiZeroIntegrator {
 	    const std::shared_ptr<interactions::BremsstrahlungAbstract> &);
 	~BremsstrahlungIntegrator();
 
+	/** As PiZeroIntegrator's, without its kernels, which are not used here */
+	void prepareSkymapParameters(const std::vector<QEnergy> &Egammas) override;
+
 	QPiZeroIntegral integrateOverEnergy(const Vector3QLength &pos,
 	                                    const QEnergy &Egamma) const override;
+	std::vector<QPiZeroIntegral> integrateOverEnergy(
+	    const Vector3QLength &pos,
+	    const std::vector<QEnergy> &Egammas) const override;
 };
 
 /** @}*/
@@ -0,0 +1,111 @@
+#ifndef HERMES_CACHETABLESTORE_H
+#define HERMES_CACHETABLESTORE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "hermes/Grid.h"
+#include "hermes/Units.h"
+
+/** \file CacheTableStore.h
+ *  Declares CacheTableStore
+ */
+
+namespace hermes {
+/**
+ * \addtogroup Integrators
+ * @{
+ */
+
+/**
+ * \class CacheTableStore
+ * \brief Keeps the cache tables of an integrator (see
+ * IntegratorTemplate::initCacheTable) on disk, one table per gamma-ray
+ * energy, all energies of the same configuration in one BinaryCache entry
+ *
+ * The key is built from everything the table depends on: the integrator
+ * adds its name, the types of its models, the content hashes of the files
+ * they were read from, their energy axes, probe values of the models and
+ * the geometry of the grid. The store is enabled if HERMES_CACHE_PATH is set.
+ *
+ * \code
+ * CacheTableStore store("PiZeroIntegrator");
+ * store.addKey(typeid(*crossSec).name()).addKey(...).addGrid(*cacheTable);
+ * if (!store.load(Egamma, *cacheTable)) {
+ *     // fill the table, then
+ *     store.store(Egamma, *cacheTable);
+ * }
+ * \endcode
+ */
+class CacheTableStore {
+  private:
+	std::string tag;
+	std::vector<std::uint64_t> keys;
+
+	bool loadValues(const QEnergy &E, void *out, std::size_t bytes) const;
+	bool storeValues(const QEnergy &E, const void *values, std::size_t bytes) const;
+
+  public:
+	/** \param tag name of the entry (file name friendly) */
+	explicit CacheTableStore(const std::string &tag);
+
+	/** True if HERMES_CACHE_PATH is set */
+	bool isEnabled() const;
+
+	CacheTableStore &addKey(double v);
+	CacheTableStore &addKey(std::uint64_t v);
+	CacheTableStore &addKey(const std::string &s);
+	CacheTableStore &addKey(const char *s) { return addKey(std::string(s)); }
+	/** Adds hashes, e.g., CosmicRayDensity::getSourceHashes() */
+	CacheTableStore &addKey(const std::vector<std::uint64_t> &hashes) {
+		addKey(static_cast<std::uint64_t>(hashes.size()));
+		for (auto h : hashes) addKey(h);
+		return *this;
+	}
+	template <typename Q>
+	CacheTableStore &addKey(const std::vector<Q> &v) {
+		addKey(static_cast<std::uint64_t>(v.size()));
+		for (const auto &x : v) addKey(static_cast<double>(x));
+		return *this;
+	}
+	/** Adds the origin, the number of points and the spacing of \p grid */
+	template <typename T>
+	CacheTableStore &addGrid(const Grid<T> &grid) {
+		const Vector3d origin = grid.getOrigin(), spacing = grid.getSpacing();
+		for (double v : {origin.x, origin.y, origin.z, spacing.x, spacing.y, spacing.z}) addKey(v);
+		for (std::size_t n : {grid.getNx(), grid.getNy(), grid.getNz()}) addKey(static_cast<std::uint64_t>(n));
+		return *this;
+	}
+
+	/**
+	    Positions at which the integrators evaluate their models to tell
+	    different inputs of the same model type apart
+	*/
+	static std::vector<Vector3QLength> getProbePositions();
+
+	/** Fills \p grid with the stored table of \p E; false if there is none */
+	template <typename T>
+	bool load(const QEnergy &E, Grid<T> &grid) const {
+		return loadValues(E, static_cast<void *>(grid.getGrid().data()), grid.getGridSize() * sizeof(T));
+	}
+	/**
+	    Adds the table of \p E to the entry (replacing an older table of
+	    the same energy); the entry is reloaded and rewritten with all its
+	    energies under a lock file next to it, so concurrent writers keep
+	    each other's tables
+	*/
+	template <typename T>
+	bool store(const QEnergy &E, Grid<T> &grid) const {
+		return storeValues(E, static_cast<const void *>(grid.getGrid().data()), grid.getGridSize() * sizeof(T));
+	}
+	/** Energies stored in the entry of this configuration */
+	std::vector<QEnergy> getEnergies() const;
+	/** File of the entry (empty if the store is disabled) */
+	std::string getFilename() const;
+};
+
+/** @}*/
+}  // namespace hermes
+
+#endif  // HERMES_CACHETABLESTORE_H
@@ -5,6 +5,7 @@
 
 #include "hermes/Units.h"
 #include "hermes/integrators/IntegratorTemplate.h"
+#include "hermes/integrators/LOSSampleStore.h"
 #include "hermes/ionizedgas/IonizedGasDensity.h"
 #include "hermes/skymaps/DispersionMeasureSkymap.h"
 
@@ -28,11 +29,22 @@ namespace hermes {
 class DispersionMeasureIntegrator : public DispersionMeasureIntegratorTemplate {
   private:
 	std::shared_ptr<ionizedgas::IonizedGasDensity> gdensity;
+	std::shared_ptr<LOSSampleStore> sampleStore;
+
+	bool useSampleStore() const;
 
   public:
 	DispersionMeasureIntegrator(const std::shared_ptr<ionizedgas::IonizedGasDensity> &gdensity);
 	~DispersionMeasureIntegrator();
 
+	/**
+	    Take the gas density from a shared LOSSampleStore (used while the
+	    observer positions agree); the LOS is then integrated with
+	    Simpson's rule on the nodes of the store instead of QAG
+	*/
+	void setSampleStore(const std::shared_ptr<LOSSampleStore> &store);
+	std::shared_ptr<LOSSampleStore> getSampleStore() const;
+
 	QDispersionMeasure integrateOverLOS(const QDirection &iterdir) const override;
 	QDispersionMeasure integrateOverLOS(const QDirection &iterdir, const QNumber &num) const override {
 		return QDispersionMeasure(0);
@@ -6,6 +6,7 @@
 
 #include "hermes/Units.h"
 #include "hermes/integrators/IntegratorTemplate.h"
+#include "hermes/integrators/LOSSampleStore.h"
 #include "hermes/ionizedgas/IonizedGasDensity.h"
 #include "hermes/magneticfields/MagneticField.h"
 
@@ -29,6 +30,9 @@ namespace hermes {
 class FreeFreeIntegrator : public RadioIntegratorTemplate {
   private:
 	std::shared_ptr<ionizedgas::IonizedGasDensity> gdensity;
+	std::shared_ptr<LOSSampleStore> sampleStore;
+
+	bool useSampleStore() const;
 
   public:
 	FreeFreeIntegrator(const std::shared_ptr<ionizedgas::IonizedGasDensity> &gdensity);
@@ -37,14 +41,25 @@ class FreeFreeIntegrator : public RadioIntegratorTemplate {
 	void setFrequency(const QFrequency &freq);
 	QFrequency getFrequency() const;
 
+	/**
+	    Take the gas density from a shared LOSSampleStore (used while the
+	    observer positions agree)
+	*/
+	void setSampleStore(const std::shared_ptr<LOSSampleStore> &store);
+	std::shared_ptr<LOSSampleStore> getSampleStore() const;
+
 	QTemperature integrateOverLOS(const QDirection &iterdir) const override;
 	QTemperature integrateOverLOS(const QDirection &iterdir, const QFrequency &freq) const override;
+	/** Walks the LOS once for all frequencies in \p freqs */
+	std::vector<QTemperature> integrateOverLOS(const QDirection &iterdir,
+	                                           const std::vector<QFrequency> &freqs) const override;
 
 	QNumber gauntFactor(const QFrequency &freq, const QTemperature &T, int Z) const;
 	QEmissivity spectralEmissivityExplicit(const QPDensity &N, const QPDensity &N_e, const QFrequency &freq,
 	                                       const QTemperature &T, int Z) const;
 	QEmissivity spectralEmissivity(const Vector3QLength &pos, const QFrequency &freq) const;
 	QInverseLength absorptionCoefficient(const Vector3QLength &pos, const QFrequency &freq) const;
+	QInverseLength absorptionCoefficientExplicit(const QPDensity &N, const QFrequency &freq) const;
 };
 
 /** @}*/
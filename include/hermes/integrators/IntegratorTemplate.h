@@ -4,12 +4,14 @@
 #include <gsl/gsl_integration.h>
 
 #include <memory>
+#include <stdexcept>
 #include <vector>
 
 #include "hermes/Common.h"
 #include "hermes/Grid.h"
 #include "hermes/HEALPixBits.h"
 #include "hermes/Units.h"
+#include "hermes/integrators/RayTable.h"
 
 /**
  \file IntegratorTemplate.h
@@ -40,6 +42,7 @@ class IntegratorTemplate {
 	bool cacheEnabled;
 	bool cacheTableInitialized;
 	std::string description;
+	std::shared_ptr<const RayTable> rayTable;
 
   public:
 	IntegratorTemplate(const std::string &description)
@@ -88,11 +91,36 @@ class IntegratorTemplate {
 	virtual QPXL integrateOverLOS(const QDirection &dir,
 	                              const QSTEP &) const = 0;
 
+	/**
+	 *  Integrates the same line of sight for several skymap parameters
+	 *  (e.g., all energies of a GammaSkymapRange) and returns one pixel
+	 *  value per parameter. Integrators which can share the LOS walk
+	 *  between parameters override this; the default simply calls
+	 *  integrateOverLOS(dir, p) for every p.
+	 */
+	virtual std::vector<QPXL> integrateOverLOS(
+	    const QDirection &dir, const std::vector<QSTEP> &params) const {
+		std::vector<QPXL> result;
+		result.reserve(params.size());
+		for (const auto &p : params) result.push_back(integrateOverLOS(dir, p));
+		return result;
+	}
+	/**
+	 *  Called by the skymaps before their pixels are integrated for the
+	 *  skymap parameters \p params, so that quantities which depend on
+	 *  the parameter only are computed once rather than for every line of
+	 *  sight; the default does nothing
+	 */
+	virtual void prepareSkymapParameters(const std::vector<QSTEP> & /* params */) {}
+
 	/**
 	    Set the position of the Sun in the galaxy as a vector (x, y, z)
 	   from which the LOS integration starts, default: (8.5_kpc, 0, 0)
 	*/
-	void setObsPosition(const Vector3QLength &pos) { observerPosition = pos; }
+	void setObsPosition(const Vector3QLength &pos) {
+		observerPosition = pos;
+		rayTable.reset();
+	}
 	/**
 	    Get the position of the Sun in the galaxy as a vector (x, y, z)
 	*/
@@ -102,7 +130,39 @@ class IntegratorTemplate {
 	   direction) becomes getMaxDistance(direction)
 	*/
 	inline QLength getMaxDistance(const QDirection &direction) const {
-		return distanceToGalBorder(observerPosition, direction);
+		return getRay(direction).maxDistance;
+	}
+	/**
+	    Line of sight in \p direction from the observer position, taken
+	    from the ray table if the direction is the centre of one of its
+	    pixels
+	*/
+	LOSRay getRay(const QDirection &direction) const {
+		LOSRay ray;
+		if (rayTable != nullptr && rayTable->findRay(direction, ray)) return ray;
+		return makeLOSRay(observerPosition, direction);
+	}
+	/**
+	    Use the precomputed lines of sight of \p table (see getRayTable()),
+	    which has to be seen from the observer position; nullptr detaches
+	    the table. Skymaps attach the table of their nside before computing.
+	*/
+	void setRayTable(const std::shared_ptr<const RayTable> &table) {
+		if (table != nullptr && !(table->getObsPosition() == observerPosition))
+			throw std::runtime_error(
+			    "hermes::IntegratorTemplate: the ray table belongs to another "
+			    "observer position");
+		rayTable = table;
+	}
+	std::shared_ptr<const RayTable> getRayTable() const { return rayTable; }
+	/**
+	    Relative cost of integrateOverLOS(dir), used to balance the shards
+	    of SkymapTemplate::computeShard(); the default grows with the
+	    length of the line of sight inside the galaxy, so lines of sight
+	    in the plane weigh several times more than those towards the poles
+	*/
+	virtual double getLOSCostEstimate(const QDirection &dir) const {
+		return 1 + static_cast<double>(getMaxDistance(dir) / 1_kpc);
 	}
 	/**
 	    Caching helpers
@@ -3,11 +3,13 @@
 
 #include <array>
 #include <memory>
+#include <vector>
 
 #include "hermes/CacheTools.h"
 #include "hermes/ProgressBar.h"
 #include "hermes/Units.h"
 #include "hermes/cosmicrays/CosmicRayDensity.h"
+#include "hermes/integrators/CacheTableStore.h"
 #include "hermes/integrators/IntegratorTemplate.h"
 #include "hermes/interactions/DiffCrossSection.h"
 #include "hermes/photonfields/PhotonField.h"
@@ -28,14 +30,38 @@ class InverseComptonIntegrator : public GammaIntegratorTemplate {
 	std::shared_ptr<ICCacheTable> cacheTable;
 	QGREmissivity getIOEfromCache(const Vector3QLength &,
 	                              const QEnergy &) const;
-	void computeCacheInThread(std::size_t start, std::size_t end,
-	                          const QEnergy &Egamma,
-	                          std::shared_ptr<ProgressBar> &p);
+	void computeCacheEntry(std::size_t i, const QEnergy &Egamma);
 
-	QGREmissivity integrateOverSumEnergy(const Vector3QLength &pos,
-	                                     const QEnergy &Egamma) const;
-	QGREmissivity integrateOverLogEnergy(const Vector3QLength &pos,
-	                                     const QEnergy &Egamma) const;
+	/**
+	    Position-independent part of the emissivity for one gamma-ray
+	    energy: K[j][i] = w_j * c * eps_i ln(eps_i / eps_{i-1})
+	    * dsigma(E_j, eps_i, E_gamma) / eps_i^2 (in SI units), where w_j is
+	    the quadrature weight of the lepton energy E_j, so that the
+	    emissivity is sum_j n_j sum_i K[j][i] u_i
+	*/
+	struct ICKernel {
+		std::size_t nPhoton;
+		std::vector<double> matrix; /**< lepton energy major */
+	};
+	struct ICKernelCache;
+	std::shared_ptr<ICKernelCache> kernelCache;
+	/**
+	    Kernel for \p Egamma, computed on the first request; the cache is
+	    cleared when it holds 1024 kernels
+	*/
+	std::shared_ptr<const ICKernel> getKernel(const QEnergy &Egamma) const;
+
+	/** Photon spectra tabulated on a galactocentric (r, |z|) grid */
+	std::vector<double> photonRAxis, photonZAxis; /**< in m */
+	std::vector<double> photonTable; /**< (r, z, eps), eps innermost */
+	/** Photon energy densities (in SI units) at \p pos */
+	void getPhotonSpectrum(const Vector3QLength &pos,
+	                       std::vector<double> &u) const;
+	/** Lepton densities per energy (in SI units) at \p pos */
+	void getLeptonSpectrum(const Vector3QLength &pos,
+	                       std::vector<double> &n) const;
+	static double contract(const ICKernel &kernel, const double *n,
+	                       const double *u);
 
   public:
 	InverseComptonIntegrator(
@@ -50,14 +76,59 @@ class InverseComptonIntegrator : public GammaIntegratorTemplate {
 	QDiffIntensity integrateOverLOS(const QDirection &iterdir) const override;
 	QDiffIntensity integrateOverLOS(const QDirection &iterdir,
 	                                const QEnergy &Egamma) const override;
+	/**
+	    Walks the LOS once for all energies in \p Egammas; unlike the
+	    adaptive single-energy version it uses a fixed-node Simpson rule
+	    shared by all energies (the cache table is not used); both agree
+	    to the 0.1% tolerance of the adaptive rule
+	*/
+	std::vector<QDiffIntensity> integrateOverLOS(
+	    const QDirection &iterdir,
+	    const std::vector<QEnergy> &Egammas) const override;
 	QGREmissivity integrateOverEnergy(const Vector3QLength &pos,
 	                                  const QEnergy &Egamma) const;
+	/**
+	    Emissivity for several gamma-ray energies at once; the lepton and
+	    photon densities at \p pos are looked up only once
+	*/
+	std::vector<QGREmissivity> integrateOverEnergy(
+	    const Vector3QLength &pos, const std::vector<QEnergy> &Egammas) const;
+	/**
+	    Emissivity at many positions at once; every row of the kernel is
+	    contracted with the spectra of all positions before the next one
+	    is loaded
+	*/
+	std::vector<QGREmissivity> integrateOverEnergy(
+	    const std::vector<Vector3QLength> &positions,
+	    const QEnergy &Egamma) const;
 	QICInnerIntegral integrateOverPhotonEnergy(const Vector3QLength &pos,
 	                                           const QEnergy &Egamma,
 	                                           const QEnergy &Eelectron) const;
 
+	/**
+	    Tabulate the spectrum of the photon field on a galactocentric
+	    (r, |z|) grid (in parallel); afterwards the spectrum at a position
+	    is interpolated bilinearly from the table instead of being looked
+	    up energy by energy. Suited to cylindrically symmetric fields such
+	    as photonfields::ISRF.
+	    \param r, z increasing node positions (|z| >= 0)
+	*/
+	void setupPhotonFieldTable(const std::vector<QLength> &r,
+	                           const std::vector<QLength> &z);
+	/**
+	    Table with r from 0 to 30 kpc (61 nodes) and the |z| nodes of the
+	    Vernetto16 data (24 nodes from 0 to 30 kpc)
+	*/
+	void setupPhotonFieldTable();
+	bool hasPhotonFieldTable() const;
+
 	void setupCacheTable(int N_x, int N_y, int N_z) override;
 	void initCacheTable() override;
+	/**
+	    Persistent store of the cache table (used by initCacheTable() if
+	    HERMES_CACHE_PATH is set), keyed by the configuration
+	*/
+	CacheTableStore getCacheTableStore() const;
 
 	tLOSProfile getLOSProfile(const QDirection &direction,
 	                          const QEnergy &Egamma, int Nsteps) const override;
@@ -5,87 +5,157 @@
 
 #include <cassert>
 #include <fstream>
-#include <functional>
 #include <sstream>
+#include <vector>
 
 #include "hermes/Common.h"
 #include "hermes/Grid.h"
+#include "hermes/GSLWorkspace.h"
 #include "hermes/Units.h"
 
 #define GSL_LIMIT 1000
 
 namespace hermes {
 
+// The integrand f of the methods below is any callable INTTYPE(QLength),
+// taken as a template parameter so that it is inlined (no std::function);
+// a value of another type, e.g. double, is converted to INTTYPE
+
 // dim(QPXL) = dim(INTTYPE) * dim(L)
-template <typename QPXL, typename INTTYPE>
-QPXL sumIntegration(std::function<INTTYPE(QLength)> f, QLength start,
-                    QLength stop, int N = 100) {
+template <typename QPXL, typename INTTYPE, typename F>
+QPXL sumIntegration(const F &f, QLength start, QLength stop, int N = 100) {
 	QLength delta_d = (stop - start) / N;
 
 	QPXL total(0);
 	for (QLength dist = start; dist <= stop; dist += delta_d) {
-		total += f(dist) * delta_d;
+		total += INTTYPE(f(dist)) * delta_d;
 	}
 	return total;
 }
 
 // dim(QPXL) = dim(INTTYPE) * dim(L)
-template <typename QPXL, typename INTTYPE>
-QPXL trapesoidIntegration(std::function<INTTYPE(QLength)> f, QLength start,
-                          QLength stop, int N = 100) {
+template <typename QPXL, typename INTTYPE, typename F>
+QPXL trapesoidIntegration(const F &f, QLength start, QLength stop,
+                          int N = 100) {
 	QLength delta_d = (stop - start) / N;
 
 	QPXL total(0);
 	for (QLength dist = start; dist <= stop - delta_d; dist += delta_d) {
-		total += (f(dist) + f(dist + delta_d)) / 2. * delta_d;
+		total += (INTTYPE(f(dist)) + INTTYPE(f(dist + delta_d))) / 2. * delta_d;
 	}
 	return total;
 }
 
 // dim(QPXL) = dim(INTTYPE) * dim(L)
-template <typename QPXL, typename INTTYPE>
-QPXL simpsonIntegration(std::function<INTTYPE(QLength)> f, QLength start,
-                        QLength stop, int N = 100) {
+template <typename QPXL, typename INTTYPE, typename F>
+QPXL simpsonIntegration(const F &f, QLength start, QLength stop,
+                        int N = 100) {
 	QLength a = start;
 	QLength b = stop;
 
 	QLength h = (b - a) / N;
-	INTTYPE XI0 = f(a) + f(b);
+	INTTYPE XI0 = INTTYPE(f(a)) + INTTYPE(f(b));
 	INTTYPE XI1 = 0, XI2 = 0;
 
 	for (int i = 1; i < N; ++i) {
 		QLength X = a + i * h;
 		if (i % 2 == 0)
-			XI2 = XI2 + f(X);
+			XI2 = XI2 + INTTYPE(f(X));
+		else
+			XI1 = XI1 + INTTYPE(f(X));
+	}
+
+	return h * (XI0 + 2 * XI2 + 4 * XI1) / 3.0;
+}
+
+// Simpson's rule with the integrand evaluated at all N + 1 nodes at once:
+// g(const QLength *dist, INTTYPE *values, std::size_t n) fills a buffer,
+// which allows batch model lookups (e.g., IonizedGasDensity::getDensity)
+// dim(QPXL) = dim(INTTYPE) * dim(L)
+template <typename QPXL, typename INTTYPE, typename G>
+QPXL simpsonIntegrationBatch(const G &g, QLength start, QLength stop,
+                             int N = 100) {
+	QLength h = (stop - start) / N;
+	std::vector<QLength> dist(N + 1);
+	for (int i = 0; i < N; ++i) dist[i] = start + i * h;
+	dist[N] = stop;
+	std::vector<INTTYPE> values(N + 1);
+	g(dist.data(), values.data(), dist.size());
+
+	INTTYPE XI0 = values[0] + values[N];
+	INTTYPE XI1 = 0, XI2 = 0;
+	for (int i = 1; i < N; ++i) {
+		if (i % 2 == 0)
+			XI2 = XI2 + values[i];
 		else
-			XI1 = XI1 + f(X);
+			XI1 = XI1 + values[i];
 	}
 
 	return h * (XI0 + 2 * XI2 + 4 * XI1) / 3.0;
 }
 
+// Weight of the node i = 0 ... N of Simpson's rule with N intervals of
+// width h, for integrands evaluated in a batch at all nodes
+inline QLength simpsonWeight(int i, int N, QLength h) {
+	if (i == 0 || i == N) return h / 3.;
+	return (i % 2 == 1) ? 4. * h / 3. : 2. * h / 3.;
+}
+
+// Simpson's rule for a spectrum-valued integrand: f(dist) returns a vector
+// of `size` components, all of which are integrated on the same nodes
+// dim(QPXL) = dim(INTTYPE) * dim(L)
+template <typename QPXL, typename INTTYPE, typename F>
+std::vector<QPXL> simpsonIntegrationSpectrum(const F &f, std::size_t size,
+                                             QLength start, QLength stop,
+                                             int N = 100) {
+	QLength a = start;
+	QLength b = stop;
+
+	QLength h = (b - a) / N;
+	std::vector<INTTYPE> XI0(size, INTTYPE(0)), XI1(size, INTTYPE(0)),
+	    XI2(size, INTTYPE(0));
+
+	auto accumulate = [size](std::vector<INTTYPE> &sum,
+	                         const std::vector<INTTYPE> &v) {
+		for (std::size_t k = 0; k < size; ++k) sum[k] = sum[k] + v[k];
+	};
+
+	accumulate(XI0, f(a));
+	accumulate(XI0, f(b));
+	for (int i = 1; i < N; ++i) {
+		QLength X = a + i * h;
+		if (i % 2 == 0)
+			accumulate(XI2, f(X));
+		else
+			accumulate(XI1, f(X));
+	}
+
+	std::vector<QPXL> result(size);
+	for (std::size_t k = 0; k < size; ++k)
+		result[k] = h * (XI0[k] + 2 * XI2[k] + 4 * XI1[k]) / 3.0;
+	return result;
+}
+
 // 8-points Gauß-Legendre integral
 static const double X[8] = {.0950125098, .2816035507, .4580167776, .6178762444,
                             .7554044083, .8656312023, .9445750230, .9894009349};
 static const double W[8] = {.1894506104, .1826034150, .1691565193, .1495959888,
                             .1246289712, .0951585116, .0622535239, .0271524594};
 
-template <typename QPXL, typename INTTYPE>
-QPXL gaussIntegration(std::function<INTTYPE(QLength)> f, QLength start,
-                      QLength stop, int N = 1) {
+template <typename QPXL, typename INTTYPE, typename F>
+QPXL gaussIntegration(const F &f, QLength start, QLength stop, int N = 1) {
 	const QLength XM = 0.5 * (stop + start);
 	const QLength XR = 0.5 * (stop - start);
 	INTTYPE SS = 0.;
 	for (int i = 0; i < 8; ++i) {
 		QLength DX = XR * X[i];
-		SS += W[i] * (f(XM + DX) + f(XM - DX));
+		SS += W[i] * (INTTYPE(f(XM + DX)) + INTTYPE(f(XM - DX)));
 	}
 	return XR * SS;
 }
 
-template <typename QPXL, typename INTTYPE>
-QPXL gslQAGIntegration(std::function<INTTYPE(QLength)> f, QLength start,
-                       QLength stop, int N) {
+template <typename QPXL, typename INTTYPE, typename F>
+QPXL gslQAGIntegration(const F &f, QLength start, QLength stop, int N) {
 	double a = static_cast<double>(start);
 	double b = static_cast<double>(stop);
 	double abs_error = 0.0;  // disabled
@@ -94,25 +164,21 @@ QPXL gslQAGIntegration(std::function<INTTYPE(QLength)> f, QLength start,
 	double result;
 	double error;
 
-	gsl_function F = {.function = [](double x, void *vf) -> double {
-		                  auto &func =
-		                      *static_cast<std::function<double(double)> *>(vf);
-		                  return func(x);
-	                  },
-	                  .params = &f};
+	gsl_function F_ = {.function = [](double x, void *vf) -> double {
+		                   const F &func = *static_cast<const F *>(vf);
+		                   return static_cast<double>(func(QLength(x)));
+	                   },
+	                   .params = const_cast<F *>(&f)};
 
-	gsl_integration_workspace *workspace_ptr =
-	    gsl_integration_workspace_alloc(GSL_LIMIT);
-	gsl_integration_qag(&F, a, b, abs_error, rel_error, N, key, workspace_ptr,
-	                    &result, &error);
-	gsl_integration_workspace_free(workspace_ptr);
+	GSLWorkspace workspace(GSL_LIMIT);
+	gsl_integration_qag(&F_, a, b, abs_error, rel_error, N, key,
+	                    workspace.get(), &result, &error);
 
 	return QPXL(result);
 }
 
-template <typename QPXL, typename INTTYPE>
-QPXL gslQAGSIntegration(std::function<INTTYPE(QLength)> f, QLength start,
-                        QLength stop, int N) {
+template <typename QPXL, typename INTTYPE, typename F>
+QPXL gslQAGSIntegration(const F &f, QLength start, QLength stop, int N) {
 	double a = static_cast<double>(start);
 	double b = static_cast<double>(stop);
 	double abs_error = 0.0;  // disabled
@@ -120,26 +186,22 @@ QPXL gslQAGSIntegration(std::function<INTTYPE(QLength)> f, QLength start,
 	double result;
 	double error;
 
-	gsl_function F = {.function = [](double x, void *vf) -> double {
-		                  auto &func =
-		                      *static_cast<std::function<double(double)> *>(vf);
-		                  return func(x);
-	                  },
-	                  .params = &f};
+	gsl_function F_ = {.function = [](double x, void *vf) -> double {
+		                   const F &func = *static_cast<const F *>(vf);
+		                   return static_cast<double>(func(QLength(x)));
+	                   },
+	                   .params = const_cast<F *>(&f)};
 
-	gsl_integration_workspace *workspace_ptr =
-	    gsl_integration_workspace_alloc(GSL_LIMIT);
-	gsl_integration_qags(&F, a, b, abs_error, rel_error, N, workspace_ptr,
+	GSLWorkspace workspace(GSL_LIMIT);
+	gsl_integration_qags(&F_, a, b, abs_error, rel_error, N, workspace.get(),
 	                     &result, &error);
-	gsl_integration_workspace_free(workspace_ptr);
 
 	return QPXL(result);
 }
 
-template <typename QPXL, typename INTTYPE>
-QPXL adaptiveSimpsonIntegration(std::function<INTTYPE(QLength)> f,
-                                QLength start, QLength stop, QPXL tolerance,
-                                int N = 30) {
+template <typename QPXL, typename INTTYPE, typename F>
+QPXL adaptiveSimpsonIntegration(const F &f, QLength start, QLength stop,
+                                QPXL tolerance, int N = 30) {
 	QPXL total(0);
 
 	QLength a = start;
@@ -150,8 +212,8 @@ QPXL adaptiveSimpsonIntegration(std::function<INTTYPE(QLength)> f,
 	std::vector<QLength> h_i(N, (b - a) / 2.);
 	std::vector<double> L_i(N, 1);
 
-	INTTYPE FA = f(a);
-	INTTYPE FB = f(b);
+	INTTYPE FA = INTTYPE(f(a));
+	INTTYPE FB = INTTYPE(f(b));
 	INTTYPE FD, FE;
 	QPXL S1, S2;
 	INTTYPE v2, v3, v4;
@@ -163,14 +225,14 @@ QPXL adaptiveSimpsonIntegration(std::function<INTTYPE(QLength)> f,
 	std::vector<INTTYPE> FC_i(N, 0);
 	std::vector<QPXL> S_i(N, 0);
 	for (int j = 0; j < N; ++j) {
-		FC_i[j] = f(a + h_i[j]);
+		FC_i[j] = INTTYPE(f(a + h_i[j]));
 		S_i[j] = h_i[j] * (FA_i[j] + 4 * FC_i[j] + FB_i[j]) / 3.0;
 	}
 
 	int i = 0;
 	while (i >= 0) {
-		FD = f(a_i[i] + h_i[i] / 2);
-		FE = f(a_i[i] + 3 * h_i[i] / 2);
+		FD = INTTYPE(f(a_i[i] + h_i[i] / 2));
+		FE = INTTYPE(f(a_i[i] + 3 * h_i[i] / 2));
 		S1 = h_i[i] * (FA_i[i] + 4 * FD + FC_i[i]) / 6.0;
 		S2 = h_i[i] * (FC_i[i] + 4 * FE + FB_i[i]) / 6.0;
 		v1 = a_i[i];
@@ -0,0 +1,158 @@
+#ifndef HERMES_LOSSAMPLESTORE_H
+#define HERMES_LOSSAMPLESTORE_H
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "hermes/Units.h"
+#include "hermes/cosmicrays/CosmicRayDensity.h"
+#include "hermes/ionizedgas/IonizedGasDensity.h"
+#include "hermes/magneticfields/MagneticField.h"
+
+/** \file LOSSampleStore.h
+ *  Declares LOSSamples and LOSSampleStore
+ */
+
+namespace hermes {
+/**
+ * \addtogroup Integrators
+ * @{
+ */
+
+/**
+ * \struct LOSSamples
+ * \brief Models evaluated at the equidistant nodes of one line of sight
+ *
+ * Node i lies at the distance i * step from the observer, i = 0 ... N,
+ * where N is even and N * step is the distance to the galactic border.
+ * The vectors of models which are not set in the store are empty.
+ */
+struct LOSSamples {
+	QLength step;
+	std::vector<Vector3QLength> position;
+	std::vector<QPDensity> ionizedGasDensity;
+	std::vector<Vector3QMField> magneticField;
+	/** (N + 1) x nEnergies, the energy axis innermost */
+	std::vector<QPDensityPerEnergy> crDensity;
+	std::size_t nEnergies;
+
+	std::size_t size() const { return position.size(); }
+	/** Weight of the node i in Simpson's rule */
+	QLength getSimpsonWeight(std::size_t i) const {
+		if (i == 0 || i + 1 == size()) return step / 3.;
+		return (i % 2 == 1) ? 4. * step / 3. : 2. * step / 3.;
+	}
+	/** Cosmic-ray spectrum at the node i (nEnergies values) */
+	const QPDensityPerEnergy *getCRSpectrum(std::size_t i) const {
+		return crDensity.data() + i * nEnergies;
+	}
+	std::size_t getMemoryUsage() const;
+};
+
+/**
+ * \class LOSSampleStore
+ * \brief Shares the model evaluations along lines of sight between
+ * integrators
+ *
+ * Integrators of the same sky (e.g., SynchroIntegrator,
+ * FreeFreeIntegrator, RotationMeasureIntegrator,
+ * DispersionMeasureIntegrator and SynchroAbsorptionIntegrator)
+ * which are given the same store look up positions, the ionised gas
+ * density, the magnetic field and the cosmic-ray spectra at the nodes of
+ * a line of sight only once; every integrator then integrates its own
+ * quantity on these nodes with Simpson's rule.
+ *
+ * The samples are kept per direction until the memory budget is exceeded,
+ * then the least recently used lines of sight are evicted. Since a
+ * skymap visits its pixels in order, the budget should hold a whole map
+ * to profit from the store in the next integrator.
+ *
+ * \code
+ * auto store = std::make_shared<LOSSampleStore>(Vector3QLength(8.5_kpc, 0, 0));
+ * synchroIntegrator->setSampleStore(store);
+ * rmIntegrator->setSampleStore(store);
+ * \endcode
+ */
+class LOSSampleStore {
+  private:
+	typedef std::pair<std::uint64_t, std::uint64_t> tKey;
+	struct KeyHash {
+		std::size_t operator()(const tKey &k) const {
+			return std::hash<std::uint64_t>()(k.first ^ (k.second * 0x9e3779b97f4a7c15ULL));
+		}
+	};
+	typedef std::list<std::pair<tKey, std::shared_ptr<const LOSSamples>>> tLRUList;
+
+	Vector3QLength observerPosition;
+	int nIntervals;
+	std::size_t memoryBudget;
+
+	std::shared_ptr<magneticfields::MagneticField> mfield;
+	std::shared_ptr<ionizedgas::IonizedGasDensity> gdensity;
+	std::shared_ptr<cosmicrays::CosmicRayDensity> crdensity;
+
+	mutable std::mutex mtx;
+	tLRUList lru;
+	std::unordered_map<tKey, tLRUList::iterator, KeyHash> entries;
+	std::size_t memoryUsage;
+	std::atomic<std::size_t> hits, misses, evictions;
+
+	static tKey makeKey(const QDirection &direction);
+	std::shared_ptr<LOSSamples> sample(const QDirection &direction) const;
+
+  public:
+	/**
+	    \param observerPosition position from which the lines of sight start
+	    \param nIntervals       number of intervals per line of sight (even)
+	    \param memoryBudget     maximal size of the stored samples in bytes
+	*/
+	LOSSampleStore(const Vector3QLength &observerPosition, int nIntervals = 500,
+	               std::size_t memoryBudget = std::size_t(1) << 30);
+
+	/** Setting a model clears the store */
+	void setMagneticField(const std::shared_ptr<magneticfields::MagneticField> &mfield);
+	void setIonizedGasDensity(const std::shared_ptr<ionizedgas::IonizedGasDensity> &gdensity);
+	void setCosmicRayDensity(const std::shared_ptr<cosmicrays::CosmicRayDensity> &crdensity);
+	std::shared_ptr<magneticfields::MagneticField> getMagneticField() const { return mfield; }
+	std::shared_ptr<ionizedgas::IonizedGasDensity> getIonizedGasDensity() const { return gdensity; }
+	std::shared_ptr<cosmicrays::CosmicRayDensity> getCosmicRayDensity() const { return crdensity; }
+
+	Vector3QLength getObsPosition() const { return observerPosition; }
+	int getNumberOfIntervals() const { return nIntervals; }
+	void setMemoryBudget(std::size_t bytes);
+	std::size_t getMemoryBudget() const { return memoryBudget; }
+
+	/**
+	    Samples of the line of sight in \p direction, evaluated on the
+	    first request; the returned samples stay valid after eviction
+	*/
+	std::shared_ptr<const LOSSamples> getSamples(const QDirection &direction);
+
+	void clear();
+	std::size_t getMemoryUsage() const;
+	std::size_t getNumberOfEntries() const;
+	std::size_t getHits() const { return hits; }
+	std::size_t getMisses() const { return misses; }
+	std::size_t getEvictions() const { return evictions; }
+};
+
+/**
+    Attaches \p store to an integrator: models the store does not have yet
+    are set from the integrator, a different model of the same kind is an
+    error. Used by the setSampleStore() methods of the integrators.
+*/
+void registerSampleStoreModels(LOSSampleStore &store,
+                               const std::shared_ptr<magneticfields::MagneticField> &mfield,
+                               const std::shared_ptr<ionizedgas::IonizedGasDensity> &gdensity,
+                               const std::shared_ptr<cosmicrays::CosmicRayDensity> &crdensity);
+
+/** @}*/
+}  // namespace hermes
+
+#endif  // HERMES_LOSSAMPLESTORE_H
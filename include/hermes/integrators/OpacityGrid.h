@@ -0,0 +1,87 @@
+#ifndef HERMES_OPACITYGRID_H
+#define HERMES_OPACITYGRID_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "hermes/Units.h"
+#include "hermes/Vector3Quantity.h"
+#include "hermes/interactions/BreitWheeler.h"
+#include "hermes/photonfields/PhotonField.h"
+
+/** \file OpacityGrid.h
+ *  Declares OpacityGrid
+ */
+
+namespace hermes {
+/**
+ * \addtogroup Integrators
+ * @{
+ */
+
+/**
+ * \class OpacityGrid
+ * \brief Absorption coefficient of gamma rays by pair production on a
+ * position-dependent photon field (e.g., photonfields::ISRF), tabulated on
+ * a galactocentric (r, |z|) grid and a logarithmic energy axis
+ *
+ * The coefficient
+ * \f$ \kappa(r, z, E_\gamma) = \int d\epsilon\, n(r, z, \epsilon)
+ * \bar\sigma(E_\gamma, \epsilon) \f$
+ * is summed over the energy axis of the photon field, where
+ * \f$ \bar\sigma \f$ is BreitWheeler::integratedOverTheta. The cross-section
+ * matrix does not depend on the position, so it is computed once (in
+ * parallel over the gamma-ray energies) and every node of the grid costs
+ * only a matrix-vector product; the nodes are filled in parallel as well.
+ *
+ * Lookups are interpolated bilinearly in (r, |z|) and log-log in the energy
+ * (linearly next to vanishing values); positions outside the grid and
+ * energies above it take the value of its boundary, energies below it are
+ * not absorbed.
+ */
+class OpacityGrid {
+  private:
+	std::vector<double> rAxis, zAxis; /**< in m */
+	double logEMin, logEMax, dLogE;   /**< ln(E / J) */
+	std::size_t nE;
+	std::vector<double> kappa; /**< (r, z, E), E innermost, in 1/m */
+
+	void compute(const std::shared_ptr<photonfields::PhotonField> &field);
+	static void locate(const std::vector<double> &axis, double v, std::size_t &i, double &f);
+
+  public:
+	/**
+	    Grid with r from 0 to 30 kpc (61 nodes), |z| from 0 to 30 kpc
+	    (24 nodes, dense near the plane) and 71 energies from 1 TeV to
+	    10 EeV
+	    \param cacheTag if not empty, the grid is kept in the binary cache
+	                    under this name (see BinaryCache); it must identify
+	                    the photon field
+	*/
+	OpacityGrid(const std::shared_ptr<photonfields::PhotonField> &field, const std::string &cacheTag = "");
+	/**
+	    \param r, z       increasing node positions (|z| >= 0)
+	    \param Emin, Emax first and last gamma-ray energy
+	    \param nE         number of energies (logarithmically spaced)
+	*/
+	OpacityGrid(const std::shared_ptr<photonfields::PhotonField> &field, const std::vector<QLength> &r,
+	            const std::vector<QLength> &z, const QEnergy &Emin, const QEnergy &Emax, std::size_t nE,
+	            const std::string &cacheTag = "");
+
+	std::vector<QLength> getRAxis() const;
+	std::vector<QLength> getZAxis() const;
+	std::vector<QEnergy> getEnergyAxis() const;
+	/** Tabulated value at the node (ir, iz, iE) */
+	QInverseLength getTableValue(std::size_t ir, std::size_t iz, std::size_t iE) const;
+
+	QInverseLength getAbsorptionCoefficient(const Vector3QLength &pos, const QEnergy &E) const;
+	/** Coefficients for all energies in \p E at once */
+	void getAbsorptionCoefficients(const Vector3QLength &pos, const std::vector<QEnergy> &E,
+	                               std::vector<QInverseLength> &out) const;
+};
+
+/** @}*/
+}  // namespace hermes
+
+#endif  // HERMES_OPACITYGRID_H
@@ -0,0 +1,105 @@
+#ifndef HERMES_OPACITYTABLE_H
+#define HERMES_OPACITYTABLE_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "hermes/BinaryCache.h"
+#include "hermes/ThreadPool.h"
+#include "hermes/Units.h"
+
+/** \file OpacityTable.h
+ *  Declares OpacityTable
+ */
+
+namespace hermes {
+/**
+ * \addtogroup Integrators
+ * @{
+ */
+
+using namespace units;
+
+/**
+ * \class OpacityTable
+ * \brief Absorption coefficient of gamma rays in a homogeneous photon field
+ * (e.g., the CMB) tabulated on a logarithmic energy axis
+ *
+ * The coefficient is a double integral over the photon spectrum and the
+ * interaction angle, which is far too slow to be evaluated per line of
+ * sight. The table is filled once (in parallel, optionally from the
+ * binary cache, see BinaryCache) and interpolated linearly in
+ * log(kappa) - log(E); next to energies where kappa vanishes (below the
+ * pair-production threshold) it is interpolated linearly in kappa.
+ *
+ * \code
+ * OpacityTable table(10_TeV, 10_EeV, 181);
+ * table.fillCached("CMB", [](const QEnergy &E) { return kappa(E); });
+ * QNumber tau = table.getAbsorptionCoefficient(100_TeV) * 8_kpc;
+ * \endcode
+ */
+class OpacityTable {
+  private:
+	double logEMin, logEMax, dLogE; /**< ln(E / J) */
+	std::vector<double> kappa;      /**< in 1/m */
+
+  public:
+	/**
+	    \param Emin, Emax first and last energy of the table
+	    \param n          number of energies (logarithmically spaced)
+	*/
+	OpacityTable(const QEnergy &Emin, const QEnergy &Emax, std::size_t n);
+
+	/**
+	    Tabulate \p f, a callable returning the QInverseLength absorption
+	    coefficient for a QEnergy; the energies are computed in parallel
+	*/
+	template <typename F>
+	void fill(F f) {
+		getThreadPool()->parallelFor(kappa.size(), [&](std::size_t i) {
+			kappa[i] = static_cast<double>(f(getEnergy(i)));
+		});
+	}
+
+	/**
+	    Like fill(), but first tries to load the table from the binary
+	    cache and stores it there after filling
+	    \param tag name of the entry; it must identify the photon field and
+	               the cross-section, the energy axis is part of the key
+	*/
+	template <typename F>
+	void fillCached(const std::string &tag, F f) {
+		std::vector<std::uint64_t> keys;
+		for (double v : {logEMin, logEMax}) {
+			std::uint64_t bits;
+			std::memcpy(&bits, &v, sizeof(double));
+			keys.push_back(bits);
+		}
+		keys.push_back(kappa.size());
+		BinaryCache cache(tag, keys);
+		if (cache.isEnabled() && cache.load() &&
+		    cache.getPayloadSize() == kappa.size() * sizeof(double)) {
+			std::memcpy(kappa.data(), cache.getPayload(), cache.getPayloadSize());
+			return;
+		}
+		fill(f);
+		if (cache.isEnabled()) cache.store({}, kappa.data(), kappa.size() * sizeof(double));
+	}
+
+	std::size_t size() const { return kappa.size(); }
+	QEnergy getEnergy(std::size_t i) const;
+	std::vector<QEnergy> getEnergyAxis() const;
+	QInverseLength getTableValue(std::size_t i) const { return QInverseLength(kappa.at(i)); }
+
+	/** True if \p E lies within the first and the last energy */
+	bool contains(const QEnergy &E) const;
+	/** Interpolated absorption coefficient; \p E has to be in the table */
+	QInverseLength getAbsorptionCoefficient(const QEnergy &E) const;
+};
+
+/** @}*/
+}  // namespace hermes
+
+#endif  // HERMES_OPACITYTABLE_H
@@ -8,6 +8,8 @@
 #include "hermes/ProgressBar.h"
 #include "hermes/Units.h"
 #include "hermes/cosmicrays/CosmicRayDensity.h"
+#include "hermes/integrators/OpacityGrid.h"
+#include "hermes/integrators/OpacityTable.h"
 #include "hermes/integrators/PiZeroIntegrator.h"
 #include "hermes/interactions/BreitWheeler.h"
 #include "hermes/interactions/DiffCrossSection.h"
@@ -23,6 +25,15 @@ class PiZeroAbsorptionIntegrator : public PiZeroIntegrator {
   private:
 	std::unique_ptr<interactions::BreitWheeler> bwCrossSec{std::make_unique<interactions::BreitWheeler>()};
 
+	std::shared_ptr<const OpacityTable> opacityTable;
+	std::shared_ptr<const OpacityGrid> opacityGrid;
+	/** CMB absorption coefficients of the energies of the skymaps */
+	std::vector<QEnergy> preparedEnergies;
+	std::vector<QInverseLength> preparedCoefficients;
+
+	/** Computes (or loads from the binary cache) the default table */
+	void buildOpacityTable();
+
   public:
 	PiZeroAbsorptionIntegrator(const std::shared_ptr<cosmicrays::CosmicRayDensity> &,
 	                           const std::shared_ptr<neutralgas::RingModel> &,
@@ -34,8 +45,45 @@ class PiZeroAbsorptionIntegrator : public PiZeroIntegrator {
 
 	QDiffIntensity integrateOverLOS(const QDirection &iterdir) const override;
 	QDiffIntensity integrateOverLOS(const QDirection &iterdir, const QEnergy &Egamma) const override;
+	std::vector<QDiffIntensity> integrateOverLOS(const QDirection &iterdir,
+	                                             const std::vector<QEnergy> &Egammas) const override;
+	/**
+	    Computes the absorption coefficients of \p Egammas once for all
+	    pixels, in addition to PiZeroIntegrator::prepareSkymapParameters()
+	*/
+	void prepareSkymapParameters(const std::vector<QEnergy> &Egammas) override;
 
+	/**
+	    Absorption coefficient on the CMB, interpolated from the opacity
+	    table within its energy range, zero below the pair-production
+	    threshold and computed otherwise
+	*/
 	QInverseLength absorptionCoefficient(const QEnergy &Egamma) const;
+	/** Absorption coefficient on the CMB by direct integration (slow) */
+	QInverseLength computeAbsorptionCoefficient(const QEnergy &Egamma) const;
+	/**
+	    Lowest gamma-ray energy absorbed on the CMB photons of
+	    computeAbsorptionCoefficient(), about 52 TeV
+	*/
+	static QEnergy getPairProductionThreshold();
+
+	/**
+	    The table of absorption coefficients; unless one has been set,
+	    a table from the pair-production threshold to 10 EeV, computed
+	    (or loaded from the binary cache) on construction
+	*/
+	std::shared_ptr<const OpacityTable> getOpacityTable() const;
+	/** Use \p table instead; must not be called during integration */
+	void setOpacityTable(const std::shared_ptr<const OpacityTable> &table);
+
+	/**
+	    Absorb on a position-dependent photon field (e.g., the ISRF)
+	    instead of the homogeneous CMB: the optical depth is then
+	    accumulated along every line of sight on the nodes at which the
+	    emissivity is evaluated; nullptr restores the CMB
+	*/
+	void setOpacityGrid(const std::shared_ptr<const OpacityGrid> &grid);
+	std::shared_ptr<const OpacityGrid> getOpacityGrid() const;
 };
 
 /** @}*/
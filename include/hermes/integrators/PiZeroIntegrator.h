@@ -2,12 +2,14 @@
 #define HERMES_PIZEROINTEGRATOR_H
 
 #include <array>
+#include <limits>
 #include <memory>
 #include <vector>
 
 #include "hermes/ProgressBar.h"
 #include "hermes/Units.h"
 #include "hermes/cosmicrays/CosmicRayDensity.h"
+#include "hermes/integrators/CacheTableStore.h"
 #include "hermes/integrators/IntegratorTemplate.h"
 #include "hermes/interactions/DiffCrossSection.h"
 #include "hermes/neutralgas/Nakanishi06.h"
@@ -31,11 +33,59 @@ class PiZeroIntegrator : public GammaIntegratorTemplate {
 	typedef Grid<QPiZeroIntegral> tCacheTable;
 	std::shared_ptr<tCacheTable> cacheTable;
 
+	/** Energies of the last cross-section table, see prepareSkymapParameters() */
+	std::vector<QEnergy> tableProjectileEnergies, tableGammaEnergies;
+
+	/** A node of the LOS integration over the rings */
+	struct RingNode {
+		std::size_t ring;   /**< position of the ring in the model, or
+		                       noRing between the rings */
+		QLength distance;
+		QLength weight;     /**< Simpson weight, 0 between the rings */
+		Vector3QLength position;
+	};
+	static constexpr std::size_t noRing = std::numeric_limits<std::size_t>::max();
+	QLength ringStep;
+
+	/**
+	    Nodes of Simpson's rule on the intervals in which the LOS crosses
+	    the enabled rings, ordered by distance; every ring of the model
+	    is visited in a single walk along the LOS. With \p withGaps the
+	    stretches between the intervals get nodes (of zero weight) as
+	    well, e.g., to accumulate an optical depth.
+	*/
+	std::vector<RingNode> getRingNodes(const QDirection &direction, bool withGaps = false) const;
+	/** Sum of the ring column densities weighted by the LOS integrals */
+	QDiffIntensity normalizeRingIntegrals(const QDirection &direction,
+	                                      const std::vector<QColumnDensity> &normIntegrals,
+	                                      const std::vector<QDiffFlux> &losIntegrals) const;
+
+	/**
+	    Position-independent part of integrateOverEnergy() for one
+	    gamma-ray energy: per CR species, the weights of the CR spectrum
+	    above E_gamma, ln(scale factor) * c * E * sum over the targets of
+	    abundance * dsigma/dE_gamma (in SI units)
+	*/
+	struct EnergyKernel {
+		std::vector<std::size_t> first; /**< index of the first CR energy
+		                                   above E_gamma */
+		std::vector<std::vector<double>> weights;
+	};
+	EnergyKernel makeEnergyKernel(const QEnergy &Egamma) const;
+	/**
+	    Kernels for the energies passed to prepareSkymapParameters(); they
+	    are only read while the pixels are integrated, other energies get
+	    theirs computed on every call
+	*/
+	std::vector<QEnergy> kernelEnergies;
+	std::vector<EnergyKernel> preparedKernels;
+
+	/** Part of prepareSkymapParameters() which sets up the cross-section */
+	void prepareCrossSectionTable(const std::vector<QEnergy> &Egammas);
+
 	QPiZeroIntegral getIOEfromCache(const Vector3QLength &,
 	                                const QEnergy &) const;
-	void computeCacheInThread(std::size_t start, std::size_t end,
-	                          const QEnergy &Egamma,
-	                          std::shared_ptr<ProgressBar> &p);
+	void computeCacheEntry(std::size_t i, const QEnergy &Egamma);
 
   public:
 	PiZeroIntegrator(
@@ -51,15 +101,56 @@ class PiZeroIntegrator : public GammaIntegratorTemplate {
 	void setEnergy(const QEnergy &Egamma);
 	QEnergy getEnergy() const;
 
+	/**
+	    Largest distance between the nodes of the LOS integration inside
+	    a ring (default 50 pc)
+	*/
+	void setRingStep(const QLength &step);
+	QLength getRingStep() const;
+
+	/**
+	    Intervals of distance in which the LOS crosses the enabled rings,
+	    ordered by distance, as (position of the ring in the model,
+	    (begin, end))
+	*/
+	std::vector<std::pair<std::size_t, std::pair<QLength, QLength>>> getRingIntervals(
+	    const QDirection &direction) const;
+
 	QDiffIntensity integrateOverLOS(const QDirection &iterdir) const override;
 	QDiffIntensity integrateOverLOS(const QDirection &iterdir,
 	                                const QEnergy &Egamma) const override;
+	/**
+	    Walks the LOS once and returns the differential intensity for
+	    every energy in \p Egammas (the cache table is not used)
+	*/
+	std::vector<QDiffIntensity> integrateOverLOS(
+	    const QDirection &iterdir,
+	    const std::vector<QEnergy> &Egammas) const override;
+	/**
+	    If caching is enabled for the cross-section, precomputes it on the
+	    energies of the cosmic rays and \p Egammas (see
+	    DifferentialCrossSection::setCacheTable()); the table is only
+	    rebuilt when these energies change. Computes the kernels of
+	    integrateOverEnergy() for \p Egammas as well.
+	*/
+	void prepareSkymapParameters(const std::vector<QEnergy> &Egammas) override;
 
 	virtual QPiZeroIntegral integrateOverEnergy(const Vector3QLength &pos,
 	                                            const QEnergy &Egamma) const;
+	/**
+	    Emissivity integral for several gamma-ray energies at once; the
+	    cosmic-ray density at \p pos is looked up only once
+	*/
+	virtual std::vector<QPiZeroIntegral> integrateOverEnergy(
+	    const Vector3QLength &pos, const std::vector<QEnergy> &Egammas) const;
 
 	void setupCacheTable(int, int, int) override;
 	void initCacheTable() override;
+	/**
+	    Persistent store of the cache table (used by initCacheTable() if
+	    HERMES_CACHE_PATH is set), keyed by the configuration
+	*/
+	CacheTableStore getCacheTableStore() const;
 };
 
 /** @}*/
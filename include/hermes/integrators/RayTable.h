@@ -0,0 +1,110 @@
+#ifndef HERMES_RAYTABLE_H
+#define HERMES_RAYTABLE_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "hermes/Units.h"
+#include "hermes/Vector3.h"
+#include "hermes/Vector3Quantity.h"
+
+/** \file RayTable.h
+ *  Declares LOSRay and RayTable
+ */
+
+namespace hermes {
+/**
+ * \addtogroup Integrators
+ * @{
+ */
+
+/**
+ * \struct LOSRay
+ * \brief Geometry of one line of sight
+ *
+ * The node at the distance s from the observer lies at
+ * origin + s * direction (in the convention of getGalacticPosition()),
+ * so sampling a line of sight needs no trigonometry; the integration
+ * runs from 0 to maxDistance.
+ */
+struct LOSRay {
+	Vector3d origin;     /**< Start of the line of sight in m */
+	Vector3d direction;  /**< Unit vector */
+	QLength maxDistance; /**< distanceToGalBorder() of the direction */
+
+	/** Position at the distance \p dist from the observer */
+	Vector3QLength getPosition(const QLength &dist) const {
+		const double s = static_cast<double>(dist);
+		return Vector3QLength(QLength(origin.x + s * direction.x),
+		                      QLength(origin.y + s * direction.y),
+		                      QLength(origin.z + s * direction.z));
+	}
+	/** Positions of the n distances \p dist */
+	void getPositions(const QLength *dist, std::size_t n,
+	                  std::vector<Vector3QLength> &positions) const {
+		positions.resize(n);
+		for (std::size_t i = 0; i < n; ++i) positions[i] = getPosition(dist[i]);
+	}
+};
+
+/**
+    Line of sight from \p observerPosition in \p direction, the same as
+    getGalacticPosition() and distanceToGalBorder() give
+*/
+LOSRay makeLOSRay(const Vector3QLength &observerPosition,
+                  const QDirection &direction);
+
+/**
+ * \class RayTable
+ * \brief The lines of sight to the centres of all pixels (RING scheme) of
+ * a HEALPix map of a given nside, seen from one observer
+ *
+ * The table is filled in parallel on construction; it takes 48 bytes per
+ * pixel (about 150 MB for nside = 512). Use getRayTable() to share one
+ * table between all integrators and skymaps of the same nside and
+ * observer, see IntegratorTemplate::setRayTable().
+ */
+class RayTable {
+  private:
+	std::size_t nside;
+	Vector3QLength observerPosition;
+	Vector3d origin;
+	std::vector<QDirection> directions;
+	std::vector<Vector3d> unitVectors;
+	std::vector<QLength> maxDistances;
+
+  public:
+	RayTable(std::size_t nside, const Vector3QLength &observerPosition);
+
+	std::size_t getNside() const { return nside; }
+	Vector3QLength getObsPosition() const { return observerPosition; }
+	std::size_t size() const { return directions.size(); }
+	std::size_t getMemoryUsage() const;
+
+	/** pix2ang_ring(nside, ipix) */
+	const QDirection &getDirection(std::size_t ipix) const {
+		return directions[ipix];
+	}
+	LOSRay getRay(std::size_t ipix) const {
+		return LOSRay{origin, unitVectors[ipix], maxDistances[ipix]};
+	}
+	/**
+	    Looks up the ray of \p direction if it is exactly the centre of a
+	    pixel of the table (as given by pix2ang_ring), returns false
+	    otherwise
+	*/
+	bool findRay(const QDirection &direction, LOSRay &ray) const;
+};
+
+/**
+    Table of \p nside and \p observerPosition, built on the first request
+    and shared as long as it is in use
+*/
+std::shared_ptr<const RayTable> getRayTable(
+    std::size_t nside, const Vector3QLength &observerPosition);
+
+/** @}*/
+}  // namespace hermes
+
+#endif  // HERMES_RAYTABLE_H
@@ -6,6 +6,7 @@
 
 #include "hermes/Units.h"
 #include "hermes/integrators/IntegratorTemplate.h"
+#include "hermes/integrators/LOSSampleStore.h"
 #include "hermes/ionizedgas/IonizedGasDensity.h"
 #include "hermes/magneticfields/MagneticField.h"
 #include "hermes/skymaps/RotationMeasureSkymap.h"
@@ -31,14 +32,24 @@ class RotationMeasureIntegrator : public IntegratorTemplate<QRotationMeasure, QN
   private:
 	std::shared_ptr<magneticfields::MagneticField> mfield;
 	std::shared_ptr<ionizedgas::IonizedGasDensity> gdensity;
+	std::shared_ptr<LOSSampleStore> sampleStore;
 
 	QRMIntegral integralFunction(const Vector3QLength& pos) const;
+	QRMIntegral integralFunction(const Vector3QLength& pos, const Vector3QMField& B, const QPDensity& N) const;
+	bool useSampleStore() const;
 
   public:
 	RotationMeasureIntegrator(const std::shared_ptr<magneticfields::MagneticField>& mfield,
 	                          const std::shared_ptr<ionizedgas::IonizedGasDensity>& gdensity);
 	~RotationMeasureIntegrator();
 
+	/**
+	    Take the magnetic field and the gas density from a shared
+	    LOSSampleStore (used while the observer positions agree)
+	*/
+	void setSampleStore(const std::shared_ptr<LOSSampleStore>& store);
+	std::shared_ptr<LOSSampleStore> getSampleStore() const;
+
 	QRotationMeasure integrateOverLOS(const QDirection& iterdir) const override;
 	QRotationMeasure integrateOverLOS(const QDirection& iterdir, const QNumber& num) const override {
 		return QRotationMeasure(0);
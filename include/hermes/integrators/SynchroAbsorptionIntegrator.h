@@ -3,6 +3,7 @@
 
 #include "hermes/integrators/FreeFreeIntegrator.h"
 #include "hermes/integrators/IntegratorTemplate.h"
+#include "hermes/integrators/LOSSampleStore.h"
 #include "hermes/integrators/SynchroIntegrator.h"
 
 /** \file SynchroAbsorptionIntegrator.h
@@ -30,6 +31,9 @@ class SynchroAbsorptionIntegrator : public RadioIntegratorTemplate {
 	std::shared_ptr<ionizedgas::IonizedGasDensity> gdensity;
 	std::shared_ptr<SynchroIntegrator> intSynchro;
 	std::shared_ptr<FreeFreeIntegrator> intFreeFree;
+	std::shared_ptr<LOSSampleStore> sampleStore;
+
+	bool useSampleStore() const;
 
   public:
 	SynchroAbsorptionIntegrator(const std::shared_ptr<magneticfields::MagneticField> &mfield,
@@ -40,6 +44,15 @@ class SynchroAbsorptionIntegrator : public RadioIntegratorTemplate {
 	void setFrequency(const QFrequency &freq);
 	QFrequency getFrequency() const;
 
+	/**
+	    Take the magnetic field, the lepton spectra and the gas density
+	    from a shared LOSSampleStore (used while the observer positions
+	    agree); the LOS is then walked in the steps of the store instead
+	    of 10 pc
+	*/
+	void setSampleStore(const std::shared_ptr<LOSSampleStore> &store);
+	std::shared_ptr<LOSSampleStore> getSampleStore() const;
+
 	QTemperature integrateOverLOS(const QDirection &iterdir_) const override;
 	QTemperature integrateOverLOS(const QDirection &iterdir, const QFrequency &freq) const override;
 };
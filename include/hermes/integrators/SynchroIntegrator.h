@@ -7,6 +7,7 @@
 #include "hermes/Units.h"
 #include "hermes/cosmicrays/CosmicRayDensity.h"
 #include "hermes/integrators/IntegratorTemplate.h"
+#include "hermes/integrators/LOSSampleStore.h"
 #include "hermes/magneticfields/MagneticField.h"
 
 /** \file SynchroIntegrator.h
@@ -34,10 +35,17 @@ class SynchroIntegrator : public RadioIntegratorTemplate {
 	    std::sqrt(3) * pow<3>(e_plus) /
 	    (8 * pi * pi * epsilon0 * c_light * m_electron);
 
-	QEmissivity integrateOverSumEnergy(const Vector3QLength &pos,
+	std::shared_ptr<LOSSampleStore> sampleStore;
+
+	QMField perpendicularField(const Vector3QLength &pos,
+	                           const Vector3QMField &B) const;
+	QEmissivity integrateOverSumEnergy(const QMField &B_perp,
+	                                   const QPDensityPerEnergy *density,
 	                                   const QFrequency &freq) const;
-	QEmissivity integrateOverLogEnergy(const Vector3QLength &pos,
+	QEmissivity integrateOverLogEnergy(const QMField &B_perp,
+	                                   const QPDensityPerEnergy *density,
 	                                   const QFrequency &freq) const;
+	bool useSampleStore() const;
 
   public:
 	SynchroIntegrator(
@@ -48,14 +56,43 @@ class SynchroIntegrator : public RadioIntegratorTemplate {
 	void setFrequency(const QFrequency &freq);
 	QFrequency getFrequency() const;
 
+	/**
+	    Take the magnetic field and the lepton spectra from a shared
+	    LOSSampleStore (used while the observer positions agree)
+	*/
+	void setSampleStore(const std::shared_ptr<LOSSampleStore> &store);
+	std::shared_ptr<LOSSampleStore> getSampleStore() const;
+
 	QTemperature integrateOverLOS(const QDirection &iterdir) const override;
 	QTemperature integrateOverLOS(const QDirection &iterdir,
 	                              const QFrequency &freq) const override;
+	/** Walks the LOS once for all frequencies in \p freqs */
+	std::vector<QTemperature> integrateOverLOS(
+	    const QDirection &iterdir,
+	    const std::vector<QFrequency> &freqs) const override;
 
 	QEnergy singleElectronEmission(const QFrequency &freq, const QEnergy &E,
 	                               const QMField &B_perp) const;
 	QEmissivity integrateOverEnergy(const Vector3QLength &pos,
 	                                const QFrequency &freq) const;
+	/**
+	    Emissivity for several frequencies at once; the magnetic field and
+	    the lepton density at \p pos are looked up only once
+	*/
+	std::vector<QEmissivity> integrateOverEnergy(
+	    const Vector3QLength &pos, const std::vector<QFrequency> &freqs) const;
+	/**
+	    Emissivity for a given field \p B and lepton spectrum \p density
+	    (one value per energy of the cosmic-ray density) at \p pos
+	*/
+	QEmissivity integrateOverEnergy(const Vector3QLength &pos,
+	                                const Vector3QMField &B,
+	                                const QPDensityPerEnergy *density,
+	                                const QFrequency &freq) const;
+	std::vector<QEmissivity> integrateOverEnergy(
+	    const Vector3QLength &pos, const Vector3QMField &B,
+	    const QPDensityPerEnergy *density,
+	    const std::vector<QFrequency> &freqs) const;
 };
 
 /** @}*/
@@ -3,6 +3,7 @@
 
 #include <array>
 #include <memory>
+#include <vector>
 
 #include "hermes/CacheTools.h"
 #include "hermes/interactions/BremsstrahlungAbstract.h"
@@ -16,7 +17,7 @@ namespace hermes { namespace interactions {
 class BremsstrahlungGALPROP : public BremsstrahlungAbstract {
   private:
 	bool cachingEnabled;
-	std::array<std::unique_ptr<CacheStorageCrossSection>, Ntargets> cache;
+	std::array<std::unique_ptr<CacheStorageCrossSectionBase>, Ntargets> cache;
 
 	QNumber ElwertFactor(const QNumber &beta_i, const QNumber &beta_f,
 	                     int Z) const;
@@ -51,6 +52,14 @@ class BremsstrahlungGALPROP : public BremsstrahlungAbstract {
 
 	void enableCaching();
 	void disableCaching();
+	bool isCachingEnabled() const override { return cachingEnabled; }
+	/**
+	    Replaces the on-demand caches of all targets by tables precomputed
+	    on an (electron energy, photon energy) grid, e.g.,
+	    CosmicRayDensity::getEnergyAxis() and the energies of a skymap range
+	*/
+	void setCacheTable(const std::vector<QEnergy> &electronEnergies,
+	                   const std::vector<QEnergy> &photonEnergies) override;
 
 	QDiffCrossSection getDiffCrossSectionForTarget(
 	    Target t, const QEnergy &T_electron,
@@ -1,6 +1,8 @@
 #ifndef HERMES_DIFFERENTIALCROSSSECTION_H
 #define HERMES_DIFFERENTIALCROSSSECTION_H
 
+#include <vector>
+
 #include "hermes/ParticleID.h"
 #include "hermes/Units.h"
 
@@ -22,6 +24,15 @@ class DifferentialCrossSection {
 
 	void enableCaching();
 	void disableCaching();
+	virtual bool isCachingEnabled() const { return cachingEnabled; }
+	/**
+	    Precomputes the cross-section on a (projectile energy, secondary
+	    energy) grid; if caching is enabled, the integrators call it with
+	    CosmicRayDensity::getEnergyAxis() and the energies of the skymaps
+	    before computing them. Does nothing unless a model overrides it.
+	*/
+	virtual void setCacheTable(const std::vector<QEnergy> & /* projectileEnergies */,
+	                           const std::vector<QEnergy> & /* secondaryEnergies */) {}
 
 	virtual QDiffCrossSection getDiffCrossSection(const QEnergy &E_proton, const QEnergy &E_gamma) const;
 	virtual QDiffCrossSection getDiffCrossSection(const QEnergy &E_electron, const QEnergy &E_photon,
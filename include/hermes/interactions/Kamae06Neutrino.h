@@ -17,6 +17,7 @@ Journal (2007).
 */
 
 #include <memory>
+#include <vector>
 
 #include "hermes/CacheTools.h"
 #include "hermes/interactions/DiffCrossSection.h"
@@ -33,11 +34,18 @@ namespace hermes { namespace interactions {
 
 class Kamae06Neutrino : public DifferentialCrossSection {
   private:
-	std::unique_ptr<CacheStorageCrossSection> cache;
+	std::unique_ptr<CacheStorageCrossSectionBase> cache;
 
   public:
 	Kamae06Neutrino();
-	void setCachingStorage(std::unique_ptr<CacheStorageCrossSection> cache);
+	void setCachingStorage(std::unique_ptr<CacheStorageCrossSectionBase> cache);
+	/**
+	    Precomputes the cross-section on a (proton energy, secondary energy)
+	    grid, e.g., CosmicRayDensity::getEnergyAxis() and the energies of a
+	    skymap range; off-grid values are cached on demand
+	*/
+	void setCacheTable(const std::vector<QEnergy> &protonEnergies,
+	                   const std::vector<QEnergy> &secondaryEnergies) override;
 
 	QDiffCrossSection getDiffCrossSection(const QEnergy &E_proton, const QEnergy &E_nu) const override;
 	QDiffCrossSection getDiffCrossSection(const PID &projectile, const PID &target, const QEnergy &E_proj,
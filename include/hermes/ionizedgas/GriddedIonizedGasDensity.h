@@ -0,0 +1,64 @@
+#ifndef HERMES_GRIDDEDIONIZEDGASDENSITY_H
+#define HERMES_GRIDDEDIONIZEDGASDENSITY_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "hermes/LookupGrid.h"
+#include "hermes/ionizedgas/IonizedGasDensity.h"
+
+namespace hermes { namespace ionizedgas {
+/**
+ * \addtogroup IonizedGas
+ * @{
+ */
+
+/**
+ @class GriddedIonizedGasDensity
+ @brief Decorator which samples any IonizedGasDensity once on a LookupGrid
+ and answers getDensity() by trilinear interpolation
+
+ The grid is filled in parallel on construction, using the batch
+ getDensity() of the model along z-columns. Positions outside the grid
+ are passed to the model. With a non-empty \p cacheTag and
+ HERMES_CACHE_PATH set, the grid is stored in and loaded from the binary
+ cache; the tag has to change whenever the model or its parameters do.
+
+ \code
+ auto ne = std::make_shared<GriddedIonizedGasDensity>(
+     std::make_shared<YMW16>(), uniformAxis(-20_kpc, 20_kpc, 401),
+     uniformAxis(-20_kpc, 20_kpc, 401), sinhAxis(3_kpc, 121, 50_pc), "YMW16");
+ std::cout << ne->getAccuracy() << std::endl;
+ \endcode
+ */
+class GriddedIonizedGasDensity : public IonizedGasDensity {
+  private:
+	std::shared_ptr<IonizedGasDensity> model;
+	LookupGrid<double> grid; /**< density in m^-3 */
+
+  public:
+	GriddedIonizedGasDensity(const std::shared_ptr<IonizedGasDensity> &model,
+	                         const std::vector<QLength> &x,
+	                         const std::vector<QLength> &y,
+	                         const std::vector<QLength> &z,
+	                         const std::string &cacheTag = "");
+
+	using IonizedGasDensity::getDensity;
+	QPDensity getDensity(const Vector3QLength &pos) const override;
+
+	std::shared_ptr<IonizedGasDensity> getModel() const { return model; }
+	const LookupGrid<double> &getGrid() const { return grid; }
+
+	/**
+	    Deviation from the model at \p nSamples random positions inside the
+	    grid, in m^-3; used to choose the resolution of the axes
+	*/
+	LookupGridAccuracy getAccuracy(std::size_t nSamples = 10000,
+	                               unsigned seed = 0) const;
+};
+
+/** @}*/
+}}  // namespace hermes::ionizedgas
+
+#endif  // HERMES_GRIDDEDIONIZEDGASDENSITY_H
@@ -22,6 +22,7 @@ class HII_Cordes91 : public IonizedGasDensity {
 
   public:
 	HII_Cordes91();
+	using IonizedGasDensity::getDensity;
 	QPDensity getDensity(const Vector3QLength &pos) const override;
 };
 
@@ -1,6 +1,9 @@
 #ifndef HERMES_IONIZEDGASDENSITY_H
 #define HERMES_IONIZEDGASDENSITY_H
 
+#include <cstddef>
+#include <vector>
+
 #include "hermes/Grid.h"
 #include "hermes/Units.h"
 
@@ -19,6 +22,20 @@ class IonizedGasDensity {
 	IonizedGasDensity(QTemperature T) : gasTemp(T) {}
 	virtual ~IonizedGasDensity() {}
 	virtual QPDensity getDensity(const Vector3QLength &pos) const = 0;
+	/**
+	    Evaluates the density at \p n positions at once, e.g., at all
+	    nodes of a line of sight; models with a vectorisable kernel
+	    override this, the default calls getDensity(pos) for each.
+	*/
+	virtual void getDensity(const Vector3QLength *pos, QPDensity *density,
+	                        std::size_t n) const {
+		for (std::size_t i = 0; i < n; ++i) density[i] = getDensity(pos[i]);
+	}
+	void getDensity(const std::vector<Vector3QLength> &pos,
+	                std::vector<QPDensity> &density) const {
+		density.resize(pos.size());
+		getDensity(pos.data(), density.data(), pos.size());
+	}
 
 	inline void setTemperature(QTemperature T) { gasTemp = T; }
 	inline QTemperature getTemperature() const { return gasTemp; }
@@ -21,6 +21,7 @@ class NE2001Simple : public IonizedGasDensity {
 
   public:
 	NE2001Simple();
+	using IonizedGasDensity::getDensity;
 	QPDensity getDensity(const Vector3QLength &pos) const override;
 	QPDensity getThickDiskDensity(const Vector3QLength &pos) const;
 	QPDensity getThinDiskDensity(const Vector3QLength &pos) const;
@@ -251,10 +251,27 @@ class YMW16 : public IonizedGasDensity {
 
 	void initParameters();
 
+	static const std::size_t blockSize = 64;
+	/**
+	    ne_ymw16() for a block of at most blockSize points (pc, in the
+	    coordinates of YMW16): the smooth disk, centre and Fermi-bubble
+	    terms are evaluated branch-free over the whole block, the local
+	    structures only where they can contribute
+	*/
+	void neBlock(const double *xx, const double *yy, const double *zz, double *ne, std::size_t m) const;
+	/**
+	    spiral() for a point within the thick disk and the arm scale
+	    height \p HH, with a single exponential per arm
+	*/
+	double spiralArms(double xx, double yy, double zz, double gd, double rr, double HH) const;
+
   public:
 	YMW16();
 	YMW16(const QTemperature &t);
+	using IonizedGasDensity::getDensity;
 	QPDensity getDensity(const Vector3QLength &pos) const override;
+	/** Batch version of getDensity(pos), see neBlock() */
+	void getDensity(const Vector3QLength *pos, QPDensity *density, std::size_t n) const override;
 
 	double ne_ymw16(const Vector3QLength &pos) const;
 	double thick(double xx, double yy, double zz, double *gd, double rr) const;
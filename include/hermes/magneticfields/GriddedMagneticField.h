@@ -0,0 +1,57 @@
+#ifndef HERMES_GRIDDEDMAGNETICFIELD_H
+#define HERMES_GRIDDEDMAGNETICFIELD_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "hermes/LookupGrid.h"
+#include "hermes/magneticfields/MagneticField.h"
+
+namespace hermes { namespace magneticfields {
+/**
+ * \addtogroup MagneticFields
+ * @{
+ */
+
+/**
+ @class GriddedMagneticField
+ @brief Decorator which samples any MagneticField once on a LookupGrid and
+ answers getField() by trilinear interpolation
+
+ The grid is filled in parallel on construction. Positions outside the
+ grid are passed to the model. With a non-empty \p cacheTag and
+ HERMES_CACHE_PATH set, the grid is stored in and loaded from the binary
+ cache; the tag has to change whenever the model or its parameters do.
+ Models with a random component (e.g., JF12 with turbulence) are frozen
+ in the state they had when the grid was filled.
+ */
+class GriddedMagneticField : public MagneticField {
+  private:
+	std::shared_ptr<MagneticField> model;
+	LookupGrid<Vector3d> grid; /**< field in T */
+
+  public:
+	GriddedMagneticField(const std::shared_ptr<MagneticField> &model,
+	                     const std::vector<QLength> &x,
+	                     const std::vector<QLength> &y,
+	                     const std::vector<QLength> &z,
+	                     const std::string &cacheTag = "");
+
+	Vector3QMField getField(const Vector3QLength &pos) const override;
+
+	std::shared_ptr<MagneticField> getModel() const { return model; }
+	const LookupGrid<Vector3d> &getGrid() const { return grid; }
+
+	/**
+	    Deviation from the model at \p nSamples random positions inside the
+	    grid, in T; used to choose the resolution of the axes
+	*/
+	LookupGridAccuracy getAccuracy(std::size_t nSamples = 10000,
+	                               unsigned seed = 0) const;
+};
+
+/** @} */
+}}  // namespace hermes::magneticfields
+
+#endif  // HERMES_GRIDDEDMAGNETICFIELD_H
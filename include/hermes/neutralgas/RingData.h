@@ -4,8 +4,10 @@
 #define HERMES_RINGDATA_H
 
 #include <array>
+#include <memory>
 #include <utility>
 
+#include "hermes/BinaryCache.h"
 #include "hermes/FITSWrapper.h"
 #include "hermes/Units.h"
 #include "hermes/neutralgas/GasType.h"
@@ -22,12 +24,19 @@ class RingData {
 	double min_lon, min_lat;
 	double delta_lon, delta_lat;
 	std::vector<float> dataVector;
+	std::shared_ptr<BinaryCache> binaryCache;  // owns data if mapped
+	const float *data;
 
 	void readDataFile(const std::string &filename);
+	bool loadBinaryCache(const std::shared_ptr<BinaryCache> &cache);
 	double getRawValue(int ring, const QDirection &dir) const;
 
   public:
 	RingData(GasType gas);
+	// data points into dataVector or the mapped cache of this instance
+	RingData(const RingData &) = delete;
+	RingData &operator=(const RingData &) = delete;
+
 	QColumnDensity getHIColumnDensityInRing(int ring, const QDirection &dir) const;
 	QRingCOIntensity getCOIntensityInRing(int ring, const QDirection &dir) const;
 
@@ -5,6 +5,7 @@
 
 #include <array>
 #include <utility>
+#include <vector>
 
 #include "hermes/FITSWrapper.h"
 #include "hermes/Grid.h"
@@ -35,6 +36,13 @@ class Ring {
 	std::size_t getIndex() const;
 	std::pair<QLength, QLength> getBoundaries() const;
 	bool isInside(const Vector3QLength &) const;
+	/**
+	    Intervals of s in [0, maxDistance] in which start + s * unitStep
+	    lies inside the ring (innerR < rho < outerR), in increasing order;
+	    a straight line crosses an annulus at most twice
+	*/
+	std::vector<std::pair<QLength, QLength>> getCrossings(const Vector3QLength &start, const Vector3d &unitStep,
+	                                                      const QLength &maxDistance) const;
 	GasType getGasType() const;
 
 	QColumnDensity getHIColumnDensity(const QDirection &) const;
@@ -54,6 +54,11 @@ class CMB : public PhotonField {
 	                                std::size_t iE_) const override {
 		return density[iE_];
 	}
+
+	void getSpectrum(const Vector3QLength &pos_,
+	                 std::vector<QEnergyDensity> &out) const override {
+		out = density;
+	}
 };
 
 /** @}*/
@@ -2,6 +2,8 @@
 #define HERMES_ISRF_H
 
 #include <array>
+#include <string>
+#include <vector>
 
 #include "hermes/photonfields/PhotonField.h"
 
@@ -11,6 +13,17 @@ namespace hermes { namespace photonfields {
  * @{
  */
 
+/**
+ @class ISRF
+ @brief Interstellar radiation field of Vernetto & Lipari (2016),
+ interpolated from spectra tabulated on a galactocentric (r, |z|) grid
+
+ The position of every energy of the energy axis within the wavelength
+ axis of the data is computed once, so getSpectrum() needs a single
+ (r, |z|) lookup for the whole spectrum. resampleUniform() additionally
+ resamples the spectra onto a uniform (r, |z|) grid, where the lookup is
+ plain index arithmetic.
+ */
 class ISRF : public PhotonField {
   private:
 	const static int freqR1 = 200;
@@ -27,11 +40,38 @@ class ISRF : public PhotonField {
 	                               20.0, 25.0, 30.0};  // in kpc (24)
 	std::vector<double> isrf;
 
+	/** Per energy of the energy axis: lower wavelength node (or npos
+	    outside of the data) and fraction towards the next one */
+	std::vector<std::size_t> freqIndex;
+	std::vector<double> freqFraction;
+
+	/** Uniform (r, |z|) resampling, energy axis innermost, in eV/cm^3 */
+	std::vector<double> uniformTable;
+	std::size_t uniformNr, uniformNz;
+	double uniformDr, uniformDz; /**< in kpc */
+
 	void buildEnergyRange();
+	void buildFrequencyIndex();
+	/** Lower nodes and fractions of (r, |z|) in kpc; false outside */
+	bool locate(double r, double z, std::size_t &ir, std::size_t &iz,
+	            double &r_d, double &z_d) const;
+	/** Offset of the lower uniform node and fractions; false outside */
+	bool locateUniform(double r, double z, std::size_t &offset, double &r_d,
+	                   double &z_d) const;
+	/** Spectrum (in eV/cm^3) from the data, interpolated at r, |z| in kpc */
+	void interpolateSpectrum(double r, double z, double *out) const;
 
 	double getISRF(std::size_t ir, std::size_t iz, std::size_t ifreq) const;
 
 	void loadFrequencyAxis();
+	/** Energy densities of one Vernetto16 file into \p out */
+	void readSpectrumFile(const std::string &filename, double *out) const;
+	/**
+	    Parse the Vernetto16 files in parallel, or map them from the
+	    binary cache (see BinaryCache) if HERMES_CACHE_PATH is set; the
+	    entry is keyed on the paths, sizes and modification times of
+	    the files (see fileManifestHash())
+	*/
 	void loadISRF();
 
   public:
@@ -43,6 +83,18 @@ class ISRF : public PhotonField {
 	                                const QEnergy &E_photon) const override;
 	QEnergyDensity getEnergyDensity(const Vector3QLength &pos_,
 	                                std::size_t iE_) const override;
+	void getSpectrum(const Vector3QLength &pos,
+	                 std::vector<QEnergyDensity> &out) const override;
+
+	/**
+	    Resample the spectra of the energy axis onto a uniform grid of
+	    \p nR radii and \p nZ heights covering the data (0 - 30 kpc
+	    each), in parallel. Afterwards getSpectrum() and
+	    getEnergyDensity(pos, iE) interpolate bilinearly on this grid; the
+	    default uses about 11 MB.
+	*/
+	void resampleUniform(std::size_t nR = 61, std::size_t nZ = 151);
+	bool isResampled() const;
 };
 
 /** @}*/
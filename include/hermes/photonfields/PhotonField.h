@@ -32,6 +32,17 @@ class PhotonField {
 	virtual QEnergyDensity getEnergyDensity(const Vector3QLength &pos,
 	                                        std::size_t iE) const = 0;
 
+	/**
+	    Energy densities at \p pos for the whole energy axis; fields which
+	    can share the spatial lookup between energies override this
+	*/
+	virtual void getSpectrum(const Vector3QLength &pos,
+	                         std::vector<QEnergyDensity> &out) const {
+		out.resize(energyRange.size());
+		for (std::size_t i = 0; i < energyRange.size(); ++i)
+			out[i] = getEnergyDensity(pos, i);
+	}
+
 	void setStartEnergy(QEnergy E_) { startEnergy = E_; }
 
 	void setEndEnergy(QEnergy E_) { endEnergy = E_; }
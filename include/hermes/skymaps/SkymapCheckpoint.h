@@ -0,0 +1,119 @@
+#ifndef HERMES_SKYMAPCHECKPOINT_H
+#define HERMES_SKYMAPCHECKPOINT_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+/**
+ \file SkymapCheckpoint.h
+ \brief Memory-mapped file holding the pixels computed so far by
+ SkymapTemplate::compute()
+ */
+
+namespace hermes {
+/**
+ * \addtogroup Skymaps
+ * @{
+ */
+
+/**
+ \class SkymapCheckpoint
+ \brief A memory-mapped file with the pixel values and a per-pixel
+ completion flag of a skymap being computed.
+
+ The file covers either the whole map or a contiguous range of pixels
+ (RING scheme), which is what a shard of SkymapTemplate::computeShard()
+ writes. Pixels outside of the range are never done.
+
+ Pixels are written straight into the shared mapping, so they survive
+ the termination of the process; the mapping is additionally flushed to
+ disk every \p syncInterval seconds. A checkpoint opened with
+ \p resume = true keeps the pixels of an earlier run if the header
+ (nside, skymap parameter, pixel range) matches, otherwise an exception
+ is thrown.
+ */
+class SkymapCheckpoint {
+  private:
+	struct Header {
+		char magic[8];
+		std::uint32_t version;
+		std::uint32_t pixelSize;
+		std::uint64_t nside;
+		std::uint64_t npix;
+		double parameter;
+		std::uint64_t firstPixel;
+		std::uint64_t nPixels;
+	};
+
+	std::string filename;
+	int fd;
+	void *mapping;
+	std::size_t mappingSize;
+	Header *header;
+	double *values;
+	unsigned char *done;
+
+	double syncInterval;
+	std::atomic<std::int64_t> nextSync;
+
+	static std::int64_t now();
+	void open(std::size_t nside, double parameter, bool resume, std::size_t firstPixel, std::size_t nPixels);
+	void map(int prot);
+	/** Unmaps and closes the file, also after a failed open() */
+	void close();
+
+  public:
+	/**
+	    \param filename     path of the checkpoint file
+	    \param nside        HEALPix nside of the skymap
+	    \param parameter    skymap parameter (e.g., energy) in SI units
+	    \param resume       keep the pixels already present in the file
+	    \param syncInterval seconds between two flushes to disk
+	    \param firstPixel   first pixel covered by the file
+	    \param nPixels      number of pixels covered by the file, by default
+	                        all pixels from \p firstPixel to the end of the map
+	*/
+	SkymapCheckpoint(const std::string &filename, std::size_t nside, double parameter, bool resume = false,
+	                 double syncInterval = 60, std::size_t firstPixel = 0, std::size_t nPixels = std::size_t(-1));
+	/**
+	    Opens an existing file read-only, e.g. to merge the shards of a
+	    skymap; nside, parameter and pixel range are taken from the file
+	    and store() must not be called
+	*/
+	explicit SkymapCheckpoint(const std::string &filename);
+	~SkymapCheckpoint();
+
+	SkymapCheckpoint(const SkymapCheckpoint &) = delete;
+	SkymapCheckpoint &operator=(const SkymapCheckpoint &) = delete;
+
+	std::string getFilename() const { return filename; }
+	std::size_t getNpix() const;
+	std::size_t getNside() const;
+	double getParameter() const;
+	std::size_t getFirstPixel() const;
+	/**
+	    Number of pixels covered by the file
+	*/
+	std::size_t getPixelCount() const;
+	bool isDone(std::size_t ipix) const;
+	double getValue(std::size_t ipix) const;
+	/**
+	    Number of pixels stored so far
+	*/
+	std::size_t getDoneCount() const;
+	/**
+	    Stores the value of a pixel; safe to call concurrently for
+	    different pixels
+	*/
+	void store(std::size_t ipix, double value);
+	/**
+	    Blocks until the mapping is written to disk
+	*/
+	void sync();
+};
+
+/** @}*/
+}  // namespace hermes
+
+#endif  // HERMES_SKYMAPCHECKPOINT_H
@@ -2,7 +2,11 @@
 #define HERMES_SKYMAPMASK_H
 
 #include <array>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include "hermes/HEALPixBits.h"
@@ -10,26 +14,90 @@
 
 namespace hermes {
 
+/**
+ \class SkymapMask
+ \brief Selects the pixels of a skymap to be computed; the base class
+ allows all pixels
+
+ The allowed pixels of an nside are kept as sorted, disjoint ranges of
+ the RING scheme, computed once per nside (in parallel, one HEALPix ring
+ per task) and shared by all skymaps using the mask. Masks with a region
+ query (CircularWindow, RectangularWindow) visit only the pixels near
+ the borders of their region on every ring; other masks derived from
+ SkymapMask evaluate isAllowed() for every pixel. A mask must not change
+ after it has been used, except MaskList::addMask(), which discards the
+ ranges of the list.
+ */
 class SkymapMask {
+  public:
+	/** Sorted, disjoint ranges [first, last) of pixels */
+	typedef std::vector<std::pair<std::size_t, std::size_t>> tPixelRanges;
+
   private:
+	struct RangeCache {
+		std::mutex mtx;
+		std::map<std::size_t, std::shared_ptr<const tPixelRanges>> ranges;
+	};
+
 	std::string description;
+	std::shared_ptr<RangeCache> rangeCache;
 
   protected:
 	QAngle normalizeAngle(QAngle angle) const;
+	/** Discard the cached ranges, e.g., after the mask has changed */
+	void clearPixelRanges();
+
+	/**
+	    Fill \p ranges with the allowed pixels; the default evaluates
+	    isAllowed() for every pixel
+	*/
+	virtual void computePixelRanges(std::size_t nside,
+	                                 tPixelRanges &ranges) const;
+	/**
+	    Appends the allowed pixels of the ring \p iring whose phi lies in
+	    [phiMin, phiMax] (in radian, may extend beyond [0, 2pi)); the arc
+	    has to contain all allowed pixels of the ring it stands for, only
+	    the pixels near its ends are checked with isAllowed()
+	*/
+	void appendRingArc(std::size_t nside, unsigned int iring, double phiMin,
+	                   double phiMax, tPixelRanges &ranges) const;
+	/** Appends the allowed pixels of the ring \p iring, checking each */
+	void appendRingScan(std::size_t nside, unsigned int iring,
+	                    tPixelRanges &ranges) const;
 
   public:
 	SkymapMask();
+	virtual ~SkymapMask() {}
+
 	std::vector<bool> getMask(std::size_t nside);
+	/**
+	    Allowed pixels of \p nside, computed on the first request
+	*/
+	std::shared_ptr<const tPixelRanges> getPixelRanges(std::size_t nside) const;
 	virtual bool isAllowed(const QDirection &dir) const { return true; }
 
 	virtual std::string getDescription() const;
 	void setDescription(const std::string &description);
+
+	/** Appends [first, last) to sorted ranges, merging adjacent ones */
+	static void appendRange(tPixelRanges &ranges, std::size_t first,
+	                        std::size_t last);
+	static std::size_t countPixels(const tPixelRanges &ranges);
+	/** Pixels of [0, npix) not in \p ranges */
+	static tPixelRanges complementRanges(const tPixelRanges &ranges,
+	                                     std::size_t npix);
+	static tPixelRanges intersectRanges(const tPixelRanges &a,
+	                                    const tPixelRanges &b);
 };
 
 class InvertMask : public SkymapMask {
   private:
 	std::shared_ptr<SkymapMask> mask;
 
+  protected:
+	void computePixelRanges(std::size_t nside,
+	                        tPixelRanges &ranges) const override;
+
   public:
 	InvertMask(const std::shared_ptr<SkymapMask> &mask);
 	bool isAllowed(const QDirection &dir) const override;
@@ -39,6 +107,10 @@ class MaskList : public SkymapMask {
   private:
 	std::vector<std::shared_ptr<SkymapMask>> list;
 
+  protected:
+	void computePixelRanges(std::size_t nside,
+	                        tPixelRanges &ranges) const override;
+
   public:
 	MaskList();
 	void addMask(const std::shared_ptr<SkymapMask> &mask);
@@ -51,6 +123,11 @@ class RectangularWindow : public SkymapMask {
 	bool isAngleBetween(QAngle testAngle, const QAngle open,
 	                    QAngle close) const;
 
+  protected:
+	/** Strip query: the rings within the latitudes, an arc on each */
+	void computePixelRanges(std::size_t nside,
+	                        tPixelRanges &ranges) const override;
+
   public:
 	/* In galactic coordinates: b=(-90_deg, 90_deg), l=(0_deg, 360_deg)
 	   Examples:
@@ -67,6 +144,11 @@ class CircularWindow : public SkymapMask {
 	Vector3d v_centre;
 	QAngle aperature;
 
+  protected:
+	/** Disc query: the arc of every ring crossing the disc */
+	void computePixelRanges(std::size_t nside,
+	                        tPixelRanges &ranges) const override;
+
   public:
 	CircularWindow(const QDirection &centre, const QAngle &aperature);
 	bool isAllowed(const QDirection &dir) const override;
@@ -1,17 +1,26 @@
 #ifndef HERMES_SKYMAPTEMP_H
 #define HERMES_SKYMAPTEMP_H
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iterator>
 #include <memory>
 #include <mutex>
+#include <string>
 #include <thread>
+#include <utility>
 #include <vector>
 
 #include "hermes/Common.h"
+#include "hermes/HEALPixBits.h"
 #include "hermes/ProgressBar.h"
 #include "hermes/Signals.h"
+#include "hermes/ThreadPool.h"
 #include "hermes/Units.h"
 #include "hermes/integrators/IntegratorTemplate.h"
 #include "hermes/skymaps/Skymap.h"
+#include "hermes/skymaps/SkymapCheckpoint.h"
 #include "hermes/skymaps/SkymapMask.h"
 
 /**
@@ -52,7 +61,8 @@ class SkymapTemplate : public Skymap {
 
 	typedef std::vector<tPixel> tFluxContainer;
 	mutable tFluxContainer fluxContainer;
-	mutable std::vector<bool> maskContainer;
+	/** Unmasked pixels, shared with all skymaps of the same mask and nside */
+	std::shared_ptr<const SkymapMask::tPixelRanges> maskRanges;
 
 	mutable tPixel defaultOutputUnits;
 	mutable std::string defaultOutputUnitsString;
@@ -64,11 +74,34 @@ class SkymapTemplate : public Skymap {
 	std::shared_ptr<IntegratorTemplate<QPXL, QSTEP>> integrator;
 
 	std::shared_ptr<ProgressBar> progressbar;
-	std::shared_ptr<std::mutex> progressbar_mutex;
+
+	LoadStatistics loadStatistics;
+
+	std::string checkpointFilename;
+	double checkpointInterval = 60;
+
+	std::vector<std::uint64_t> multiOrderUniq;
+	std::vector<QPXL> multiOrderValues;
 
 	void initDefaultOutputUnits(QPXL units, const std::string &unitsString);
 	void initContainer();
 	void initMask();
+	void computePixels(const std::vector<std::size_t> &pixels,
+	                   SkymapCheckpoint *checkpoint, const std::string &title);
+	/**
+	    Sets the masked pixels of [first, last) to UNSEEN and calls f(ipix)
+	    for the unmasked ones, walking the ranges of the mask
+	*/
+	template <typename F>
+	void forEachUnmaskedPixel(std::size_t first, std::size_t last, F f);
+	/**
+	    Hands the shared lines of sight of the pixels (see getRayTable())
+	    to the integrator
+	*/
+	void attachRayTable() const {
+		integrator->setRayTable(
+		    getRayTable(nside, integrator->getObsPosition()));
+	}
 
   public:
 	SkymapTemplate(std::size_t nside, const SkymapDefinitions &s);
@@ -123,6 +156,12 @@ class SkymapTemplate : public Skymap {
 	void printPixels() const;
 	void setMask(std::shared_ptr<SkymapMask> mask_);
 	std::vector<bool> getMask() const;
+	/**
+	    Unmasked pixels as sorted ranges [first, last) of the RING scheme
+	*/
+	const SkymapMask::tPixelRanges &getUnmaskedRanges() const {
+		return *maskRanges;
+	}
 	inline bool isMasked(std::size_t pixel) const;
 
 	virtual void computePixel(
@@ -131,7 +170,88 @@ class SkymapTemplate : public Skymap {
 	void computePixelRange(
 	    std::vector<std::size_t> chunk,
 	    const std::shared_ptr<IntegratorTemplate<QPXL, QSTEP>> &integrator_);
-	void compute();
+	/**
+	    Computes all unmasked pixels in parallel. SIGINT/SIGTERM stop the
+	    computation after the pixels in progress; the signal is then passed
+	    on to the previous handler. With \p resume, pixels already computed
+	    (read from the checkpoint file if one is set, otherwise the pixels
+	    of an earlier, interrupted call) are skipped.
+	*/
+	void compute(bool resume = false);
+	/**
+	    Store every computed pixel in a memory-mapped checkpoint file,
+	    flushed to disk every \p syncInterval seconds; an empty filename
+	    disables checkpointing
+	*/
+	void setCheckpointFile(const std::string &filename, double syncInterval = 60);
+	std::string getCheckpointFile() const { return checkpointFilename; }
+	/**
+	    Pixel range [first, last) of the shard \p k of \p nShards in the
+	    RING scheme. The ranges are contiguous and balanced by the
+	    estimated cost of the unmasked pixels
+	    (IntegratorTemplate::getLOSCostEstimate()) rather than by the
+	    number of pixels; every process computes the same ranges.
+	*/
+	std::pair<std::size_t, std::size_t> getShardRange(std::size_t k,
+	                                                  std::size_t nShards) const;
+	/**
+	    Computes only the unmasked pixels of the shard \p k of \p nShards
+	    (see getShardRange()) and stores them in the partial map file
+	    \p filename, a SkymapCheckpoint of the shard range flushed every
+	    syncInterval of setCheckpointFile(). Independent processes, e.g.
+	    the jobs of a batch array, compute one shard each; with \p resume
+	    an interrupted shard continues from its file. The shards are
+	    combined by mergeShards().
+	*/
+	void computeShard(std::size_t k, std::size_t nShards,
+	                  const std::string &filename, bool resume = false);
+	/**
+	    Fills the skymap from the partial map files of computeShard(),
+	    written for the same nside and skymap parameter; the merged map
+	    is then saved as usual with save(). Throws if an unmasked pixel
+	    is missing from all shards.
+	*/
+	void mergeShards(const std::vector<std::string> &filenames);
+	/**
+	    Computes several skymaps (e.g., of a SkymapRange) in a single pass
+	    over the sky: every LOS is integrated once for all skymap parameters
+	    with IntegratorTemplate::integrateOverLOS(dir, params). Returns false,
+	    without computing anything, if the maps do not share the integrator,
+	    nside and mask or if the integrator uses a cache table (which holds
+	    a single parameter only); compute each map separately then.
+	*/
+	template <typename SKYMAP>
+	static bool computeRange(std::vector<SKYMAP> &skymaps);
+	/**
+	    Adaptive alternative to compute(): every unmasked pixel is computed
+	    at \p coarseNside, then each pixel is compared with its 4 children
+	    in the NESTED scheme (which are computed as well); where a child
+	    deviates from its parent by more than \p tolerance (relative), the
+	    children are refined in the same way, down to the nside of the
+	    skymap. The skymap is filled with the value of the finest computed
+	    ancestor of every pixel (nearest-neighbour upsampling); the computed
+	    leaves are available as a multi-order map, see getMultiOrderUniq().
+	    Both nside values have to be powers of 2; checkpoints are not used.
+	    Returns the number of integrated lines of sight.
+	*/
+	std::size_t computeAdaptive(std::size_t coarseNside, double tolerance);
+	/**
+	    Leaves of the last computeAdaptive() run in the NUNIQ scheme of
+	    multi-order coverage maps (uniq = 4 * nside^2 + ipix_nest)
+	*/
+	const std::vector<std::uint64_t> &getMultiOrderUniq() const {
+		return multiOrderUniq;
+	}
+	/**
+	    Values of the leaves, in the order of getMultiOrderUniq()
+	*/
+	const std::vector<QPXL> &getMultiOrderValues() const {
+		return multiOrderValues;
+	}
+	/**
+	    Load-balancing statistics of the last compute() run
+	*/
+	LoadStatistics getLoadStatistics() const { return loadStatistics; }
 
 	/** output **/
 	void convertToUnits(QPXL units_, const std::string &defaultUnitsString);
@@ -191,7 +311,26 @@ void SkymapTemplate<QPXL, QSTEP>::initContainer() {
 template <typename QPXL, typename QSTEP>
 void SkymapTemplate<QPXL, QSTEP>::initMask() {
 	if (mask == nullptr) mask = std::make_shared<SkymapMask>(SkymapMask());
-	maskContainer = mask->getMask(nside);
+	maskRanges = mask->getPixelRanges(nside);
+}
+
+template <typename QPXL, typename QSTEP>
+template <typename F>
+void SkymapTemplate<QPXL, QSTEP>::forEachUnmaskedPixel(std::size_t first,
+                                                       std::size_t last, F f) {
+	std::size_t next = first;
+	for (const auto &r : *maskRanges) {
+		if (r.second <= first) continue;
+		if (r.first >= last) break;
+		const std::size_t begin = std::max(r.first, first);
+		const std::size_t end = std::min(r.second, last);
+		std::fill(fluxContainer.begin() + next, fluxContainer.begin() + begin,
+		          QPXL(UNSEEN));
+		for (std::size_t ipix = begin; ipix < end; ++ipix) f(ipix);
+		next = end;
+	}
+	std::fill(fluxContainer.begin() + next, fluxContainer.begin() + last,
+	          QPXL(UNSEEN));
 }
 
 /* Getters */
@@ -202,7 +341,7 @@ std::size_t SkymapTemplate<QPXL, QSTEP>::size() const {
 
 template <typename QPXL, typename QSTEP>
 std::size_t SkymapTemplate<QPXL, QSTEP>::getUnmaskedPixelCount() const {
-	return std::count(maskContainer.begin(), maskContainer.end(), true);
+	return SkymapMask::countPixels(*maskRanges);
 }
 
 template <typename QPXL, typename QSTEP>
@@ -271,46 +410,395 @@ void SkymapTemplate<QPXL, QSTEP>::computePixelRange(
 }
 
 template <typename QPXL, typename QSTEP>
-void SkymapTemplate<QPXL, QSTEP>::compute() {
-	std::cout << "hermes::Integrator: Number of Threads: " << getThreadsNumber()
+void SkymapTemplate<QPXL, QSTEP>::setCheckpointFile(const std::string &filename,
+                                                    double syncInterval) {
+	checkpointFilename = filename;
+	checkpointInterval = syncInterval;
+}
+
+template <typename QPXL, typename QSTEP>
+void SkymapTemplate<QPXL, QSTEP>::compute(bool resume) {
+	auto pool = getThreadPool();
+	std::cout << "hermes::Integrator: Number of Threads: " << pool->size()
 	          << std::endl;
 
 	if (integrator == nullptr)
 		throw std::runtime_error(
 		    "Provide an integrator with Skymap::setIntegrator()");
 
+	std::unique_ptr<SkymapCheckpoint> checkpoint;
+	if (!checkpointFilename.empty())
+		checkpoint = std::make_unique<SkymapCheckpoint>(
+		    checkpointFilename, nside, static_cast<double>(skymapParameter),
+		    resume, checkpointInterval);
+
+	std::vector<std::size_t> validPixels;
+	forEachUnmaskedPixel(0, npix, [&](std::size_t ipxl) {
+		if (resume && checkpoint != nullptr && checkpoint->isDone(ipxl)) {
+			fluxContainer[ipxl] = QPXL(checkpoint->getValue(ipxl));
+			return;
+		}
+		if (resume && checkpoint == nullptr &&
+		    fluxContainer[ipxl] != QPXL(UNSEEN))
+			return;
+		validPixels.push_back(ipxl);
+	});
+
+	computePixels(validPixels, checkpoint.get(), "Compute skymap");
+}
+
+template <typename QPXL, typename QSTEP>
+void SkymapTemplate<QPXL, QSTEP>::computePixels(
+    const std::vector<std::size_t> &pixels, SkymapCheckpoint *checkpoint,
+    const std::string &title) {
+	if (pixels.empty()) return;
+	attachRayTable();
+
 	// Generate cache tables in integrator for a given skymap parameter
+	integrator->prepareSkymapParameters({skymapParameter});
 	if (integrator->isCacheTableEnabled()) {
 		integrator->setSkymapParameter(skymapParameter);
 		integrator->initCacheTable();
 	}
 
 	// Progressbar init
-	progressbar =
-	    std::make_shared<ProgressBar>(ProgressBar(getUnmaskedPixelCount()));
-	progressbar_mutex = std::make_shared<std::mutex>();
-	progressbar->setMutex(progressbar_mutex);
-	progressbar->start("Compute skymap");
-
-    std::vector<std::size_t> validPixels;
-    for (std::size_t ipxl = 0; ipxl < fluxContainer.size(); ++ipxl) {
-        if (!isMasked(ipxl)) {
-            validPixels.push_back(ipxl);
-        } else {
-            fluxContainer[ipxl] = QPXL(UNSEEN);
-        }
-    }
-            
-    auto job_chunks = getIndexedThreadChunks(validPixels);
-	std::vector<std::thread> threads;
-	for (auto &chunk : job_chunks) {
-		threads.push_back(
-		    std::thread(&SkymapTemplate<QPXL, QSTEP>::computePixelRange, this,
-		                chunk, integrator));
+	progressbar = std::make_shared<ProgressBar>(pixels.size());
+	progressbar->start(title);
+	ProgressBarGuard progressbarGuard(progressbar);
+
+	// pixels are handed out dynamically (grain = 1), because the cost of
+	// a LOS varies by orders of magnitude across the sky
+	auto pool = getThreadPool();
+	CancelSignalGuard signalGuard;
+	const auto integrator_ = integrator;
+	loadStatistics = pool->parallelFor(
+	    pixels.size(),
+	    [&](std::size_t i) {
+		    if (signalGuard.isCancelled()) return;
+		    const std::size_t ipix = pixels[i];
+		    computePixel(ipix, integrator_);
+		    if (checkpoint != nullptr)
+			    checkpoint->store(ipix, static_cast<double>(fluxContainer[ipix]));
+		    progressbar->update();
+	    },
+	    1);
+
+	progressbar->stop();
+	std::cout << "hermes::Skymap: " << loadStatistics << std::endl;
+
+	if (checkpoint != nullptr) checkpoint->sync();
+	if (signalGuard.isCancelled()) {
+		std::cerr << "hermes::Skymap: computation interrupted";
+		if (checkpoint != nullptr)
+			std::cerr << ", " << checkpoint->getDoneCount()
+			          << " pixels stored in " << checkpoint->getFilename();
+		std::cerr << std::endl;
+		signalGuard.raisePending();
 	}
-	for (auto &t : threads) {
-		t.join();
+}
+
+template <typename QPXL, typename QSTEP>
+std::pair<std::size_t, std::size_t> SkymapTemplate<QPXL, QSTEP>::getShardRange(
+    std::size_t k, std::size_t nShards) const {
+	if (integrator == nullptr)
+		throw std::runtime_error(
+		    "Provide an integrator with Skymap::setIntegrator()");
+	if (k >= nShards)
+		throw std::runtime_error(
+		    "hermes::Skymap: the shard index has to be smaller than the "
+		    "number of shards");
+
+	// the costs are summed in fixed blocks of pixels, so that the sums,
+	// and hence the ranges, do not depend on the number of threads
+	const std::size_t blockSize = 4096;
+	const std::size_t nBlocks = (npix + blockSize - 1) / blockSize;
+	attachRayTable();
+	auto cost = [&](std::size_t ipix) {
+		return isMasked(ipix) ? 0.
+		                      : integrator->getLOSCostEstimate(
+		                            pix2ang_ring(nside, ipix));
+	};
+	std::vector<double> blockCost(nBlocks, 0);
+	getThreadPool()->parallelFor(nBlocks, [&](std::size_t b) {
+		for (std::size_t i = b * blockSize; i < std::min(npix, (b + 1) * blockSize);
+		     ++i)
+			blockCost[b] += cost(i);
+	});
+	double total = 0;
+	for (auto c : blockCost) total += c;
+
+	// first pixel whose preceding pixels cost at least j / nShards of all
+	auto boundary = [&](std::size_t j) -> std::size_t {
+		if (j == 0) return 0;
+		if (j == nShards) return npix;
+		const double target = total * j / nShards;
+		double sum = 0;
+		std::size_t b = 0;
+		for (; b < nBlocks && sum + blockCost[b] < target; ++b)
+			sum += blockCost[b];
+		std::size_t i = b * blockSize;
+		for (; i < npix && sum < target; ++i) sum += cost(i);
+		return i;
+	};
+
+	return std::make_pair(boundary(k), boundary(k + 1));
+}
+
+template <typename QPXL, typename QSTEP>
+void SkymapTemplate<QPXL, QSTEP>::computeShard(std::size_t k,
+                                               std::size_t nShards,
+                                               const std::string &filename,
+                                               bool resume) {
+	std::cout << "hermes::Integrator: Number of Threads: "
+	          << getThreadPool()->size() << std::endl;
+
+	const auto range = getShardRange(k, nShards);
+	SkymapCheckpoint shard(filename, nside, static_cast<double>(skymapParameter),
+	                       resume, checkpointInterval, range.first,
+	                       range.second - range.first);
+
+	std::fill(fluxContainer.begin(), fluxContainer.end(), QPXL(UNSEEN));
+	std::vector<std::size_t> validPixels;
+	forEachUnmaskedPixel(range.first, range.second, [&](std::size_t ipxl) {
+		if (shard.isDone(ipxl)) {
+			fluxContainer[ipxl] = QPXL(shard.getValue(ipxl));
+			return;
+		}
+		validPixels.push_back(ipxl);
+	});
+
+	computePixels(validPixels, &shard,
+	              "Compute skymap shard " + std::to_string(k + 1) + "/" +
+	                  std::to_string(nShards));
+}
+
+template <typename QPXL, typename QSTEP>
+void SkymapTemplate<QPXL, QSTEP>::mergeShards(
+    const std::vector<std::string> &filenames) {
+	std::vector<bool> covered(npix, false);
+	for (const auto &filename : filenames) {
+		SkymapCheckpoint shard(filename);
+		if (shard.getNside() != nside ||
+		    shard.getParameter() != static_cast<double>(skymapParameter))
+			throw std::runtime_error("hermes::Skymap: " + filename +
+			                         " is a shard of another skymap");
+		const std::size_t last = shard.getFirstPixel() + shard.getPixelCount();
+		for (std::size_t ipxl = shard.getFirstPixel(); ipxl < last; ++ipxl) {
+			if (!shard.isDone(ipxl)) continue;
+			fluxContainer[ipxl] = QPXL(shard.getValue(ipxl));
+			covered[ipxl] = true;
+		}
+	}
+
+	std::size_t missing = 0;
+	for (std::size_t ipxl = 0; ipxl < npix; ++ipxl) {
+		if (isMasked(ipxl)) {
+			fluxContainer[ipxl] = QPXL(UNSEEN);
+		} else if (!covered[ipxl]) {
+			fluxContainer[ipxl] = QPXL(UNSEEN);
+			++missing;
+		}
+	}
+	if (missing > 0)
+		throw std::runtime_error("hermes::Skymap: " + std::to_string(missing) +
+		                         " unmasked pixels are missing from the shards");
+}
+
+template <typename QPXL, typename QSTEP>
+std::size_t SkymapTemplate<QPXL, QSTEP>::computeAdaptive(
+    std::size_t coarseNside, double tolerance) {
+	if (integrator == nullptr)
+		throw std::runtime_error(
+		    "Provide an integrator with Skymap::setIntegrator()");
+	if (coarseNside == 0 || (coarseNside & (coarseNside - 1)) != 0 ||
+	    (nside & (nside - 1)) != 0 || coarseNside > nside)
+		throw std::runtime_error(
+		    "hermes::Skymap: computeAdaptive() requires coarseNside <= nside, "
+		    "both powers of 2");
+
+	auto pool = getThreadPool();
+	std::cout << "hermes::Integrator: Number of Threads: " << pool->size()
+	          << std::endl;
+
+	const unsigned int coarseOrder = log2(coarseNside);
+	const unsigned int targetOrder = log2(nside);
+
+	// unmasked[l][p]: the pixel p of order coarseOrder + l has an unmasked
+	// descendant at the nside of the skymap
+	std::vector<std::vector<bool>> unmasked(targetOrder - coarseOrder + 1);
+	unmasked.back().resize(npix);
+	for (std::size_t n = 0; n < npix; ++n)
+		unmasked.back()[n] = !isMasked(nest2ring(nside, n));
+	for (std::size_t l = unmasked.size() - 1; l > 0; --l) {
+		unmasked[l - 1].resize(unmasked[l].size() / 4);
+		for (std::size_t p = 0; p < unmasked[l - 1].size(); ++p)
+			unmasked[l - 1][p] = unmasked[l][4 * p] || unmasked[l][4 * p + 1] ||
+			                     unmasked[l][4 * p + 2] || unmasked[l][4 * p + 3];
 	}
+
+	// the coarser pixels are not in the table and get their own rays
+	attachRayTable();
+	integrator->prepareSkymapParameters({skymapParameter});
+	if (integrator->isCacheTableEnabled()) {
+		integrator->setSkymapParameter(skymapParameter);
+		integrator->initCacheTable();
+	}
+
+	std::fill(fluxContainer.begin(), fluxContainer.end(), QPXL(UNSEEN));
+	multiOrderUniq.clear();
+	multiOrderValues.clear();
+
+	CancelSignalGuard signalGuard;
+	const auto integrator_ = integrator;
+	std::size_t evaluations = 0;
+
+	// nested pixels of one order, integrated in parallel
+	auto evaluate = [&](unsigned int order,
+	                    const std::vector<std::size_t> &pixels) {
+		std::vector<QPXL> values(pixels.size(), QPXL(UNSEEN));
+		const unsigned int nside_ = 1u << order;
+		pool->parallelFor(
+		    pixels.size(),
+		    [&](std::size_t i) {
+			    if (signalGuard.isCancelled()) return;
+			    values[i] =
+			        integrator_->integrateOverLOS(pix2ang_nest(nside_, pixels[i]));
+		    },
+		    1);
+		evaluations += pixels.size();
+		return values;
+	};
+
+	// a leaf sets all its unmasked descendants at the nside of the skymap
+	auto addLeaf = [&](unsigned int order, std::size_t p, QPXL value) {
+		multiOrderUniq.push_back((std::uint64_t(4) << (2 * order)) + p);
+		multiOrderValues.push_back(value);
+		const unsigned int shift = 2 * (targetOrder - order);
+		for (std::size_t n = p << shift; n < (p + 1) << shift; ++n) {
+			const std::size_t ipix = nest2ring(nside, n);
+			if (!isMasked(ipix)) fluxContainer[ipix] = value;
+		}
+	};
+
+	std::vector<std::size_t> candidates;
+	for (std::size_t p = 0; p < unmasked.front().size(); ++p)
+		if (unmasked.front()[p]) candidates.push_back(p);
+	std::vector<QPXL> values = evaluate(coarseOrder, candidates);
+
+	if (coarseOrder == targetOrder && !signalGuard.isCancelled())
+		for (std::size_t i = 0; i < candidates.size(); ++i)
+			addLeaf(coarseOrder, candidates[i], values[i]);
+
+	for (unsigned int order = coarseOrder; order < targetOrder; ++order) {
+		if (candidates.empty() || signalGuard.isCancelled()) break;
+		const std::vector<bool> &childUnmasked = unmasked[order + 1 - coarseOrder];
+
+		std::vector<std::size_t> children;
+		for (auto p : candidates)
+			for (std::size_t c = 4 * p; c < 4 * p + 4; ++c)
+				if (childUnmasked[c]) children.push_back(c);
+		std::vector<QPXL> childValues = evaluate(order + 1, children);
+		if (signalGuard.isCancelled()) break;
+
+		std::vector<std::size_t> next;
+		std::vector<QPXL> nextValues;
+		for (std::size_t i = 0, j = 0; i < candidates.size(); ++i) {
+			const std::size_t first = j;
+			const double parent = static_cast<double>(values[i]);
+			bool smooth = true;
+			for (; j < children.size() && children[j] / 4 == candidates[i]; ++j)
+				smooth = smooth && std::fabs(static_cast<double>(childValues[j]) -
+				                             parent) <= tolerance * std::fabs(parent);
+			for (std::size_t k = first; k < j; ++k) {
+				if (smooth || order + 1 == targetOrder) {
+					addLeaf(order + 1, children[k], childValues[k]);
+				} else {
+					next.push_back(children[k]);
+					nextValues.push_back(childValues[k]);
+				}
+			}
+		}
+		candidates.swap(next);
+		values.swap(nextValues);
+	}
+
+	std::cout << "hermes::Skymap: adaptive computation integrated "
+	          << evaluations << " lines of sight for "
+	          << getUnmaskedPixelCount() << " pixels" << std::endl;
+
+	if (signalGuard.isCancelled()) {
+		std::cerr << "hermes::Skymap: computation interrupted" << std::endl;
+		signalGuard.raisePending();
+	}
+
+	return evaluations;
+}
+
+template <typename QPXL, typename QSTEP>
+template <typename SKYMAP>
+bool SkymapTemplate<QPXL, QSTEP>::computeRange(std::vector<SKYMAP> &skymaps) {
+	if (skymaps.empty()) return true;
+
+	SkymapTemplate<QPXL, QSTEP> &first = skymaps.front();
+	const auto integrator_ = first.integrator;
+	if (integrator_ == nullptr)
+		throw std::runtime_error(
+		    "Provide an integrator with Skymap::setIntegrator()");
+	if (integrator_->isCacheTableEnabled()) return false;
+
+	std::vector<QSTEP> params;
+	for (SkymapTemplate<QPXL, QSTEP> &map : skymaps) {
+		if (map.integrator != integrator_ || map.nside != first.nside ||
+		    (map.maskRanges != first.maskRanges &&
+		     *map.maskRanges != *first.maskRanges))
+			return false;
+		params.push_back(map.skymapParameter);
+	}
+	first.attachRayTable();
+	integrator_->prepareSkymapParameters(params);
+
+	auto pool = getThreadPool();
+	std::cout << "hermes::Integrator: Number of Threads: " << pool->size()
+	          << std::endl;
+
+	auto progressbar_ =
+	    std::make_shared<ProgressBar>(first.getUnmaskedPixelCount());
+	progressbar_->start("Compute " + std::to_string(params.size()) +
+	                    " skymaps in one pass");
+	ProgressBarGuard progressbarGuard(progressbar_);
+
+	std::vector<std::size_t> validPixels;
+	for (SkymapTemplate<QPXL, QSTEP> &map : skymaps)
+		map.forEachUnmaskedPixel(0, first.npix, [](std::size_t) {});
+	for (const auto &r : *first.maskRanges)
+		for (std::size_t ipxl = r.first; ipxl < r.second; ++ipxl)
+			validPixels.push_back(ipxl);
+
+	CancelSignalGuard signalGuard;
+	auto stats = pool->parallelFor(
+	    validPixels.size(),
+	    [&](std::size_t i) {
+		    if (signalGuard.isCancelled()) return;
+		    const std::size_t ipix = validPixels[i];
+		    auto values = integrator_->integrateOverLOS(
+		        pix2ang_ring(first.nside, ipix), params);
+		    for (std::size_t k = 0; k < skymaps.size(); ++k)
+			    static_cast<SkymapTemplate<QPXL, QSTEP> &>(skymaps[k])
+			        .fluxContainer[ipix] = values[k];
+		    progressbar_->update();
+	    },
+	    1);
+
+	progressbar_->stop();
+	std::cout << "hermes::Skymap: " << stats << std::endl;
+	for (SkymapTemplate<QPXL, QSTEP> &map : skymaps) map.loadStatistics = stats;
+
+	if (signalGuard.isCancelled()) {
+		std::cerr << "hermes::Skymap: computation interrupted" << std::endl;
+		signalGuard.raisePending();
+	}
+
+	return true;
 }
 
 template <typename QPXL, typename QSTEP>
@@ -387,12 +875,23 @@ void SkymapTemplate<QPXL, QSTEP>::setMask(std::shared_ptr<SkymapMask> mask_) {
 
 template <typename QPXL, typename QSTEP>
 std::vector<bool> SkymapTemplate<QPXL, QSTEP>::getMask() const {
+	std::vector<bool> maskContainer(npix, false);
+	for (const auto &r : *maskRanges)
+		std::fill(maskContainer.begin() + r.first,
+		          maskContainer.begin() + r.second, true);
 	return maskContainer;
 }
 
 template <typename QPXL, typename QSTEP>
 inline bool SkymapTemplate<QPXL, QSTEP>::isMasked(std::size_t ipix) const {
-	return (maskContainer[ipix] == false);
+	// the last range starting at or before ipix
+	const auto &ranges = *maskRanges;
+	auto it = std::upper_bound(
+	    ranges.begin(), ranges.end(), ipix,
+	    [](std::size_t p, const std::pair<std::size_t, std::size_t> &r) {
+		    return p < r.first;
+	    });
+	return it == ranges.begin() || ipix >= std::prev(it)->second;
 }
 
 template <typename QPXL, typename QSTEP>
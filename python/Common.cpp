@@ -1,6 +1,10 @@
 #include "hermes/Common.h"
 #include "hermes/Version.h"
 #include "hermes/HEALPixBits.h"
+#include "hermes/LookupGrid.h"
+#include "hermes/MemoryPlacement.h"
+#include "hermes/ProgressBar.h"
+#include "hermes/ThreadPool.h"
 
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
@@ -24,6 +28,37 @@ void init_common(py::module &m) {
 	m.def("nside2npix", &nside2npix);
 	m.def("nside2order", &nside2order);
 	m.def("loc2pix", &loc2pix);
+	m.def("nest2ring", &nest2ring);
+	m.def("ring2nest", &ring2nest);
+	m.def("pix2ang_nest", &pix2ang_nest);
+
+	py::class_<LoadStatistics>(m, "LoadStatistics")
+	    .def_readonly("wallTime", &LoadStatistics::wallTime)
+	    .def_readonly("busyTime", &LoadStatistics::busyTime)
+	    .def_readonly("tasks", &LoadStatistics::tasks)
+	    .def_readonly("steals", &LoadStatistics::steals)
+	    .def("getTotalTasks", &LoadStatistics::getTotalTasks)
+	    .def("getTotalSteals", &LoadStatistics::getTotalSteals)
+	    .def("getImbalance", &LoadStatistics::getImbalance)
+	    .def("getEfficiency", &LoadStatistics::getEfficiency);
+
+	m.def("getThreadPinning", &getThreadPinning);
+	m.def("setThreadPinning", &setThreadPinning);
+	m.def("getHugePages", &getHugePages);
+	m.def("setHugePages", &setHugePages);
+	m.def("getNumaInterleave", &getNumaInterleave);
+	m.def("setNumaInterleave", &setNumaInterleave);
+	m.def("getProgressMetricsFile", &getProgressMetricsFile);
+	m.def("setProgressMetricsFile", &setProgressMetricsFile);
+
+	m.def("uniformAxis", &uniformAxis);
+	m.def("sinhAxis", &sinhAxis);
+	py::class_<LookupGridAccuracy>(m, "LookupGridAccuracy")
+	    .def_readonly("nSamples", &LookupGridAccuracy::nSamples)
+	    .def_readonly("maxError", &LookupGridAccuracy::maxError)
+	    .def_readonly("rmsError", &LookupGridAccuracy::rmsError)
+	    .def_readonly("rmsValue", &LookupGridAccuracy::rmsValue)
+	    .def("getRelativeError", &LookupGridAccuracy::getRelativeError);
 
     m.attr("__version__") = std::string(g_GIT_DESC);
 }
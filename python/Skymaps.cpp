@@ -40,9 +40,22 @@ void declare_default_skymap_methods(py::class_<SKYMAP> c) {
 	      [](SKYMAP &s, const std::shared_ptr<IntegratorClass> &i) {
 		      s.setIntegrator(i);
 	      });
-	c.def("compute", &SKYMAP::compute);
+	c.def("compute", &SKYMAP::compute, py::arg("resume") = false);
+	c.def("setCheckpointFile", &SKYMAP::setCheckpointFile, py::arg("filename"),
+	      py::arg("syncInterval") = 60);
+	c.def("getCheckpointFile", &SKYMAP::getCheckpointFile);
+	c.def("getShardRange", &SKYMAP::getShardRange, py::arg("k"),
+	      py::arg("nShards"));
+	c.def("computeShard", &SKYMAP::computeShard, py::arg("k"),
+	      py::arg("nShards"), py::arg("filename"), py::arg("resume") = false);
+	c.def("mergeShards", &SKYMAP::mergeShards, py::arg("filenames"));
+	c.def("computeAdaptive", &SKYMAP::computeAdaptive, py::arg("coarseNside"),
+	      py::arg("tolerance"));
+	c.def("getMultiOrderUniq", &SKYMAP::getMultiOrderUniq);
+	c.def("getMultiOrderValues", &SKYMAP::getMultiOrderValues);
 	c.def("computePixel", &SKYMAP::computePixel);
 	c.def("computePixelRange", &SKYMAP::computePixelRange);
+	c.def("getLoadStatistics", &SKYMAP::getLoadStatistics);
 	c.def("getPixel", &SKYMAP::getPixel);
 	c.def("getMean", &SKYMAP::getMean);
 	c.def("hasMask", &SKYMAP::hasMask);
@@ -140,8 +153,14 @@ void init_skymaps(py::module &m) {
 	            1>() /* Essential: keep object alive while iterator exists */);
 
 	// Skymap Masks
-	// NOLINTNEXTLINE(bugprone-unused-raii)
-	py::class_<SkymapMask, std::shared_ptr<SkymapMask>>(m, "SkymapMask");
+	py::class_<SkymapMask, std::shared_ptr<SkymapMask>>(m, "SkymapMask")
+	    .def("getMask", &SkymapMask::getMask, py::arg("nside"))
+	    .def(
+	        "getPixelRanges",
+	        [](const SkymapMask &mask, std::size_t nside) {
+		        return *mask.getPixelRanges(nside);
+	        },
+	        py::arg("nside"));
 	py::class_<InvertMask, std::shared_ptr<InvertMask>, SkymapMask>(
 	    m, "InvertMask")
 	    .def(py::init<const std::shared_ptr<SkymapMask>>(), py::arg("mask"));
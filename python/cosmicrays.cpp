@@ -21,6 +21,12 @@ void init(py::module &m) {
 	py::class_<CosmicRayDensity, std::shared_ptr<CosmicRayDensity>>(
 	    subm, "CosmicRayDensity")
 	    .def("getDensityPerEnergy", &CosmicRayDensity::getDensityPerEnergy)
+	    .def("getDensitySpectrum",
+	         [](const CosmicRayDensity &cr, const Vector3QLength &pos) {
+		         std::vector<QPDensityPerEnergy> spectrum;
+		         cr.getDensitySpectrum(pos, spectrum);
+		         return spectrum;
+	         })
 	    .def("getEnergyAxis", &CosmicRayDensity::getEnergyAxis);
 	py::class_<DummyCR, std::shared_ptr<DummyCR>,
 	           CosmicRayDensity>(subm, "DummyCR")
@@ -2,14 +2,19 @@
 #include <pybind11/stl.h>
 
 #include "hermes/integrators/BremsstrahlungIntegrator.h"
+#include "hermes/integrators/CacheTableStore.h"
 #include "hermes/integrators/DarkMatterIntegrator.h"
 #include "hermes/integrators/DispersionMeasureIntegrator.h"
 #include "hermes/integrators/FreeFreeIntegrator.h"
 #include "hermes/integrators/IntegratorTemplate.h"
 #include "hermes/integrators/InverseComptonIntegrator.h"
 #include "hermes/integrators/LOSIntegrationMethods.h"
+#include "hermes/integrators/LOSSampleStore.h"
+#include "hermes/integrators/OpacityGrid.h"
+#include "hermes/integrators/OpacityTable.h"
 #include "hermes/integrators/PiZeroAbsorptionIntegrator.h"
 #include "hermes/integrators/PiZeroIntegrator.h"
+#include "hermes/integrators/RayTable.h"
 #include "hermes/integrators/RotationMeasureIntegrator.h"
 #include "hermes/integrators/SynchroAbsorptionIntegrator.h"
 #include "hermes/integrators/SynchroIntegrator.h"
@@ -32,25 +37,89 @@ void declare_default_integrator_methods(py::class_<INTEGRATOR> c) {
 	c.def("getObsPosition", &INTEGRATOR::getObsPosition);
 	c.def("setObsPosition", &INTEGRATOR::setObsPosition);
 	c.def("setupCacheTable", &INTEGRATOR::setupCacheTable);
+	c.def("setRayTable",
+	      [](INTEGRATOR &i, const std::shared_ptr<RayTable> &table) { i.setRayTable(table); });
+	c.def("getRayTable", [](const INTEGRATOR &i) { return std::const_pointer_cast<RayTable>(i.getRayTable()); });
 }
 
 void init_integrators(py::module &m) {
+	// LOSSampleStore
+	py::class_<LOSSampleStore, std::shared_ptr<LOSSampleStore>>(m, "LOSSampleStore")
+	    .def(py::init<const Vector3QLength &, int, std::size_t>(), py::arg("observerPosition"),
+	         py::arg("nIntervals") = 500, py::arg("memoryBudget") = std::size_t(1) << 30)
+	    .def("setMagneticField", &LOSSampleStore::setMagneticField)
+	    .def("setIonizedGasDensity", &LOSSampleStore::setIonizedGasDensity)
+	    .def("setCosmicRayDensity", &LOSSampleStore::setCosmicRayDensity)
+	    .def("getObsPosition", &LOSSampleStore::getObsPosition)
+	    .def("getNumberOfIntervals", &LOSSampleStore::getNumberOfIntervals)
+	    .def("setMemoryBudget", &LOSSampleStore::setMemoryBudget)
+	    .def("getMemoryBudget", &LOSSampleStore::getMemoryBudget)
+	    .def("getMemoryUsage", &LOSSampleStore::getMemoryUsage)
+	    .def("getNumberOfEntries", &LOSSampleStore::getNumberOfEntries)
+	    .def("getHits", &LOSSampleStore::getHits)
+	    .def("getMisses", &LOSSampleStore::getMisses)
+	    .def("getEvictions", &LOSSampleStore::getEvictions)
+	    .def("clear", &LOSSampleStore::clear);
+
+	// RayTable
+	py::class_<RayTable, std::shared_ptr<RayTable>>(m, "RayTable")
+	    .def("getNside", &RayTable::getNside)
+	    .def("getObsPosition", &RayTable::getObsPosition)
+	    .def("size", &RayTable::size)
+	    .def("getMemoryUsage", &RayTable::getMemoryUsage)
+	    .def("getDirection", &RayTable::getDirection);
+	m.def("getRayTable", [](std::size_t nside, const Vector3QLength &observerPosition) {
+		return std::const_pointer_cast<RayTable>(getRayTable(nside, observerPosition));
+	});
+
+	// OpacityGrid
+	py::class_<OpacityGrid, std::shared_ptr<OpacityGrid>>(m, "OpacityGrid")
+	    .def(py::init<const std::shared_ptr<photonfields::PhotonField> &, const std::string &>(), py::arg("field"),
+	         py::arg("cacheTag") = "")
+	    .def(py::init<const std::shared_ptr<photonfields::PhotonField> &, const std::vector<QLength> &,
+	                  const std::vector<QLength> &, const QEnergy &, const QEnergy &, std::size_t, const std::string &>(),
+	         py::arg("field"), py::arg("r"), py::arg("z"), py::arg("Emin"), py::arg("Emax"), py::arg("nE"),
+	         py::arg("cacheTag") = "")
+	    .def("getRAxis", &OpacityGrid::getRAxis)
+	    .def("getZAxis", &OpacityGrid::getZAxis)
+	    .def("getEnergyAxis", &OpacityGrid::getEnergyAxis)
+	    .def("getAbsorptionCoefficient", &OpacityGrid::getAbsorptionCoefficient);
+
+	// CacheTableStore
+	py::class_<CacheTableStore>(m, "CacheTableStore")
+	    .def("isEnabled", &CacheTableStore::isEnabled)
+	    .def("getEnergies", &CacheTableStore::getEnergies)
+	    .def("getFilename", &CacheTableStore::getFilename);
+
+	// OpacityTable
+	py::class_<OpacityTable, std::shared_ptr<OpacityTable>>(m, "OpacityTable")
+	    .def("size", &OpacityTable::size)
+	    .def("getEnergyAxis", &OpacityTable::getEnergyAxis)
+	    .def("contains", &OpacityTable::contains)
+	    .def("getAbsorptionCoefficient", &OpacityTable::getAbsorptionCoefficient);
+
 	// DispersionMeasureIntegrator
 	NEW_INTEGRATOR(dmintegrator, "DispersionMeasureIntegrator", DispersionMeasureIntegrator, QDispersionMeasure,
 	               QNumber);
 	dmintegrator.def(py::init<const std::shared_ptr<ionizedgas::IonizedGasDensity>>());
 	dmintegrator.def("getLOSProfile", &DispersionMeasureIntegrator::getLOSProfile);
+	dmintegrator.def("setSampleStore", &DispersionMeasureIntegrator::setSampleStore);
+	dmintegrator.def("getSampleStore", &DispersionMeasureIntegrator::getSampleStore);
 	declare_default_integrator_methods<DispersionMeasureIntegrator>(dmintegrator);
 
 	// RotationMeasureIntegrator
 	NEW_INTEGRATOR(rmintegrator, "RotationMeasureIntegrator", RotationMeasureIntegrator, QRotationMeasure, QNumber);
 	rmintegrator.def(py::init<const std::shared_ptr<magneticfields::MagneticField>,
 	                          const std::shared_ptr<ionizedgas::IonizedGasDensity>>());
+	rmintegrator.def("setSampleStore", &RotationMeasureIntegrator::setSampleStore);
+	rmintegrator.def("getSampleStore", &RotationMeasureIntegrator::getSampleStore);
 	declare_default_integrator_methods<RotationMeasureIntegrator>(rmintegrator);
 
 	// FreeFreeIntegrator
 	NEW_INTEGRATOR(ffintegrator, "FreeFreeIntegrator", FreeFreeIntegrator, QTemperature, QFrequency);
 	ffintegrator.def(py::init<const std::shared_ptr<ionizedgas::IonizedGasDensity>>());
+	ffintegrator.def("setSampleStore", &FreeFreeIntegrator::setSampleStore);
+	ffintegrator.def("getSampleStore", &FreeFreeIntegrator::getSampleStore);
 	declare_default_integrator_methods<FreeFreeIntegrator>(ffintegrator);
 
 	// SynchroIntegrator
@@ -58,6 +127,8 @@ void init_integrators(py::module &m) {
 	    m, "SynchroIntegrator", py::buffer_protocol());
 	synchrointegrator.def(py::init<const std::shared_ptr<magneticfields::MagneticField>,
 	                               const std::shared_ptr<cosmicrays::CosmicRayDensity>>());
+	synchrointegrator.def("setSampleStore", &SynchroIntegrator::setSampleStore);
+	synchrointegrator.def("getSampleStore", &SynchroIntegrator::getSampleStore);
 	declare_default_integrator_methods<SynchroIntegrator>(synchrointegrator);
 
 	// SynchroAbsorption
@@ -66,6 +137,8 @@ void init_integrators(py::module &m) {
 	synchroabsintegrator.def(py::init<const std::shared_ptr<magneticfields::MagneticField>,
 	                                  const std::shared_ptr<cosmicrays::CosmicRayDensity>,
 	                                  const std::shared_ptr<ionizedgas::IonizedGasDensity>>());
+	synchroabsintegrator.def("setSampleStore", &SynchroAbsorptionIntegrator::setSampleStore);
+	synchroabsintegrator.def("getSampleStore", &SynchroAbsorptionIntegrator::getSampleStore);
 	declare_default_integrator_methods<SynchroAbsorptionIntegrator>(synchroabsintegrator);
 
 	// InverseComptonIntegrator
@@ -74,8 +147,26 @@ void init_integrators(py::module &m) {
 	    py::init<const std::shared_ptr<cosmicrays::CosmicRayDensity>, const std::shared_ptr<photonfields::PhotonField>,
 	             const std::shared_ptr<interactions::DifferentialCrossSection>>());
 	declare_default_integrator_methods<InverseComptonIntegrator>(icintegrator);
-	icintegrator.def("integrateOverEnergy", &InverseComptonIntegrator::integrateOverEnergy);
+	icintegrator.def("integrateOverEnergy",
+	                 static_cast<QGREmissivity (InverseComptonIntegrator::*)(const Vector3QLength &, const QEnergy &)
+	                                 const>(&InverseComptonIntegrator::integrateOverEnergy));
+	icintegrator.def("integrateOverLOS",
+	                 static_cast<std::vector<QDiffIntensity> (InverseComptonIntegrator::*)(
+	                     const QDirection &, const std::vector<QEnergy> &) const>(
+	                     &InverseComptonIntegrator::integrateOverLOS));
 	icintegrator.def("integrateOverPhotonEnergy", &InverseComptonIntegrator::integrateOverPhotonEnergy);
+	icintegrator.def("integrateOverEnergy",
+	                 static_cast<std::vector<QGREmissivity> (InverseComptonIntegrator::*)(
+	                     const std::vector<Vector3QLength> &, const QEnergy &) const>(
+	                     &InverseComptonIntegrator::integrateOverEnergy));
+	icintegrator.def("setupPhotonFieldTable",
+	                 static_cast<void (InverseComptonIntegrator::*)()>(&InverseComptonIntegrator::setupPhotonFieldTable));
+	icintegrator.def("setupPhotonFieldTable",
+	                 static_cast<void (InverseComptonIntegrator::*)(const std::vector<QLength> &,
+	                                                                const std::vector<QLength> &)>(
+	                     &InverseComptonIntegrator::setupPhotonFieldTable));
+	icintegrator.def("hasPhotonFieldTable", &InverseComptonIntegrator::hasPhotonFieldTable);
+	icintegrator.def("getCacheTableStore", &InverseComptonIntegrator::getCacheTableStore);
 	icintegrator.def("getLOSProfile", &InverseComptonIntegrator::getLOSProfile);
 
 	// PiZeroIntegrator
@@ -88,9 +179,16 @@ void init_integrators(py::module &m) {
 	                              const std::shared_ptr<neutralgas::RingModel>,
 	                              const std::shared_ptr<interactions::DifferentialCrossSection>>());
 	declare_default_integrator_methods<PiZeroIntegrator>(pizerointegrator);
+	pizerointegrator.def("setRingStep", &PiZeroIntegrator::setRingStep);
+	pizerointegrator.def("getRingStep", &PiZeroIntegrator::getRingStep);
+	pizerointegrator.def("getRingIntervals", &PiZeroIntegrator::getRingIntervals);
+	pizerointegrator.def("getCacheTableStore", &PiZeroIntegrator::getCacheTableStore);
 	pizerointegrator.def("integrateOverLOS",
 	                     static_cast<QDiffIntensity (PiZeroIntegrator::*)(const QDirection &, const QEnergy &) const>(
 	                         &PiZeroIntegrator::integrateOverLOS));
+	pizerointegrator.def("integrateOverLOS",
+	    static_cast<std::vector<QDiffIntensity> (PiZeroIntegrator::*)(const QDirection &, const std::vector<QEnergy> &)
+	                    const>(&PiZeroIntegrator::integrateOverLOS));
 
 	// BremsstrahlungIntegrator
 	py::class_<BremsstrahlungIntegrator, InverseComptonIntegratorParentClass, std::shared_ptr<BremsstrahlungIntegrator>>
@@ -99,10 +197,16 @@ void init_integrators(py::module &m) {
 	    py::init<const std::shared_ptr<cosmicrays::CosmicRayDensity>, const std::shared_ptr<neutralgas::RingModel>,
 	             const std::shared_ptr<interactions::BremsstrahlungAbstract>>());
 	declare_default_integrator_methods<BremsstrahlungIntegrator>(bremsintegrator);
+	bremsintegrator.def("setRingStep", &BremsstrahlungIntegrator::setRingStep);
+	bremsintegrator.def("getRingStep", &BremsstrahlungIntegrator::getRingStep);
+	bremsintegrator.def("getRingIntervals", &BremsstrahlungIntegrator::getRingIntervals);
 	bremsintegrator.def(
 	    "integrateOverLOS",
 	    static_cast<QDiffIntensity (BremsstrahlungIntegrator::*)(const QDirection &, const QEnergy &) const>(
 	        &BremsstrahlungIntegrator::integrateOverLOS));
+	bremsintegrator.def("integrateOverLOS",
+	    static_cast<std::vector<QDiffIntensity> (BremsstrahlungIntegrator::*)(const QDirection &, const std::vector<QEnergy> &)
+	                    const>(&BremsstrahlungIntegrator::integrateOverLOS));
 
 	// PiZeroIntegrator
 	py::class_<PiZeroAbsorptionIntegrator, InverseComptonIntegratorParentClass,
@@ -115,11 +219,28 @@ void init_integrators(py::module &m) {
 	                                 const std::shared_ptr<neutralgas::RingModel>,
 	                                 const std::shared_ptr<interactions::DifferentialCrossSection>>());
 	declare_default_integrator_methods<PiZeroAbsorptionIntegrator>(pizeroabsintegrator);
+	pizeroabsintegrator.def("setRingStep", &PiZeroAbsorptionIntegrator::setRingStep);
+	pizeroabsintegrator.def("getRingStep", &PiZeroAbsorptionIntegrator::getRingStep);
+	pizeroabsintegrator.def("getRingIntervals", &PiZeroAbsorptionIntegrator::getRingIntervals);
 	pizeroabsintegrator.def("absorptionCoefficient", &PiZeroAbsorptionIntegrator::absorptionCoefficient);
+	pizeroabsintegrator.def("computeAbsorptionCoefficient", &PiZeroAbsorptionIntegrator::computeAbsorptionCoefficient);
+	pizeroabsintegrator.def_static("getPairProductionThreshold", &PiZeroAbsorptionIntegrator::getPairProductionThreshold);
+	pizeroabsintegrator.def("setOpacityGrid", [](PiZeroAbsorptionIntegrator &i, const std::shared_ptr<OpacityGrid> &grid) {
+		i.setOpacityGrid(grid);
+	});
+	pizeroabsintegrator.def("getOpacityGrid", [](const PiZeroAbsorptionIntegrator &i) {
+		return std::const_pointer_cast<OpacityGrid>(i.getOpacityGrid());
+	});
+	pizeroabsintegrator.def("getOpacityTable", [](const PiZeroAbsorptionIntegrator &i) {
+		return std::const_pointer_cast<OpacityTable>(i.getOpacityTable());
+	});
 	pizeroabsintegrator.def(
 	    "integrateOverLOS",
 	    static_cast<QDiffIntensity (PiZeroAbsorptionIntegrator::*)(const QDirection &, const QEnergy &) const>(
 	        &PiZeroAbsorptionIntegrator::integrateOverLOS));
+	pizeroabsintegrator.def("integrateOverLOS",
+	    static_cast<std::vector<QDiffIntensity> (PiZeroAbsorptionIntegrator::*)(const QDirection &, const std::vector<QEnergy> &)
+	                    const>(&PiZeroAbsorptionIntegrator::integrateOverLOS));
 
 	// DarkMatterIntegrator
 	py::class_<DarkMatterIntegrator, InverseComptonIntegratorParentClass, std::shared_ptr<DarkMatterIntegrator>>
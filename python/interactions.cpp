@@ -57,6 +57,7 @@ void init(py::module &m) {
 
 	py::class_<Kamae06Gamma, std::shared_ptr<Kamae06Gamma>, DifferentialCrossSection>(subm, "Kamae06Gamma")
 	    .def(py::init<>())
+	    .def("setCacheTable", &Kamae06Gamma::setCacheTable, py::arg("protonEnergies"), py::arg("secondaryEnergies"))
 	    .def("getDiffCrossSection",
 	         static_cast<QDiffCrossSection (Kamae06Gamma::*)(const QEnergy &, const QEnergy &) const>(
 	             &Kamae06Gamma::getDiffCrossSection))
@@ -66,6 +67,7 @@ void init(py::module &m) {
 
 	py::class_<Kamae06Neutrino, std::shared_ptr<Kamae06Neutrino>, DifferentialCrossSection>(subm, "Kamae06Neutrino")
 	    .def(py::init<>())
+	    .def("setCacheTable", &Kamae06Neutrino::setCacheTable, py::arg("protonEnergies"), py::arg("secondaryEnergies"))
 	    .def("getDiffCrossSection",
 	         static_cast<QDiffCrossSection (Kamae06Neutrino::*)(const QEnergy &, const QEnergy &) const>(
 	             &Kamae06Neutrino::getDiffCrossSection))
@@ -105,7 +107,11 @@ void init(py::module &m) {
 	py::class_<BremsstrahlungGALPROP, std::shared_ptr<BremsstrahlungGALPROP>, BremsstrahlungAbstract>(
 	    subm, "BremsstrahlungGALPROP")
 	    .def(py::init<>())
-	    .def("getDiffCrossSectionForTarget", &BremsstrahlungGALPROP::getDiffCrossSectionForTarget);
+	    .def("getDiffCrossSectionForTarget", &BremsstrahlungGALPROP::getDiffCrossSectionForTarget)
+	    .def("enableCaching", &BremsstrahlungGALPROP::enableCaching)
+	    .def("disableCaching", &BremsstrahlungGALPROP::disableCaching)
+	    .def("setCacheTable", &BremsstrahlungGALPROP::setCacheTable, py::arg("electronEnergies"),
+	         py::arg("photonEnergies"));
 
 	py::class_<BremsstrahlungTsai74, std::shared_ptr<BremsstrahlungTsai74>, BremsstrahlungAbstract>(
 	    subm, "BremsstrahlungTsai74")
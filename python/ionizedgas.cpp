@@ -2,6 +2,7 @@
 #include <pybind11/stl.h>
 
 #include "hermes/ionizedgas/IonizedGasDensity.h"
+#include "hermes/ionizedgas/GriddedIonizedGasDensity.h"
 #include "hermes/ionizedgas/HII_Cordes91.h"
 #include "hermes/ionizedgas/NE2001Simple.h"
 #include "hermes/ionizedgas/YMW16.h"
@@ -12,27 +13,50 @@ namespace py = pybind11;
 namespace hermes { namespace ionizedgas {
 
 void init(py::module &m) {
+	auto getDensity =
+	    static_cast<QPDensity (IonizedGasDensity::*)(const Vector3QLength &)
+	                    const>(&IonizedGasDensity::getDensity);
+
 	py::module subm = m.def_submodule("ionizedgas");
 	subm.doc() = "ionized gas package";
 
 	// charged gas density models
 	py::class_<IonizedGasDensity, std::shared_ptr<IonizedGasDensity>>(
 	    subm, "IonizedGasDensity")
-	    .def("getDensity", &IonizedGasDensity::getDensity);
+	    .def("getDensity", getDensity)
+	    .def("getDensities",
+	         [](const IonizedGasDensity &d,
+	            const std::vector<Vector3QLength> &pos) {
+		         std::vector<QPDensity> density;
+		         d.getDensity(pos, density);
+		         return density;
+	         });
 	py::class_<HII_Cordes91, std::shared_ptr<HII_Cordes91>, IonizedGasDensity>(
 	    subm, "HII_Cordes91")
 	    .def(py::init<>())
-	    .def("getDensity", &IonizedGasDensity::getDensity);
+	    .def("getDensity", getDensity);
 	py::class_<NE2001Simple, std::shared_ptr<NE2001Simple>, IonizedGasDensity>(
 	    subm, "NE2001Simple")
 	    .def(py::init<>())
-	    .def("getDensity", &IonizedGasDensity::getDensity);
+	    .def("getDensity", getDensity);
 	py::class_<YMW16, std::shared_ptr<YMW16>, IonizedGasDensity>(subm, "YMW16")
 	    .def(py::init<>())
 	    .def("getDensity",
 	         [](const YMW16 &d, const Vector3QLength &v) -> double {
 		         return static_cast<double>(d.getDensity(v));
 	         });
+	py::class_<GriddedIonizedGasDensity,
+	           std::shared_ptr<GriddedIonizedGasDensity>, IonizedGasDensity>(
+	    subm, "GriddedIonizedGasDensity")
+	    .def(py::init<const std::shared_ptr<IonizedGasDensity> &,
+	                  const std::vector<QLength> &, const std::vector<QLength> &,
+	                  const std::vector<QLength> &, const std::string &>(),
+	         py::arg("model"), py::arg("x"), py::arg("y"), py::arg("z"),
+	         py::arg("cacheTag") = "")
+	    .def("getDensity", getDensity)
+	    .def("getModel", &GriddedIonizedGasDensity::getModel)
+	    .def("getAccuracy", &GriddedIonizedGasDensity::getAccuracy,
+	         py::arg("nSamples") = 10000, py::arg("seed") = 0);
 }
 
 }}  // namespace hermes::ionizedgas
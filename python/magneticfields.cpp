@@ -1,6 +1,7 @@
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
+#include "hermes/magneticfields/GriddedMagneticField.h"
 #include "hermes/magneticfields/JF12.h"
 #include "hermes/magneticfields/MagneticField.h"
 #include "hermes/magneticfields/MagneticFieldGrid.h"
@@ -34,6 +35,18 @@ void init(py::module &m) {
 	    subm, "JF12")
 	    .def(py::init<>())
 	    .def("getField", &MagneticField::getField);
+
+	py::class_<GriddedMagneticField, std::shared_ptr<GriddedMagneticField>,
+	           MagneticField>(subm, "GriddedMagneticField")
+	    .def(py::init<const std::shared_ptr<MagneticField> &,
+	                  const std::vector<QLength> &, const std::vector<QLength> &,
+	                  const std::vector<QLength> &, const std::string &>(),
+	         py::arg("model"), py::arg("x"), py::arg("y"), py::arg("z"),
+	         py::arg("cacheTag") = "")
+	    .def("getField", &MagneticField::getField)
+	    .def("getModel", &GriddedMagneticField::getModel)
+	    .def("getAccuracy", &GriddedMagneticField::getAccuracy,
+	         py::arg("nSamples") = 10000, py::arg("seed") = 0);
 }
 
 }}  // namespace hermes::magneticfields
@@ -23,11 +23,20 @@ void init(py::module &m) {
 	         static_cast<QEnergyDensity (PhotonField::*)(const Vector3QLength &,
 	                                                     std::size_t) const>(
 	             &PhotonField::getEnergyDensity))
+	    .def("getSpectrum",
+	         [](const PhotonField &f, const Vector3QLength &pos) {
+		         std::vector<QEnergyDensity> out;
+		         f.getSpectrum(pos, out);
+		         return out;
+	         })
 	    .def("getEnergyAxis", &PhotonField::getEnergyAxis);
 	py::class_<CMB, std::shared_ptr<CMB>, PhotonField>(subm, "CMB")
 	    .def(py::init<>());
 	py::class_<ISRF, std::shared_ptr<ISRF>, PhotonField>(subm, "ISRF")
-	    .def(py::init<>());
+	    .def(py::init<>())
+	    .def("resampleUniform", &ISRF::resampleUniform, py::arg("nR") = 61,
+	         py::arg("nZ") = 151)
+	    .def("isResampled", &ISRF::isResampled);
 }
 
 }}  // namespace hermes::photonfields
@@ -0,0 +1,185 @@
+#include "hermes/BinaryCache.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+namespace hermes {
+
+namespace {
+const char binaryCacheMagic[8] = {'H', 'E', 'R', 'M', 'E', 'S', 'B', 'C'};
+const std::uint32_t binaryCacheVersion = 1;
+const std::size_t payloadAlignment = 64;
+
+struct BinaryCacheHeader {
+	char magic[8];
+	std::uint32_t version;
+	std::uint32_t headerSize;
+	std::uint64_t key;
+	std::uint64_t nMetadata;
+	std::uint64_t payloadOffset;
+	std::uint64_t payloadSize;
+};
+
+const std::uint64_t fnvOffset = 14695981039346656037ULL;
+const std::uint64_t fnvPrime = 1099511628211ULL;
+
+std::uint64_t fnv1a(const unsigned char *data, std::size_t n, std::uint64_t h) {
+	for (std::size_t i = 0; i < n; ++i) {
+		h ^= data[i];
+		h *= fnvPrime;
+	}
+	return h;
+}
+}  // namespace
+
+std::string getBinaryCachePath() {
+	const char *env_path = getenv("HERMES_CACHE_PATH");
+	if (env_path == nullptr) return "";
+	return std::string(env_path);
+}
+
+std::uint64_t fileContentHash(const std::string &filename) {
+	std::ifstream in(filename, std::ios::binary);
+	if (!in.good()) throw std::runtime_error("hermes::fileContentHash: cannot read " + filename);
+
+	std::uint64_t h = fnvOffset;
+	std::vector<char> buffer(1 << 20);
+	while (in) {
+		in.read(buffer.data(), buffer.size());
+		h = fnv1a(reinterpret_cast<const unsigned char *>(buffer.data()), static_cast<std::size_t>(in.gcount()), h);
+	}
+	return h;
+}
+
+std::uint64_t fileManifestHash(const std::string &filename) {
+	struct stat st;
+	if (stat(filename.c_str(), &st) != 0) throw std::runtime_error("hermes::fileManifestHash: cannot stat " + filename);
+
+	std::uint64_t h = fnv1a(reinterpret_cast<const unsigned char *>(filename.data()), filename.size(), fnvOffset);
+	const std::int64_t fields[] = {static_cast<std::int64_t>(st.st_size), static_cast<std::int64_t>(st.st_mtime)};
+	return fnv1a(reinterpret_cast<const unsigned char *>(fields), sizeof(fields), h);
+}
+
+std::uint64_t stringHash(const std::string &s) {
+	return fnv1a(reinterpret_cast<const unsigned char *>(s.data()), s.size(), fnvOffset);
+}
+
+BinaryCache::BinaryCache(const std::string &tag, const std::vector<std::uint64_t> &sourceHashes)
+    : key(fnvOffset), mapping(nullptr), mappingSize(0), payload(nullptr), payloadSize(0) {
+	for (auto h : sourceHashes) key = fnv1a(reinterpret_cast<const unsigned char *>(&h), sizeof(h), key);
+	key = fnv1a(reinterpret_cast<const unsigned char *>(tag.data()), tag.size(), key);
+
+	std::string path = getBinaryCachePath();
+	if (path.empty()) return;
+
+	std::ostringstream name;
+	name << path << "/" << tag << "-" << std::hex << key << ".bin";
+	filename = name.str();
+}
+
+BinaryCache::~BinaryCache() { unmap(); }
+
+void BinaryCache::unmap() {
+	if (mapping != nullptr) munmap(mapping, mappingSize);
+	mapping = nullptr;
+	mappingSize = 0;
+	payload = nullptr;
+	payloadSize = 0;
+	metadata.clear();
+}
+
+bool BinaryCache::load() {
+	unmap();
+	if (!isEnabled()) return false;
+
+	int fd = ::open(filename.c_str(), O_RDONLY);
+	if (fd < 0) return false;
+
+	struct stat st;
+	if (::fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < sizeof(BinaryCacheHeader)) {
+		::close(fd);
+		return false;
+	}
+
+	mappingSize = st.st_size;
+	mapping = mmap(nullptr, mappingSize, PROT_READ, MAP_SHARED, fd, 0);
+	::close(fd);  // the mapping stays valid
+	if (mapping == MAP_FAILED) {
+		mapping = nullptr;
+		mappingSize = 0;
+		return false;
+	}
+
+	const auto *header = static_cast<const BinaryCacheHeader *>(mapping);
+	const std::size_t metadataEnd = sizeof(BinaryCacheHeader) + header->nMetadata * sizeof(double);
+	if (std::memcmp(header->magic, binaryCacheMagic, sizeof(binaryCacheMagic)) != 0 ||
+	    header->version != binaryCacheVersion || header->headerSize != sizeof(BinaryCacheHeader) ||
+	    header->key != key || metadataEnd > header->payloadOffset ||
+	    header->payloadOffset + header->payloadSize != mappingSize) {
+		std::cerr << "hermes::BinaryCache: ignoring stale or foreign entry " << filename << std::endl;
+		unmap();
+		return false;
+	}
+
+	const auto *meta = reinterpret_cast<const double *>(static_cast<const char *>(mapping) + sizeof(BinaryCacheHeader));
+	metadata.assign(meta, meta + header->nMetadata);
+	payload = static_cast<const char *>(mapping) + header->payloadOffset;
+	payloadSize = header->payloadSize;
+
+	std::cerr << "hermes: info: loaded " << filename << std::endl;
+	return true;
+}
+
+bool BinaryCache::store(const std::vector<double> &metadata_, const void *data, std::size_t bytes) {
+	if (!isEnabled()) return false;
+
+	BinaryCacheHeader header;
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.magic, binaryCacheMagic, sizeof(binaryCacheMagic));
+	header.version = binaryCacheVersion;
+	header.headerSize = sizeof(BinaryCacheHeader);
+	header.key = key;
+	header.nMetadata = metadata_.size();
+	std::size_t metadataEnd = sizeof(BinaryCacheHeader) + metadata_.size() * sizeof(double);
+	header.payloadOffset = (metadataEnd + payloadAlignment - 1) / payloadAlignment * payloadAlignment;
+	header.payloadSize = bytes;
+
+	std::ostringstream tmpName;
+	tmpName << filename << ".tmp." << ::getpid();
+	{
+		std::ofstream out(tmpName.str(), std::ios::binary);
+		if (!out.good()) {
+			std::cerr << "hermes::BinaryCache: cannot write " << tmpName.str() << std::endl;
+			return false;
+		}
+		out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+		out.write(reinterpret_cast<const char *>(metadata_.data()), metadata_.size() * sizeof(double));
+		std::vector<char> padding(header.payloadOffset - metadataEnd, 0);
+		out.write(padding.data(), padding.size());
+		out.write(static_cast<const char *>(data), bytes);
+		if (!out.good()) {
+			std::cerr << "hermes::BinaryCache: cannot write " << tmpName.str() << std::endl;
+			std::remove(tmpName.str().c_str());
+			return false;
+		}
+	}
+
+	if (std::rename(tmpName.str().c_str(), filename.c_str()) != 0) {
+		std::remove(tmpName.str().c_str());
+		return false;
+	}
+	std::cerr << "hermes: info: stored " << filename << std::endl;
+	return true;
+}
+
+}  // namespace hermes
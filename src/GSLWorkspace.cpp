@@ -0,0 +1,52 @@
+#include "hermes/GSLWorkspace.h"
+
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+namespace hermes {
+
+namespace {
+/** Idle workspaces of one thread, per limit; freed at thread exit */
+struct GSLWorkspacePool {
+	std::unordered_map<std::size_t, std::vector<gsl_integration_workspace *>> idle;
+	std::size_t allocations = 0;
+
+	~GSLWorkspacePool() {
+		for (auto &entry : idle)
+			for (auto *w : entry.second) gsl_integration_workspace_free(w);
+	}
+};
+
+GSLWorkspacePool &getPool() {
+	thread_local GSLWorkspacePool pool;
+	return pool;
+}
+}  // namespace
+
+GSLWorkspace::GSLWorkspace(std::size_t limit_) : workspace(nullptr), limit(limit_) {
+	auto &idle = getPool().idle[limit];
+	if (!idle.empty()) {
+		workspace = idle.back();
+		idle.pop_back();
+		return;
+	}
+	// room for every workspace of this limit, so that returning it in the
+	// (noexcept) destructor never allocates
+	idle.reserve(idle.capacity() + 1);
+	workspace = gsl_integration_workspace_alloc(limit);
+	if (workspace == nullptr) throw std::runtime_error("hermes::GSLWorkspace: cannot allocate a workspace");
+	++getPool().allocations;
+}
+
+GSLWorkspace::~GSLWorkspace() { getPool().idle.find(limit)->second.push_back(workspace); }
+
+std::size_t GSLWorkspace::getPoolSize() {
+	std::size_t n = 0;
+	for (const auto &entry : getPool().idle) n += entry.second.size();
+	return n;
+}
+
+std::size_t GSLWorkspace::getNumberOfAllocations() { return getPool().allocations; }
+
+}  // namespace hermes
@@ -1,6 +1,7 @@
 #include "hermes/HEALPixBits.h"
 
 #include <cmath>
+#include <stdexcept>
 
 namespace hermes {
 
@@ -105,6 +106,21 @@ QDirection pix2ang_ring(unsigned int nside, unsigned int ipix) {
 	}
 }
 
+void ring_info(unsigned int nside, unsigned int iring, unsigned int &startpix,
+               unsigned int &ringpix) {
+	if (iring < nside) {  // North Polar cap
+		ringpix = 4 * iring;
+		startpix = 2 * iring * (iring - 1);
+	} else if (iring <= 3 * nside) {  // Equatorial region
+		ringpix = 4 * nside;
+		startpix = 2 * nside * (nside - 1) + (iring - nside) * 4 * nside;
+	} else {  // South Polar cap
+		const unsigned int ir = 4 * nside - iring;
+		ringpix = 4 * ir;
+		startpix = nside2npix(nside) - 2 * ir * (ir + 1);
+	}
+}
+
 unsigned int loc2pix(unsigned int nside, double z, double phi, double sth,
                      bool have_sth) {
 	const double twothird = 2. / 3.;
@@ -158,4 +174,133 @@ unsigned int loc2pix(unsigned int nside, double z, double phi, double sth,
 	}
 }
 
+namespace {
+
+// row and column of the base pixels (faces) in units of nside
+const int jrll[12] = {2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4};
+const int jpll[12] = {1, 3, 5, 7, 0, 2, 4, 6, 1, 3, 5, 7};
+
+// the even bits of v moved to the lower half
+unsigned int compressBits(unsigned int v) {
+	unsigned int r = v & 0x55555555u;
+	r = (r ^ (r >> 1)) & 0x33333333u;
+	r = (r ^ (r >> 2)) & 0x0f0f0f0fu;
+	r = (r ^ (r >> 4)) & 0x00ff00ffu;
+	r = (r ^ (r >> 8)) & 0x0000ffffu;
+	return r;
+}
+
+// inverse of compressBits()
+unsigned int spreadBits(unsigned int v) {
+	unsigned int r = v & 0x0000ffffu;
+	r = (r ^ (r << 8)) & 0x00ff00ffu;
+	r = (r ^ (r << 4)) & 0x0f0f0f0fu;
+	r = (r ^ (r << 2)) & 0x33333333u;
+	r = (r ^ (r << 1)) & 0x55555555u;
+	return r;
+}
+
+long isqrt(long v) {
+	long r = static_cast<long>(std::sqrt(static_cast<double>(v) + 0.5));
+	while (r * r > v) --r;
+	while ((r + 1) * (r + 1) <= v) ++r;
+	return r;
+}
+
+void checkNside(unsigned int nside) {
+	if (nside == 0 || (nside & (nside - 1)) != 0)
+		throw std::runtime_error("hermes::HEALPix: the NESTED scheme requires nside = 2^order");
+}
+
+}  // namespace
+
+unsigned int nest2ring(unsigned int nside, unsigned int ipix) {
+	checkNside(nside);
+	const long ns = nside;
+	const long npface = ns * ns;
+	const long face = ipix / npface;
+	const unsigned int p = ipix & (npface - 1);
+	const long ix = compressBits(p);
+	const long iy = compressBits(p >> 1);
+
+	const long nl4 = 4 * ns;
+	const long npix = 12 * npface;
+	const long ncap = 2 * ns * (ns - 1);
+	const long jr = jrll[face] * ns - ix - iy - 1;
+
+	long nr, nBefore, kshift;
+	if (jr < ns) {
+		nr = jr;
+		nBefore = 2 * nr * (nr - 1);
+		kshift = 0;
+	} else if (jr > 3 * ns) {
+		nr = nl4 - jr;
+		nBefore = npix - 2 * (nr + 1) * nr;
+		kshift = 0;
+	} else {
+		nr = ns;
+		nBefore = ncap + (jr - ns) * nl4;
+		kshift = (jr - ns) & 1;
+	}
+
+	long jp = (jpll[face] * nr + ix - iy + 1 + kshift) / 2;
+	if (jp > nl4)
+		jp -= nl4;
+	else if (jp < 1)
+		jp += nl4;
+
+	return nBefore + jp - 1;
+}
+
+unsigned int ring2nest(unsigned int nside, unsigned int ipix) {
+	checkNside(nside);
+	const long ns = nside;
+	const long pix = ipix;
+	const long nl2 = 2 * ns;
+	const long npix = 12 * ns * ns;
+	const long ncap = 2 * ns * (ns - 1);
+
+	long iring, iphi, kshift, nr, face;
+	if (pix < ncap) {  // North Polar cap
+		iring = (1 + isqrt(1 + 2 * pix)) >> 1;
+		iphi = pix + 1 - 2 * iring * (iring - 1);
+		kshift = 0;
+		nr = iring;
+		face = (iphi - 1) / nr;
+	} else if (pix < npix - ncap) {  // Equatorial region
+		const long ip = pix - ncap;
+		const long tmp = ip / (4 * ns);
+		iring = tmp + ns;
+		iphi = ip - tmp * 4 * ns + 1;
+		kshift = (iring + ns) & 1;
+		nr = ns;
+		const long ire = iring - ns + 1;
+		const long irm = nl2 + 2 - ire;
+		const long ifm = (iphi - ire / 2 + ns - 1) / ns;
+		const long ifp = (iphi - irm / 2 + ns - 1) / ns;
+		face = (ifp == ifm) ? (ifp | 4) : ((ifp < ifm) ? ifp : (ifm + 8));
+	} else {  // South Polar cap
+		const long ip = npix - pix;
+		iring = (1 + isqrt(2 * ip - 1)) >> 1;
+		iphi = 4 * iring + 1 - (ip - 2 * iring * (iring - 1));
+		kshift = 0;
+		nr = iring;
+		iring = 2 * nl2 - iring;
+		face = 8 + (iphi - 1) / nr;
+	}
+
+	const long irt = iring - jrll[face] * ns + 1;
+	long ipt = 2 * iphi - jpll[face] * nr - kshift - 1;
+	if (ipt >= nl2) ipt -= 8 * ns;
+
+	const long ix = (ipt - irt) >> 1;
+	const long iy = (-ipt - irt) >> 1;
+
+	return face * ns * ns + spreadBits(ix) + (spreadBits(iy) << 1);
+}
+
+QDirection pix2ang_nest(unsigned int nside, unsigned int ipix) {
+	return pix2ang_ring(nside, nest2ring(nside, ipix));
+}
+
 }  // namespace hermes
@@ -0,0 +1,127 @@
+#include "hermes/MemoryPlacement.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <string>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace hermes {
+
+namespace {
+const std::size_t hugePageSize = std::size_t(2) << 20;
+
+/** Flag initialised from an environment variable, then set explicitly */
+struct PlacementFlag {
+	std::once_flag initialised;
+	std::atomic<bool> value{false};  // set() may race with get() elsewhere
+	const char *variable;
+
+	explicit PlacementFlag(const char *variable_) : variable(variable_) {}
+
+	bool get() {
+		std::call_once(initialised, [this] {
+			const char *env = getenv(variable);
+			value = (env != nullptr) && std::atoi(env) != 0;
+		});
+		return value;
+	}
+	void set(bool v) {
+		std::call_once(initialised, [] {});
+		value = v;
+	}
+};
+
+PlacementFlag threadPinning("HERMES_PIN_THREADS");
+PlacementFlag hugePages("HERMES_HUGE_PAGES");
+PlacementFlag numaInterleave("HERMES_NUMA_INTERLEAVE");
+
+#ifdef __linux__
+/** Bit mask of the online NUMA nodes, e.g. "0-1" -> 0b11 */
+unsigned long getOnlineNodeMask() {
+	std::ifstream in("/sys/devices/system/node/online");
+	std::string list;
+	if (!(in >> list)) return 0;
+
+	unsigned long mask = 0;
+	std::stringstream ss(list);
+	std::string range;
+	while (std::getline(ss, range, ',')) {
+		std::size_t dash = range.find('-');
+		int lo = std::atoi(range.substr(0, dash).c_str());
+		int hi = (dash == std::string::npos) ? lo : std::atoi(range.substr(dash + 1).c_str());
+		for (int n = lo; n <= hi && n < static_cast<int>(8 * sizeof(unsigned long)); ++n) mask |= 1UL << n;
+	}
+	return mask;
+}
+#endif
+}  // namespace
+
+bool getThreadPinning() { return threadPinning.get(); }
+void setThreadPinning(bool enable) { threadPinning.set(enable); }
+bool getHugePages() { return hugePages.get(); }
+void setHugePages(bool enable) { hugePages.set(enable); }
+bool getNumaInterleave() { return numaInterleave.get(); }
+void setNumaInterleave(bool enable) { numaInterleave.set(enable); }
+
+bool pinCurrentThread(std::size_t index) {
+#ifdef __linux__
+	cpu_set_t allowed;
+	CPU_ZERO(&allowed);
+	if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) return false;
+	const int nAllowed = CPU_COUNT(&allowed);
+	if (nAllowed == 0) return false;
+
+	int target = static_cast<int>(index % nAllowed);
+	for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+		if (!CPU_ISSET(cpu, &allowed)) continue;
+		if (target-- > 0) continue;
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(cpu, &set);
+		return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+	}
+#endif
+	return false;
+}
+
+void placeLargeAllocation(void *data, std::size_t bytes) {
+#ifdef __linux__
+	if (data == nullptr || bytes < hugePageSize) return;
+	const bool huge = getHugePages(), interleave = getNumaInterleave();
+	if (!huge && !interleave) return;
+
+	// both calls need page-aligned ranges; the whole pages inside the
+	// buffer are enough for a large allocation
+	const std::uintptr_t pageSize = static_cast<std::uintptr_t>(sysconf(_SC_PAGESIZE));
+	const std::uintptr_t align = huge ? hugePageSize : pageSize;
+	std::uintptr_t begin = (reinterpret_cast<std::uintptr_t>(data) + align - 1) / align * align;
+	std::uintptr_t end = (reinterpret_cast<std::uintptr_t>(data) + bytes) / align * align;
+	if (end <= begin) return;
+
+#ifdef MADV_HUGEPAGE
+	if (huge) madvise(reinterpret_cast<void *>(begin), end - begin, MADV_HUGEPAGE);
+#endif
+#ifdef SYS_mbind
+	if (interleave) {
+		unsigned long mask = getOnlineNodeMask();
+		const int mpolInterleave = 3;  // MPOL_INTERLEAVE of <numaif.h>
+		if ((mask & (mask - 1)) != 0)  // more than one node
+			syscall(SYS_mbind, reinterpret_cast<void *>(begin), end - begin, mpolInterleave, &mask,
+			        8 * sizeof(unsigned long), 0);
+	}
+#endif
+#endif
+}
+
+}  // namespace hermes
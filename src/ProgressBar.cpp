@@ -1,63 +1,197 @@
 #include "hermes/ProgressBar.h"
 
+#include <algorithm>
 #include <cstdio>
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
 #include <utility>
 
+#include "hermes/Common.h"
+#include "hermes/ThreadPool.h"
+
 namespace hermes {
 
-/// Initialize a ProgressBar with [steps] number of steps, updated at
-/// [updateSteps] intervalls
+namespace {
+std::mutex metricsFileMutex;
+bool metricsFileSet = false;
+std::string metricsFile;
+
+std::string jsonEscape(const std::string &s) {
+	std::string out;
+	for (char c : s) {
+		if (c == '"' || c == '\\') out.push_back('\\');
+		out.push_back(c);
+	}
+	return out;
+}
+}  // namespace
+
+std::string getProgressMetricsFile() {
+	std::lock_guard<std::mutex> lock(metricsFileMutex);
+	if (!metricsFileSet) {
+		const char *env = getenv("HERMES_PROGRESS_FILE");
+		if (env != nullptr) metricsFile = env;
+		metricsFileSet = true;
+	}
+	return metricsFile;
+}
+
+void setProgressMetricsFile(const std::string &filename) {
+	std::lock_guard<std::mutex> lock(metricsFileMutex);
+	metricsFile = filename;
+	metricsFileSet = true;
+}
+
+/// Initialize a ProgressBar with [steps] number of steps; the bar is
+/// redrawn at most once per report interval, [updateSteps] is kept for
+/// compatibility
 ProgressBar::ProgressBar(unsigned long steps, unsigned long updateSteps)
     : _steps(steps),
-      _currentCount(0),
       _maxbarLength(10),
       _updateSteps(updateSteps),
-      _nextStep(1),
+      nCounters(getThreadsNumber() + 1),
+      counters(new Counter[getThreadsNumber() + 1]),
       _startTime(0),
-      mutexSet(false) {
+      metricsFilename(getProgressMetricsFile()),
+      reportInterval(1),
+      finished(false),
+      stopping(false) {
 	if (_updateSteps > _steps) _updateSteps = _steps;
 	arrow.append(">");
 }
 
-void ProgressBar::setMutex(std::shared_ptr<std::mutex> mutex) {
-	_mutex = std::move(mutex);
-	mutexSet = true;
+ProgressBar::~ProgressBar() { stop(); }
+
+void ProgressBar::setMutex(std::shared_ptr<std::mutex> /* mutex */) {}
+
+void ProgressBar::setMetricsFile(const std::string &filename) {
+	metricsFilename = filename;
 }
 
-void ProgressBar::start(const std::string &title) {
+void ProgressBar::setReportInterval(double seconds) { reportInterval = seconds; }
+
+void ProgressBar::start(const std::string &title_) {
+	stop();
+	title = title_;
 	_startTime = time(NULL);
+	startClock = std::chrono::steady_clock::now();
 	std::string s = ctime(&_startTime);
 	s.erase(s.end() - 1, s.end());
 	stringTmpl = "  Started ";
 	stringTmpl.append(s);
-	stringTmpl.append(" : [%-10s] %3i%%    %s: %02i:%02i:%02i %s\r");
+	stringTmpl.append(" : [%-10s] %3lu%%    %s: %02i:%02i:%02i %s\r");
 	std::cout << title << std::endl;
+
+	finished = false;
+	stopping = false;
+	reporter = std::thread(&ProgressBar::reporterLoop, this);
+}
+
+void ProgressBar::stop() {
+	if (!reporter.joinable()) return;
+	{
+		std::lock_guard<std::mutex> lock(reporterMutex);
+		stopping = true;
+	}
+	reporterWakeup.notify_all();
+	reporter.join();
+
+	// an interrupted bar keeps its last position on a line of its own
+	report();
+	if (!finished) {
+		std::printf("\n");
+		fflush(stdout);
+	}
 }
+
+void ProgressBar::reporterLoop() {
+	std::unique_lock<std::mutex> lock(reporterMutex);
+	const auto interval = std::chrono::duration<double>(reportInterval);
+	while (!stopping && !finished) {
+		reporterWakeup.wait_for(lock, interval);
+		if (stopping) break;
+		lock.unlock();
+		report();
+		lock.lock();
+	}
+}
+
+void ProgressBar::report() {
+	std::vector<unsigned long> perThread = getThreadCounts();
+	unsigned long position = 0;
+	for (auto n : perThread) position += n;
+
+	if (!finished && position > 0) {
+		setPosition(std::min(position, _steps));
+		finished = (position >= _steps);
+	}
+	if (!metricsFilename.empty()) writeMetrics(position, perThread);
+}
+
+void ProgressBar::writeMetrics(unsigned long position,
+                               const std::vector<unsigned long> &perThread) const {
+	const double elapsed =
+	    std::chrono::duration<double>(std::chrono::steady_clock::now() - startClock).count();
+	const double rate = (elapsed > 0) ? position / elapsed : 0;
+	const double eta = (rate > 0) ? (_steps - std::min(position, _steps)) / rate : -1;
+	const bool json = metricsFilename.size() >= 5 &&
+	                  metricsFilename.compare(metricsFilename.size() - 5, 5, ".json") == 0;
+
+	// written next to the target and renamed, so readers never see a
+	// partial snapshot
+	const std::string tmpName = metricsFilename + ".tmp";
+	{
+		std::ofstream out(tmpName);
+		if (!out.good()) return;
+		if (json) {
+			out << "{\n  \"title\": \"" << jsonEscape(title) << "\",\n  \"done\": " << position
+			    << ",\n  \"total\": " << _steps << ",\n  \"elapsed\": " << elapsed << ",\n  \"rate\": " << rate
+			    << ",\n  \"eta\": " << eta << ",\n  \"finished\": " << (position >= _steps ? "true" : "false")
+			    << ",\n  \"threads\": [";
+			for (std::size_t i = 0; i < perThread.size(); ++i)
+				out << (i == 0 ? "\n" : ",\n") << "    {\"worker\": " << static_cast<int>(i) - 1
+				    << ", \"done\": " << perThread[i]
+				    << ", \"rate\": " << ((elapsed > 0) ? perThread[i] / elapsed : 0) << "}";
+			out << "\n  ]\n}\n";
+		} else {
+			out << "title " << title << "\ndone " << position << "\ntotal " << _steps << "\nelapsed " << elapsed
+			    << "\nrate " << rate << "\neta " << eta << "\nfinished " << (position >= _steps ? 1 : 0) << "\n";
+			for (std::size_t i = 0; i < perThread.size(); ++i)
+				out << "worker " << static_cast<int>(i) - 1 << " done " << perThread[i] << " rate "
+				    << ((elapsed > 0) ? perThread[i] / elapsed : 0) << "\n";
+		}
+	}
+	std::rename(tmpName.c_str(), metricsFilename.c_str());
+}
+
 /// update the progressbar
 /// should be called steps times in a loop
 void ProgressBar::update() {
-	if (mutexSet) {
-		std::lock_guard<std::mutex> guard(*_mutex);
-		_currentCount++;
-		if (_currentCount == _nextStep || _currentCount == _steps || _currentCount == 1000) {
-			_nextStep += long(_steps / float(_updateSteps));
-			setPosition(_currentCount);
-		}
-	} else {
-		_currentCount++;
-		if (_currentCount == _nextStep || _currentCount == _steps || _currentCount == 1000) {
-			_nextStep += long(_steps / float(_updateSteps));
-			setPosition(_currentCount);
-		}
-	}
+	const int worker = ThreadPool::getWorkerIndex();
+	counters[static_cast<std::size_t>(worker + 1) % nCounters].count.fetch_add(
+	    1, std::memory_order_relaxed);
+}
+
+unsigned long ProgressBar::getCount() const {
+	unsigned long count = 0;
+	for (std::size_t i = 0; i < nCounters; ++i)
+		count += counters[i].count.load(std::memory_order_relaxed);
+	return count;
+}
+
+std::vector<unsigned long> ProgressBar::getThreadCounts() const {
+	std::vector<unsigned long> counts(nCounters);
+	for (std::size_t i = 0; i < nCounters; ++i)
+		counts[i] = counters[i].count.load(std::memory_order_relaxed);
+	return counts;
 }
 
 void ProgressBar::setPosition(unsigned long position) {
-	int percentage = int(100 * (position / float(_steps)));
+	unsigned long percentage = static_cast<unsigned long>(100 * (position / float(_steps)));
 	time_t currentTime = time(NULL);
 	if (position < _steps) {
-		if (arrow.size() <= (_maxbarLength) * (position) / (_steps)) arrow.insert(0, "=");
+		while (arrow.size() <= (_maxbarLength) * (position) / (_steps)) arrow.insert(0, "=");
 		time_t tElapsed = currentTime - _startTime;
 		float tToGo = (_steps - position) * tElapsed / position;
 		std::printf(stringTmpl.c_str(), arrow.c_str(), percentage, "Finish in", int(tToGo / 3600),
@@ -69,7 +203,7 @@ void ProgressBar::setPosition(unsigned long position) {
 		s.append(ctime(&currentTime));
 		char fs[255];
 		std::snprintf(fs, 100, "%c[%d;%dm Finished %c[%dm", 27, 1, 32, 27, 0);
-		std::printf(stringTmpl.c_str(), fs, 100, "Needed", int(tElapsed / 3600), (int(tElapsed) % 3600) / 60,
+		std::printf(stringTmpl.c_str(), fs, 100ul, "Needed", int(tElapsed / 3600), (int(tElapsed) % 3600) / 60,
 		            int(tElapsed) % 60, s.c_str());
 	}
 }
@@ -77,13 +211,13 @@ void ProgressBar::setPosition(unsigned long position) {
 /// Mark the progressbar with an error
 void ProgressBar::setError() {
 	time_t currentTime = time(NULL);
-	_currentCount++;
+	unsigned long count = getCount() + 1;
 	time_t tElapsed = currentTime - _startTime;
 	std::string s = " - Finished at ";
 	s.append(ctime(&currentTime));
 	char fs[255];
 	std::snprintf(fs, 100, "%c[%d;%dm  ERROR   %c[%dm", 27, 1, 31, 27, 0);
-	std::printf(stringTmpl.c_str(), fs, _currentCount, "Needed", int(tElapsed / 3600), (int(tElapsed) % 3600) / 60,
+	std::printf(stringTmpl.c_str(), fs, count, "Needed", int(tElapsed / 3600), (int(tElapsed) % 3600) / 60,
 	            int(tElapsed) % 60, s.c_str());
 }
 
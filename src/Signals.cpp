@@ -2,12 +2,41 @@
 
 namespace hermes {
 
-int g_cancel_signal_flag = 0;
+volatile std::sig_atomic_t g_cancel_signal_flag = 0;
 
 void g_cancel_signal_callback(int sig) {
+	// only async-signal-safe operations here; the message is printed by
+	// the interrupted loop
+	g_cancel_signal_flag = sig;
+}
+
+CancelSignalGuard::CancelSignalGuard() : installed(true) {
+	g_cancel_signal_flag = 0;
+	oldSigIntHandler = ::signal(SIGINT, g_cancel_signal_callback);
+	oldSigTermHandler = ::signal(SIGTERM, g_cancel_signal_callback);
+}
+
+CancelSignalGuard::~CancelSignalGuard() {
+	if (!installed) return;
+	::signal(SIGINT, oldSigIntHandler);
+	::signal(SIGTERM, oldSigTermHandler);
+	installed = false;
+}
+
+bool CancelSignalGuard::isCancelled() const { return g_cancel_signal_flag != 0; }
+
+void CancelSignalGuard::raisePending() {
+	int sig = g_cancel_signal_flag;
+	if (installed) {
+		::signal(SIGINT, oldSigIntHandler);
+		::signal(SIGTERM, oldSigTermHandler);
+		installed = false;
+	}
+	if (sig == 0) return;
 	std::cerr << "hermes::Skymap: Signal " << sig
 	          << " (SIGINT/SIGTERM) received" << std::endl;
-	g_cancel_signal_flag = sig;
+	g_cancel_signal_flag = 0;
+	std::raise(sig);
 }
 
 }  // namespace hermes
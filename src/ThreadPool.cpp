@@ -0,0 +1,222 @@
+#include "hermes/ThreadPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <numeric>
+
+#include "hermes/Common.h"
+#include "hermes/MemoryPlacement.h"
+
+namespace hermes {
+
+namespace {
+thread_local int tlsWorkerIndex = -1;
+
+double secondsSince(const std::chrono::steady_clock::time_point &t0) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+}  // namespace
+
+std::size_t LoadStatistics::getTotalTasks() const { return std::accumulate(tasks.begin(), tasks.end(), std::size_t(0)); }
+
+std::size_t LoadStatistics::getTotalSteals() const {
+	return std::accumulate(steals.begin(), steals.end(), std::size_t(0));
+}
+
+double LoadStatistics::getImbalance() const {
+	if (busyTime.empty()) return 1;
+	double total = std::accumulate(busyTime.begin(), busyTime.end(), 0.0);
+	if (total <= 0) return 1;
+	double mean = total / busyTime.size();
+	return *std::max_element(busyTime.begin(), busyTime.end()) / mean;
+}
+
+double LoadStatistics::getEfficiency() const {
+	if (busyTime.empty() || wallTime <= 0) return 1;
+	double total = std::accumulate(busyTime.begin(), busyTime.end(), 0.0);
+	return total / (wallTime * busyTime.size());
+}
+
+std::ostream &operator<<(std::ostream &out, const LoadStatistics &s) {
+	out << "wall time = " << s.wallTime << " s, threads = " << s.busyTime.size()
+	    << ", imbalance (max/mean busy time) = " << s.getImbalance()
+	    << ", efficiency = " << 100 * s.getEfficiency() << "%, steals = " << s.getTotalSteals();
+	return out;
+}
+
+ThreadPool::ThreadPool(std::size_t nThreads_, bool pinned_)
+    : nThreads(std::max<std::size_t>(1, nThreads_)),
+      pinned(pinned_),
+      generation(0),
+      activeWorkers(0),
+      stopping(false),
+      job(nullptr),
+      grain(1),
+      aborted(false) {
+	queues.reset(new WorkerQueue[nThreads]);
+	workers.reserve(nThreads);
+	for (std::size_t i = 0; i < nThreads; ++i) workers.emplace_back(&ThreadPool::workerLoop, this, i);
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(poolMutex);
+		stopping = true;
+	}
+	workAvailable.notify_all();
+	for (auto &t : workers) t.join();
+}
+
+std::size_t ThreadPool::size() const { return nThreads; }
+
+bool ThreadPool::isPinned() const { return pinned; }
+
+int ThreadPool::getWorkerIndex() { return tlsWorkerIndex; }
+
+void ThreadPool::workerLoop(std::size_t id) {
+	tlsWorkerIndex = static_cast<int>(id);
+	if (pinned) pinCurrentThread(id);
+	std::size_t seenGeneration = 0;
+	std::unique_lock<std::mutex> lock(poolMutex);
+	while (true) {
+		workAvailable.wait(lock, [&] { return stopping || generation != seenGeneration; });
+		if (stopping) return;
+		seenGeneration = generation;
+
+		lock.unlock();
+		runWorker(id);
+		lock.lock();
+
+		if (--activeWorkers == 0) workDone.notify_all();
+	}
+}
+
+bool ThreadPool::popLocal(std::size_t id, std::size_t &begin, std::size_t &end) {
+	auto &q = queues[id];
+	std::lock_guard<std::mutex> lock(q.mtx);
+	if (q.begin >= q.end) return false;
+	begin = q.begin;
+	end = std::min(q.end, q.begin + grain);
+	q.begin = end;
+	return true;
+}
+
+bool ThreadPool::steal(std::size_t id) {
+	// pick the victim with the largest remaining block
+	std::size_t victim = id, largest = 0;
+	for (std::size_t i = 0; i < nThreads; ++i) {
+		if (i == id) continue;
+		std::lock_guard<std::mutex> lock(queues[i].mtx);
+		std::size_t left = queues[i].end - queues[i].begin;
+		if (queues[i].begin < queues[i].end && left > largest) {
+			largest = left;
+			victim = i;
+		}
+	}
+	if (victim == id) return false;
+
+	std::size_t begin, end;
+	{
+		auto &q = queues[victim];
+		std::lock_guard<std::mutex> lock(q.mtx);
+		if (q.begin >= q.end) return true;  // emptied meanwhile, look again
+		std::size_t left = q.end - q.begin;
+		end = q.end;
+		begin = q.end - std::max<std::size_t>(1, left / 2);
+		q.end = begin;
+	}
+	{
+		auto &q = queues[id];
+		std::lock_guard<std::mutex> lock(q.mtx);
+		q.begin = begin;
+		q.end = end;
+	}
+	stats.steals[id]++;
+	return true;
+}
+
+void ThreadPool::runWorker(std::size_t id) {
+	std::size_t begin, end;
+	while (true) {
+		if (!popLocal(id, begin, end)) {
+			if (!steal(id)) break;
+			continue;
+		}
+		auto t0 = std::chrono::steady_clock::now();
+		for (std::size_t i = begin; i < end && !aborted; ++i) {
+			try {
+				(*job)(i);
+			} catch (...) {
+				std::lock_guard<std::mutex> lock(poolMutex);
+				if (!firstException) firstException = std::current_exception();
+				aborted = true;
+			}
+		}
+		stats.busyTime[id] += secondsSince(t0);
+		stats.tasks[id] += end - begin;
+	}
+}
+
+LoadStatistics ThreadPool::parallelFor(std::size_t n, const std::function<void(std::size_t)> &f,
+                                       std::size_t grain_) {
+	LoadStatistics result;
+	if (n == 0) return result;
+
+	// nested call from inside a task: run serially in the calling worker
+	if (getWorkerIndex() >= 0) {
+		auto t0 = std::chrono::steady_clock::now();
+		for (std::size_t i = 0; i < n; ++i) f(i);
+		result.wallTime = secondsSince(t0);
+		result.busyTime = {result.wallTime};
+		result.tasks = {n};
+		result.steals = {0};
+		return result;
+	}
+
+	std::lock_guard<std::mutex> runLock(runMutex);
+
+	job = &f;
+	grain = (grain_ > 0) ? grain_ : std::max<std::size_t>(1, std::min<std::size_t>(256, n / (32 * nThreads)));
+	aborted = false;
+	firstException = nullptr;
+	stats = LoadStatistics();
+	stats.busyTime.assign(nThreads, 0);
+	stats.tasks.assign(nThreads, 0);
+	stats.steals.assign(nThreads, 0);
+
+	// initial split into contiguous blocks, one per worker
+	for (std::size_t i = 0; i < nThreads; ++i) {
+		std::lock_guard<std::mutex> lock(queues[i].mtx);
+		queues[i].begin = i * n / nThreads;
+		queues[i].end = (i + 1) * n / nThreads;
+	}
+
+	auto t0 = std::chrono::steady_clock::now();
+	{
+		std::unique_lock<std::mutex> lock(poolMutex);
+		activeWorkers = nThreads;
+		++generation;
+		workAvailable.notify_all();
+		workDone.wait(lock, [this] { return activeWorkers == 0; });
+	}
+	stats.wallTime = secondsSince(t0);
+	job = nullptr;
+
+	if (firstException) std::rethrow_exception(firstException);
+
+	return stats;
+}
+
+std::shared_ptr<ThreadPool> getThreadPool() {
+	static std::mutex mtx;
+	static std::shared_ptr<ThreadPool> pool;
+
+	std::lock_guard<std::mutex> lock(mtx);
+	std::size_t n = getThreadsNumber();
+	bool pinned = getThreadPinning();
+	if (pool == nullptr || pool->size() != n || pool->isPinned() != pinned)
+		pool = std::make_shared<ThreadPool>(n, pinned);
+	return pool;
+}
+
+}  // namespace hermes
@@ -38,6 +38,7 @@ void Dragon2D::readFile() {
 
 	ffile->openFile(FITS::READ);
 	ffile->moveToHDU(1);
+	sourceFiles = {filename};
 
 	// read header
 	readEnergyAxis();
@@ -39,6 +39,16 @@ Dragon3D::Dragon3D(const std::string &filename_, const std::vector<PID> &pids_)
 }
 
 void Dragon3D::readFile() {
+	sourceFiles = {filename};
+
+	// the parsed grid is cached in its final layout (see BinaryCache)
+	std::shared_ptr<BinaryCache> cache;
+	if (!getBinaryCachePath().empty()) {
+		cache = std::make_shared<BinaryCache>("Dragon3D_" + getPIDsAsString(),
+		                                      getSourceHashes());
+		if (loadBinaryCache(cache)) return;
+	}
+
 	ffile = std::make_unique<FITSFile>(FITSFile(filename));
 
 	ffile->openFile(FITS::READ);
@@ -49,6 +59,66 @@ void Dragon3D::readFile() {
 
 	readSpatialGrid3D();
 	readDensity3D();
+
+	if (cache != nullptr) storeBinaryCache(*cache);
+}
+
+void Dragon3D::storeBinaryCache(BinaryCache &cache) const {
+	std::vector<double> metadata = {
+	    static_cast<double>(dimE),       static_cast<double>(dimx),
+	    static_cast<double>(dimy),       static_cast<double>(dimz),
+	    static_cast<double>(xmin),       static_cast<double>(xmax),
+	    static_cast<double>(ymin),       static_cast<double>(ymax),
+	    static_cast<double>(zmin),       static_cast<double>(zmax),
+	    energyScaleFactor};
+	for (const auto &E : energyRange) metadata.push_back(static_cast<double>(E));
+
+	cache.store(metadata, grid->data(),
+	            grid->getGridSize() * sizeof(QPDensityPerEnergy));
+}
+
+bool Dragon3D::loadBinaryCache(const std::shared_ptr<BinaryCache> &cache) {
+	if (!cache->load()) return false;
+
+	const auto &metadata = cache->getMetadata();
+	if (metadata.size() < 11) return false;
+	dimE = static_cast<int>(metadata[0]);
+	dimx = static_cast<int>(metadata[1]);
+	dimy = static_cast<int>(metadata[2]);
+	dimz = static_cast<int>(metadata[3]);
+	if (metadata.size() != 11 + static_cast<std::size_t>(dimE) ||
+	    cache->getPayloadSize() !=
+	        static_cast<std::size_t>(dimE) * dimx * dimy * dimz *
+	            sizeof(QPDensityPerEnergy))
+		return false;
+
+	xmin = QLength(metadata[4]);
+	xmax = QLength(metadata[5]);
+	ymin = QLength(metadata[6]);
+	ymax = QLength(metadata[7]);
+	zmin = QLength(metadata[8]);
+	zmax = QLength(metadata[9]);
+	rmax = sqrt(xmax * xmax + ymax * ymax);
+	energyScaleFactor = metadata[10];
+
+	energyRange.clear();
+	energyIndex.clear();
+	for (int i = 0; i < dimE; ++i) {
+		QEnergy E(metadata[11 + i]);
+		energyRange.push_back(E);
+		energyIndex[E] = i;
+	}
+
+	Vector3d origin(static_cast<double>(xmin), static_cast<double>(ymin),
+	                static_cast<double>(zmin));
+	Vector3d spacing(static_cast<double>((xmax - xmin) / (dimx - 1)),
+	                 static_cast<double>((ymax - ymin) / (dimy - 1)),
+	                 static_cast<double>((zmax - zmin) / (dimz - 1)));
+	// zero-copy: the grid reads the mapped payload directly
+	grid = std::make_unique<SpectralGridQPDensityPerEnergy>(
+	    origin, dimx, dimy, dimz, spacing, dimE, cache,
+	    static_cast<const QPDensityPerEnergy *>(cache->getPayload()));
+	return true;
 }
 
 QPDensityPerEnergy Dragon3D::getDensityPerEnergy(
@@ -62,7 +132,19 @@ QPDensityPerEnergy Dragon3D::getDensityPerEnergy(
 	if (pos_.y < ymin || pos_.y > ymax) return QPDensityPerEnergy(0);
 	if (pos_.z < zmin || pos_.z > zmax) return QPDensityPerEnergy(0);
 
-	return (grid[iE_])->interpolate(pos_);
+	return grid->interpolate(pos_, iE_);
+}
+
+void Dragon3D::getDensitySpectrum(
+    const Vector3QLength &pos_, std::vector<QPDensityPerEnergy> &out) const {
+	out.resize(energyRange.size());
+	if (pos_.x < xmin || pos_.x > xmax || pos_.y < ymin || pos_.y > ymax ||
+	    pos_.z < zmin || pos_.z > zmax) {
+		std::fill(out.begin(), out.end(), QPDensityPerEnergy(0));
+		return;
+	}
+
+	grid->interpolateSpectrum(pos_, out);
 }
 
 void Dragon3D::readEnergyAxis() {
@@ -102,10 +184,8 @@ void Dragon3D::readSpatialGrid3D() {
 	Vector3d spacing(static_cast<double>(deltax), static_cast<double>(deltay),
 	                 static_cast<double>(deltaz));
 
-	for (int i = 0; i < dimE; ++i) {
-		grid.push_back(std::make_unique<ScalarGridQPDensityPerEnergy>(
-		    ScalarGridQPDensityPerEnergy(origin, dimx, dimy, dimz, spacing)));
-	}
+	grid = std::make_unique<SpectralGridQPDensityPerEnergy>(
+	    origin, dimx, dimy, dimz, spacing, dimE);
 }
 
 std::array<QLength, 2> Dragon3D::getXBoundaries() const {
@@ -169,8 +249,8 @@ void Dragon3D::readDensity3D() {
 
 				(*it) *= fluxToDensity;
 
-				grid[iE]->addValue(ix, iy, iz,
-				                   static_cast<QPDensityPerEnergy>(*it));
+				grid->addValue(ix, iy, iz, iE,
+				               static_cast<QPDensityPerEnergy>(*it));
 			}
 		}
 		hduIndex++;
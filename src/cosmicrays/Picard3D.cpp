@@ -2,6 +2,7 @@
 
 #include "hermes/cosmicrays/Picard3D.h"
 
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <filesystem>
@@ -38,7 +39,24 @@ Picard3D::Picard3D(std::string cosmicRayFluxesDirectory, const std::vector<PID>
 	readFile();
 }
 
+std::vector<std::string> Picard3D::listSpeciesFiles() const {
+	std::vector<std::string> paths;
+	for (const auto &speciesFile : std::filesystem::directory_iterator(cosmicRayFluxesDirectory))
+		if (speciesFile.path().extension() == ".h5") paths.push_back(speciesFile.path());
+	std::sort(paths.begin(), paths.end());
+	return paths;
+}
+
 void Picard3D::readFile() {
+	sourceFiles = listSpeciesFiles();
+
+	// the parsed grid is cached in its final layout (see BinaryCache)
+	std::shared_ptr<BinaryCache> cache;
+	if (!getBinaryCachePath().empty()) {
+		cache = std::make_shared<BinaryCache>("Picard3D_" + getPIDsAsString(), getSourceHashes());
+		if (loadBinaryCache(cache)) return;
+	}
+
 	std::string finalTimeStepDirectory = cosmicRayFluxesDirectory;
 	auto speciesFiles = std::filesystem::directory_iterator(finalTimeStepDirectory);
 	bool gotEnergyAxisAndSpatialGrid{false};
@@ -58,6 +76,69 @@ void Picard3D::readFile() {
 		h5Filename = speciesFile.path().filename();
 		readDensity3D();
 	}
+
+	if (cache != nullptr && gotEnergyAxisAndSpatialGrid) storeBinaryCache(*cache);
+}
+
+void Picard3D::storeBinaryCache(BinaryCache &cache) const {
+	std::vector<double> metadata = {static_cast<double>(numberOfEnergies),
+	                                static_cast<double>(numberOfXValues),
+	                                static_cast<double>(numberOfYValues),
+	                                static_cast<double>(numberOfZValues),
+	                                static_cast<double>(xMin),
+	                                static_cast<double>(xMax),
+	                                static_cast<double>(yMin),
+	                                static_cast<double>(yMax),
+	                                static_cast<double>(zMin),
+	                                static_cast<double>(zMax),
+	                                energyScaleFactor};
+	for (const auto &energy : energyRange) metadata.push_back(static_cast<double>(energy));
+
+	cache.store(metadata, grid->data(), grid->getGridSize() * sizeof(QPDensityPerEnergy));
+}
+
+bool Picard3D::loadBinaryCache(const std::shared_ptr<BinaryCache> &cache) {
+	if (!cache->load()) return false;
+
+	const auto &metadata = cache->getMetadata();
+	if (metadata.size() < 11) return false;
+	numberOfEnergies = static_cast<size_t>(metadata[0]);
+	numberOfXValues = static_cast<size_t>(metadata[1]);
+	numberOfYValues = static_cast<size_t>(metadata[2]);
+	numberOfZValues = static_cast<size_t>(metadata[3]);
+	if (metadata.size() != 11 + numberOfEnergies ||
+	    cache->getPayloadSize() !=
+	        numberOfEnergies * numberOfXValues * numberOfYValues * numberOfZValues * sizeof(QPDensityPerEnergy))
+		return false;
+
+	xMin = QLength(metadata[4]);
+	xMax = QLength(metadata[5]);
+	yMin = QLength(metadata[6]);
+	yMax = QLength(metadata[7]);
+	zMin = QLength(metadata[8]);
+	zMax = QLength(metadata[9]);
+	energyScaleFactor = metadata[10];
+	setScaleFactor(true);
+
+	energyRange.clear();
+	energyToIndex.clear();
+	for (size_t energyIndex = 0; energyIndex < numberOfEnergies; ++energyIndex) {
+		QEnergy energy(metadata[11 + energyIndex]);
+		energyRange.push_back(energy);
+		energyToIndex[energy] = energyIndex;
+	}
+
+	Vector3d spacing(static_cast<double>((xMax - xMin) / (numberOfXValues - 1)),
+	                 static_cast<double>((yMax - yMin) / (numberOfYValues - 1)),
+	                 static_cast<double>((zMax - zMin) / (numberOfZValues - 1)));
+	Vector3d gridOrigin(static_cast<double>(xMin), static_cast<double>(yMin), static_cast<double>(zMin));
+	Vector3d volumeOrigin = gridOrigin - spacing * 0.5;
+
+	// zero-copy: the grid reads the mapped payload directly
+	grid = std::make_unique<SpectralGridQPDensityPerEnergy>(
+	    volumeOrigin, numberOfXValues, numberOfYValues, numberOfZValues, spacing, numberOfEnergies, cache,
+	    static_cast<const QPDensityPerEnergy *>(cache->getPayload()));
+	return true;
 }
 
 void Picard3D::evaluateEnergyScaleFactor() {
@@ -125,10 +206,8 @@ void Picard3D::readSpatialGrid3D() {
 
 	Vector3d volumeOrigin = gridOrigin - spacing * 0.5;
 
-	for (int energyIndex = 0; energyIndex < numberOfEnergies; ++energyIndex) {
-		grid.push_back(std::make_unique<ScalarGridQPDensityPerEnergy>(
-		    ScalarGridQPDensityPerEnergy(volumeOrigin, numberOfXValues, numberOfYValues, numberOfZValues, spacing)));
-	}
+	grid = std::make_unique<SpectralGridQPDensityPerEnergy>(volumeOrigin, numberOfXValues, numberOfYValues,
+	                                                        numberOfZValues, spacing, numberOfEnergies);
 }
 
 std::size_t Picard3D::getArrayIndex3D(std::size_t xIndex, std::size_t yIndex, std::size_t zIndex) const {
@@ -165,7 +244,7 @@ void Picard3D::readDensity3D() {
 						auto flux = fluxTimesEnergySquared / (kineticEnergyPerNucleon * kineticEnergyPerNucleon);
 
 						auto density = fluxToDensity * flux;
-						grid[energyIndex]->addValue(xIndex, yIndex, zIndex, density);
+						grid->addValue(xIndex, yIndex, zIndex, energyIndex, density);
 					}
 				}
 			}
@@ -191,7 +270,18 @@ QPDensityPerEnergy Picard3D::getDensityPerEnergy(int energyIndex, const Vector3Q
 	if (position.y < yMin || position.y > yMax) return {0};
 	if (position.z < zMin || position.z > zMax) return {0};
 
-	return (grid[energyIndex])->interpolate(position);
+	return grid->interpolate(position, energyIndex);
+}
+
+void Picard3D::getDensitySpectrum(const Vector3QLength &position, std::vector<QPDensityPerEnergy> &out) const {
+	out.resize(energyRange.size());
+	if (position.x < xMin || position.x > xMax || position.y < yMin || position.y > yMax || position.z < zMin ||
+	    position.z > zMax) {
+		std::fill(out.begin(), out.end(), QPDensityPerEnergy(0));
+		return;
+	}
+
+	grid->interpolateSpectrum(position, out);
 }
 
 std::array<QLength, 2> Picard3D::getXBoundaries() const { return {xMin, xMax}; }
@@ -5,6 +5,8 @@
 #include <cmath>
 #include <iostream>
 
+#include "hermes/GSLWorkspace.h"
+
 namespace hermes { namespace darkmatter {
 
 static const double f_NFW(double x, double gamma) {
@@ -22,13 +24,12 @@ double I_func(double x, void *params) {
 }
 
 double I(double c, double gamma) {
-	gsl_integration_workspace *w = gsl_integration_workspace_alloc(1000);
+	GSLWorkspace w(1000);
 	double result, error;
 	gsl_function F;
 	F.function = &I_func;
 	F.params = &gamma;
-	gsl_integration_qags(&F, 0, c, 0, 1e-7, 1000, w, &result, &error);
-	gsl_integration_workspace_free(w);
+	gsl_integration_qags(&F, 0, c, 0, 1e-7, 1000, w.get(), &result, &error);
 
 	return result;
 }
@@ -24,6 +24,10 @@ BremsstrahlungIntegrator::BremsstrahlungIntegrator(
 
 BremsstrahlungIntegrator::~BremsstrahlungIntegrator() {}
 
+void BremsstrahlungIntegrator::prepareSkymapParameters(const std::vector<QEnergy> &Egammas_) {
+	prepareCrossSectionTable(Egammas_);
+}
+
 QPiZeroIntegral BremsstrahlungIntegrator::integrateOverEnergy(
     const Vector3QLength &pos_, const QEnergy &Egamma_) const {
 	if (cacheTableInitialized) return getIOEfromCache(pos_, Egamma_);
@@ -51,12 +55,13 @@ QPiZeroIntegral BremsstrahlungIntegrator::integrateOverEnergy(
 
 	auto pid_projectile = crDensity->getPID();
 
+	std::vector<QPDensityPerEnergy> spectrum;
+	crDensity->getDensitySpectrum(pos_, spectrum);
+
 	std::vector<QPDensity> cosmicRayVector;
-	std::transform(crDensity->beginAfterEnergy(Egamma_), crDensity->end(),
-	               std::back_inserter(cosmicRayVector),
-	               [crDensity, pos_](const QEnergy &E) -> QPDensity {
-		               return crDensity->getDensityPerEnergy(E, pos_) * E;
-	               });
+	for (auto itE = crDensity->beginAfterEnergy(Egamma_);
+	     itE != crDensity->end(); ++itE)
+		cosmicRayVector.push_back(spectrum[itE - crDensity->begin()] * (*itE));
 
 	std::vector<QPiZeroIntegral> integral;
 	std::transform(cosmicRayVector.begin(), cosmicRayVector.end(),
@@ -73,4 +78,41 @@ QPiZeroIntegral BremsstrahlungIntegrator::integrateOverEnergy(
 	return integralOverEnergy;
 }
 
+std::vector<QPiZeroIntegral> BremsstrahlungIntegrator::integrateOverEnergy(
+    const Vector3QLength &pos_, const std::vector<QEnergy> &Egammas_) const {
+	auto crDensity = crList[0];
+
+	// the density is shared by all gamma-ray energies
+	std::vector<QPDensityPerEnergy> spectrum;
+	crDensity->getDensitySpectrum(pos_, spectrum);
+
+	std::vector<QPDensity> cosmicRayVector;
+	for (auto itE = crDensity->begin(); itE != crDensity->end(); ++itE)
+		cosmicRayVector.push_back(spectrum[itE - crDensity->begin()] * (*itE));
+
+	std::vector<QPiZeroIntegral> total(Egammas_.size(), QPiZeroIntegral(0));
+	for (std::size_t k = 0; k < Egammas_.size(); ++k) {
+		const QEnergy Egamma = Egammas_[k];
+
+		QPiZeroIntegral integral(0);
+		for (auto itE = crDensity->beginAfterEnergy(Egamma);
+		     itE != crDensity->end(); ++itE) {
+			// brems = cs_HI + cs_He*He_abundance
+			QDiffCrossSection crossSection =
+			    crossSecBrem->getDiffCrossSectionForTarget(
+			        interactions::BremsstrahlungAbstract::Target::HI, *itE,
+			        Egamma) +
+			    0.1 * crossSecBrem->getDiffCrossSectionForTarget(
+			              interactions::BremsstrahlungAbstract::Target::He,
+			              *itE, Egamma);
+			integral += cosmicRayVector[itE - crDensity->begin()] *
+			            crossSection * c_light;
+		}
+		// log-integration
+		total[k] = std::log(crDensity->getEnergyScaleFactor()) * integral;
+	}
+
+	return total;
+}
+
 }  // namespace hermes
@@ -0,0 +1,109 @@
+#include "hermes/integrators/CacheTableStore.h"
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+
+#include <cstring>
+
+#include "hermes/BinaryCache.h"
+
+namespace hermes {
+
+namespace {
+/**
+    Exclusive lock on "<entry>.lock", held while an entry is reloaded,
+    merged and replaced, so that processes (and threads) sharing
+    HERMES_CACHE_PATH do not drop each other's tables
+*/
+class EntryLock {
+	int fd;
+
+  public:
+	explicit EntryLock(const std::string &filename) : fd(::open((filename + ".lock").c_str(), O_RDWR | O_CREAT, 0644)) {
+		if (fd >= 0) ::flock(fd, LOCK_EX);
+	}
+	~EntryLock() {
+		if (fd >= 0) ::close(fd);  // releases the lock
+	}
+	EntryLock(const EntryLock &) = delete;
+	EntryLock &operator=(const EntryLock &) = delete;
+};
+}  // namespace
+
+CacheTableStore::CacheTableStore(const std::string &tag_) : tag(tag_) {}
+
+bool CacheTableStore::isEnabled() const { return !getBinaryCachePath().empty(); }
+
+CacheTableStore &CacheTableStore::addKey(double v) {
+	std::uint64_t bits;
+	std::memcpy(&bits, &v, sizeof(double));
+	keys.push_back(bits);
+	return *this;
+}
+
+CacheTableStore &CacheTableStore::addKey(std::uint64_t v) {
+	keys.push_back(v);
+	return *this;
+}
+
+CacheTableStore &CacheTableStore::addKey(const std::string &s) {
+	keys.push_back(stringHash(s));
+	return *this;
+}
+
+std::vector<Vector3QLength> CacheTableStore::getProbePositions() {
+	return {Vector3QLength(8.5_kpc, 0_kpc, 0_kpc), Vector3QLength(4_kpc, 3_kpc, 0.1_kpc),
+	        Vector3QLength(-2_kpc, -1_kpc, 0.5_kpc), Vector3QLength(12_kpc, -7_kpc, -1_kpc)};
+}
+
+bool CacheTableStore::loadValues(const QEnergy &E, void *out, std::size_t bytes) const {
+	if (!isEnabled()) return false;
+	BinaryCache cache(tag, keys);
+	if (!cache.load()) return false;
+
+	// the metadata are the energies (in J) of the tables in the payload
+	const std::vector<double> &energies = cache.getMetadata();
+	if (cache.getPayloadSize() != energies.size() * bytes) return false;
+	for (std::size_t i = 0; i < energies.size(); ++i)
+		if (energies[i] == static_cast<double>(E)) {
+			std::memcpy(out, static_cast<const char *>(cache.getPayload()) + i * bytes, bytes);
+			return true;
+		}
+	return false;
+}
+
+bool CacheTableStore::storeValues(const QEnergy &E, const void *values, std::size_t bytes) const {
+	if (!isEnabled()) return false;
+	BinaryCache cache(tag, keys);
+	EntryLock lock(cache.getFilename());
+
+	// merge with the tables stored by others since this one was loaded
+	std::vector<double> energies;
+	std::vector<char> payload;
+	if (cache.load() && cache.getPayloadSize() == cache.getMetadata().size() * bytes) {
+		const char *old = static_cast<const char *>(cache.getPayload());
+		for (std::size_t i = 0; i < cache.getMetadata().size(); ++i) {
+			if (cache.getMetadata()[i] == static_cast<double>(E)) continue;
+			energies.push_back(cache.getMetadata()[i]);
+			payload.insert(payload.end(), old + i * bytes, old + (i + 1) * bytes);
+		}
+	}
+	energies.push_back(static_cast<double>(E));
+	payload.insert(payload.end(), static_cast<const char *>(values), static_cast<const char *>(values) + bytes);
+
+	return cache.store(energies, payload.data(), payload.size());
+}
+
+std::vector<QEnergy> CacheTableStore::getEnergies() const {
+	std::vector<QEnergy> energies;
+	if (!isEnabled()) return energies;
+	BinaryCache cache(tag, keys);
+	if (!cache.load()) return energies;
+	for (double E : cache.getMetadata()) energies.push_back(QEnergy(E));
+	return energies;
+}
+
+std::string CacheTableStore::getFilename() const { return BinaryCache(tag, keys).getFilename(); }
+
+}  // namespace hermes
@@ -20,14 +20,13 @@ QDiffIntensity DarkMatterIntegrator::integrateOverLOS(
 
 QDiffIntensity DarkMatterIntegrator::integrateOverLOS(
     const QDirection &direction_, const QEnergy &Egamma_) const {
-	auto integrand = [this, direction_, Egamma_](const QLength &dist) {
-		return this->spectralEmissivity(
-		    getGalacticPosition(getObsPosition(), dist, direction_), Egamma_);
+	const LOSRay ray = getRay(direction_);
+	auto integrand = [this, &ray, Egamma_](const QLength &dist) {
+		return this->spectralEmissivity(ray.getPosition(dist), Egamma_);
 	};
 
 	return gslQAGSIntegration<QDiffFlux, QGREmissivity>(
-	           [integrand](QLength dist) { return integrand(dist); }, 0,
-	           getMaxDistance(direction_), 500) /
+	           integrand, 0, ray.maxDistance, 500) /
 	       (4_pi * 1_sr);
 }
 
@@ -9,23 +9,39 @@ DispersionMeasureIntegrator::DispersionMeasureIntegrator(const std::shared_ptr<i
 
 DispersionMeasureIntegrator::~DispersionMeasureIntegrator() {}
 
+void DispersionMeasureIntegrator::setSampleStore(const std::shared_ptr<LOSSampleStore> &store) {
+	if (store != nullptr) registerSampleStoreModels(*store, nullptr, gdensity, nullptr);
+	sampleStore = store;
+}
+
+std::shared_ptr<LOSSampleStore> DispersionMeasureIntegrator::getSampleStore() const { return sampleStore; }
+
+bool DispersionMeasureIntegrator::useSampleStore() const {
+	return sampleStore != nullptr && sampleStore->getObsPosition() == observerPosition;
+}
+
 QDispersionMeasure DispersionMeasureIntegrator::integrateOverLOS(const QDirection &direction) const {
-	auto integrand = [this, direction](const QLength &dist) {
-		return gdensity->getDensity(getGalacticPosition(getObsPosition(), dist, direction));
-	};
+	if (useSampleStore()) {
+		auto samples = sampleStore->getSamples(direction);
+		QDispersionMeasure total(0);
+		for (std::size_t i = 0; i < samples->size(); ++i)
+			total += samples->ionizedGasDensity[i] * samples->getSimpsonWeight(i);
+		return total;
+	}
+
+	const LOSRay ray = getRay(direction);
+	auto integrand = [this, &ray](const QLength &dist) { return gdensity->getDensity(ray.getPosition(dist)); };
 
-	return gslQAGIntegration<QDispersionMeasure, QPDensity>([this, integrand](QLength dist) { return integrand(dist); },
-	                                                        0, getMaxDistance(direction), 500);
+	return gslQAGIntegration<QDispersionMeasure, QPDensity>(integrand, 0, ray.maxDistance, 500);
 }
 
 DispersionMeasureIntegrator::tLOSProfile DispersionMeasureIntegrator::getLOSProfile(const QDirection &direction,
                                                                                     int Nsteps) const {
-	auto integrand = [this, direction](const QLength &dist) {
-		return gdensity->getDensity(getGalacticPosition(getObsPosition(), dist, direction));
-	};
+	const LOSRay ray = getRay(direction);
+	auto integrand = [this, &ray](const QLength &dist) { return gdensity->getDensity(ray.getPosition(dist)); };
 
 	QLength start = 0_m;
-	QLength stop = getMaxDistance(direction);
+	QLength stop = ray.maxDistance;
 	QLength delta_d = (stop - start) / Nsteps;
 
 	tLOSProfile profile;
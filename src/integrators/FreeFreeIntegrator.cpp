@@ -15,15 +15,59 @@ QTemperature FreeFreeIntegrator::integrateOverLOS(const QDirection &direction) c
 	return integrateOverLOS(direction, 408.0_GHz);
 }
 
-QTemperature FreeFreeIntegrator::integrateOverLOS(const QDirection &direction, const QFrequency &freq_) const {
-	auto integrand = [this, direction, freq_](const QLength &dist) {
-		return this->spectralEmissivity(getGalacticPosition(getObsPosition(), dist, direction), freq_);
-	};
+void FreeFreeIntegrator::setSampleStore(const std::shared_ptr<LOSSampleStore> &store) {
+	if (store != nullptr) registerSampleStoreModels(*store, nullptr, gdensity, nullptr);
+	sampleStore = store;
+}
 
-	QIntensity total_intensity = simpsonIntegration<QIntensity, QEmissivity>(
-	    [integrand](QLength dist) { return integrand(dist); }, 0, getMaxDistance(direction), 500);
+std::shared_ptr<LOSSampleStore> FreeFreeIntegrator::getSampleStore() const { return sampleStore; }
 
-	return intensityToTemperature(total_intensity / 4_pi, freq_);
+bool FreeFreeIntegrator::useSampleStore() const {
+	return sampleStore != nullptr && sampleStore->getObsPosition() == observerPosition;
+}
+
+QTemperature FreeFreeIntegrator::integrateOverLOS(const QDirection &direction, const QFrequency &freq_) const {
+	return integrateOverLOS(direction, std::vector<QFrequency>{freq_})[0];
+}
+
+std::vector<QTemperature> FreeFreeIntegrator::integrateOverLOS(const QDirection &direction,
+                                                             const std::vector<QFrequency> &freqs_) const {
+	const int Z = 1;
+	const QTemperature T = gdensity->getTemperature();
+
+	// the gas density is looked up once per node for all frequencies,
+	// either from the sample store or in one batch
+	std::shared_ptr<const LOSSamples> samples;
+	std::vector<QPDensity> density;
+	std::vector<QLength> weight;
+	if (useSampleStore()) {
+		samples = sampleStore->getSamples(direction);
+		for (std::size_t i = 0; i < samples->size(); ++i) weight.push_back(samples->getSimpsonWeight(i));
+	} else {
+		const int N = 500;
+		const LOSRay ray = getRay(direction);
+		const QLength h = ray.maxDistance / N;
+		std::vector<Vector3QLength> pos;
+		pos.reserve(N + 1);
+		for (int i = 0; i <= N; ++i) {
+			pos.push_back(ray.getPosition(h * static_cast<double>(i)));
+			weight.push_back(simpsonWeight(i, N, h));
+		}
+		gdensity->getDensity(pos, density);
+	}
+
+	std::vector<QIntensity> intensities(freqs_.size(), QIntensity(0));
+	for (std::size_t i = 0; i < weight.size(); ++i) {
+		QPDensity N = (samples != nullptr) ? samples->ionizedGasDensity[i] : density[i];
+		for (std::size_t k = 0; k < freqs_.size(); ++k)
+			intensities[k] += spectralEmissivityExplicit(N, N, freqs_[k], T, Z) * weight[i];
+	}
+
+	std::vector<QTemperature> result;
+	result.reserve(freqs_.size());
+	for (std::size_t k = 0; k < freqs_.size(); ++k)
+		result.push_back(intensityToTemperature(intensities[k] / 4_pi, freqs_[k]));
+	return result;
 }
 
 QNumber FreeFreeIntegrator::gauntFactor(const QFrequency &freq, const QTemperature &T, int Z) const {
@@ -48,10 +92,14 @@ QEmissivity FreeFreeIntegrator::spectralEmissivity(const Vector3QLength &pos_, c
 }
 
 QInverseLength FreeFreeIntegrator::absorptionCoefficient(const Vector3QLength &pos_, const QFrequency &freq_) const {
+	return absorptionCoefficientExplicit(gdensity->getDensity(pos_), freq_);
+}
+
+QInverseLength FreeFreeIntegrator::absorptionCoefficientExplicit(const QPDensity &N, const QFrequency &freq_) const {
 	QTemperature T = 1e4_K;
 
-	return spectralEmissivity(pos_, freq_) * c_squared / (8_pi * h_planck * pow<3>(freq_)) *
-	       expm1(h_planck * freq_ / (k_boltzmann * T));
+	return spectralEmissivityExplicit(N, N, freq_, gdensity->getTemperature(), 1) * c_squared /
+	       (8_pi * h_planck * pow<3>(freq_)) * expm1(h_planck * freq_ / (k_boltzmann * T));
 }
 
 QEmissivity FreeFreeIntegrator::spectralEmissivityExplicit(const QPDensity &N, const QPDensity &N_e,
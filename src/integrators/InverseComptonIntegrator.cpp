@@ -1,18 +1,33 @@
 #include "hermes/integrators/InverseComptonIntegrator.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <functional>
 #include <iostream>
+#include <iterator>
 #include <memory>
 #include <mutex>
+#include <shared_mutex>
 #include <stdexcept>
-#include <thread>
+#include <typeinfo>
+#include <unordered_map>
 
 #include "hermes/Common.h"
 #include "hermes/Signals.h"
+#include "hermes/ThreadPool.h"
 #include "hermes/integrators/LOSIntegrationMethods.h"
 
 namespace hermes {
 
+struct InverseComptonIntegrator::ICKernelCache {
+	/** the kernels are dropped once there are as many */
+	static constexpr std::size_t maxSize = 1024;
+	std::shared_mutex mtx;
+	std::unordered_map<std::uint64_t, std::shared_ptr<const ICKernel>> kernels;
+};
+
 InverseComptonIntegrator::InverseComptonIntegrator(
     const std::shared_ptr<cosmicrays::CosmicRayDensity> &crdensity_,
     const std::shared_ptr<photonfields::PhotonField> &phdensity_,
@@ -20,19 +35,15 @@ InverseComptonIntegrator::InverseComptonIntegrator(
     : GammaIntegratorTemplate("InverseCompton"),
       crdensity(crdensity_),
       phdensity(phdensity_),
-      crossSec(crossSec_) {}
+      crossSec(crossSec_),
+      kernelCache(std::make_shared<ICKernelCache>()) {}
 
 InverseComptonIntegrator::~InverseComptonIntegrator() {}
 
-void InverseComptonIntegrator::computeCacheInThread(
-    std::size_t start, std::size_t end, const QEnergy &Egamma,
-    std::shared_ptr<ProgressBar> &p) {
-	for (std::size_t i = start; i < end; ++i) {
-		auto pos =
-		    static_cast<Vector3QLength>(cacheTable->positionFromIndex(i));
-		cacheTable->get(i) = this->integrateOverEnergy(pos, Egamma);
-		p->update();
-	}
+void InverseComptonIntegrator::computeCacheEntry(std::size_t i,
+                                                 const QEnergy &Egamma) {
+	auto pos = static_cast<Vector3QLength>(cacheTable->positionFromIndex(i));
+	cacheTable->get(i) = this->integrateOverEnergy(pos, Egamma);
 }
 
 void InverseComptonIntegrator::setupCacheTable(int N_x, int N_y, int N_z) {
@@ -57,33 +68,60 @@ void InverseComptonIntegrator::initCacheTable() {
 
 	if (cacheTableInitialized) cacheTableInitialized = false;
 
+	const QEnergy Egamma = skymapParameter;
+	CacheTableStore store = getCacheTableStore();
+	if (store.load(Egamma, *cacheTable)) {
+		cacheTableInitialized = true;
+		return;
+	}
+
+	auto pool = getThreadPool();
 	std::cout << "hermes::Integrator::initCacheTable: Number of Threads: "
-	          << getThreadsNumber() << std::endl;
+	          << pool->size() << std::endl;
 
-	const QEnergy Egamma = skymapParameter;
 	size_t grid_size = cacheTable->getGridSize();
 
 	// Progressbar init
-	auto progressbar = std::make_shared<ProgressBar>(ProgressBar(grid_size));
-	auto progressbar_mutex = std::make_shared<std::mutex>();
-	progressbar->setMutex(progressbar_mutex);
+	auto progressbar = std::make_shared<ProgressBar>(grid_size);
 	progressbar->start("Generate Cache Table");
 
-	auto job_chunks = getThreadChunks(grid_size);
-	std::vector<std::thread> threads;
-	threads.reserve(job_chunks.size());
-	for (auto &c : job_chunks) {
-		threads.push_back(
-		    std::thread(&InverseComptonIntegrator::computeCacheInThread, this,
-		                c.first, c.second, Egamma, std::ref(progressbar)));
-	}
-	for (auto &t : threads) {
-		t.join();
-	}
+	auto stats = pool->parallelFor(grid_size, [&](std::size_t i) {
+		computeCacheEntry(i, Egamma);
+		progressbar->update();
+	});
+	progressbar->stop();
+	std::cout << "hermes::Integrator::initCacheTable: " << stats << std::endl;
+	store.store(Egamma, *cacheTable);
 
 	cacheTableInitialized = true;
 }
 
+CacheTableStore InverseComptonIntegrator::getCacheTableStore() const {
+	CacheTableStore store(getDescription() + "_CacheTable");
+	store.addKey(typeid(*crossSec).name())
+	    .addKey(typeid(*crdensity).name())
+	    .addKey(typeid(*phdensity).name());
+	if (store.isEnabled()) store.addKey(crdensity->getSourceHashes());
+	store.addKey(crdensity->getEnergyAxis()).addKey(phdensity->getEnergyAxis());
+	store.addKey(static_cast<std::uint64_t>(crdensity->existsScaleFactor()));
+
+	std::vector<QPDensityPerEnergy> leptons;
+	std::vector<QEnergyDensity> photons;
+	for (const auto &pos : CacheTableStore::getProbePositions()) {
+		crdensity->getDensitySpectrum(pos, leptons);
+		phdensity->getSpectrum(pos, photons);
+		store.addKey(leptons).addKey(photons);
+	}
+	store.addKey(static_cast<double>(
+	    crossSec->getDiffCrossSection(10_GeV, 1_eV, 1_GeV)));
+
+	// the photon field table changes the emissivity slightly
+	store.addKey(photonRAxis).addKey(photonZAxis);
+
+	store.addGrid(*cacheTable);
+	return store;
+}
+
 QGREmissivity InverseComptonIntegrator::getIOEfromCache(
     const Vector3QLength &pos_, const QEnergy &Egamma_) const {
 	return cacheTable->interpolate(static_cast<Vector3d>(pos_));
@@ -96,55 +134,251 @@ QDiffIntensity InverseComptonIntegrator::integrateOverLOS(
 
 QDiffIntensity InverseComptonIntegrator::integrateOverLOS(
     const QDirection &direction_, const QEnergy &Egamma_) const {
-	auto integrand = [this, direction_, Egamma_](const QLength &dist) {
-		return this->integrateOverEnergy(
-		    getGalacticPosition(getObsPosition(), dist, direction_), Egamma_);
+	const LOSRay ray = getRay(direction_);
+	auto integrand = [this, &ray, Egamma_](const QLength &dist) {
+		return this->integrateOverEnergy(ray.getPosition(dist), Egamma_);
 	};
 
 	return gslQAGIntegration<QDiffFlux, QGREmissivity>(
-	           [integrand](QLength dist) { return integrand(dist); }, 0,
-	           getMaxDistance(direction_), 500) /
+	           integrand, 0, ray.maxDistance, 500) /
 	       (4_pi * 1_sr);
 }
 
-QGREmissivity InverseComptonIntegrator::integrateOverEnergy(
-    const Vector3QLength &pos_, const QEnergy &Egamma_) const {
-	if (cacheTableInitialized) return getIOEfromCache(pos_, Egamma_);
+std::vector<QDiffIntensity> InverseComptonIntegrator::integrateOverLOS(
+    const QDirection &direction_, const std::vector<QEnergy> &Egammas_) const {
+	const LOSRay ray = getRay(direction_);
+	auto integrand = [this, &ray, &Egammas_](const QLength &dist) {
+		return this->integrateOverEnergy(ray.getPosition(dist), Egammas_);
+	};
+
+	auto integrals = simpsonIntegrationSpectrum<QDiffFlux, QGREmissivity>(
+	    integrand, Egammas_.size(), 0, ray.maxDistance, 500);
+
+	std::vector<QDiffIntensity> result;
+	result.reserve(integrals.size());
+	for (const auto &i : integrals) result.push_back(i / (4_pi * 1_sr));
+	return result;
+}
+
+void InverseComptonIntegrator::setupPhotonFieldTable() {
+	std::vector<QLength> r, z;
+	for (int i = 0; i <= 60; ++i) r.push_back(0.5_kpc * static_cast<double>(i));
+	for (double v : {0.0, 0.1, 0.2, 0.3, 0.4, 0.5, 0.6, 0.8, 1.0, 1.2, 1.5, 2.0,
+	                 2.5, 3.0, 4.0, 5.0, 6.0, 8.0, 10.0, 12.0, 15.0, 20.0, 25.0,
+	                 30.0})
+		z.push_back(v * 1_kpc);
+	setupPhotonFieldTable(r, z);
+}
+
+void InverseComptonIntegrator::setupPhotonFieldTable(
+    const std::vector<QLength> &r, const std::vector<QLength> &z) {
+	if (r.size() < 2 || z.size() < 2)
+		throw std::runtime_error(
+		    "hermes::InverseComptonIntegrator: the photon field table needs "
+		    "at least 2 nodes per axis");
+	std::vector<double> rAxis, zAxis;
+	for (const auto &v : r) rAxis.push_back(static_cast<double>(v));
+	for (const auto &v : z) zAxis.push_back(static_cast<double>(v));
+	for (const auto *a : {&rAxis, &zAxis})
+		for (std::size_t i = 1; i < a->size(); ++i)
+			if (!((*a)[i] > (*a)[i - 1]))
+				throw std::runtime_error(
+				    "hermes::InverseComptonIntegrator: axis nodes must be "
+				    "increasing");
+	if (zAxis.front() < 0)
+		throw std::runtime_error(
+		    "hermes::InverseComptonIntegrator: the z axis is for |z|");
+
+	const std::size_t nPhoton = phdensity->getEnergyAxis().size();
+	std::vector<double> table(rAxis.size() * zAxis.size() * nPhoton);
+	getThreadPool()->parallelFor(
+	    rAxis.size() * zAxis.size(), [&](std::size_t n) {
+		    Vector3QLength pos(0_m);
+		    pos.x = QLength(rAxis[n / zAxis.size()]);
+		    pos.z = QLength(zAxis[n % zAxis.size()]);
+		    std::vector<QEnergyDensity> spectrum;
+		    phdensity->getSpectrum(pos, spectrum);
+		    double *out = table.data() + n * nPhoton;
+		    for (std::size_t i = 0; i < nPhoton; ++i)
+			    out[i] = static_cast<double>(spectrum[i]);
+	    });
+
+	photonRAxis = std::move(rAxis);
+	photonZAxis = std::move(zAxis);
+	photonTable = std::move(table);
+}
+
+bool InverseComptonIntegrator::hasPhotonFieldTable() const {
+	return !photonTable.empty();
+}
+
+void InverseComptonIntegrator::getPhotonSpectrum(const Vector3QLength &pos_,
+                                                 std::vector<double> &u) const {
+	const std::size_t nPhoton = phdensity->getEnergyAxis().size();
+	u.resize(nPhoton);
+	if (photonTable.empty()) {
+		thread_local std::vector<QEnergyDensity> spectrum;
+		phdensity->getSpectrum(pos_, spectrum);
+		for (std::size_t i = 0; i < nPhoton; ++i)
+			u[i] = static_cast<double>(spectrum[i]);
+		return;
+	}
 
+	// bilinear in (r, |z|), clamped to the table
+	auto locate = [](const std::vector<double> &axis, double v,
+	                 std::size_t &i, double &f) {
+		v = std::min(std::max(v, axis.front()), axis.back());
+		i = std::upper_bound(axis.begin() + 1, axis.end() - 1, v) -
+		    axis.begin() - 1;
+		f = (v - axis[i]) / (axis[i + 1] - axis[i]);
+	};
+	std::size_t ir, iz;
+	double fr, fz;
+	locate(photonRAxis,
+	       static_cast<double>(sqrt(pos_.x * pos_.x + pos_.y * pos_.y)), ir,
+	       fr);
+	locate(photonZAxis, std::fabs(static_cast<double>(pos_.z)), iz, fz);
+
+	const std::size_t nz = photonZAxis.size();
+	const double *c00 = photonTable.data() + (ir * nz + iz) * nPhoton;
+	const double *c01 = c00 + nPhoton;
+	const double *c10 = c00 + nz * nPhoton;
+	const double *c11 = c10 + nPhoton;
+	const double w00 = (1 - fr) * (1 - fz), w01 = (1 - fr) * fz,
+	             w10 = fr * (1 - fz), w11 = fr * fz;
+	for (std::size_t i = 0; i < nPhoton; ++i)
+		u[i] = w00 * c00[i] + w01 * c01[i] + w10 * c10[i] + w11 * c11[i];
+}
+
+void InverseComptonIntegrator::getLeptonSpectrum(const Vector3QLength &pos_,
+                                                 std::vector<double> &n) const {
+	thread_local std::vector<QPDensityPerEnergy> spectrum;
+	crdensity->getDensitySpectrum(pos_, spectrum);
+	n.resize(spectrum.size());
+	for (std::size_t j = 0; j < spectrum.size(); ++j)
+		n[j] = static_cast<double>(spectrum[j]);
+}
+
+std::shared_ptr<const InverseComptonIntegrator::ICKernel>
+InverseComptonIntegrator::getKernel(const QEnergy &Egamma_) const {
+	const double E = static_cast<double>(Egamma_);
+	std::uint64_t key;
+	std::memcpy(&key, &E, sizeof(double));
+	{
+		std::shared_lock<std::shared_mutex> lock(kernelCache->mtx);
+		auto it = kernelCache->kernels.find(key);
+		if (it != kernelCache->kernels.end()) return it->second;
+	}
+
+	const std::vector<QEnergy> eps = phdensity->getEnergyAxis();
+	const std::vector<QEnergy> Ee = crdensity->getEnergyAxis();
+	auto kernel = std::make_shared<ICKernel>();
+	kernel->nPhoton = eps.size();
+	kernel->matrix.assign(Ee.size() * eps.size(), 0.);
+
+	// quadrature weights of the lepton energies, as in
+	// integrateOverPhotonEnergy() and the former sum/log integrations
+	std::vector<QEnergy> weights(Ee.size(), 0_J);
 	if (crdensity->existsScaleFactor()) {
-		return integrateOverLogEnergy(pos_, Egamma_);
+		for (std::size_t j = 0; j < Ee.size(); ++j)
+			weights[j] = Ee[j] * log(crdensity->getEnergyScaleFactor());
 	} else {
-		return integrateOverSumEnergy(pos_, Egamma_);
+		for (std::size_t j = 1; j < Ee.size(); ++j)
+			weights[j] = Ee[j] - Ee[j - 1];
 	}
-}
 
-QGREmissivity InverseComptonIntegrator::integrateOverSumEnergy(
-    const Vector3QLength &pos_, const QEnergy &Egamma_) const {
-	QGREmissivity integral(0);
-	QEnergy deltaE;
+	for (std::size_t j = 0; j < Ee.size(); ++j) {
+		if (weights[j] == 0_J) continue;
+		double *row = kernel->matrix.data() + j * eps.size();
+		for (std::size_t i = 1; i < eps.size(); ++i) {
+			QNumber xlog = log(eps[i] / eps[i - 1]);
+			// per unit photon energy density and lepton density
+			QGREmissivity value =
+			    c_light * weights[j] * eps[i] * xlog *
+			    crossSec->getDiffCrossSection(Ee[j], eps[i], Egamma_) /
+			    pow<2>(eps[i]) * (1_J / 1_m3) / (1_J * 1_m3);
+			row[i] = static_cast<double>(value);
+		}
+	}
 
-	for (auto itE = std::next(crdensity->begin()); itE != crdensity->end();
-	     ++itE) {
-		deltaE = (*itE) - *std::prev(itE);
-		integral += integrateOverPhotonEnergy(pos_, Egamma_, (*itE)) *
-		            crdensity->getDensityPerEnergy(*itE, pos_) * c_light *
-		            deltaE;
+	std::unique_lock<std::shared_mutex> lock(kernelCache->mtx);
+	if (kernelCache->kernels.size() >= ICKernelCache::maxSize) kernelCache->kernels.clear();
+	return kernelCache->kernels.emplace(key, std::move(kernel))
+	    .first->second;
+}
+
+double InverseComptonIntegrator::contract(const ICKernel &kernel,
+                                          const double *n, const double *u) {
+	const std::size_t nPhoton = kernel.nPhoton;
+	const std::size_t nLepton = kernel.matrix.size() / nPhoton;
+	double total = 0;
+	for (std::size_t j = 0; j < nLepton; ++j) {
+		const double *row = kernel.matrix.data() + j * nPhoton;
+		double inner = 0;
+		for (std::size_t i = 0; i < nPhoton; ++i) inner += row[i] * u[i];
+		total += n[j] * inner;
 	}
+	return total;
+}
 
-	return integral;
+std::vector<QGREmissivity> InverseComptonIntegrator::integrateOverEnergy(
+    const Vector3QLength &pos_, const std::vector<QEnergy> &Egammas_) const {
+	// densities are shared by all gamma-ray energies
+	thread_local std::vector<double> u, n;
+	getPhotonSpectrum(pos_, u);
+	getLeptonSpectrum(pos_, n);
+
+	std::vector<QGREmissivity> result(Egammas_.size(), QGREmissivity(0));
+	for (std::size_t k = 0; k < Egammas_.size(); ++k)
+		result[k] = QGREmissivity(
+		    contract(*getKernel(Egammas_[k]), n.data(), u.data()));
+
+	return result;
 }
 
-QGREmissivity InverseComptonIntegrator::integrateOverLogEnergy(
+QGREmissivity InverseComptonIntegrator::integrateOverEnergy(
     const Vector3QLength &pos_, const QEnergy &Egamma_) const {
-	QGREmissivity integral(0);
+	if (cacheTableInitialized) return getIOEfromCache(pos_, Egamma_);
+
+	thread_local std::vector<double> u, n;
+	getPhotonSpectrum(pos_, u);
+	getLeptonSpectrum(pos_, n);
+
+	return QGREmissivity(contract(*getKernel(Egamma_), n.data(), u.data()));
+}
 
-	for (auto itE = crdensity->begin(); itE != crdensity->end(); ++itE) {
-		integral += integrateOverPhotonEnergy(pos_, Egamma_, (*itE)) *
-		            crdensity->getDensityPerEnergy((*itE), pos_) * (*itE) *
-		            c_light;
+std::vector<QGREmissivity> InverseComptonIntegrator::integrateOverEnergy(
+    const std::vector<Vector3QLength> &positions_,
+    const QEnergy &Egamma_) const {
+	auto kernel = getKernel(Egamma_);
+	const std::size_t nPhoton = kernel->nPhoton;
+	const std::size_t nLepton = kernel->matrix.size() / nPhoton;
+	const std::size_t nPos = positions_.size();
+
+	std::vector<double> u(nPos * nPhoton), n(nPos * nLepton);
+	std::vector<double> buffer;
+	for (std::size_t p = 0; p < nPos; ++p) {
+		getPhotonSpectrum(positions_[p], buffer);
+		std::copy(buffer.begin(), buffer.end(), u.begin() + p * nPhoton);
+		getLeptonSpectrum(positions_[p], buffer);
+		std::copy(buffer.begin(), buffer.end(), n.begin() + p * nLepton);
 	}
 
-	return integral * log(crdensity->getEnergyScaleFactor());
+	std::vector<double> total(nPos, 0.);
+	for (std::size_t j = 0; j < nLepton; ++j) {
+		const double *row = kernel->matrix.data() + j * nPhoton;
+		for (std::size_t p = 0; p < nPos; ++p) {
+			const double *up = u.data() + p * nPhoton;
+			double inner = 0;
+			for (std::size_t i = 0; i < nPhoton; ++i) inner += row[i] * up[i];
+			total[p] += n[p * nLepton + j] * inner;
+		}
+	}
+
+	std::vector<QGREmissivity> result;
+	result.reserve(nPos);
+	for (double t : total) result.push_back(QGREmissivity(t));
+	return result;
 }
 
 QICInnerIntegral InverseComptonIntegrator::integrateOverPhotonEnergy(
@@ -174,21 +408,26 @@ QICInnerIntegral InverseComptonIntegrator::integrateOverPhotonEnergy(
 
 InverseComptonIntegrator::tLOSProfile InverseComptonIntegrator::getLOSProfile(
     const QDirection &direction, const QEnergy &Egamma, int Nsteps) const {
-	auto integrand = [this, direction, Egamma](const QLength &dist) {
-		return this->integrateOverEnergy(
-		    getGalacticPosition(getObsPosition(), dist, direction), Egamma);
-	};
-
+	const LOSRay ray = getRay(direction);
 	QLength start = 0_m;
-	QLength stop = getMaxDistance(direction);
+	QLength stop = ray.maxDistance;
 	QLength delta_d = (stop - start) / Nsteps;
 
 	tLOSProfile profile;
-
+	std::vector<Vector3QLength> positions;
 	for (QLength dist = start; dist <= stop; dist += delta_d) {
 		profile.first.push_back(dist);
-		profile.second.push_back(static_cast<double>(integrand(dist)));
+		positions.push_back(ray.getPosition(dist));
+	}
+
+	if (cacheTableInitialized) {
+		for (const auto &pos : positions)
+			profile.second.push_back(
+			    static_cast<double>(getIOEfromCache(pos, Egamma)));
+		return profile;
 	}
+	for (const auto &e : integrateOverEnergy(positions, Egamma))
+		profile.second.push_back(static_cast<double>(e));
 
 	return profile;
 }
@@ -0,0 +1,168 @@
+#include "hermes/integrators/LOSSampleStore.h"
+
+#include <cstring>
+#include <stdexcept>
+
+#include "hermes/Common.h"
+#include "hermes/integrators/RayTable.h"
+
+namespace hermes {
+
+std::size_t LOSSamples::getMemoryUsage() const {
+	return sizeof(LOSSamples) + position.capacity() * sizeof(Vector3QLength) +
+	       ionizedGasDensity.capacity() * sizeof(QPDensity) + magneticField.capacity() * sizeof(Vector3QMField) +
+	       crDensity.capacity() * sizeof(QPDensityPerEnergy);
+}
+
+LOSSampleStore::LOSSampleStore(const Vector3QLength &observerPosition_, int nIntervals_, std::size_t memoryBudget_)
+    : observerPosition(observerPosition_),
+      nIntervals(nIntervals_),
+      memoryBudget(memoryBudget_),
+      memoryUsage(0),
+      hits(0),
+      misses(0),
+      evictions(0) {
+	if (nIntervals < 2 || nIntervals % 2 != 0)
+		throw std::runtime_error("hermes::LOSSampleStore: the number of intervals must be even and positive");
+}
+
+void LOSSampleStore::setMagneticField(const std::shared_ptr<magneticfields::MagneticField> &mfield_) {
+	mfield = mfield_;
+	clear();
+}
+
+void LOSSampleStore::setIonizedGasDensity(const std::shared_ptr<ionizedgas::IonizedGasDensity> &gdensity_) {
+	gdensity = gdensity_;
+	clear();
+}
+
+void LOSSampleStore::setCosmicRayDensity(const std::shared_ptr<cosmicrays::CosmicRayDensity> &crdensity_) {
+	crdensity = crdensity_;
+	clear();
+}
+
+void LOSSampleStore::setMemoryBudget(std::size_t bytes) {
+	std::lock_guard<std::mutex> lock(mtx);
+	memoryBudget = bytes;
+	while (memoryUsage > memoryBudget && !lru.empty()) {
+		memoryUsage -= lru.back().second->getMemoryUsage();
+		entries.erase(lru.back().first);
+		lru.pop_back();
+		++evictions;
+	}
+}
+
+LOSSampleStore::tKey LOSSampleStore::makeKey(const QDirection &direction) {
+	double theta = static_cast<double>(direction[0]);
+	double phi = static_cast<double>(direction[1]);
+	tKey key;
+	std::memcpy(&key.first, &theta, sizeof(double));
+	std::memcpy(&key.second, &phi, sizeof(double));
+	return key;
+}
+
+std::shared_ptr<LOSSamples> LOSSampleStore::sample(const QDirection &direction) const {
+	auto s = std::make_shared<LOSSamples>();
+	const std::size_t n = nIntervals + 1;
+	const LOSRay ray = makeLOSRay(observerPosition, direction);
+	s->step = ray.maxDistance / nIntervals;
+	s->nEnergies = (crdensity != nullptr) ? crdensity->getEnergyAxis().size() : 0;
+
+	s->position.reserve(n);
+	for (std::size_t i = 0; i < n; ++i)
+		s->position.push_back(ray.getPosition(s->step * static_cast<double>(i)));
+
+	if (gdensity != nullptr) gdensity->getDensity(s->position, s->ionizedGasDensity);
+	if (mfield != nullptr) {
+		s->magneticField.reserve(n);
+		for (const auto &pos : s->position) s->magneticField.push_back(mfield->getField(pos));
+	}
+	if (crdensity != nullptr) {
+		s->crDensity.resize(n * s->nEnergies);
+		std::vector<QPDensityPerEnergy> spectrum;
+		for (std::size_t i = 0; i < n; ++i) {
+			crdensity->getDensitySpectrum(s->position[i], spectrum);
+			std::copy(spectrum.begin(), spectrum.end(), s->crDensity.begin() + i * s->nEnergies);
+		}
+	}
+
+	return s;
+}
+
+std::shared_ptr<const LOSSamples> LOSSampleStore::getSamples(const QDirection &direction) {
+	const tKey key = makeKey(direction);
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		auto it = entries.find(key);
+		if (it != entries.end()) {
+			lru.splice(lru.begin(), lru, it->second);
+			++hits;
+			return it->second->second;
+		}
+	}
+
+	// evaluate outside of the lock; concurrent requests of the same
+	// direction may evaluate it twice, but only one copy is kept
+	std::shared_ptr<const LOSSamples> samples = sample(direction);
+	++misses;
+
+	std::lock_guard<std::mutex> lock(mtx);
+	auto it = entries.find(key);
+	if (it != entries.end()) return it->second->second;
+
+	const std::size_t bytes = samples->getMemoryUsage();
+	if (bytes > memoryBudget) return samples;
+	while (memoryUsage + bytes > memoryBudget && !lru.empty()) {
+		memoryUsage -= lru.back().second->getMemoryUsage();
+		entries.erase(lru.back().first);
+		lru.pop_back();
+		++evictions;
+	}
+	lru.emplace_front(key, samples);
+	entries[key] = lru.begin();
+	memoryUsage += bytes;
+
+	return samples;
+}
+
+void LOSSampleStore::clear() {
+	std::lock_guard<std::mutex> lock(mtx);
+	lru.clear();
+	entries.clear();
+	memoryUsage = 0;
+}
+
+std::size_t LOSSampleStore::getMemoryUsage() const {
+	std::lock_guard<std::mutex> lock(mtx);
+	return memoryUsage;
+}
+
+std::size_t LOSSampleStore::getNumberOfEntries() const {
+	std::lock_guard<std::mutex> lock(mtx);
+	return entries.size();
+}
+
+void registerSampleStoreModels(LOSSampleStore &store, const std::shared_ptr<magneticfields::MagneticField> &mfield,
+                               const std::shared_ptr<ionizedgas::IonizedGasDensity> &gdensity,
+                               const std::shared_ptr<cosmicrays::CosmicRayDensity> &crdensity) {
+	if (mfield != nullptr) {
+		if (store.getMagneticField() == nullptr)
+			store.setMagneticField(mfield);
+		else if (store.getMagneticField() != mfield)
+			throw std::runtime_error("hermes::LOSSampleStore: the store samples a different magnetic field");
+	}
+	if (gdensity != nullptr) {
+		if (store.getIonizedGasDensity() == nullptr)
+			store.setIonizedGasDensity(gdensity);
+		else if (store.getIonizedGasDensity() != gdensity)
+			throw std::runtime_error("hermes::LOSSampleStore: the store samples a different ionised gas density");
+	}
+	if (crdensity != nullptr) {
+		if (store.getCosmicRayDensity() == nullptr)
+			store.setCosmicRayDensity(crdensity);
+		else if (store.getCosmicRayDensity() != crdensity)
+			throw std::runtime_error("hermes::LOSSampleStore: the store samples a different cosmic-ray density");
+	}
+}
+
+}  // namespace hermes
@@ -0,0 +1,187 @@
+#include "hermes/integrators/OpacityGrid.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+#include "hermes/BinaryCache.h"
+#include "hermes/ThreadPool.h"
+
+namespace hermes {
+
+namespace {
+std::vector<QLength> defaultRAxis() {
+	std::vector<QLength> r;
+	for (int i = 0; i <= 60; ++i) r.push_back(0.5_kpc * static_cast<double>(i));
+	return r;
+}
+
+std::vector<QLength> defaultZAxis() {
+	std::vector<QLength> z;
+	for (double v : {0.0, 0.1, 0.2, 0.3, 0.4, 0.5, 0.6, 0.8, 1.0, 1.2, 1.5, 2.0,
+	                 2.5, 3.0, 4.0, 5.0, 6.0, 8.0, 10.0, 12.0, 15.0, 20.0, 25.0, 30.0})
+		z.push_back(v * 1_kpc);
+	return z;
+}
+
+std::uint64_t bitsOf(double v) {
+	std::uint64_t bits;
+	std::memcpy(&bits, &v, sizeof(double));
+	return bits;
+}
+}  // namespace
+
+OpacityGrid::OpacityGrid(const std::shared_ptr<photonfields::PhotonField> &field, const std::string &cacheTag)
+    : OpacityGrid(field, defaultRAxis(), defaultZAxis(), 1_TeV, 10_EeV, 71, cacheTag) {}
+
+OpacityGrid::OpacityGrid(const std::shared_ptr<photonfields::PhotonField> &field, const std::vector<QLength> &r,
+                         const std::vector<QLength> &z, const QEnergy &Emin, const QEnergy &Emax, std::size_t nE_,
+                         const std::string &cacheTag)
+    : nE(nE_) {
+	if (r.size() < 2 || z.size() < 2 || nE < 2 || !(Emin > 0_J) || !(Emax > Emin))
+		throw std::runtime_error(
+		    "hermes::OpacityGrid: requires at least 2 nodes per axis and 0 < Emin < Emax");
+	for (const auto &v : r) rAxis.push_back(static_cast<double>(v));
+	for (const auto &v : z) zAxis.push_back(static_cast<double>(v));
+	for (const auto *a : {&rAxis, &zAxis})
+		for (std::size_t i = 1; i < a->size(); ++i)
+			if (!((*a)[i] > (*a)[i - 1]))
+				throw std::runtime_error("hermes::OpacityGrid: axis nodes must be increasing");
+	if (zAxis.front() < 0) throw std::runtime_error("hermes::OpacityGrid: the z axis is for |z|");
+	logEMin = std::log(static_cast<double>(Emin));
+	logEMax = std::log(static_cast<double>(Emax));
+	dLogE = (logEMax - logEMin) / (nE - 1);
+	kappa.resize(rAxis.size() * zAxis.size() * nE);
+
+	if (cacheTag.empty()) {
+		compute(field);
+		return;
+	}
+
+	std::vector<std::uint64_t> keys;
+	for (const auto *a : {&rAxis, &zAxis})
+		for (double v : *a) keys.push_back(bitsOf(v));
+	keys.push_back(bitsOf(logEMin));
+	keys.push_back(bitsOf(logEMax));
+	keys.push_back(nE);
+	BinaryCache cache("OpacityGrid_" + cacheTag, keys);
+	if (cache.isEnabled() && cache.load() && cache.getPayloadSize() == kappa.size() * sizeof(double)) {
+		std::memcpy(kappa.data(), cache.getPayload(), cache.getPayloadSize());
+		return;
+	}
+	compute(field);
+	if (cache.isEnabled()) cache.store({}, kappa.data(), kappa.size() * sizeof(double));
+}
+
+void OpacityGrid::compute(const std::shared_ptr<photonfields::PhotonField> &field) {
+	const std::vector<QEnergy> eps = field->getEnergyAxis();
+	std::size_t nEps = eps.size();
+	if (nEps < 2) throw std::runtime_error("hermes::OpacityGrid: the photon field needs an energy axis");
+
+	// cross-section times the width in ln(eps) (as in InverseComptonIntegrator)
+	interactions::BreitWheeler bw;
+	const std::vector<QEnergy> Egammas = getEnergyAxis();
+	std::vector<double> sigma(nE * nEps, 0.);
+	getThreadPool()->parallelFor(nE, [&](std::size_t iE) {
+		for (std::size_t j = 1; j < nEps; ++j)
+			sigma[iE * nEps + j] = static_cast<double>(bw.integratedOverTheta(Egammas[iE], eps[j])) *
+			                       std::log(static_cast<double>(eps[j] / eps[j - 1]));
+	});
+
+	getThreadPool()->parallelFor(rAxis.size() * zAxis.size(), [&](std::size_t n) {
+		Vector3QLength pos(0_m);
+		pos.x = QLength(rAxis[n / zAxis.size()]);
+		pos.z = QLength(zAxis[n % zAxis.size()]);
+		std::vector<QEnergyDensity> spectrum;
+		field->getSpectrum(pos, spectrum);
+		std::vector<double> density(nEps);  // u / eps, in 1/m^3
+		for (std::size_t j = 1; j < nEps; ++j) density[j] = static_cast<double>(spectrum[j] / eps[j]);
+		double *out = kappa.data() + n * nE;
+		for (std::size_t iE = 0; iE < nE; ++iE) {
+			const double *s = sigma.data() + iE * nEps;
+			double k = 0;
+			for (std::size_t j = 1; j < nEps; ++j) k += s[j] * density[j];
+			out[iE] = k;
+		}
+	});
+}
+
+std::vector<QLength> OpacityGrid::getRAxis() const {
+	std::vector<QLength> axis;
+	for (double v : rAxis) axis.push_back(QLength(v));
+	return axis;
+}
+
+std::vector<QLength> OpacityGrid::getZAxis() const {
+	std::vector<QLength> axis;
+	for (double v : zAxis) axis.push_back(QLength(v));
+	return axis;
+}
+
+std::vector<QEnergy> OpacityGrid::getEnergyAxis() const {
+	std::vector<QEnergy> axis(nE);
+	for (std::size_t i = 0; i + 1 < nE; ++i) axis[i] = QEnergy(std::exp(logEMin + dLogE * static_cast<double>(i)));
+	axis.back() = QEnergy(std::exp(logEMax));
+	return axis;
+}
+
+QInverseLength OpacityGrid::getTableValue(std::size_t ir, std::size_t iz, std::size_t iE) const {
+	if (ir >= rAxis.size() || iz >= zAxis.size() || iE >= nE)
+		throw std::out_of_range("hermes::OpacityGrid: node out of range");
+	return QInverseLength(kappa[(ir * zAxis.size() + iz) * nE + iE]);
+}
+
+void OpacityGrid::locate(const std::vector<double> &axis, double v, std::size_t &i, double &f) {
+	if (v <= axis.front()) {
+		i = 0;
+		f = 0;
+	} else if (v >= axis.back()) {
+		i = axis.size() - 2;
+		f = 1;
+	} else {
+		i = std::upper_bound(axis.begin() + 1, axis.end() - 1, v) - axis.begin() - 1;
+		f = (v - axis[i]) / (axis[i + 1] - axis[i]);
+	}
+}
+
+QInverseLength OpacityGrid::getAbsorptionCoefficient(const Vector3QLength &pos, const QEnergy &E) const {
+	std::vector<QInverseLength> out;
+	getAbsorptionCoefficients(pos, {E}, out);
+	return out.front();
+}
+
+void OpacityGrid::getAbsorptionCoefficients(const Vector3QLength &pos, const std::vector<QEnergy> &E,
+                                            std::vector<QInverseLength> &out) const {
+	std::size_t ir, iz;
+	double fr, fz;
+	locate(rAxis, static_cast<double>(pos.getRho()), ir, fr);
+	locate(zAxis, std::fabs(static_cast<double>(pos.z)), iz, fz);
+
+	const std::size_t nz = zAxis.size();
+	const double *k00 = kappa.data() + (ir * nz + iz) * nE;
+	const double *k01 = k00 + nE;
+	const double *k10 = k00 + nz * nE;
+	const double *k11 = k10 + nE;
+	const double w00 = (1 - fr) * (1 - fz), w01 = (1 - fr) * fz, w10 = fr * (1 - fz), w11 = fr * fz;
+
+	out.resize(E.size());
+	for (std::size_t k = 0; k < E.size(); ++k) {
+		double r = (std::log(static_cast<double>(E[k])) - logEMin) / dLogE;
+		// below the table (i.e., towards the pair-production threshold)
+		// the absorption is neglected
+		if (r < -1e-9) {
+			out[k] = QInverseLength(0);
+			continue;
+		}
+		r = std::min(std::max(r, 0.), static_cast<double>(nE - 1));
+		const std::size_t i = std::min(static_cast<std::size_t>(r), nE - 2);
+		const double f = r - static_cast<double>(i);
+		const double a = w00 * k00[i] + w01 * k01[i] + w10 * k10[i] + w11 * k11[i];
+		const double b = w00 * k00[i + 1] + w01 * k01[i + 1] + w10 * k10[i + 1] + w11 * k11[i + 1];
+		out[k] = QInverseLength((a > 0 && b > 0) ? a * std::pow(b / a, f) : a + (b - a) * f);
+	}
+}
+
+}  // namespace hermes
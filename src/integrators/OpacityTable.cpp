@@ -0,0 +1,44 @@
+#include "hermes/integrators/OpacityTable.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace hermes {
+
+OpacityTable::OpacityTable(const QEnergy &Emin, const QEnergy &Emax, std::size_t n) : kappa(n, 0.) {
+	if (n < 2 || !(Emin > 0_J) || !(Emax > Emin))
+		throw std::runtime_error("hermes::OpacityTable: requires n >= 2 and 0 < Emin < Emax");
+	logEMin = std::log(static_cast<double>(Emin));
+	logEMax = std::log(static_cast<double>(Emax));
+	dLogE = (logEMax - logEMin) / (n - 1);
+}
+
+QEnergy OpacityTable::getEnergy(std::size_t i) const {
+	if (i + 1 == kappa.size()) return QEnergy(std::exp(logEMax));
+	return QEnergy(std::exp(logEMin + dLogE * static_cast<double>(i)));
+}
+
+std::vector<QEnergy> OpacityTable::getEnergyAxis() const {
+	std::vector<QEnergy> axis(kappa.size());
+	for (std::size_t i = 0; i < kappa.size(); ++i) axis[i] = getEnergy(i);
+	return axis;
+}
+
+bool OpacityTable::contains(const QEnergy &E) const {
+	const double logE = std::log(static_cast<double>(E));
+	return logE >= logEMin - 1e-12 * dLogE && logE <= logEMax + 1e-12 * dLogE;
+}
+
+QInverseLength OpacityTable::getAbsorptionCoefficient(const QEnergy &E) const {
+	const double r = (std::log(static_cast<double>(E)) - logEMin) / dLogE;
+	const std::size_t i =
+	    static_cast<std::size_t>(std::min(std::max(std::floor(r), 0.), static_cast<double>(kappa.size() - 2)));
+	const double f = r - static_cast<double>(i);
+	const double k0 = kappa[i], k1 = kappa[i + 1];
+
+	if (k0 > 0 && k1 > 0) return QInverseLength(k0 * std::pow(k1 / k0, f));
+	return QInverseLength(k0 + (k1 - k0) * f);
+}
+
+}  // namespace hermes
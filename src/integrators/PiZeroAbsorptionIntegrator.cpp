@@ -1,25 +1,31 @@
 #include "hermes/integrators/PiZeroAbsorptionIntegrator.h"
 
 #include <algorithm>
+#include <cmath>
 #include <functional>
 #include <iterator>
 #include <memory>
-#include <mutex>
 #include <numeric>
 #include <thread>
 #include <utility>
 
 #include "hermes/Common.h"
+#include "hermes/GSLWorkspace.h"
 #include "hermes/integrators/LOSIntegrationMethods.h"
 
 namespace hermes {
 
+// range of the CMB photon energies in computeAbsorptionCoefficient()
+const QEnergy cmbEpsMin = 1e-5_eV;
+const QEnergy cmbEpsMax = 5e-3_eV;
+
 PiZeroAbsorptionIntegrator::PiZeroAbsorptionIntegrator(
     const std::shared_ptr<cosmicrays::CosmicRayDensity> &crDensity_,
     const std::shared_ptr<neutralgas::RingModel> &ngdensity_,
     const std::shared_ptr<interactions::DifferentialCrossSection> &crossSec_)
     : PiZeroIntegrator(crDensity_, ngdensity_, crossSec_) {
 	setDescription("PiZeroAbsorptionIntegrator");
+	buildOpacityTable();
 }
 
 PiZeroAbsorptionIntegrator::PiZeroAbsorptionIntegrator(
@@ -28,6 +34,7 @@ PiZeroAbsorptionIntegrator::PiZeroAbsorptionIntegrator(
     const std::shared_ptr<interactions::DifferentialCrossSection> &crossSec_)
     : PiZeroIntegrator(crList_, ngdensity_, crossSec_) {
 	setDescription("PiZeroAbsorptionIntegrator");
+	buildOpacityTable();
 }
 
 PiZeroAbsorptionIntegrator::~PiZeroAbsorptionIntegrator() { setDescription("PiZeroAbsorptionIntegrator"); }
@@ -38,61 +45,86 @@ QDiffIntensity PiZeroAbsorptionIntegrator::integrateOverLOS(const QDirection &di
 
 QDiffIntensity PiZeroAbsorptionIntegrator::integrateOverLOS(const QDirection &direction_,
                                                             const QEnergy &Egamma_) const {
-	QDiffIntensity total_diff_flux(0.0);
+	if (opacityGrid != nullptr) return integrateOverLOS(direction_, std::vector<QEnergy>{Egamma_}).front();
+
+	auto gasType = ngdensity->getGasType();
+	auto prepared = std::find(preparedEnergies.begin(), preparedEnergies.end(), Egamma_);
+	const auto K = (prepared != preparedEnergies.end())
+	                   ? preparedCoefficients[prepared - preparedEnergies.begin()]
+	                   : absorptionCoefficient(Egamma_);
+
+	// as in PiZeroIntegrator, the emissivity attenuated by exp(-K * dist)
+	std::vector<QColumnDensity> normIntegrals(ngdensity->size(), QColumnDensity(0));
+	std::vector<QDiffFlux> losIntegrals(ngdensity->size(), QDiffFlux(0));
+	for (const auto &node : getRingNodes(direction_)) {
+		auto profile = dProfile->getPDensity(gasType, node.position);
+		if (profile == QPDensity(0)) continue;
+		normIntegrals[node.ring] += profile * node.weight;
+		losIntegrals[node.ring] +=
+		    profile * integrateOverEnergy(node.position, Egamma_) * exp(-K * node.distance) * node.weight;
+	}
+
+	return normalizeRingIntegrals(direction_, normIntegrals, losIntegrals);
+}
 
+std::vector<QDiffIntensity> PiZeroAbsorptionIntegrator::integrateOverLOS(const QDirection &direction_,
+                                                                       const std::vector<QEnergy> &Egammas_) const {
+	const std::size_t nE = Egammas_.size();
 	auto gasType = ngdensity->getGasType();
 
-	const auto K = absorptionCoefficient(Egamma_);
-
-	// Sum over rings
-	for (const auto &ring : *ngdensity) {
-		// TODO: this could be better
-		if (!ngdensity->isRingEnabled(ring->getIndex())) continue;
-
-		/** Normalization-part **/
-		// p_Theta_f(r) = profile(r) * Theta_in(r)
-		auto p_Theta_f = [ring, gasType, this](const Vector3QLength &pos) {
-			return (ring->isInside(pos)) ? dProfile->getPDensity(gasType, pos) : 0;
-		};
-		auto normIntegrand = [this, p_Theta_f, direction_](const QLength &dist) {
-			return p_Theta_f(getGalacticPosition(this->observerPosition, dist, direction_));
-		};
-
-		// optimize LOS integration limits:
-		// instead of 0 and getMaxDistance(dir)
-		auto b = ring->getBoundaries();
-		auto rho = observerPosition.getRho();
-		QLength r_min = rho - b.second;
-		if (r_min < 0_m) r_min = 0_m;
-		QLength r_max = rho + b.second;
-		if (r_max > getMaxDistance(direction_)) r_max = getMaxDistance(direction_);
-
-		QColumnDensity normIntegral = simpsonIntegration<QColumnDensity, QPDensity>(normIntegrand, r_min, r_max, 200);
-
-		// LOS is not crossing the current ring at all, skip
-		if (normIntegral == QColumnDensity(0)) continue;
-
-		// std::cerr << "normIntegral" << normIntegral << std::endl;
-
-		/** LOS integral over emissivity **/
-		// los_f = emissivity(r) * profile(r) * Theta_in(r)
-		auto los_f = [ring, gasType, this](const Vector3QLength &pos, const QEnergy &Egamma_) {
-			return (ring->isInside(pos)) ? dProfile->getPDensity(gasType, pos) * this->integrateOverEnergy(pos, Egamma_)
-			                             : 0;
-		};
-		auto losIntegrand = [this, los_f, direction_, Egamma_, K](const QLength &dist) {
-			return los_f(getGalacticPosition(this->observerPosition, dist, direction_), Egamma_) * exp(-K * dist);
-		};
-		QDiffIntensity losIntegral =
-		    simpsonIntegration<QDiffFlux, QGREmissivity>(losIntegrand, r_min, r_max, 500) / (4_pi * 1_sr);
-
-		// Finally, normalize LOS integrals, separatelly for HI and CO
-		total_diff_flux += ring->getColumnDensity(direction_) / normIntegral * losIntegral;
+	// optical depth from the observer to the current node: K * dist on the
+	// CMB, or accumulated on the nodes (trapezoidal rule) on an opacity grid,
+	// for which the nodes also cover the stretches between the rings
+	std::vector<QInverseLength> computedK, kappa, kappaPrev;
+	const std::vector<QInverseLength> *K = &preparedCoefficients;
+	std::vector<double> tau(nE, 0.);
+	QLength prevDistance(0);
+	if (opacityGrid == nullptr) {
+		if (Egammas_ != preparedEnergies) {
+			for (const auto &E : Egammas_) computedK.push_back(absorptionCoefficient(E));
+			K = &computedK;
+		}
+	} else {
+		opacityGrid->getAbsorptionCoefficients(getRay(direction_).getPosition(0_m), Egammas_,
+		                                       kappaPrev);
 	}
 
+	std::vector<QColumnDensity> normIntegrals(ngdensity->size(), QColumnDensity(0));
+	std::vector<std::vector<QDiffFlux>> losIntegrals(nE, std::vector<QDiffFlux>(ngdensity->size(), QDiffFlux(0)));
+	for (const auto &node : getRingNodes(direction_, opacityGrid != nullptr)) {
+		if (opacityGrid == nullptr) {
+			for (std::size_t k = 0; k < nE; ++k) tau[k] = static_cast<double>((*K)[k] * node.distance);
+		} else {
+			opacityGrid->getAbsorptionCoefficients(node.position, Egammas_, kappa);
+			const QLength step = node.distance - prevDistance;
+			for (std::size_t k = 0; k < nE; ++k) tau[k] += 0.5 * static_cast<double>((kappa[k] + kappaPrev[k]) * step);
+			std::swap(kappa, kappaPrev);
+			prevDistance = node.distance;
+		}
+		if (node.ring == noRing) continue;
+
+		auto profile = dProfile->getPDensity(gasType, node.position);
+		if (profile == QPDensity(0)) continue;
+		normIntegrals[node.ring] += profile * node.weight;
+		auto integrals = integrateOverEnergy(node.position, Egammas_);
+		for (std::size_t k = 0; k < nE; ++k)
+			losIntegrals[k][node.ring] += profile * integrals[k] * std::exp(-tau[k]) * node.weight;
+	}
+
+	std::vector<QDiffIntensity> total_diff_flux(nE);
+	for (std::size_t k = 0; k < nE; ++k)
+		total_diff_flux[k] = normalizeRingIntegrals(direction_, normIntegrals, losIntegrals[k]);
 	return total_diff_flux;
 }
 
+void PiZeroAbsorptionIntegrator::prepareSkymapParameters(const std::vector<QEnergy> &Egammas_) {
+	PiZeroIntegrator::prepareSkymapParameters(Egammas_);
+	std::vector<QInverseLength> coefficients;
+	for (const auto &E : Egammas_) coefficients.push_back(absorptionCoefficient(E));
+	preparedEnergies = Egammas_;
+	preparedCoefficients = std::move(coefficients);
+}
+
 auto cmbPhotonField(const QEnergy &eps) {
 	using hermes::units::expm1;
 	const auto K = 1. / (M_PI * M_PI) / pow<3>(h_planck_bar * c_light);
@@ -101,15 +133,47 @@ auto cmbPhotonField(const QEnergy &eps) {
 	return K * pow<2>(eps) / expm1(eps / kT);
 }
 
+QEnergy PiZeroAbsorptionIntegrator::getPairProductionThreshold() {
+	// E * eps >= (m_e c^2)^2 for a head-on collision
+	return pow<2>(m_electron * c_squared) / cmbEpsMax;
+}
+
+void PiZeroAbsorptionIntegrator::buildOpacityTable() {
+	// 20 nodes per decade from the threshold to 10 EeV
+	const QEnergy Emin = getPairProductionThreshold();
+	const QEnergy Emax = 10_EeV;
+	const auto n = static_cast<std::size_t>(std::ceil(20 * std::log10(static_cast<double>(Emax / Emin)))) + 1;
+	auto table = std::make_shared<OpacityTable>(Emin, Emax, n);
+	table->fillCached("PiZeroAbsorptionIntegrator_CMB",
+	                  [this](const QEnergy &E) { return computeAbsorptionCoefficient(E); });
+	opacityTable = table;
+}
+
+std::shared_ptr<const OpacityTable> PiZeroAbsorptionIntegrator::getOpacityTable() const { return opacityTable; }
+
+void PiZeroAbsorptionIntegrator::setOpacityTable(const std::shared_ptr<const OpacityTable> &table) {
+	opacityTable = table;
+	preparedEnergies.clear();
+	preparedCoefficients.clear();
+}
+
+void PiZeroAbsorptionIntegrator::setOpacityGrid(const std::shared_ptr<const OpacityGrid> &grid) { opacityGrid = grid; }
+
+std::shared_ptr<const OpacityGrid> PiZeroAbsorptionIntegrator::getOpacityGrid() const { return opacityGrid; }
+
 QInverseLength PiZeroAbsorptionIntegrator::absorptionCoefficient(const QEnergy &Egamma_) const {
+	if (opacityTable != nullptr && opacityTable->contains(Egamma_))
+		return opacityTable->getAbsorptionCoefficient(Egamma_);
+	if (Egamma_ < getPairProductionThreshold()) return QInverseLength(0);
+	return computeAbsorptionCoefficient(Egamma_);
+}
+
+QInverseLength PiZeroAbsorptionIntegrator::computeAbsorptionCoefficient(const QEnergy &Egamma_) const {
 	auto integrand = [this, Egamma_](double eps) {
 		return static_cast<double>(cmbPhotonField(QEnergy(eps)) *
 		                           bwCrossSec->integratedOverTheta(Egamma_, QEnergy(eps)));
 	};
 
-	QEnergy epsMin = 1e-5_eV;
-	QEnergy epsMax = 5e-3_eV;
-
 	double abs_error = 0.0;  // disabled
 	double rel_error = 1.0e-4;
 	int key = GSL_INTEG_GAUSS51;  // GSL_INTEG_GAUSS15;
@@ -119,10 +183,9 @@ QInverseLength PiZeroAbsorptionIntegrator::absorptionCoefficient(const QEnergy &
 	gsl_function_pp<decltype(integrand)> Fp(integrand);
 	gsl_function *F = static_cast<gsl_function *>(&Fp);
 
-	gsl_integration_workspace *w = gsl_integration_workspace_alloc(GSL_LIMIT);
-	gsl_integration_qag(F, static_cast<double>(epsMin), static_cast<double>(epsMax), abs_error, rel_error, GSL_LIMIT,
-	                    key, w, &result, &error);
-	gsl_integration_workspace_free(w);
+	GSLWorkspace w(GSL_LIMIT);
+	gsl_integration_qag(F, static_cast<double>(cmbEpsMin), static_cast<double>(cmbEpsMax), abs_error, rel_error, GSL_LIMIT,
+	                    key, w.get(), &result, &error);
 
 	return QInverseLength(result);
 }
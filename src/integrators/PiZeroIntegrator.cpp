@@ -1,14 +1,18 @@
 #include "hermes/integrators/PiZeroIntegrator.h"
 
 #include <algorithm>
+#include <cmath>
 #include <functional>
 #include <iterator>
 #include <memory>
 #include <mutex>
+#include <cstdint>
 #include <numeric>
-#include <thread>
+#include <stdexcept>
+#include <typeinfo>
 
 #include "hermes/Common.h"
+#include "hermes/ThreadPool.h"
 #include "hermes/integrators/LOSIntegrationMethods.h"
 
 namespace hermes {
@@ -20,7 +24,8 @@ PiZeroIntegrator::PiZeroIntegrator(const std::shared_ptr<cosmicrays::CosmicRayDe
       crList(std::vector<std::shared_ptr<cosmicrays::CosmicRayDensity>>{crDensity_}),
       ngdensity(ngdensity_),
       crossSec(crossSec_),
-      dProfile(std::make_unique<neutralgas::Nakanishi06>()) {}
+      dProfile(std::make_unique<neutralgas::Nakanishi06>()),
+      ringStep(50_pc) {}
 
 PiZeroIntegrator::PiZeroIntegrator(const std::vector<std::shared_ptr<cosmicrays::CosmicRayDensity>> &crList_,
                                    const std::shared_ptr<neutralgas::RingModel> &ngdensity_,
@@ -29,7 +34,8 @@ PiZeroIntegrator::PiZeroIntegrator(const std::vector<std::shared_ptr<cosmicrays:
       crList(crList_),
       ngdensity(ngdensity_),
       crossSec(crossSec_),
-      dProfile(std::make_shared<neutralgas::Nakanishi06>()) {}
+      dProfile(std::make_shared<neutralgas::Nakanishi06>()),
+      ringStep(50_pc) {}
 
 PiZeroIntegrator::~PiZeroIntegrator() {}
 
@@ -44,15 +50,9 @@ void PiZeroIntegrator::setupCacheTable(int N_x, int N_y, int N_z) {
 	cacheEnabled = true;
 }
 
-void PiZeroIntegrator::computeCacheInThread(std::size_t start, std::size_t end, const QEnergy &Egamma,
-                                            std::shared_ptr<ProgressBar> &p) {
-	for (std::size_t i = start; i < end; ++i) {
-		auto pos = static_cast<Vector3QLength>(cacheTable->positionFromIndex(i));
-		// TODO: remove std::cerr << "pos = " << pos.x / 1_kpc << ", " << pos.y
-		// / 1_kpc << ", " << pos.z / 1_kpc << std::endl;
-		cacheTable->get(i) = this->integrateOverEnergy(pos, Egamma);
-		p->update();
-	}
+void PiZeroIntegrator::computeCacheEntry(std::size_t i, const QEnergy &Egamma) {
+	auto pos = static_cast<Vector3QLength>(cacheTable->positionFromIndex(i));
+	cacheTable->get(i) = this->integrateOverEnergy(pos, Egamma);
 }
 
 void PiZeroIntegrator::initCacheTable() {
@@ -65,29 +65,79 @@ void PiZeroIntegrator::initCacheTable() {
 		return;
 	}
 
-	std::cout << "hermes::Integrator::initCacheTable: Number of Threads: " << getThreadsNumber() << std::endl;
-
 	const QEnergy Egamma = skymapParameter;
+	CacheTableStore store = getCacheTableStore();
+	if (store.load(Egamma, *cacheTable)) {
+		cacheTableInitialized = true;
+		return;
+	}
+
+	auto pool = getThreadPool();
+	std::cout << "hermes::Integrator::initCacheTable: Number of Threads: " << pool->size() << std::endl;
+
 	size_t grid_size = cacheTable->getGridSize();
 
 	// Progressbar init
-	auto progressbar = std::make_shared<ProgressBar>(ProgressBar(grid_size));
-	auto progressbar_mutex = std::make_shared<std::mutex>();
-	progressbar->setMutex(progressbar_mutex);
+	auto progressbar = std::make_shared<ProgressBar>(grid_size);
 	progressbar->start("Generate Cache Table");
 
-	auto job_chunks = getThreadChunks(grid_size);
-	std::vector<std::thread> threads;
-	threads.reserve(job_chunks.size());
-	for (auto &c : job_chunks) {
-		threads.push_back(std::thread(&PiZeroIntegrator::computeCacheInThread, this, c.first, c.second, Egamma,
-		                              std::ref(progressbar)));
+	auto stats = pool->parallelFor(grid_size, [&](std::size_t i) {
+		computeCacheEntry(i, Egamma);
+		progressbar->update();
+	});
+	progressbar->stop();
+	std::cout << "hermes::Integrator::initCacheTable: " << stats << std::endl;
+	store.store(Egamma, *cacheTable);
+
+	cacheTableInitialized = true;
+}
+
+CacheTableStore PiZeroIntegrator::getCacheTableStore() const {
+	CacheTableStore store(getDescription() + "_CacheTable");
+	store.addKey(typeid(*crossSec).name());
+	for (const auto &gas : ngdensity->getAbundanceFractions())
+		store.addKey(static_cast<std::uint64_t>(gas.first.getID())).addKey(gas.second);
+
+	std::vector<QPDensityPerEnergy> spectrum;
+	for (const auto &crDensity : crList) {
+		store.addKey(typeid(*crDensity).name()).addKey(static_cast<std::uint64_t>(crDensity->getPID().getID()));
+		if (store.isEnabled()) store.addKey(crDensity->getSourceHashes());
+		store.addKey(crDensity->getEnergyAxis());
+		for (const auto &pos : CacheTableStore::getProbePositions()) {
+			crDensity->getDensitySpectrum(pos, spectrum);
+			store.addKey(spectrum);
+		}
+		for (const auto &gas : ngdensity->getAbundanceFractions())
+			store.addKey(static_cast<double>(
+			    crossSec->getDiffCrossSection(crDensity->getPID(), gas.first, 100_GeV, 10_GeV)));
 	}
-	for (auto &t : threads) {
-		t.join();
+
+	store.addGrid(*cacheTable);
+	return store;
+}
+
+void PiZeroIntegrator::prepareSkymapParameters(const std::vector<QEnergy> &Egammas_) {
+	prepareCrossSectionTable(Egammas_);
+
+	std::vector<EnergyKernel> kernels;
+	for (const auto &E : Egammas_) kernels.push_back(makeEnergyKernel(E));
+	kernelEnergies = Egammas_;
+	preparedKernels = std::move(kernels);
+}
+
+void PiZeroIntegrator::prepareCrossSectionTable(const std::vector<QEnergy> &Egammas_) {
+	if (!crossSec->isCachingEnabled()) return;
+
+	std::vector<QEnergy> projectileEnergies;
+	for (const auto &crDensity : crList) {
+		auto axis = crDensity->getEnergyAxis();
+		projectileEnergies.insert(projectileEnergies.end(), axis.begin(), axis.end());
 	}
+	if (projectileEnergies == tableProjectileEnergies && Egammas_ == tableGammaEnergies) return;
 
-	cacheTableInitialized = true;
+	crossSec->setCacheTable(projectileEnergies, Egammas_);
+	tableProjectileEnergies = std::move(projectileEnergies);
+	tableGammaEnergies = Egammas_;
 }
 
 QPiZeroIntegral PiZeroIntegrator::getIOEfromCache(const Vector3QLength &pos_, const QEnergy &Egamma_) const {
@@ -98,95 +148,186 @@ QDiffIntensity PiZeroIntegrator::integrateOverLOS(const QDirection &direction) c
 	return integrateOverLOS(direction, 1_GeV);
 }
 
-QDiffIntensity PiZeroIntegrator::integrateOverLOS(const QDirection &direction_, const QEnergy &Egamma_) const {
+void PiZeroIntegrator::setRingStep(const QLength &step) {
+	if (!(step > 0_m)) throw std::runtime_error("hermes::PiZeroIntegrator: the ring step has to be positive");
+	ringStep = step;
+}
+
+QLength PiZeroIntegrator::getRingStep() const { return ringStep; }
+
+std::vector<std::pair<std::size_t, std::pair<QLength, QLength>>> PiZeroIntegrator::getRingIntervals(
+    const QDirection &direction_) const {
+	const LOSRay ray = getRay(direction_);
+	const Vector3QLength start = ray.getPosition(0_m);
+	const Vector3d &unitStep = ray.direction;
+	const QLength maxDistance = ray.maxDistance;
+
+	std::vector<std::pair<std::size_t, std::pair<QLength, QLength>>> intervals;
+	for (std::size_t i = 0; i < ngdensity->size(); ++i) {
+		const auto ring = (*ngdensity)[i];
+		if (!ngdensity->isRingEnabled(ring->getIndex())) continue;
+		for (const auto &interval : ring->getCrossings(start, unitStep, maxDistance))
+			intervals.emplace_back(i, interval);
+	}
+	std::sort(intervals.begin(), intervals.end(),
+	          [](const auto &a, const auto &b) { return a.second.first < b.second.first; });
+	return intervals;
+}
+
+std::vector<PiZeroIntegrator::RingNode> PiZeroIntegrator::getRingNodes(const QDirection &direction_,
+                                                                       bool withGaps) const {
+	std::vector<RingNode> nodes;
+	const LOSRay ray = getRay(direction_);
+	auto addNodes = [&](std::size_t ring, QLength begin, QLength end) {
+		if (!(end > begin)) return;
+		// Simpson's rule needs an even number of intervals
+		int N = 2 * static_cast<int>(std::ceil(static_cast<double>((end - begin) / (2. * ringStep))));
+		N = std::max(N, 4);
+		const QLength h = (end - begin) / static_cast<double>(N);
+		for (int i = 0; i <= N; ++i) {
+			const QLength dist = begin + h * static_cast<double>(i);
+			const QLength weight = (ring == noRing) ? 0_m : simpsonWeight(i, N, h);
+			nodes.push_back({ring, dist, weight, ray.getPosition(dist)});
+		}
+	};
+
+	QLength covered = 0_m;
+	for (const auto &interval : getRingIntervals(direction_)) {
+		if (withGaps) addNodes(noRing, covered, interval.second.first);
+		addNodes(interval.first, interval.second.first, interval.second.second);
+		covered = interval.second.second;
+	}
+	return nodes;
+}
+
+QDiffIntensity PiZeroIntegrator::normalizeRingIntegrals(const QDirection &direction_,
+                                                        const std::vector<QColumnDensity> &normIntegrals,
+                                                        const std::vector<QDiffFlux> &losIntegrals) const {
 	QDiffIntensity total_diff_flux(0.0);
+	for (std::size_t i = 0; i < normIntegrals.size(); ++i) {
+		// LOS is not crossing the ring at all
+		if (normIntegrals[i] == QColumnDensity(0)) continue;
+		// normalize LOS integrals, separatelly for HI and CO
+		total_diff_flux +=
+		    (*ngdensity)[i]->getColumnDensity(direction_) / normIntegrals[i] * (losIntegrals[i] / (4_pi * 1_sr));
+	}
+	return total_diff_flux;
+}
 
+QDiffIntensity PiZeroIntegrator::integrateOverLOS(const QDirection &direction_, const QEnergy &Egamma_) const {
 	auto gasType = ngdensity->getGasType();
 
-	// Sum over rings
-	for (const auto &ring : *ngdensity) {
-		// TODO(adundovi): this could be checked better
-		if (!ngdensity->isRingEnabled(ring->getIndex())) continue;
+	// normalization integral: profile(r) * Theta_in(r);
+	// LOS integral: emissivity(r) * profile(r) * Theta_in(r)
+	std::vector<QColumnDensity> normIntegrals(ngdensity->size(), QColumnDensity(0));
+	std::vector<QDiffFlux> losIntegrals(ngdensity->size(), QDiffFlux(0));
+	for (const auto &node : getRingNodes(direction_)) {
+		auto profile = dProfile->getPDensity(gasType, node.position);
+		if (profile == QPDensity(0)) continue;
+		normIntegrals[node.ring] += profile * node.weight;
+		losIntegrals[node.ring] += profile * integrateOverEnergy(node.position, Egamma_) * node.weight;
+	}
+
+	return normalizeRingIntegrals(direction_, normIntegrals, losIntegrals);
+}
+
+std::vector<QDiffIntensity> PiZeroIntegrator::integrateOverLOS(const QDirection &direction_,
+                                                             const std::vector<QEnergy> &Egammas_) const {
+	const std::size_t nE = Egammas_.size();
+	auto gasType = ngdensity->getGasType();
 
-		/** Normalization-part **/
-		// p_Theta_f(r) = profile(r) * Theta_in(r)
-		auto p_Theta_f = [ring, gasType, this](const Vector3QLength &pos) {
-			return (ring->isInside(pos)) ? dProfile->getPDensity(gasType, pos) : 0;
-		};
-		auto normIntegrand = [this, p_Theta_f, direction_](const QLength &dist) {
-			return p_Theta_f(getGalacticPosition(this->observerPosition, dist, direction_));
-		};
-
-		// optimize LOS integration limits:
-		// instead of 0 and getMaxDistance(dir)
-		auto b = ring->getBoundaries();
-		auto rho = observerPosition.getRho();
-		QLength r_min = rho - b.second;
-		if (r_min < 0_m) r_min = 0_m;
-		QLength r_max = rho + b.second;
-		if (r_max > getMaxDistance(direction_)) r_max = getMaxDistance(direction_);
-
-		QColumnDensity normIntegral = simpsonIntegration<QColumnDensity, QPDensity>(normIntegrand, r_min, r_max, 200);
-
-		// LOS is not crossing the current ring at all, skip
-		if (normIntegral == QColumnDensity(0)) continue;
-
-		// std::cerr << "normIntegral" << normIntegral << std::endl;
-
-		/** LOS integral over emissivity **/
-		// los_f = emissivity(r) * profile(r) * Theta_in(r)
-		auto los_f = [ring, gasType, this](const Vector3QLength &pos, const QEnergy &Egamma_) {
-			return (ring->isInside(pos)) ? dProfile->getPDensity(gasType, pos) * this->integrateOverEnergy(pos, Egamma_)
-			                             : 0;
-		};
-		auto losIntegrand = [this, los_f, direction_, Egamma_](const QLength &dist) {
-			return los_f(getGalacticPosition(this->observerPosition, dist, direction_), Egamma_);
-		};
-		QDiffIntensity losIntegral =
-		    simpsonIntegration<QDiffFlux, QGREmissivity>(losIntegrand, r_min, r_max, 500) / (4_pi * 1_sr);
-
-		// Finally, normalize LOS integrals, separatelly for HI and CO
-		total_diff_flux += ring->getColumnDensity(direction_) / normIntegral * losIntegral;
+	// all energies on the same nodes
+	std::vector<QColumnDensity> normIntegrals(ngdensity->size(), QColumnDensity(0));
+	std::vector<std::vector<QDiffFlux>> losIntegrals(nE, std::vector<QDiffFlux>(ngdensity->size(), QDiffFlux(0)));
+	for (const auto &node : getRingNodes(direction_)) {
+		auto profile = dProfile->getPDensity(gasType, node.position);
+		if (profile == QPDensity(0)) continue;
+		normIntegrals[node.ring] += profile * node.weight;
+		auto integrals = integrateOverEnergy(node.position, Egammas_);
+		for (std::size_t k = 0; k < nE; ++k) losIntegrals[k][node.ring] += profile * integrals[k] * node.weight;
 	}
 
+	std::vector<QDiffIntensity> total_diff_flux(nE);
+	for (std::size_t k = 0; k < nE; ++k)
+		total_diff_flux[k] = normalizeRingIntegrals(direction_, normIntegrals, losIntegrals[k]);
 	return total_diff_flux;
 }
 
+PiZeroIntegrator::EnergyKernel PiZeroIntegrator::makeEnergyKernel(const QEnergy &Egamma_) const {
+	EnergyKernel kernel;
+	for (const auto &crDensity : crList) {
+		auto pid_projectile = crDensity->getPID();
+		const double logStep = std::log(crDensity->getEnergyScaleFactor());
+		auto first = crDensity->beginAfterEnergy(Egamma_);
+		kernel.first.push_back(first - crDensity->begin());
+		std::vector<double> weights;
+		weights.reserve(crDensity->end() - first);
+		for (auto itE = first; itE != crDensity->end(); ++itE) {
+			QPiZeroIntegral value(0);
+			for (const auto &neutralGas : ngdensity->getAbundanceFractions()) {
+				auto pid_target = neutralGas.first;
+				auto f_target = neutralGas.second;
+				value += c_light * (1. / 1_m3) * f_target *
+				         crossSec->getDiffCrossSection(pid_projectile, pid_target, *itE, Egamma_);
+			}
+			// value per unit density of CR per unit ln(E)
+			weights.push_back(logStep * static_cast<double>(value) * static_cast<double>(*itE / 1_J));
+		}
+		kernel.weights.push_back(std::move(weights));
+	}
+	return kernel;
+}
+
 QPiZeroIntegral PiZeroIntegrator::integrateOverEnergy(const Vector3QLength &pos_, const QEnergy &Egamma_) const {
 	if (cacheTableInitialized) {
 		return getIOEfromCache(pos_, Egamma_);
 	}
 
-	QPiZeroIntegral total(0);
+	// only the CR spectra depend on the position
+	EnergyKernel computed;
+	const EnergyKernel *kernel = &computed;
+	auto prepared = std::find(kernelEnergies.begin(), kernelEnergies.end(), Egamma_);
+	if (prepared != kernelEnergies.end())
+		kernel = &preparedKernels[prepared - kernelEnergies.begin()];
+	else
+		computed = makeEnergyKernel(Egamma_);
+
+	thread_local std::vector<QPDensityPerEnergy> spectrum;
+	double total = 0;
+	for (std::size_t s = 0; s < crList.size(); ++s) {
+		crList[s]->getDensitySpectrum(pos_, spectrum);
+		const QPDensityPerEnergy *n = spectrum.data() + kernel->first[s];
+		const std::vector<double> &w = kernel->weights[s];
+		for (std::size_t j = 0; j < w.size(); ++j) total += w[j] * static_cast<double>(n[j]);
+	}
+	return QPiZeroIntegral(total);
+}
 
-	// TODO(adundovi): micro-optimization - E_min = E_gamma +
-	// m_pi^2c^4/(4E_gamma)
-	std::vector<QEnergy> energies;
-	energies.insert(energies.begin(), crList[0]->beginAfterEnergy(Egamma_), crList[0]->end());
+std::vector<QPiZeroIntegral> PiZeroIntegrator::integrateOverEnergy(const Vector3QLength &pos_,
+                                                                 const std::vector<QEnergy> &Egammas_) const {
+	std::vector<QPiZeroIntegral> total(Egammas_.size(), QPiZeroIntegral(0));
 
-	for (const auto &crDensity : crList) {
-		auto pid_projectile = crDensity->getPID();
+	std::vector<EnergyKernel> computed;
+	const std::vector<EnergyKernel> *kernels = &preparedKernels;
+	if (Egammas_ != kernelEnergies) {
+		for (const auto &E : Egammas_) computed.push_back(makeEnergyKernel(E));
+		kernels = &computed;
+	}
 
-		std::vector<QPDensity> cosmicRayVector;
-		std::transform(
-		    crDensity->beginAfterEnergy(Egamma_), crDensity->end(), std::back_inserter(cosmicRayVector),
-		    [crDensity, pos_](const QEnergy &E) -> QPDensity { return crDensity->getDensityPerEnergy(E, pos_) * E; });
-
-		std::vector<QPiZeroIntegral> integral;
-		std::transform(cosmicRayVector.begin(), cosmicRayVector.end(), energies.begin(), std::back_inserter(integral),
-		               [&](const QPDensity &n, const QEnergy &E) {
-			               QPiZeroIntegral value(0);
-			               for (const auto &neutralGas : ngdensity->getAbundanceFractions()) {
-				               auto pid_target = neutralGas.first;
-				               auto f_target = neutralGas.second;
-				               value += c_light * n * f_target *
-				                        crossSec->getDiffCrossSection(pid_projectile, pid_target, E, Egamma_);
-			               }
-			               return value;
-		               });
-		// log-integration
-		total += std::log(crDensity->getEnergyScaleFactor()) *
-		         std::accumulate(integral.begin(), integral.end(), QPiZeroIntegral(0));
+	// the spectra are shared by all gamma-ray energies
+	thread_local std::vector<std::vector<QPDensityPerEnergy>> spectra;
+	spectra.resize(crList.size());
+	for (std::size_t s = 0; s < crList.size(); ++s) crList[s]->getDensitySpectrum(pos_, spectra[s]);
+
+	for (std::size_t k = 0; k < Egammas_.size(); ++k) {
+		const EnergyKernel &kernel = (*kernels)[k];
+		double integral = 0;
+		for (std::size_t s = 0; s < crList.size(); ++s) {
+			const QPDensityPerEnergy *n = spectra[s].data() + kernel.first[s];
+			const std::vector<double> &w = kernel.weights[s];
+			for (std::size_t j = 0; j < w.size(); ++j) integral += w[j] * static_cast<double>(n[j]);
+		}
+		total[k] = QPiZeroIntegral(integral);
 	}
 	return total;
 }
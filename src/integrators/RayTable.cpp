@@ -0,0 +1,96 @@
+#include "hermes/integrators/RayTable.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <tuple>
+
+#include "hermes/Common.h"
+#include "hermes/HEALPixBits.h"
+#include "hermes/ThreadPool.h"
+
+namespace hermes {
+
+namespace {
+Vector3d rayOrigin(const Vector3QLength &observerPosition) {
+	// getGalacticPosition() places the observer on the x axis
+	return Vector3d(static_cast<double>(observerPosition.x), 0, 0);
+}
+
+Vector3d rayDirection(const QDirection &direction) {
+	const double theta = static_cast<double>(direction[0]);
+	const double phi = static_cast<double>(direction[1]);
+	const double sinTheta = std::sin(theta);
+	return Vector3d(-sinTheta * std::cos(phi), -sinTheta * std::sin(phi),
+	                std::cos(theta));
+}
+
+std::uint64_t bits(const QLength &l) {
+	const double v = static_cast<double>(l);
+	std::uint64_t b;
+	std::memcpy(&b, &v, sizeof(double));
+	return b;
+}
+}  // namespace
+
+LOSRay makeLOSRay(const Vector3QLength &observerPosition,
+                  const QDirection &direction) {
+	return LOSRay{rayOrigin(observerPosition), rayDirection(direction),
+	              distanceToGalBorder(observerPosition, direction)};
+}
+
+RayTable::RayTable(std::size_t nside_, const Vector3QLength &observerPosition_)
+    : nside(nside_),
+      observerPosition(observerPosition_),
+      origin(rayOrigin(observerPosition_)) {
+	const std::size_t npix = nside2npix(nside);
+	directions.resize(npix);
+	unitVectors.resize(npix);
+	maxDistances.resize(npix);
+	getThreadPool()->parallelFor(
+	    npix,
+	    [&](std::size_t ipix) {
+		    directions[ipix] = pix2ang_ring(nside, ipix);
+		    unitVectors[ipix] = rayDirection(directions[ipix]);
+		    maxDistances[ipix] =
+		        distanceToGalBorder(observerPosition, directions[ipix]);
+	    },
+	    4096);
+}
+
+std::size_t RayTable::getMemoryUsage() const {
+	return sizeof(RayTable) + directions.capacity() * sizeof(QDirection) +
+	       unitVectors.capacity() * sizeof(Vector3d) +
+	       maxDistances.capacity() * sizeof(QLength);
+}
+
+bool RayTable::findRay(const QDirection &direction, LOSRay &ray) const {
+	const std::size_t ipix = ang2pix_ring(nside, direction);
+	if (ipix >= directions.size() || directions[ipix][0] != direction[0] ||
+	    directions[ipix][1] != direction[1])
+		return false;
+	ray = getRay(ipix);
+	return true;
+}
+
+std::shared_ptr<const RayTable> getRayTable(
+    std::size_t nside, const Vector3QLength &observerPosition) {
+	typedef std::tuple<std::size_t, std::uint64_t, std::uint64_t, std::uint64_t>
+	    tKey;
+	static std::mutex mtx;
+	static std::map<tKey, std::weak_ptr<const RayTable>> tables;
+
+	const tKey key(nside, bits(observerPosition.x), bits(observerPosition.y),
+	               bits(observerPosition.z));
+	std::lock_guard<std::mutex> lock(mtx);
+	auto table = tables[key].lock();
+	if (table == nullptr) {
+		table = std::make_shared<const RayTable>(nside, observerPosition);
+		tables[key] = table;
+	}
+	return table;
+}
+
+}  // namespace hermes
@@ -10,24 +10,57 @@ RotationMeasureIntegrator::RotationMeasureIntegrator(const std::shared_ptr<magne
 
 RotationMeasureIntegrator::~RotationMeasureIntegrator() {}
 
+void RotationMeasureIntegrator::setSampleStore(const std::shared_ptr<LOSSampleStore>& store) {
+	if (store != nullptr) registerSampleStoreModels(*store, mfield, gdensity, nullptr);
+	sampleStore = store;
+}
+
+std::shared_ptr<LOSSampleStore> RotationMeasureIntegrator::getSampleStore() const { return sampleStore; }
+
+bool RotationMeasureIntegrator::useSampleStore() const {
+	return sampleStore != nullptr && sampleStore->getObsPosition() == observerPosition;
+}
+
 QRotationMeasure RotationMeasureIntegrator::integrateOverLOS(const QDirection& direction) const {
-	auto integrand = [this, direction](const QLength& dist) {
-		return this->integralFunction(getGalacticPosition(getObsPosition(), dist, direction));
+	if (useSampleStore()) {
+		auto samples = sampleStore->getSamples(direction);
+		QRotationMeasure total(0);
+		for (std::size_t i = 0; i < samples->size(); ++i)
+			total += integralFunction(samples->position[i], samples->magneticField[i],
+			                          samples->ionizedGasDensity[i]) *
+			         samples->getSimpsonWeight(i);
+		return total;
+	}
+
+	// Simpson's rule with the gas density evaluated in one batch
+	const LOSRay ray = getRay(direction);
+	auto integrand = [this, &ray](const QLength* dist, QRMIntegral* values, std::size_t n) {
+		std::vector<Vector3QLength> pos;
+		ray.getPositions(dist, n, pos);
+		std::vector<QPDensity> density;
+		gdensity->getDensity(pos, density);
+		for (std::size_t i = 0; i < n; ++i) values[i] = integralFunction(pos[i], mfield->getField(pos[i]), density[i]);
 	};
 
-	return simpsonIntegration<QRotationMeasure, QRMIntegral>([integrand](QLength dist) { return integrand(dist); }, 0,
-	                                                         getMaxDistance(direction), 500);
+	return simpsonIntegrationBatch<QRotationMeasure, QRMIntegral>(integrand, 0, ray.maxDistance, 500);
 }
 
 QRMIntegral RotationMeasureIntegrator::integralFunction(const Vector3QLength& pos) const {
+	Vector3QMField B = mfield->getField(pos);
+	if (B.getR() == 0_muG) return 0;
+
+	return integralFunction(pos, B, gdensity->getDensity(pos));
+}
+
+QRMIntegral RotationMeasureIntegrator::integralFunction(const Vector3QLength& pos, const Vector3QMField& B,
+                                                        const QPDensity& N) const {
 	const auto const_a0 = pow<3>(e_plus) / (8 * pi * pi * epsilon0 * squared(m_electron) * pow<3>(c_light));
 
-	Vector3QMField B = mfield->getField(pos);
 	if (B.getR() == 0_muG) return 0;
 	// TODO(adundovi): optimise
 	QMField B_parallel = B.getR() * cos((B.getValue()).getAngleTo(pos.getValue()));
 
-	return const_a0 * B_parallel * gdensity->getDensity(pos) * radian;
+	return const_a0 * B_parallel * N * radian;
 }
 
 }  // namespace hermes
@@ -21,8 +21,38 @@ QTemperature SynchroAbsorptionIntegrator::integrateOverLOS(const QDirection& dir
 	return integrateOverLOS(direction, 408_MHz);
 }
 
+void SynchroAbsorptionIntegrator::setSampleStore(const std::shared_ptr<LOSSampleStore>& store) {
+	if (store != nullptr) registerSampleStoreModels(*store, mfield, gdensity, crdensity);
+	sampleStore = store;
+}
+
+std::shared_ptr<LOSSampleStore> SynchroAbsorptionIntegrator::getSampleStore() const { return sampleStore; }
+
+bool SynchroAbsorptionIntegrator::useSampleStore() const {
+	return sampleStore != nullptr && sampleStore->getObsPosition() == observerPosition;
+}
+
 QTemperature SynchroAbsorptionIntegrator::integrateOverLOS(const QDirection& direction_,
                                                            const QFrequency& freq_) const {
+	if (useSampleStore()) {
+		auto samples = sampleStore->getSamples(direction_);
+		QIntensity total_intensity(0);
+		QNumber opticalDepth(0);
+		std::vector<QNumber> opticalDepthLOS(samples->size(), QNumber(0));
+
+		for (std::size_t i = 1; i < samples->size(); ++i) {
+			opticalDepth += intFreeFree->absorptionCoefficientExplicit(samples->ionizedGasDensity[i], freq_) *
+			                samples->step;
+			opticalDepthLOS[i] = opticalDepth;
+		}
+		for (std::size_t i = 1; i < samples->size(); ++i)
+			total_intensity += intSynchro->integrateOverEnergy(samples->position[i], samples->magneticField[i],
+			                                                   samples->getCRSpectrum(i), freq_) /
+			                   4_pi * exp(opticalDepthLOS[i] - opticalDepth) * samples->step;
+
+		return intensityToTemperature(total_intensity, freq_);
+	}
+
 	Vector3QLength observerPosition(8.5_kpc, 0, 0);
 	Vector3QLength pos(0.0);
 	QIntensity total_intensity(0);
@@ -32,10 +62,11 @@ QTemperature SynchroAbsorptionIntegrator::integrateOverLOS(const QDirection& dir
 	std::vector<QNumber> opticalDepthLOS;
 
 	// distance from the (spherical) galactic border in the given direction
-	QLength maxDistance = distanceToGalBorder(observerPosition, direction_);
+	const LOSRay ray = makeLOSRay(observerPosition, direction_);
+	QLength maxDistance = ray.maxDistance;
 
 	for (QLength dist = delta_d; dist <= maxDistance; dist += delta_d) {
-		pos = getGalacticPosition(observerPosition, dist, direction_);
+		pos = ray.getPosition(dist);
 		opticalDepth += intFreeFree->absorptionCoefficient(pos, freq_) * delta_d;
 		opticalDepthLOS.push_back(opticalDepth);
 	}
@@ -43,7 +74,7 @@ QTemperature SynchroAbsorptionIntegrator::integrateOverLOS(const QDirection& dir
 	// TODO(adundovi): implement sophisticated adaptive integration method :-)
 	auto opticalDepthIter = opticalDepthLOS.begin();
 	for (QLength dist = delta_d; dist <= maxDistance; dist += delta_d) {
-		pos = getGalacticPosition(observerPosition, dist, direction_);
+		pos = ray.getPosition(dist);
 		total_intensity += intSynchro->integrateOverEnergy(pos, freq_) / 4_pi *
 		                   exp((*opticalDepthIter) - opticalDepthLOS[opticalDepthLOS.size() - 1]) * delta_d;
 		++opticalDepthIter;
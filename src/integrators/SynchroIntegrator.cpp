@@ -3,6 +3,7 @@
 #include <gsl/gsl_sf_synchrotron.h>
 
 #include <memory>
+#include <vector>
 
 #include "hermes/Common.h"
 #include "hermes/integrators/LOSIntegrationMethods.h"
@@ -29,20 +30,79 @@ QTemperature SynchroIntegrator::integrateOverLOS(
 	return integrateOverLOS(direction, skymapParameter);
 }
 
+void SynchroIntegrator::setSampleStore(
+    const std::shared_ptr<LOSSampleStore> &store) {
+	if (store != nullptr)
+		registerSampleStoreModels(*store, mfield, nullptr, crdensity);
+	sampleStore = store;
+}
+
+std::shared_ptr<LOSSampleStore> SynchroIntegrator::getSampleStore() const {
+	return sampleStore;
+}
+
+bool SynchroIntegrator::useSampleStore() const {
+	return sampleStore != nullptr &&
+	       sampleStore->getObsPosition() == observerPosition;
+}
+
 QTemperature SynchroIntegrator::integrateOverLOS(
     const QDirection &direction, const QFrequency &freq_) const {
-	auto integrand = [this, direction, freq_](const QLength &dist) {
-		return this->integrateOverEnergy(
-		    getGalacticPosition(this->observerPosition, dist, direction), freq_);
+	if (useSampleStore()) {
+		auto samples = sampleStore->getSamples(direction);
+		QIntensity total_intensity(0);
+		for (std::size_t i = 0; i < samples->size(); ++i)
+			total_intensity +=
+			    integrateOverEnergy(samples->position[i],
+			                        samples->magneticField[i],
+			                        samples->getCRSpectrum(i), freq_) *
+			    samples->getSimpsonWeight(i);
+		return intensityToTemperature(total_intensity / 4_pi, freq_);
+	}
+
+	const LOSRay ray = getRay(direction);
+	auto integrand = [this, &ray, freq_](const QLength &dist) {
+		return this->integrateOverEnergy(ray.getPosition(dist), freq_);
 	};
 
 	QIntensity total_intensity = simpsonIntegration<QIntensity, QEmissivity>(
-	    [integrand](QLength dist) { return integrand(dist); }, 0,
-	    getMaxDistance(direction), 100);
+	    integrand, 0, ray.maxDistance, 100);
 
 	return intensityToTemperature(total_intensity / 4_pi, freq_);
 }
 
+std::vector<QTemperature> SynchroIntegrator::integrateOverLOS(
+    const QDirection &direction,
+    const std::vector<QFrequency> &freqs_) const {
+	std::vector<QIntensity> intensities(freqs_.size(), QIntensity(0));
+
+	if (useSampleStore()) {
+		auto samples = sampleStore->getSamples(direction);
+		for (std::size_t i = 0; i < samples->size(); ++i) {
+			auto emissivity = integrateOverEnergy(
+			    samples->position[i], samples->magneticField[i],
+			    samples->getCRSpectrum(i), freqs_);
+			for (std::size_t k = 0; k < freqs_.size(); ++k)
+				intensities[k] += emissivity[k] * samples->getSimpsonWeight(i);
+		}
+	} else {
+		const LOSRay ray = getRay(direction);
+		auto integrand = [this, &ray, &freqs_](const QLength &dist) {
+			return this->integrateOverEnergy(ray.getPosition(dist), freqs_);
+		};
+
+		intensities = simpsonIntegrationSpectrum<QIntensity, QEmissivity>(
+		    integrand, freqs_.size(), 0, ray.maxDistance, 100);
+	}
+
+	std::vector<QTemperature> result;
+	result.reserve(freqs_.size());
+	for (std::size_t k = 0; k < freqs_.size(); ++k)
+		result.push_back(
+		    intensityToTemperature(intensities[k] / 4_pi, freqs_[k]));
+	return result;
+}
+
 QEnergy SynchroIntegrator::singleElectronEmission(
     const QFrequency &freq_, const QEnergy &E_, const QMField &B_perp_) const {
 	// TODO(adundovi): non-relativistic factor (c/v) (see Longair eq. 8.55)
@@ -60,57 +120,95 @@ QEnergy SynchroIntegrator::singleElectronEmission(
 	return const_synchro * B_perp_ * gsl_sf_synchrotron_1(ratio);
 }
 
+QMField SynchroIntegrator::perpendicularField(
+    const Vector3QLength &pos_, const Vector3QMField &B_) const {
+	// skip B null-vector as it will produce NaN in the next step
+	if (B_.getR() == 0_muG) return 0_T;
+	if (pos_ == Vector3QLength(0)) return 0_T;  // skip the origin
+	return fabs(B_.getR() * sin((B_.getValue()).getAngleTo(pos_.getValue())));
+}
+
 QEmissivity SynchroIntegrator::integrateOverEnergy(
     const Vector3QLength &pos_, const QFrequency &freq_) const {
+	Vector3QMField B = mfield->getField(pos_);
+	if (perpendicularField(pos_, B) == 0_T) return QEmissivity(0);
+
+	std::vector<QPDensityPerEnergy> density;
+	crdensity->getDensitySpectrum(pos_, density);
+
+	return integrateOverEnergy(pos_, B, density.data(), freq_);
+}
+
+QEmissivity SynchroIntegrator::integrateOverEnergy(
+    const Vector3QLength &pos_, const Vector3QMField &B_,
+    const QPDensityPerEnergy *density, const QFrequency &freq_) const {
+	QMField B_perp = perpendicularField(pos_, B_);
+	if (B_perp == 0_T) return QEmissivity(0);
+
 	if (crdensity->existsScaleFactor()) {
-		return integrateOverLogEnergy(pos_, freq_);
+		return integrateOverLogEnergy(B_perp, density, freq_);
 	} else {
-		return integrateOverSumEnergy(pos_, freq_);
+		return integrateOverSumEnergy(B_perp, density, freq_);
 	}
 }
 
 QEmissivity SynchroIntegrator::integrateOverSumEnergy(
-    const Vector3QLength &pos_, const QFrequency &freq_) const {
+    const QMField &B_perp, const QPDensityPerEnergy *density,
+    const QFrequency &freq_) const {
 	QEmissivity emissivity(0);
 	QEnergy deltaE;
-	Vector3QMField B;
-	QMField B_perp;
-
-	B = mfield->getField(pos_);
-	// skip B null-vector as it will produce NaN in the next step
-	if (B.getR() == 0_muG) return emissivity;
-	if (pos_ == Vector3QLength(0)) return emissivity;  // skip the origin
-	B_perp = B.getR() * sin((B.getValue()).getAngleTo(pos_.getValue()));
-	if (B_perp == 0_T) return emissivity;
 
 	for (auto itE = std::next(crdensity->begin()); itE != crdensity->end();
 	     ++itE) {
 		deltaE = (*itE) - *std::prev(itE);
-		emissivity += singleElectronEmission(freq_, (*itE), fabs(B_perp)) *
-		              crdensity->getDensityPerEnergy(*itE, pos_) * deltaE;
+		emissivity += singleElectronEmission(freq_, (*itE), B_perp) *
+		              density[itE - crdensity->begin()] * deltaE;
 	}
 
 	return emissivity;
 }
 
 QEmissivity SynchroIntegrator::integrateOverLogEnergy(
-    const Vector3QLength &pos_, const QFrequency &freq_) const {
+    const QMField &B_perp, const QPDensityPerEnergy *density,
+    const QFrequency &freq_) const {
 	QEmissivity emissivity(0);
-	Vector3QMField B;
-	QMField B_perp;
-
-	B = mfield->getField(pos_);
-	if (B.getR() == 0_muG) return emissivity;
-	if (pos_ == Vector3QLength(0)) return emissivity;  // skip the origin
-	B_perp = B.getR() * sin((B.getValue()).getAngleTo(pos_.getValue()));
-	if (B_perp == 0_T) return emissivity;
 
 	for (auto itE = crdensity->begin(); itE != crdensity->end(); ++itE) {
-		emissivity += singleElectronEmission(freq_, (*itE), fabs(B_perp)) *
-		              crdensity->getDensityPerEnergy(*itE, pos_) * (*itE);
+		emissivity += singleElectronEmission(freq_, (*itE), B_perp) *
+		              density[itE - crdensity->begin()] * (*itE);
 	}
 
 	return emissivity * log(crdensity->getEnergyScaleFactor());
 }
 
+std::vector<QEmissivity> SynchroIntegrator::integrateOverEnergy(
+    const Vector3QLength &pos_, const std::vector<QFrequency> &freqs_) const {
+	Vector3QMField B = mfield->getField(pos_);
+	if (perpendicularField(pos_, B) == 0_T)
+		return std::vector<QEmissivity>(freqs_.size(), QEmissivity(0));
+
+	std::vector<QPDensityPerEnergy> density;
+	crdensity->getDensitySpectrum(pos_, density);
+
+	return integrateOverEnergy(pos_, B, density.data(), freqs_);
+}
+
+std::vector<QEmissivity> SynchroIntegrator::integrateOverEnergy(
+    const Vector3QLength &pos_, const Vector3QMField &B_,
+    const QPDensityPerEnergy *density,
+    const std::vector<QFrequency> &freqs_) const {
+	std::vector<QEmissivity> emissivity(freqs_.size(), QEmissivity(0));
+
+	QMField B_perp = perpendicularField(pos_, B_);
+	if (B_perp == 0_T) return emissivity;
+
+	const bool logEnergy = crdensity->existsScaleFactor();
+	for (std::size_t k = 0; k < freqs_.size(); ++k)
+		emissivity[k] = logEnergy
+		                    ? integrateOverLogEnergy(B_perp, density, freqs_[k])
+		                    : integrateOverSumEnergy(B_perp, density, freqs_[k]);
+
+	return emissivity;
+}
+
 }  // namespace hermes
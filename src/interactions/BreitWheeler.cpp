@@ -5,6 +5,7 @@
 #include <functional>
 
 #include "hermes/Common.h"
+#include "hermes/GSLWorkspace.h"
 
 #define GSL_LIMIT 10000
 #define GSL_KEYINT 3
@@ -48,10 +49,9 @@ QArea BreitWheeler::integratedOverTheta(const QEnergy &Egamma, const QEnergy &Ep
 	gsl_function_pp<decltype(integrand)> Fp(integrand);
 	gsl_function *F = static_cast<gsl_function *>(&Fp);
 
-	gsl_integration_workspace *w = gsl_integration_workspace_alloc(GSL_LIMIT);
-	gsl_integration_qag(F, static_cast<double>(a), static_cast<double>(b), abs_error, rel_error, GSL_LIMIT, key, w,
-	                    &result, &error);
-	gsl_integration_workspace_free(w);
+	GSLWorkspace w(GSL_LIMIT);
+	gsl_integration_qag(F, static_cast<double>(a), static_cast<double>(b), abs_error, rel_error, GSL_LIMIT, key,
+	                    w.get(), &result, &error);
 
 	return 0.5 * result;
 }
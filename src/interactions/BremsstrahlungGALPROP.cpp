@@ -6,6 +6,7 @@
 #include <functional>
 
 #include "hermes/Common.h"
+#include "hermes/GSLWorkspace.h"
 
 // Following units from Koch and Motz, 1959
 #define mc_units (m_electron * c_light)
@@ -37,6 +38,21 @@ void BremsstrahlungGALPROP::enableCaching() { cachingEnabled = true; };
 
 void BremsstrahlungGALPROP::disableCaching() { cachingEnabled = false; };
 
+void BremsstrahlungGALPROP::setCacheTable(
+    const std::vector<QEnergy> &electronEnergies,
+    const std::vector<QEnergy> &photonEnergies) {
+	for (auto &t : allTargets) {
+		auto table = std::make_unique<CacheStorageCrossSectionTable>(
+		    electronEnergies, photonEnergies);
+		table->setFunction([t, this](QEnergy T_electron, QEnergy E_gamma) {
+			return this->getDiffCrossSectionForTargetDirectly(t, T_electron,
+			                                                  E_gamma);
+		});
+		cache[static_cast<int>(t)] = std::move(table);
+	}
+	cachingEnabled = true;
+}
+
 QDiffCrossSection BremsstrahlungGALPROP::getDiffCrossSectionForTarget(
     Target t, const QEnergy &T_electron, const QEnergy &E_gamma) const {
 	if (cachingEnabled)
@@ -93,9 +109,8 @@ QNumber BremsstrahlungGALPROP::I_Phi_1(const QNumber &delta_, int Z,
 	gsl_function_pp<decltype(R_N)> Fp(R_N);
 	gsl_function *F = static_cast<gsl_function *>(&Fp);
 
-	gsl_integration_workspace *w = gsl_integration_workspace_alloc(LIMIT);
-	gsl_integration_qags(F, delta, 1, 0, EPSINT, LIMIT, w, &result, &error);
-	gsl_integration_workspace_free(w);
+	GSLWorkspace w(LIMIT);
+	gsl_integration_qags(F, delta, 1, 0, EPSINT, LIMIT, w.get(), &result, &error);
 
 	return result;
 }
@@ -114,9 +129,8 @@ QNumber BremsstrahlungGALPROP::I_Phi_2(const QNumber &delta_, int Z,
 	gsl_function_pp<decltype(R_N)> Fp(R_N);
 	gsl_function *F = static_cast<gsl_function *>(&Fp);
 
-	gsl_integration_workspace *w = gsl_integration_workspace_alloc(LIMIT);
-	gsl_integration_qags(F, delta, 1, 0, EPSINT, LIMIT, w, &result, &error);
-	gsl_integration_workspace_free(w);
+	GSLWorkspace w(LIMIT);
+	gsl_integration_qags(F, delta, 1, 0, EPSINT, LIMIT, w.get(), &result, &error);
 
 	return result;
 }
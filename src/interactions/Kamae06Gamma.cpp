@@ -4,13 +4,17 @@ namespace hermes { namespace interactions {
 
 Kamae06Gamma::Kamae06Gamma() : DifferentialCrossSection(false) {}
 
-void Kamae06Gamma::setCachingStorage(std::unique_ptr<CacheStorageCrossSection> cache_) {
+void Kamae06Gamma::setCachingStorage(std::unique_ptr<CacheStorageCrossSectionBase> cache_) {
 	cache = std::move(cache_);
 	enableCaching();
 	auto f = [this](QEnergy E_proton, QEnergy E_gamma) { return this->getDiffCrossSectionDirectly(E_proton, E_gamma); };
 	cache->setFunction(f);
 };
 
+void Kamae06Gamma::setCacheTable(const std::vector<QEnergy> &protonEnergies, const std::vector<QEnergy> &secondaryEnergies) {
+	setCachingStorage(std::make_unique<CacheStorageCrossSectionTable>(protonEnergies, secondaryEnergies));
+}
+
 QDiffCrossSection Kamae06Gamma::getDiffCrossSection(const QEnergy &E_proton, const QEnergy &E_gamma) const {
 	if (cachingEnabled) return cache->getValue(E_proton, E_gamma);
 	return getDiffCrossSectionDirectly(E_proton, E_gamma);
@@ -4,13 +4,17 @@ namespace hermes { namespace interactions {
 
 Kamae06Neutrino::Kamae06Neutrino() : DifferentialCrossSection(false) {}
 
-void Kamae06Neutrino::setCachingStorage(std::unique_ptr<CacheStorageCrossSection> cache_) {
+void Kamae06Neutrino::setCachingStorage(std::unique_ptr<CacheStorageCrossSectionBase> cache_) {
 	cache = std::move(cache_);
 	enableCaching();
 	auto f = [this](QEnergy E_proton, QEnergy E_nu) { return this->getDiffCrossSectionDirectly(E_proton, E_nu); };
 	cache->setFunction(f);
 };
 
+void Kamae06Neutrino::setCacheTable(const std::vector<QEnergy> &protonEnergies, const std::vector<QEnergy> &secondaryEnergies) {
+	setCachingStorage(std::make_unique<CacheStorageCrossSectionTable>(protonEnergies, secondaryEnergies));
+}
+
 QDiffCrossSection Kamae06Neutrino::getDiffCrossSection(const QEnergy &E_proton, const QEnergy &E_nu) const {
 	if (cachingEnabled) return cache->getValue(E_proton, E_nu);
 	return getDiffCrossSectionDirectly(E_proton, E_nu);
@@ -0,0 +1,40 @@
+#include "hermes/ionizedgas/GriddedIonizedGasDensity.h"
+
+namespace hermes { namespace ionizedgas {
+
+GriddedIonizedGasDensity::GriddedIonizedGasDensity(
+    const std::shared_ptr<IonizedGasDensity> &model_,
+    const std::vector<QLength> &x, const std::vector<QLength> &y,
+    const std::vector<QLength> &z, const std::string &cacheTag)
+    : IonizedGasDensity(model_->getTemperature()), model(model_), grid(x, y, z) {
+	auto column = [this](const Vector3d *pos, double *out, std::size_t n) {
+		std::vector<Vector3QLength> p;
+		p.reserve(n);
+		for (std::size_t i = 0; i < n; ++i) p.push_back(Vector3QLength(pos[i]));
+		std::vector<QPDensity> density;
+		model->getDensity(p, density);
+		for (std::size_t i = 0; i < n; ++i)
+			out[i] = static_cast<double>(density[i]);
+	};
+	if (cacheTag.empty())
+		grid.fill(column);
+	else
+		grid.fillCached("GriddedIonizedGasDensity_" + cacheTag, column);
+}
+
+QPDensity GriddedIonizedGasDensity::getDensity(const Vector3QLength &pos) const {
+	const Vector3d r = pos.getValue();
+	if (!grid.contains(r)) return model->getDensity(pos);
+	return QPDensity(grid.interpolate(r));
+}
+
+LookupGridAccuracy GriddedIonizedGasDensity::getAccuracy(std::size_t nSamples,
+                                                         unsigned seed) const {
+	return grid.measureAccuracy(
+	    [this](const Vector3d &pos) {
+		    return static_cast<double>(model->getDensity(Vector3QLength(pos)));
+	    },
+	    nSamples, seed);
+}
+
+}}  // namespace hermes::ionizedgas
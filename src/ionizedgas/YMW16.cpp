@@ -1,5 +1,7 @@
 #include "hermes/ionizedgas/YMW16.h"
 
+#include <algorithm>
+
 /*Copyright (C) 2016, 2017  J. M. Yao, R. N. Manchester, N. Wang.
 
 This file is part of the YMW16 program. YMW16 is a model for the
@@ -31,6 +33,29 @@ by Andrej Dundovic (andrej.dundovic@gssi.it, 2020)
 
 namespace hermes { namespace ionizedgas {
 
+namespace {
+// (2 / (exp(-a) + exp(a)))^2 with a single exponential
+inline double sech2(double a) {
+	const double t = std::exp(-std::fabs(a));
+	const double d = 1 + t * t;
+	return 4 * t * t / (d * d);
+}
+
+struct GumCentre {
+	double x, y, z;
+};
+// centre of the Gum nebula (in pc): l = 264 deg, b = -4 deg, 450 pc from
+// the Sun; shared by YMW16::gum() and YMW16::neBlock()
+const GumCentre &gumCentre() {
+	const double lc = 264;
+	const double bc = -4;
+	const double dc = 450;
+	static const GumCentre c = {dc * std::cos(bc / RAD) * std::sin(lc / RAD),
+	                            R0 * 1000 - dc * std::cos(bc / RAD) * std::cos(lc / RAD), dc * std::sin(bc / RAD)};
+	return c;
+}
+}  // namespace
+
 YMW16::YMW16() : IonizedGasDensity(1e4_K) { initParameters(); }
 
 YMW16::YMW16(const QTemperature &t) : IonizedGasDensity(t) { initParameters(); }
@@ -49,6 +74,169 @@ QPDensity YMW16::getDensity(const Vector3QLength &pos) const {
 	return density;
 };
 
+void YMW16::getDensity(const Vector3QLength *pos, QPDensity *density, std::size_t n) const {
+	const double pc = static_cast<double>(parsec);
+	double xx[blockSize], yy[blockSize], zz[blockSize], ne[blockSize];
+
+	for (std::size_t begin = 0; begin < n; begin += blockSize) {
+		const std::size_t m = std::min(blockSize, n - begin);
+		// the same change of coordinates as in getDensity(pos)
+		for (std::size_t i = 0; i < m; ++i) {
+			xx[i] = -static_cast<double>(pos[begin + i].getY()) / pc;
+			yy[i] = static_cast<double>(pos[begin + i].getX()) / pc;
+			zz[i] = static_cast<double>(pos[begin + i].getZ()) / pc;
+		}
+		neBlock(xx, yy, zz, ne, m);
+		for (std::size_t i = 0; i < m; ++i) density[begin + i] = QPDensity(ne[i]) / 1_cm3 * 1_m3;
+	}
+}
+
+void YMW16::neBlock(const double *xx, const double *yy, const double *zz, double *ne, std::size_t m) const {
+	const double R_warp = 8400;  // pc
+	double rr[blockSize], R_g[blockSize], zz_w[blockSize], gd[blockSize];
+	double ne1[blockSize], ne2[blockSize], ne4[blockSize], ne5[blockSize], WFB[blockSize];
+	double UU[blockSize], RLI[blockSize];
+
+	// Fermi bubbles
+	static const double fbnz = 0.5 * 8300 * std::tan(50 / RAD);
+	static const double fbsz = -0.5 * 8300 * std::tan(50 / RAD);
+	static const double fbna2 = fbnz * fbnz;
+	static const double fbnb2 = std::pow(8300 * std::tan(20 / RAD), 2);
+	const GumCentre &gc = gumCentre();
+
+	// smooth components: straight-line code over the whole block, which
+	// the compiler vectorises (including exp() with -ffast-math); all
+	// terms are evaluated and then masked
+	for (std::size_t i = 0; i < m; ++i) {
+		const double rho2 = xx[i] * xx[i] + yy[i] * yy[i];
+		rr[i] = std::sqrt(rho2);
+		R_g[i] = std::sqrt(rho2 + zz[i] * zz[i]);
+
+		// warp, cos(atan2(yy, xx) - theta_max) with theta_max = 0
+		const double warp = t0.Gamma_w * (rr[i] - R_warp) * xx[i] / std::max(rr[i], R_warp);
+		zz_w[i] = (rr[i] < R_warp) ? zz[i] : zz[i] - warp;
+		const double az_w = std::fabs(zz_w[i]);
+
+		// thick disk
+		const bool inThick = (az_w <= mc * t1.H1) & ((rr[i] - t1.Bd) <= mc * t1.Ad);
+		const double gdd = (rr[i] < t1.Bd) ? 1 : sech2((rr[i] - t1.Bd) / t1.Ad);
+		const double thick = t1.n1 * gdd * sech2(az_w / t1.H1);
+		gd[i] = inThick ? gdd : 0;
+		ne1[i] = inThick ? thick : 0;
+
+		// thin disk
+		const double HH = t2.K2 * (32 + 0.0016 * rr[i] + 0.0000004 * rr[i] * rr[i]);
+		const bool inThin = ((rr[i] - t2.B2) <= (mc * t2.A2)) & (az_w <= (mc * HH));
+		const double thin = t2.n2 * gd[i] * sech2((rr[i] - t2.B2) / t2.A2) * sech2(zz_w[i] / HH);
+		ne2[i] = inThin ? thin : 0;
+
+		// galactic centre
+		const double Rgc2 = (xx[i] - 50) * (xx[i] - 50) + yy[i] * yy[i];
+		const bool inGC = (Rgc2 <= (mc * t4.Agc) * (mc * t4.Agc)) & (std::fabs(zz[i]) <= (mc * t4.Hgc));
+		const double galcen = t4.ngc * std::exp(-Rgc2 / (t4.Agc * t4.Agc)) * sech2((zz[i] + 7) / t4.Hgc);
+		ne4[i] = inGC ? galcen : 0;
+
+		// Gum nebula: gum() with tan(theta) = |dz| / rho and the angles
+		// alpha and theta replaced by their sines and cosines
+		const double dx = xx[i] - gc.x, dy = yy[i] - gc.y, dz = std::fabs(zz[i] - gc.z);
+		const double rho = std::sqrt(dx * dx + dy * dy);
+		const double RR = std::sqrt(rho * rho + dz * dz);
+		const double q = std::sqrt(dz * dz + t5.Kgn * t5.Kgn * rho * rho);
+		const double zp = t5.Agn * t5.Kgn * dz / q;
+		const double xyp = t5.Agn * t5.Kgn * rho / q;
+		const double rp = std::sqrt(zp * zp + xyp * xyp);
+		const bool vertical = (t5.Agn - xyp) < 1e-15;
+		const double cosa2 = std::max(t5.Agn * t5.Agn - xyp * xyp, 0.);
+		const double norm = std::sqrt(cosa2 + t5.Kgn * t5.Kgn * xyp * xyp);
+		const double sina = vertical ? 1 : t5.Kgn * xyp / norm;
+		const double cosa = vertical ? 0 : std::sqrt(cosa2) / norm;
+		const double Dmin = std::fabs((RR - rp) * (dz * cosa + rho * sina) / RR);
+		const double gum = t5.ngn * std::exp(-Dmin * Dmin / (t5.Wgn * t5.Wgn));
+		ne5[i] = (Dmin > mc * t5.Wgn) ? 0 : gum;
+
+		// distances for the local bubble and Loop I
+		const double ulb = (yy[i] - 8340) * 0.94 - 0.34 * zz[i];
+		UU[i] = std::sqrt(ulb * ulb + xx[i] * xx[i]);
+		const double lx = xx[i] + 10.156, ly = yy[i] - 8106.206, lz = zz[i] - 10.467;
+		RLI[i] = std::sqrt(lx * lx + ly * ly + lz * lz);
+
+		// Fermi bubbles
+		const double N = rho2 / fbnb2 + (zz[i] - fbnz) * (zz[i] - fbnz) / fbna2;
+		const double S = rho2 / fbnb2 + (zz[i] - fbsz) * (zz[i] - fbsz) / fbna2;
+		WFB[i] = ((N < 1) | (S < 1)) ? 1 : 0;
+	}
+
+	// the remaining structures as in ne_ymw16(), only where they can
+	// contribute
+	for (std::size_t i = 0; i < m; ++i) {
+		ne[i] = 0;
+		if (R_g[i] >= 100000) continue;  // outside of MW and MC
+
+		const double x_s = xx[i];
+		const double y_s = yy[i] - R0 * 1000;
+		const double z_s = zz[i] - t0.z_Sun;
+		const double dist = std::sqrt(x_s * x_s + y_s * y_s + z_s * z_s);
+		const double r = std::sqrt(x_s * x_s + y_s * y_s);
+		// the Galactic coordinates are needed only near the Sun and far out
+		const double az = std::fabs(zz[i]);
+		const bool outsideLB = ((UU[i] - Rlb) > (mc * t6.wlb1) || az > (mc * t6.hlb1)) &&
+		                       ((UU[i] - Rlb) > (mc * t6.wlb2) || az > (mc * t6.hlb2));
+		double gbr = 0, glr = 0;
+		if (!outsideLB || R_g[i] > 30000) {
+			gbr = (dist < 1e-15) ? 0 : std::asin(z_s / dist);
+			glr = (r < 1e-15) ? 0 : ((x_s >= 0) ? std::acos(-y_s / r) : std::acos(y_s / r) + pi);
+		}
+		const double gb = gbr * RAD;
+		const double gl = glr * RAD;
+
+		int np = 2;
+		if (R_g[i] <= 30000) {
+			np = 1;
+		} else if (gl > 265. && gl < 315. && gb > -60. && gb < -20.)
+			np = 0;
+
+		if (np == 1) {
+			int m_6 = 0, WLI = 0;
+
+			// the spiral arms vanish outside of the thick disk
+			double ne3 = 0;
+			const double HHs = t3.Ka * (32 + 0.0016 * rr[i] + 0.0000004 * rr[i] * rr[i]);
+			if (gd[i] != 0 && std::fabs(zz_w[i]) <= mc * HHs && std::fabs(zz_w[i] / 300) < 10)
+				ne3 = spiralArms(xx[i], yy[i], zz_w[i], gd[i], rr[i], HHs);
+
+			// localbubble() returns 0 and disables nps() outside of the
+			// bubble, nps() is 0 away from the loop
+			double hh = UU[i], ne6 = 0, ne7 = 0;
+			if (!outsideLB) {
+				ne6 = localbubble(xx[i], yy[i], zz[i], gl, gb, &hh, &m_6);
+				if (std::fabs(RLI[i] - t7.RLI) <= (mc * t7.WLI)) ne7 = nps(xx[i], yy[i], zz[i], &WLI, &m_6);
+			}
+
+			double ne_1 = (WFB[i] == 1) ? t8.J_FB * ne1[i] : ne1[i];
+			double ne0 = ne_1 + MAX(ne2[i], ne3);
+			int WLB, WGN;
+			if (hh > 110) { /* Outside LB */
+				WLB = (ne6 > ne0 && ne6 > ne5[i]) ? 1 : 0;
+			} else { /* Inside LB */
+				if (ne6 > ne0) {
+					WLB = 1;
+				} else {
+					ne_1 = t6.J_LB * ne_1;
+					ne0 = ne_1 + MAX(ne2[i], ne3);
+					WLB = 0;
+				}
+			}
+			WLI = (ne7 > ne0) ? 1 : 0;
+			WGN = (ne5[i] > ne0) ? 1 : 0;
+
+			ne[i] = (1 - WLB) * ((1 - WGN) * ((1 - WLI) * (ne0 + ne4[i]) + WLI * ne7) + WGN * ne5[i]) + WLB * ne6;
+		} else if (np == 0) {
+			int w_lmc = 0, w_smc = 0;
+			ne[i] = lmc(glr, gbr, dist, &w_lmc) + dora(glr, gbr, dist) + smc(xx[i], yy[i], zz[i], &w_smc);
+		}
+	}
+}
+
 void YMW16::initParameters() {
 	t0 = {
 	    .Gamma_w = P_Gamma_w,
@@ -195,7 +383,11 @@ double YMW16::galcen(double xx, double yy, double zz) const {
 
 double YMW16::spiral(double xx, double yy, double zz, double gd, double rr, int *ww, int *m_3) const {
 	int i, which_arm;
-	static double rmin[5], thmin[5], tpitch[5], cspitch[5], sspitch[5];
+	static const double rmin[5] = {sp_1_1, sp_2_1, sp_3_1, sp_4_1, sp_5_1};
+	static const double thmin[5] = {sp_1_2, sp_2_2, sp_3_2, sp_4_2, sp_5_2};
+	static const double tpitch[5] = {sp_1_3, sp_2_3, sp_3_3, sp_4_3, sp_5_3};
+	static const double cspitch[5] = {sp_1_4, sp_2_4, sp_3_4, sp_4_4, sp_5_4};
+	static const double sspitch[5] = {sp_1_5, sp_2_5, sp_3_5, sp_4_5, sp_5_5};
 	double detrr = 1e10;
 	double armr1, armr2, smin, sminmin, saxis, uu, Aaa, HH, Hg;
 	double ne3s = 0;
@@ -209,35 +401,6 @@ double YMW16::spiral(double xx, double yy, double zz, double gd, double rr, int
 	Hg = 32 + 0.0016 * rr + 0.0000004 * std::pow(rr, 2);
 	HH = t3.Ka * Hg;
 
-	if (*ww == 1) {
-		rmin[0] = sp_1_1;
-		thmin[0] = sp_1_2;
-		tpitch[0] = sp_1_3;
-		cspitch[0] = sp_1_4;
-		sspitch[0] = sp_1_5;
-		rmin[1] = sp_2_1;
-		thmin[1] = sp_2_2;
-		tpitch[1] = sp_2_3;
-		cspitch[1] = sp_2_4;
-		sspitch[1] = sp_2_5;
-		rmin[2] = sp_3_1;
-		thmin[2] = sp_3_2;
-		tpitch[2] = sp_3_3;
-		cspitch[2] = sp_3_4;
-		sspitch[2] = sp_3_5;
-		rmin[3] = sp_4_1;
-		thmin[3] = sp_4_2;
-		tpitch[3] = sp_4_3;
-		cspitch[3] = sp_4_4;
-		sspitch[3] = sp_4_5;
-		rmin[4] = sp_5_1;
-		thmin[4] = sp_5_2;
-		tpitch[4] = sp_5_3;
-		cspitch[4] = sp_5_4;
-		sspitch[4] = sp_5_5;
-		(*ww)++;
-	}
-
 	theta = std::atan2(yy, xx);
 	if (theta < 0) theta = 2 * pi + theta;
 
@@ -351,28 +514,70 @@ double YMW16::spiral(double xx, double yy, double zz, double gd, double rr, int
 	return 0;
 }
 
+double YMW16::spiralArms(double xx, double yy, double zz, double gd, double rr, double HH) const {
+	static const double rmin[5] = {sp_1_1, sp_2_1, sp_3_1, sp_4_1, sp_5_1};
+	static const double thmin[5] = {sp_1_2, sp_2_2, sp_3_2, sp_4_2, sp_5_2};
+	static const double tpitch[5] = {sp_1_3, sp_2_3, sp_3_3, sp_4_3, sp_5_3};
+	static const double cspitch[5] = {sp_1_4, sp_2_4, sp_3_4, sp_4_4, sp_5_4};
+	// exp(2 pi tpitch): an arm radius one turn further out
+	static const double turn[5] = {std::exp(2 * pi * sp_1_3), std::exp(2 * pi * sp_2_3), std::exp(2 * pi * sp_3_3),
+	                               std::exp(2 * pi * sp_4_3), std::exp(2 * pi * sp_5_3)};
+	// the lower bound of theta for which the arm is also followed
+	// inwards, see spiral()
+	static const double thetaSplit[4] = {0.77, 2.093, 3.81, 5.76};
+
+	double theta = std::atan2(yy, xx);
+	if (theta < 0) theta = 2 * pi + theta;
+	const double thetaDeg = theta * RAD;
+
+	// the same for all arms
+	const double factor = gd * sech2((rr - t3.B2s) / t3.Aa) * sech2(std::fabs(zz) / HH);
+
+	double detrr = 1e10;
+	double ne3s = 0;
+	for (int i = 0; i <= 4; i++) {
+		const double armr = rmin[i] * std::exp((theta - thmin[i]) * tpitch[i]);
+		// the ranges end at 6.28, beyond it the previous detrr is kept
+		if (theta < 6.28) {
+			if (i == 4) {
+				detrr = (theta >= 0.96 && theta < 2) ? std::fabs(rr - armr) : 1e10;
+			} else if (theta < thetaSplit[i]) {
+				if (i < 2)
+					detrr = std::fabs(rr - armr * turn[i]);
+				else
+					detrr = MIN(std::fabs(rr - armr * turn[i]), std::fabs(rr - armr * turn[i] * turn[i]));
+			} else {
+				detrr = MIN(std::fabs(rr - armr), std::fabs(rr - armr * turn[i]));
+			}
+		}
+		if (detrr > mc * t3.warm[i]) continue;
+
+		const double smin = detrr * cspitch[i];
+		double ga = sech2(smin / t3.warm[i]);
+		if (i == 2) {
+			const double dsg = thetaDeg - t3.thetasg, dcn = thetaDeg - t3.thetacn;
+			const double cn = (rr > 6000 && thetaDeg > t3.thetacn)
+			                      ? 1 + t3.ncn
+			                      : 1 + t3.ncn * std::exp(-(dcn * dcn) / (t3.wcn * t3.wcn));
+			ga *= (1 - t3.nsg * std::exp(-(dsg * dsg) / (t3.wsg * t3.wsg))) * cn;
+		}
+		ne3s += t3.narm[i] * ga * factor;
+	}
+	return ne3s;
+}
+
 double YMW16::gum(double xx, double yy, double zz, int *m_5) const {
-	double slc, clc, sbc, cbc, xc, yc, zc, rgalc;
+	double xc, yc, zc;
 	double rp, RR, xyp, zp;
 	double theta, alpha;
 	double Dmin = 1e5;
 
-	// center of Gum Nebula
-	const double lc = 264;
-	const double bc = -4;
-	const double dc = 450;
-
 	if (*m_5 >= 1) return 0;
 
-	slc = std::sin(lc / RAD);
-	clc = std::cos(lc / RAD);
-	sbc = std::sin(bc / RAD);
-	cbc = std::cos(bc / RAD);
-
-	rgalc = dc * cbc;
-	xc = rgalc * slc;
-	yc = R0 * 1000 - rgalc * clc;
-	zc = dc * sbc;
+	// center of Gum Nebula
+	xc = gumCentre().x;
+	yc = gumCentre().y;
+	zc = gumCentre().z;
 
 	theta = std::fabs(std::atan((zz - zc) / std::sqrt((xx - xc) * (xx - xc) + (yy - yc) * (yy - yc))));
 	zp = ((t5.Agn) * (t5.Agn) * (t5.Kgn)) /
@@ -459,17 +664,16 @@ double YMW16::localbubble(double xx, double yy, double zz, double gl, double gb,
 double YMW16::nps(double xx, double yy, double zz, int *WLI, int *m_7) const {
 	double x_c, y_c, z_c;
 	double gLI;
-	double theta_LI;
 
 	if (*m_7 >= 1) return 0;
 
-	theta_LI = (t7.thetaLI) / RAD;
 	x_c = -10.156;
 	y_c = 8106.206;
 	z_c = 10.467;
 	double rr, theta;
 	rr = std::sqrt((xx - x_c) * (xx - x_c) + (yy - y_c) * (yy - y_c) + (zz - z_c) * (zz - z_c));
-	theta = std::acos(((xx - x_c) * (std::cos(theta_LI)) + (zz - z_c) * (std::sin(theta_LI))) / rr) * RAD;
+	static const double cos_LI = std::cos(P_thetaLI / RAD), sin_LI = std::sin(P_thetaLI / RAD);
+	theta = std::acos(((xx - x_c) * cos_LI + (zz - z_c) * sin_LI) / rr) * RAD;
 	*WLI = 1;
 	if (std::fabs(rr - t7.RLI) > (mc * t7.WLI) || std::fabs(theta) > (mc * t7.detthetaLI)) {
 		if (rr > 500) (*m_7)++;
@@ -482,15 +686,16 @@ double YMW16::nps(double xx, double yy, double zz, int *WLI, int *m_7) const {
 }
 
 double YMW16::fermibubble(double xx, double yy, double zz) const {
-	double fbnz, fbsz, na, nb, sa, sb, N, S;
+	double N, S;
 	// center of Fermi bubble
-	fbnz = 0.5 * 8300 * std::tan(50 / RAD);
-	fbsz = -(0.5 * (8300 * std::tan(50 / RAD) - 8300 * std::tan(0 / RAD)) + (8300 * std::tan(0 / RAD)));
+	static const double fbnz = 0.5 * 8300 * std::tan(50 / RAD);
+	static const double fbsz =
+	    -(0.5 * (8300 * std::tan(50 / RAD) - 8300 * std::tan(0 / RAD)) + (8300 * std::tan(0 / RAD)));
 	// min_axis and max_axis of Fermi bubble
-	na = fbnz;
-	nb = 8300 * std::tan(20 / RAD);
-	sa = 0.5 * (8300 * std::tan(50 / RAD) - 8300 * std::tan(0 / RAD));
-	sb = 8300 * std::tan(20 / RAD);
+	static const double na = fbnz;
+	static const double nb = 8300 * std::tan(20 / RAD);
+	static const double sa = 0.5 * (8300 * std::tan(50 / RAD) - 8300 * std::tan(0 / RAD));
+	static const double sb = 8300 * std::tan(20 / RAD);
 	N = (std::pow(xx, 2) / (nb * nb)) + (std::pow(yy, 2) / (nb * nb)) + (std::pow(zz - fbnz, 2) / (na * na));
 	S = (std::pow(xx, 2) / (sb * sb)) + (std::pow(yy, 2) / (sb * sb)) + (std::pow(zz - fbsz, 2) / (sa * sa));
 	if (N < 1 || S < 1) {
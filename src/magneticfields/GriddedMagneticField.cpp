@@ -0,0 +1,35 @@
+#include "hermes/magneticfields/GriddedMagneticField.h"
+
+namespace hermes { namespace magneticfields {
+
+GriddedMagneticField::GriddedMagneticField(
+    const std::shared_ptr<MagneticField> &model_, const std::vector<QLength> &x,
+    const std::vector<QLength> &y, const std::vector<QLength> &z,
+    const std::string &cacheTag)
+    : model(model_), grid(x, y, z) {
+	auto column = [this](const Vector3d *pos, Vector3d *out, std::size_t n) {
+		for (std::size_t i = 0; i < n; ++i)
+			out[i] = model->getField(Vector3QLength(pos[i])).getValue();
+	};
+	if (cacheTag.empty())
+		grid.fill(column);
+	else
+		grid.fillCached("GriddedMagneticField_" + cacheTag, column);
+}
+
+Vector3QMField GriddedMagneticField::getField(const Vector3QLength &pos) const {
+	const Vector3d r = pos.getValue();
+	if (!grid.contains(r)) return model->getField(pos);
+	return Vector3QMField(grid.interpolate(r));
+}
+
+LookupGridAccuracy GriddedMagneticField::getAccuracy(std::size_t nSamples,
+                                                     unsigned seed) const {
+	return grid.measureAccuracy(
+	    [this](const Vector3d &pos) {
+		    return model->getField(Vector3QLength(pos)).getValue();
+	    },
+	    nSamples, seed);
+}
+
+}}  // namespace hermes::magneticfields
@@ -9,7 +9,7 @@
 
 namespace hermes { namespace neutralgas {
 
-RingData::RingData(GasType gas) : type(gas) {
+RingData::RingData(GasType gas) : type(gas), data(nullptr) {
 	if (gas == GasType::HI) {
 		readDataFile("NHrings_Ts300K.fits.gz");
 	}
@@ -19,7 +19,16 @@ RingData::RingData(GasType gas) : type(gas) {
 }
 
 void RingData::readDataFile(const std::string &filename) {
-	ffile = std::make_unique<FITSFile>(FITSFile(getDataPath("GasDensity/Remy18/" + filename)));
+	const std::string path = getDataPath("GasDensity/Remy18/" + filename);
+
+	// the decoded maps are cached in a native format (see BinaryCache)
+	std::shared_ptr<BinaryCache> cache;
+	if (!getBinaryCachePath().empty()) {
+		cache = std::make_shared<BinaryCache>("RingData_" + filename, std::vector<std::uint64_t>{fileContentHash(path)});
+		if (loadBinaryCache(cache)) return;
+	}
+
+	ffile = std::make_unique<FITSFile>(FITSFile(path));
 	ffile->openFile(FITS::READ);
 
 	n_lon = ffile->readKeyValueAsInt("NAXIS1");
@@ -36,6 +45,32 @@ void RingData::readDataFile(const std::string &filename) {
 	int firstElement = 1;
 	int nElements = n_lon * n_lat * n_rings;
 	dataVector = ffile->readImageAsFloat(firstElement, nElements);
+	data = dataVector.data();
+
+	if (cache != nullptr)
+		cache->store({static_cast<double>(n_lon), static_cast<double>(n_lat), static_cast<double>(n_rings), min_lon,
+		              delta_lon, min_lat, delta_lat},
+		             dataVector.data(), dataVector.size() * sizeof(float));
+}
+
+bool RingData::loadBinaryCache(const std::shared_ptr<BinaryCache> &cache) {
+	if (!cache->load()) return false;
+
+	const auto &metadata = cache->getMetadata();
+	if (metadata.size() != 7) return false;
+	n_lon = static_cast<int>(metadata[0]);
+	n_lat = static_cast<int>(metadata[1]);
+	n_rings = static_cast<int>(metadata[2]);
+	if (cache->getPayloadSize() != static_cast<std::size_t>(n_lon) * n_lat * n_rings * sizeof(float)) return false;
+	min_lon = metadata[3];
+	delta_lon = metadata[4];
+	min_lat = metadata[5];
+	delta_lat = metadata[6];
+
+	// zero-copy: read the mapped payload directly
+	binaryCache = cache;
+	data = static_cast<const float *>(cache->getPayload());
+	return true;
 }
 
 GasType RingData::getGasType() const { return type; }
@@ -51,7 +86,7 @@ double RingData::getRawValue(int ring, const QDirection &dir) const {
 	int pxl_lon = static_cast<int>(round(lon / 360_deg * n_lon));
 
 	// NAXIS1 x NAXIS2 x NAXIS3 => lon x lat x ring
-	return dataVector[(ring * n_lat + pxl_lat) * n_lon + pxl_lon];
+	return data[(ring * n_lat + pxl_lat) * n_lon + pxl_lon];
 }
 
 QColumnDensity RingData::getHIColumnDensityInRing(int ring, const QDirection &dir) const {
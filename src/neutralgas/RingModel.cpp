@@ -29,6 +29,44 @@ bool Ring::isInside(const Vector3QLength &pos) const {
 	return (rho > innerR && rho < outerR);
 }
 
+std::vector<std::pair<QLength, QLength>> Ring::getCrossings(const Vector3QLength &start, const Vector3d &unitStep,
+                                                          const QLength &maxDistance) const {
+	// rho^2(s) = a s^2 + 2 b s + c
+	const double x = static_cast<double>(start.x), y = static_cast<double>(start.y);
+	const double a = unitStep.x * unitStep.x + unitStep.y * unitStep.y;
+	const double b = x * unitStep.x + y * unitStep.y;
+	const double c = x * x + y * y;
+	const double sMax = static_cast<double>(maxDistance);
+
+	// interval in which rho < R, clipped to [0, sMax]; empty if lo >= hi
+	auto disk = [a, b, c, sMax](double R, double &lo, double &hi) {
+		lo = 0;
+		hi = (c < R * R) ? sMax : 0;
+		if (a <= 0) return;
+		const double disc = b * b - a * (c - R * R);
+		if (disc <= 0) {
+			hi = 0;
+			return;
+		}
+		lo = std::max((-b - std::sqrt(disc)) / a, 0.);
+		hi = std::min((-b + std::sqrt(disc)) / a, sMax);
+	};
+
+	double outerLo, outerHi, innerLo, innerHi;
+	disk(static_cast<double>(outerR), outerLo, outerHi);
+	disk(static_cast<double>(innerR), innerLo, innerHi);
+
+	std::vector<std::pair<QLength, QLength>> intervals;
+	if (!(outerLo < outerHi)) return intervals;
+	if (!(innerLo < innerHi)) {
+		intervals.emplace_back(QLength(outerLo), QLength(outerHi));
+		return intervals;
+	}
+	if (outerLo < innerLo) intervals.emplace_back(QLength(outerLo), QLength(std::min(innerLo, outerHi)));
+	if (innerHi < outerHi) intervals.emplace_back(QLength(std::max(innerHi, outerLo)), QLength(outerHi));
+	return intervals;
+}
+
 GasType Ring::getGasType() const { return dataPtr->getGasType(); }
 
 QColumnDensity Ring::getHIColumnDensity(const QDirection &dir_) const {
@@ -45,7 +83,7 @@ QColumnDensity Ring::getColumnDensity(const QDirection &dir_) const {
 	return QColumnDensity(0);
 }
 
-RingModel::RingModel(GasType gas) : NeutralGasAbstract(), dataPtr(std::make_shared<RingData>(RingData(gas))) {
+RingModel::RingModel(GasType gas) : NeutralGasAbstract(), dataPtr(std::make_shared<RingData>(gas)) {
 	std::fill(XCOvalues.begin(), XCOvalues.end(),
 	          XcoDefaultValue);  // default value for XCO
 	std::fill(enabledRings.begin(), enabledRings.end(),
@@ -54,7 +92,7 @@ RingModel::RingModel(GasType gas) : NeutralGasAbstract(), dataPtr(std::make_shar
 }
 
 // RingModel::RingModel(GasType gas, std::array<QRingX0Unit, 12> XCOvalues_)
-//     : NeutralGasAbstract(), dataPtr(std::make_shared<RingData>(RingData(gas))) {
+//     : NeutralGasAbstract(), dataPtr(std::make_shared<RingData>(gas)) {
 // 	std::copy(XCOvalues_.begin(), XCOvalues_.end(), XCOvalues.begin());
 // 	std::fill(enabledRings.begin(), enabledRings.end(),
 // 	          true);  // enable all by default
@@ -62,7 +100,7 @@ RingModel::RingModel(GasType gas) : NeutralGasAbstract(), dataPtr(std::make_shar
 // }
 
 RingModel::RingModel(GasType gas, std::array<double, 12> XCOfactors)
-    : NeutralGasAbstract(), dataPtr(std::make_shared<RingData>(RingData(gas))) {
+    : NeutralGasAbstract(), dataPtr(std::make_shared<RingData>(gas)) {
 	std::fill(XCOvalues.begin(), XCOvalues.end(),
 	          XcoDefaultValue);  // default value for XCO
 	std::transform(XCOfactors.begin(), XCOfactors.end(), XCOvalues.begin(), XCOvalues.begin(), std::multiplies<>{});
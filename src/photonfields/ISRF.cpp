@@ -1,16 +1,21 @@
 #include "hermes/photonfields/ISRF.h"
 
 #include <algorithm>
-#include <cassert>
 #include <cmath>
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <iterator>
+#include <memory>
 #include <sstream>
+#include <stdexcept>
 #include <string>
 
+#include "hermes/BinaryCache.h"
 #include "hermes/Common.h"
+#include "hermes/ThreadPool.h"
 
 namespace hermes { namespace photonfields {
 
@@ -20,7 +25,7 @@ std::string str(const int &n) {
 	return ss.str();
 }
 
-ISRF::ISRF() {
+ISRF::ISRF() : uniformNr(0), uniformNz(0), uniformDr(0), uniformDz(0) {
 	loadFrequencyAxis();
 
 	auto logWavelenghtToFrequency = [](double lambda) {
@@ -42,6 +47,7 @@ ISRF::ISRF() {
 	*/
 
 	buildEnergyRange();
+	buildFrequencyIndex();
 	loadISRF();
 }
 
@@ -54,6 +60,27 @@ void ISRF::buildEnergyRange() {
 		energyRange.push_back(E);
 }
 
+void ISRF::buildFrequencyIndex() {
+	freqIndex.clear();
+	freqFraction.clear();
+	for (const auto &E : energyRange) {
+		double logf_ = std::log10(
+		    static_cast<double>(h_planck * c_light / E / (micrometre)));
+		if (logf_ < logwavelenghts.front() || logf_ > logwavelenghts.back()) {
+			freqIndex.push_back(std::string::npos);
+			freqFraction.push_back(0);
+			continue;
+		}
+		std::size_t ifreq = std::upper_bound(logwavelenghts.begin() + 1,
+		                                     logwavelenghts.end() - 1, logf_) -
+		                    logwavelenghts.begin() - 1;
+		freqIndex.push_back(ifreq);
+		freqFraction.push_back(
+		    (logf_ - logwavelenghts[ifreq]) /
+		    (logwavelenghts[ifreq + 1] - logwavelenghts[ifreq]));
+	}
+}
+
 void ISRF::loadFrequencyAxis() {
 	double logwl = log10(0.01);  // micron
 	for (size_t i = 0; i < freqR1; ++i) {
@@ -72,37 +99,77 @@ void ISRF::loadFrequencyAxis() {
 
 std::size_t ISRF::getSize() const { return isrf.size(); }
 
-void ISRF::loadISRF() {
-	const int max_num_of_char_in_a_line = 512;
-	const int num_of_header_lines = 1;
+void ISRF::readSpectrumFile(const std::string &filename, double *out) const {
+	std::ifstream fin(filename.c_str(), std::ios::binary);
+	if (!fin) {
+		std::stringstream ss;
+		ss << "hermes: error: File " << filename << " not found";
+		throw std::runtime_error(ss.str());
+	}
+	std::string content((std::istreambuf_iterator<char>(fin)),
+	                    std::istreambuf_iterator<char>());
+
+	// skip the header line, then read (frequency, energy density) pairs
+	const char *p = content.c_str();
+	const char *line = std::strchr(p, '\n');
+	p = (line != nullptr) ? line + 1 : p + content.size();
+	const std::size_t nf = logwavelenghts.size();
+	std::size_t n = 0;
+	while (true) {
+		char *next;
+		std::strtod(p, &next);
+		if (next == p) break;
+		p = next;
+		double e_ = std::strtod(p, &next);
+		if (next == p) break;
+		p = next;
+		if (n < nf) out[n] = e_;
+		++n;
+	}
+	if (n != nf) {
+		std::stringstream ss;
+		ss << "hermes: error: File " << filename << " has " << n
+		   << " instead of " << nf << " values";
+		throw std::runtime_error(ss.str());
+	}
+}
 
-	int n = 0;
+void ISRF::loadISRF() {
+	std::vector<std::string> filenames;
 	for (auto i : r_id) {
 		for (auto j : z_id) {
 			std::ostringstream name;
 			name << "RadiationField/Vernetto16/spectrum_r"
 			     << str(static_cast<int>(i * 10)) << "_z"
 			     << str(static_cast<int>(j * 10)) << ".dat";
-			std::string filename = getDataPath(name.str());
-
-			std::ifstream fin(filename.c_str());
-			if (!fin) {
-				std::stringstream ss;
-				ss << "hermes: error: File " << filename << " not found";
-				throw std::runtime_error(ss.str());
-			}
-			for (std::size_t k = 0; k < num_of_header_lines; ++k) {
-				fin.ignore(max_num_of_char_in_a_line, '\n');
-			}
-			while (!fin.eof()) {
-				double f_, e_;
-				fin >> f_ >> e_;
-				if (!fin.eof()) isrf.push_back(e_);
-			}
-			n++;
+			filenames.push_back(getDataPath(name.str()));
+		}
+	}
+	const std::size_t nf = logwavelenghts.size();
+	const std::size_t bytes = filenames.size() * nf * sizeof(double);
+
+	// the parsed spectra are cached in their final layout (see BinaryCache),
+	// keyed on the manifest of the files so that a warm start reads none
+	std::shared_ptr<BinaryCache> cache;
+	if (!getBinaryCachePath().empty()) {
+		std::vector<std::uint64_t> hashes;
+		hashes.reserve(filenames.size());
+		for (const auto &f : filenames) hashes.push_back(fileManifestHash(f));
+		cache = std::make_shared<BinaryCache>("ISRF_Vernetto16", hashes);
+		if (cache->load() && cache->getPayloadSize() == bytes) {
+			isrf.resize(filenames.size() * nf);
+			std::memcpy(isrf.data(), cache->getPayload(), bytes);
+			return;
 		}
 	}
-	assert(isrf.size() == r_id.size() * z_id.size() * logwavelenghts.size());
+
+	// one spectrum per (r, z) node, stored in the order of the nodes
+	isrf.assign(filenames.size() * nf, 0.);
+	getThreadPool()->parallelFor(filenames.size(), [&](std::size_t n) {
+		readSpectrumFile(filenames[n], isrf.data() + n * nf);
+	});
+
+	if (cache != nullptr) cache->store({}, isrf.data(), bytes);
 }
 
 double ISRF::getISRF(std::size_t ir, std::size_t iz, std::size_t imu) const {
@@ -111,13 +178,163 @@ double ISRF::getISRF(std::size_t ir, std::size_t iz, std::size_t imu) const {
 	return isrf[i];
 }
 
+bool ISRF::locate(double r_, double z_, std::size_t &ir, std::size_t &iz,
+                  double &r_d, double &z_d) const {
+	if (r_ < r_id.front() || r_ > r_id.back()) return false;
+	if (z_ < z_id.front() || z_ > z_id.back()) return false;
+
+	ir = std::upper_bound(r_id.begin() + 1, r_id.end() - 1, r_) -
+	     r_id.begin() - 1;
+	iz = std::upper_bound(z_id.begin() + 1, z_id.end() - 1, z_) -
+	     z_id.begin() - 1;
+	r_d = (r_ - r_id[ir]) / (r_id[ir + 1] - r_id[ir]);
+	z_d = (z_ - z_id[iz]) / (z_id[iz + 1] - z_id[iz]);
+	return true;
+}
+
+void ISRF::interpolateSpectrum(double r_, double z_, double *out) const {
+	std::size_t ir, iz;
+	double r_d, z_d;
+	if (!locate(r_, z_, ir, iz, r_d, z_d)) {
+		std::fill(out, out + energyRange.size(), 0.);
+		return;
+	}
+
+	// the wavelengths are contiguous for every (r, z) node
+	const std::size_t nf = logwavelenghts.size();
+	const double *c00 = &isrf[(ir * z_id.size() + iz) * nf];
+	const double *c01 = c00 + nf;
+	const double *c10 = c00 + z_id.size() * nf;
+	const double *c11 = c10 + nf;
+	const double w00 = (1. - r_d) * (1. - z_d), w01 = (1. - r_d) * z_d,
+	             w10 = r_d * (1. - z_d), w11 = r_d * z_d;
+
+	for (std::size_t iE = 0; iE < energyRange.size(); ++iE) {
+		const std::size_t ifreq = freqIndex[iE];
+		if (ifreq == std::string::npos) {
+			out[iE] = 0;
+			continue;
+		}
+		const double f_d = freqFraction[iE];
+		double c_0 = w00 * c00[ifreq] + w01 * c01[ifreq] + w10 * c10[ifreq] +
+		             w11 * c11[ifreq];
+		double c_1 = w00 * c00[ifreq + 1] + w01 * c01[ifreq + 1] +
+		             w10 * c10[ifreq + 1] + w11 * c11[ifreq + 1];
+		out[iE] = c_0 * (1. - f_d) + c_1 * f_d;
+	}
+}
+
+void ISRF::resampleUniform(std::size_t nR, std::size_t nZ) {
+	if (nR < 2 || nZ < 2)
+		throw std::runtime_error(
+		    "hermes::ISRF::resampleUniform: requires at least 2 nodes per "
+		    "axis");
+
+	const std::size_t nE = energyRange.size();
+	const double dr = (r_id.back() - r_id.front()) / (nR - 1);
+	const double dz = (z_id.back() - z_id.front()) / (nZ - 1);
+	std::vector<double> table(nR * nZ * nE);
+	getThreadPool()->parallelFor(nR * nZ, [&](std::size_t n) {
+		double r_ = std::min(r_id.front() + dr * (n / nZ), r_id.back());
+		double z_ = std::min(z_id.front() + dz * (n % nZ), z_id.back());
+		interpolateSpectrum(r_, z_, table.data() + n * nE);
+	});
+
+	uniformTable = std::move(table);
+	uniformNr = nR;
+	uniformNz = nZ;
+	uniformDr = dr;
+	uniformDz = dz;
+}
+
+bool ISRF::isResampled() const { return !uniformTable.empty(); }
+
+bool ISRF::locateUniform(double r_, double z_, std::size_t &offset,
+                         double &r_d, double &z_d) const {
+	if (r_ < r_id.front() || r_ > r_id.back()) return false;
+	if (z_ < z_id.front() || z_ > z_id.back()) return false;
+
+	double u = (r_ - r_id.front()) / uniformDr;
+	double v = (z_ - z_id.front()) / uniformDz;
+	std::size_t ir = std::min(static_cast<std::size_t>(u), uniformNr - 2);
+	std::size_t iz = std::min(static_cast<std::size_t>(v), uniformNz - 2);
+	r_d = u - ir;
+	z_d = v - iz;
+	offset = (ir * uniformNz + iz) * energyRange.size();
+	return true;
+}
+
+void ISRF::getSpectrum(const Vector3QLength &pos,
+                       std::vector<QEnergyDensity> &out) const {
+	const std::size_t nE = energyRange.size();
+	double r_ = static_cast<double>(sqrt(pos.x * pos.x + pos.y * pos.y) / 1_kpc);
+	double z_ = static_cast<double>(fabs(pos.z) / 1_kpc);
+	out.resize(nE);
+
+	if (uniformTable.empty()) {
+		thread_local std::vector<double> spectrum;
+		spectrum.resize(nE);
+		interpolateSpectrum(r_, z_, spectrum.data());
+		for (std::size_t iE = 0; iE < nE; ++iE)
+			out[iE] = spectrum[iE] * 1_eV / 1_cm3;
+		return;
+	}
+
+	std::size_t offset;
+	double r_d, z_d;
+	if (!locateUniform(r_, z_, offset, r_d, z_d)) {
+		std::fill(out.begin(), out.end(), QEnergyDensity(0));
+		return;
+	}
+	const double *c00 = uniformTable.data() + offset;
+	const double *c01 = c00 + nE;
+	const double *c10 = c00 + uniformNz * nE;
+	const double *c11 = c10 + nE;
+	const double w00 = (1. - r_d) * (1. - z_d), w01 = (1. - r_d) * z_d,
+	             w10 = r_d * (1. - z_d), w11 = r_d * z_d;
+	for (std::size_t iE = 0; iE < nE; ++iE)
+		out[iE] = (w00 * c00[iE] + w01 * c01[iE] + w10 * c10[iE] +
+		           w11 * c11[iE]) *
+		          1_eV / 1_cm3;
+}
+
 QEnergyDensity ISRF::getEnergyDensity(const Vector3QLength &pos,
                                       std::size_t iE) const {
-	QLength r = sqrt(pos.x * pos.x + pos.y * pos.y);
-	QLength z = pos.z;
-	QEnergy E = energyRange[iE];
-	// TODO(adundovi): not implemented
-	return getEnergyDensity(r, z, E);
+	double r_ = static_cast<double>(sqrt(pos.x * pos.x + pos.y * pos.y) / 1_kpc);
+	double z_ = static_cast<double>(fabs(pos.z) / 1_kpc);
+
+	if (!uniformTable.empty()) {
+		const std::size_t nE = energyRange.size();
+		std::size_t offset;
+		double r_d, z_d;
+		if (!locateUniform(r_, z_, offset, r_d, z_d)) return 0;
+		const double *c = uniformTable.data() + offset + iE;
+		return ((1. - r_d) * ((1. - z_d) * c[0] + z_d * c[nE]) +
+		        r_d * ((1. - z_d) * c[uniformNz * nE] +
+		               z_d * c[(uniformNz + 1) * nE])) *
+		       1_eV / 1_cm3;
+	}
+
+	const std::size_t ifreq = freqIndex[iE];
+	std::size_t ir, iz;
+	double r_d, z_d;
+	if (ifreq == std::string::npos || !locate(r_, z_, ir, iz, r_d, z_d))
+		return 0;
+	const double f_d = freqFraction[iE];
+
+	double c_00 =
+	    getISRF(ir, iz, ifreq) * (1. - r_d) + getISRF(ir + 1, iz, ifreq) * r_d;
+	double c_01 = getISRF(ir, iz, ifreq + 1) * (1. - r_d) +
+	              getISRF(ir + 1, iz, ifreq + 1) * r_d;
+	double c_10 = getISRF(ir, iz + 1, ifreq) * (1. - r_d) +
+	              getISRF(ir + 1, iz + 1, ifreq) * r_d;
+	double c_11 = getISRF(ir, iz + 1, ifreq + 1) * (1. - r_d) +
+	              getISRF(ir + 1, iz + 1, ifreq + 1) * r_d;
+
+	double c_0 = c_00 * (1. - z_d) + c_10 * z_d;
+	double c_1 = c_01 * (1. - z_d) + c_11 * z_d;
+
+	return (c_0 * (1. - f_d) + c_1 * f_d) * 1_eV / 1_cm3;
 }
 
 QEnergyDensity ISRF::getEnergyDensity(const Vector3QLength &pos,
@@ -135,37 +352,19 @@ QEnergyDensity ISRF::getEnergyDensity(const QLength &r, const QLength &z,
 	    static_cast<double>(h_planck * c_light / E_photon / (micrometre));
 	double logf_ = std::log10(f_mu);
 
-	if (r_ < r_id.front() || r_ > r_id.back()) return 0;
-	if (z_ < z_id.front() || z_ > z_id.back()) return 0;
 	if (logf_ < logwavelenghts.front() || logf_ > logwavelenghts.back())
 		return 0;
+	std::size_t ir, iz;
+	double r_d, z_d;
+	if (!locate(r_, z_, ir, iz, r_d, z_d)) return 0;
 
-	std::size_t ir =
-	    std::lower_bound(r_id.begin(), r_id.end(), r_) - r_id.begin();
-	std::size_t iz =
-	    std::lower_bound(z_id.begin(), z_id.end(), z_) - z_id.begin();
 	std::size_t ifreq =
-	    std::lower_bound(logwavelenghts.begin(), logwavelenghts.end(), logf_) -
+	    std::upper_bound(logwavelenghts.begin() + 1, logwavelenghts.end() - 1,
+	                     logf_) -
 	    logwavelenghts.begin() - 1;
-
-	if (ir == r_id.size()) return 0;
-	if (iz == z_id.size()) return 0;
-	if (ifreq == logwavelenghts.size()) return 0;
-
-	double r_d = (r_ - r_id[ir]) / (r_id[ir + 1] - r_id[ir]);
-	double z_d = (z_ - z_id[iz]) / (z_id[iz + 1] - z_id[iz]);
 	double f_d = (logf_ - logwavelenghts[ifreq]) /
 	             (logwavelenghts[ifreq + 1] - logwavelenghts[ifreq]);
 
-	/*
-	if (!(r_d >= 0 && r_d <= 1))
-	    return 0;
-	if (!(z_d >= 0 && z_d <= 1))
-	    return 0;
-	if (!(f_d >= 0 && f_d <= 1))
-	    return 0;
-	*/
-
 	double c_00 =
 	    getISRF(ir, iz, ifreq) * (1. - r_d) + getISRF(ir + 1, iz, ifreq) * r_d;
 	double c_01 = getISRF(ir, iz, ifreq + 1) * (1. - r_d) +
@@ -3,6 +3,8 @@
 #include <iostream>
 #include <stdexcept>
 
+#include "hermes/Signals.h"
+
 namespace hermes {
 
 GammaSkymapRange::GammaSkymapRange(std::size_t nside_, QEnergy minEn_,
@@ -46,12 +48,20 @@ GammaSkymap GammaSkymapRange::operator[](std::size_t i) const {
 }
 
 void GammaSkymapRange::compute() {
+	// walk each LOS once for all maps, if they share integrator and mask
+	if (GammaSkymap::computeRange(skymaps)) return;
+
+	// a map stopped by a signal hands it on to this guard, so that the
+	// remaining maps are skipped
+	CancelSignalGuard signalGuard;
 	for (iterator it = skymaps.begin(); it != skymaps.end(); ++it) {
+		if (signalGuard.isCancelled()) break;
 		std::cerr << "hermes::SkymapRange: " << it - skymaps.begin() + 1 << "/"
 		          << skymaps.size() << ", Energy = " << it->getEnergy() / 1_GeV
 		          << " GeV" << std::endl;
 		it->compute();
 	}
+	signalGuard.raisePending();
 }
 
 void GammaSkymapRange::save(
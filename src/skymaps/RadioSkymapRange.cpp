@@ -3,6 +3,8 @@
 #include <iostream>
 #include <stdexcept>
 
+#include "hermes/Signals.h"
+
 namespace hermes {
 
 RadioSkymapRange::RadioSkymapRange(std::size_t nside_, QFrequency minFreq_,
@@ -43,12 +45,20 @@ void RadioSkymapRange::setMask(const std::shared_ptr<SkymapMask>& mask_) {
 }
 
 void RadioSkymapRange::compute() {
+	// walk each LOS once for all maps, if they share integrator and mask
+	if (RadioSkymap::computeRange(skymaps)) return;
+
+	// a map stopped by a signal hands it on to this guard, so that the
+	// remaining maps are skipped
+	CancelSignalGuard signalGuard;
 	for (iterator it = skymaps.begin(); it != skymaps.end(); ++it) {
+		if (signalGuard.isCancelled()) break;
 		std::cout << "hermes::SkymapRange: " << it - skymaps.begin() + 1 << "/"
 		          << skymaps.size() << ", Frequency = " << it->getFrequency()
 		          << " Hz" << std::endl;
 		it->compute();
 	}
+	signalGuard.raisePending();
 }
 
 void RadioSkymapRange::save(
@@ -0,0 +1,194 @@
+#include "hermes/skymaps/SkymapCheckpoint.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+#include "hermes/HEALPixBits.h"
+
+namespace hermes {
+
+namespace {
+const char checkpointMagic[8] = {'H', 'E', 'R', 'M', 'E', 'S', 'C', 'P'};
+const std::uint32_t checkpointVersion = 2;
+}  // namespace
+
+SkymapCheckpoint::SkymapCheckpoint(const std::string &filename_, std::size_t nside, double parameter, bool resume,
+                                   double syncInterval_, std::size_t firstPixel, std::size_t nPixels)
+    : filename(filename_),
+      fd(-1),
+      mapping(nullptr),
+      mappingSize(0),
+      header(nullptr),
+      values(nullptr),
+      done(nullptr),
+      syncInterval(syncInterval_),
+      nextSync(0) {
+	try {
+		open(nside, parameter, resume, firstPixel, nPixels);
+	} catch (...) {
+		close();
+		throw;
+	}
+	nextSync = now() + static_cast<std::int64_t>(syncInterval * 1e3);
+}
+
+SkymapCheckpoint::SkymapCheckpoint(const std::string &filename_)
+    : filename(filename_),
+      fd(-1),
+      mapping(nullptr),
+      mappingSize(0),
+      header(nullptr),
+      values(nullptr),
+      done(nullptr),
+      syncInterval(0),
+      nextSync(0) {
+	fd = ::open(filename.c_str(), O_RDONLY);
+	if (fd < 0) throw std::runtime_error("hermes::SkymapCheckpoint: cannot open " + filename);
+
+	struct stat st;
+	Header h;
+	if (::fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < sizeof(Header) ||
+	    ::pread(fd, &h, sizeof(Header), 0) != static_cast<ssize_t>(sizeof(Header)) ||
+	    std::memcmp(h.magic, checkpointMagic, sizeof(checkpointMagic)) != 0 || h.version != checkpointVersion ||
+	    h.pixelSize != sizeof(double) || h.npix != nside2npix(h.nside) || h.firstPixel + h.nPixels > h.npix ||
+	    static_cast<std::size_t>(st.st_size) != sizeof(Header) + h.nPixels * (sizeof(double) + 1)) {
+		close();
+		throw std::runtime_error("hermes::SkymapCheckpoint: " + filename + " is not a skymap checkpoint");
+	}
+
+	mappingSize = st.st_size;
+	try {
+		map(PROT_READ);
+	} catch (...) {
+		close();
+		throw;
+	}
+}
+
+SkymapCheckpoint::~SkymapCheckpoint() { close(); }
+
+void SkymapCheckpoint::close() {
+	if (mapping != nullptr) {
+		msync(mapping, mappingSize, MS_SYNC);
+		munmap(mapping, mappingSize);
+		mapping = nullptr;
+		header = nullptr;
+		values = nullptr;
+		done = nullptr;
+	}
+	if (fd >= 0) ::close(fd);
+	fd = -1;
+}
+
+std::int64_t SkymapCheckpoint::now() {
+	return std::chrono::duration_cast<std::chrono::milliseconds>(
+	           std::chrono::steady_clock::now().time_since_epoch())
+	    .count();
+}
+
+void SkymapCheckpoint::map(int prot) {
+	mapping = mmap(nullptr, mappingSize, prot, MAP_SHARED, fd, 0);
+	if (mapping == MAP_FAILED) {
+		mapping = nullptr;
+		throw std::runtime_error("hermes::SkymapCheckpoint: cannot map " + filename);
+	}
+
+	header = static_cast<Header *>(mapping);
+	values = reinterpret_cast<double *>(static_cast<char *>(mapping) + sizeof(Header));
+	done = reinterpret_cast<unsigned char *>(values + (mappingSize - sizeof(Header)) / (sizeof(double) + 1));
+}
+
+void SkymapCheckpoint::open(std::size_t nside, double parameter, bool resume, std::size_t firstPixel,
+                            std::size_t nPixels) {
+	const std::size_t npix = nside2npix(nside);
+	if (firstPixel > npix)
+		throw std::runtime_error("hermes::SkymapCheckpoint: pixel range exceeds the skymap");
+	if (nPixels == std::size_t(-1)) nPixels = npix - firstPixel;
+	if (nPixels > npix - firstPixel)
+		throw std::runtime_error("hermes::SkymapCheckpoint: pixel range exceeds the skymap");
+	mappingSize = sizeof(Header) + nPixels * sizeof(double) + nPixels;
+
+	struct stat st;
+	bool exists = (::stat(filename.c_str(), &st) == 0);
+	bool reuse = resume && exists;
+
+	fd = ::open(filename.c_str(), reuse ? O_RDWR : (O_RDWR | O_CREAT | O_TRUNC), 0644);
+	if (fd < 0) throw std::runtime_error("hermes::SkymapCheckpoint: cannot open " + filename);
+
+	if (reuse && static_cast<std::size_t>(st.st_size) != mappingSize)
+		throw std::runtime_error("hermes::SkymapCheckpoint: " + filename + " does not match the skymap");
+	if (!reuse && ::ftruncate(fd, static_cast<off_t>(mappingSize)) != 0)
+		throw std::runtime_error("hermes::SkymapCheckpoint: cannot resize " + filename);
+
+	map(PROT_READ | PROT_WRITE);
+
+	if (reuse) {
+		if (std::memcmp(header->magic, checkpointMagic, sizeof(checkpointMagic)) != 0 ||
+		    header->version != checkpointVersion || header->pixelSize != sizeof(double) || header->nside != nside ||
+		    header->npix != npix || header->parameter != parameter || header->firstPixel != firstPixel ||
+		    header->nPixels != nPixels)
+			throw std::runtime_error("hermes::SkymapCheckpoint: " + filename + " does not match the skymap");
+		std::cout << "hermes::SkymapCheckpoint: resuming with " << getDoneCount() << " of " << nPixels
+		          << " pixels from " << filename << std::endl;
+		return;
+	}
+
+	// a fresh file is zero-filled by ftruncate, hence no pixel is done
+	std::memcpy(header->magic, checkpointMagic, sizeof(checkpointMagic));
+	header->version = checkpointVersion;
+	header->pixelSize = sizeof(double);
+	header->nside = nside;
+	header->npix = npix;
+	header->parameter = parameter;
+	header->firstPixel = firstPixel;
+	header->nPixels = nPixels;
+}
+
+std::size_t SkymapCheckpoint::getNpix() const { return header->npix; }
+
+std::size_t SkymapCheckpoint::getNside() const { return header->nside; }
+
+double SkymapCheckpoint::getParameter() const { return header->parameter; }
+
+std::size_t SkymapCheckpoint::getFirstPixel() const { return header->firstPixel; }
+
+std::size_t SkymapCheckpoint::getPixelCount() const { return header->nPixels; }
+
+bool SkymapCheckpoint::isDone(std::size_t ipix) const {
+	// pixels below the range wrap around to large offsets
+	const std::size_t i = ipix - header->firstPixel;
+	return i < header->nPixels && done[i] != 0;
+}
+
+double SkymapCheckpoint::getValue(std::size_t ipix) const { return values[ipix - header->firstPixel]; }
+
+std::size_t SkymapCheckpoint::getDoneCount() const {
+	std::size_t count = 0;
+	for (std::size_t i = 0; i < header->nPixels; ++i) count += (done[i] != 0);
+	return count;
+}
+
+void SkymapCheckpoint::store(std::size_t ipix, double value) {
+	const std::size_t i = ipix - header->firstPixel;
+	values[i] = value;
+	done[i] = 1;
+
+	// the first thread past the deadline flushes, the others carry on
+	std::int64_t deadline = nextSync.load(std::memory_order_relaxed);
+	std::int64_t t = now();
+	if (t >= deadline &&
+	    nextSync.compare_exchange_strong(deadline, t + static_cast<std::int64_t>(syncInterval * 1e3)))
+		msync(mapping, mappingSize, MS_ASYNC);
+}
+
+void SkymapCheckpoint::sync() { msync(mapping, mappingSize, MS_SYNC); }
+
+}  // namespace hermes
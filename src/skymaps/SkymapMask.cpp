@@ -1,12 +1,78 @@
 #include "hermes/skymaps/SkymapMask.h"
 
 #include <algorithm>
+#include <cmath>
+#include <typeinfo>
 
 #include "hermes/Common.h"
+#include "hermes/ThreadPool.h"
 
 namespace hermes {
 
-SkymapMask::SkymapMask() : description("SkymapMask") {}
+namespace {
+/** Pixels of one HEALPix ring, equally spaced in phi from phi0 */
+struct Ring {
+	std::size_t nside;
+	unsigned int start, n;
+	double theta, phi0, dphi;
+
+	Ring(std::size_t nside_, unsigned int iring) : nside(nside_) {
+		ring_info(nside, iring, start, n);
+		QDirection first = pix2ang_ring(nside, start);
+		theta = static_cast<double>(first[0]);
+		phi0 = static_cast<double>(first[1]);
+		dphi = 2 * pi / n;
+	}
+
+	/** RING index of the pixel j, taken modulo the ring */
+	std::size_t pixel(long j) const {
+		return start + ((j % static_cast<long>(n)) + n) % n;
+	}
+	bool isAllowed(const SkymapMask &mask, long j) const {
+		return mask.isAllowed(pix2ang_ring(nside, pixel(j)));
+	}
+};
+
+/** Appends the pixels j ... j + count - 1 of a ring (modulo the ring) */
+void appendCircular(SkymapMask::tPixelRanges &ranges, const Ring &ring, long j,
+                    long count) {
+	const std::size_t first = ring.pixel(j);
+	const std::size_t end = ring.start + ring.n;
+	if (first + count <= end) {
+		SkymapMask::appendRange(ranges, first, first + count);
+	} else {
+		SkymapMask::appendRange(ranges, ring.start, first + count - ring.n);
+		SkymapMask::appendRange(ranges, first, end);
+	}
+}
+
+void sortRanges(SkymapMask::tPixelRanges &ranges) {
+	std::sort(ranges.begin(), ranges.end());
+	SkymapMask::tPixelRanges merged;
+	for (const auto &r : ranges) SkymapMask::appendRange(merged, r.first, r.second);
+	ranges.swap(merged);
+}
+
+/**
+    Runs f(iring, ranges) for every ring in parallel and concatenates the
+    ranges in the order of the rings (which is the order of the pixels)
+*/
+template <typename F>
+void collectRings(std::size_t nside, F f, SkymapMask::tPixelRanges &ranges) {
+	const std::size_t nRings = 4 * nside - 1;
+	std::vector<SkymapMask::tPixelRanges> perRing(nRings);
+	getThreadPool()->parallelFor(nRings, [&](std::size_t i) {
+		f(static_cast<unsigned int>(i + 1), perRing[i]);
+		sortRanges(perRing[i]);
+	});
+	ranges.clear();
+	for (const auto &ring : perRing)
+		for (const auto &r : ring) SkymapMask::appendRange(ranges, r.first, r.second);
+}
+}  // namespace
+
+SkymapMask::SkymapMask()
+    : description("SkymapMask"), rangeCache(std::make_shared<RangeCache>()) {}
 
 std::string SkymapMask::getDescription() const { return description; }
 
@@ -21,17 +87,110 @@ QAngle SkymapMask::normalizeAngle(QAngle angle) const {
 }
 
 std::vector<bool> SkymapMask::getMask(std::size_t nside) {
-	// TODO(adundovi): fix not to calculate the mask for every skymap in a
-	// skymap range
-	long npix = nside2npix(nside);
-	std::vector<bool> maskContainer(npix, false);
-
-	for (long ipix = 0; ipix < npix; ++ipix) {
-		QDirection thetaphi = pix2ang_ring(nside, ipix);
-		if (isAllowed(thetaphi)) maskContainer[ipix] = true;
+	std::vector<bool> maskContainer(nside2npix(nside), false);
+	for (const auto &r : *getPixelRanges(nside))
+		std::fill(maskContainer.begin() + r.first,
+		          maskContainer.begin() + r.second, true);
+	return maskContainer;
+}
+
+std::shared_ptr<const SkymapMask::tPixelRanges> SkymapMask::getPixelRanges(
+    std::size_t nside) const {
+	// keep the cache alive even if clearPixelRanges() replaces it meanwhile
+	const auto cache = rangeCache;
+	std::lock_guard<std::mutex> lock(cache->mtx);
+	auto it = cache->ranges.find(nside);
+	if (it != cache->ranges.end()) return it->second;
+
+	auto ranges = std::make_shared<tPixelRanges>();
+	computePixelRanges(nside, *ranges);
+	cache->ranges[nside] = ranges;
+	return ranges;
+}
+
+void SkymapMask::clearPixelRanges() { rangeCache = std::make_shared<RangeCache>(); }
+
+void SkymapMask::computePixelRanges(std::size_t nside,
+                                    tPixelRanges &ranges) const {
+	ranges.clear();
+	if (typeid(*this) == typeid(SkymapMask)) {
+		appendRange(ranges, 0, nside2npix(nside));
+		return;
 	}
+	collectRings(
+	    nside,
+	    [&](unsigned int iring, tPixelRanges &out) {
+		    appendRingScan(nside, iring, out);
+	    },
+	    ranges);
+}
 
-	return maskContainer;
+void SkymapMask::appendRingScan(std::size_t nside, unsigned int iring,
+                                tPixelRanges &ranges) const {
+	const Ring ring(nside, iring);
+	for (unsigned int j = 0; j < ring.n; ++j)
+		if (ring.isAllowed(*this, j)) appendRange(ranges, ring.start + j, ring.start + j + 1);
+}
+
+void SkymapMask::appendRingArc(std::size_t nside, unsigned int iring,
+                               double phiMin, double phiMax,
+                               tPixelRanges &ranges) const {
+	const Ring ring(nside, iring);
+	if (phiMax - phiMin >= 2 * pi - ring.dphi) {
+		appendRingScan(nside, iring, ranges);
+		return;
+	}
+
+	// pixels of the arc, then trimmed at both ends to the allowed ones
+	long jlo = static_cast<long>(std::ceil((phiMin - ring.phi0) / ring.dphi));
+	long jhi = static_cast<long>(std::floor((phiMax - ring.phi0) / ring.dphi));
+	while (jlo <= jhi && !ring.isAllowed(*this, jlo)) ++jlo;
+	while (jhi > jlo && !ring.isAllowed(*this, jhi)) --jhi;
+	if (jlo <= jhi) appendCircular(ranges, ring, jlo, jhi - jlo + 1);
+}
+
+void SkymapMask::appendRange(tPixelRanges &ranges, std::size_t first,
+                             std::size_t last) {
+	if (first >= last) return;
+	if (!ranges.empty() && first <= ranges.back().second &&
+	    first >= ranges.back().first) {
+		ranges.back().second = std::max(ranges.back().second, last);
+		return;
+	}
+	ranges.emplace_back(first, last);
+}
+
+std::size_t SkymapMask::countPixels(const tPixelRanges &ranges) {
+	std::size_t count = 0;
+	for (const auto &r : ranges) count += r.second - r.first;
+	return count;
+}
+
+SkymapMask::tPixelRanges SkymapMask::complementRanges(
+    const tPixelRanges &ranges, std::size_t npix) {
+	tPixelRanges result;
+	std::size_t next = 0;
+	for (const auto &r : ranges) {
+		appendRange(result, next, r.first);
+		next = r.second;
+	}
+	appendRange(result, next, npix);
+	return result;
+}
+
+SkymapMask::tPixelRanges SkymapMask::intersectRanges(const tPixelRanges &a,
+                                                     const tPixelRanges &b) {
+	tPixelRanges result;
+	auto i = a.begin(), j = b.begin();
+	while (i != a.end() && j != b.end()) {
+		appendRange(result, std::max(i->first, j->first),
+		            std::min(i->second, j->second));
+		if (i->second < j->second)
+			++i;
+		else
+			++j;
+	}
+	return result;
 }
 
 /* InvertWindows class */
@@ -42,11 +201,25 @@ bool InvertMask::isAllowed(const QDirection &dir) const {
 	return !mask->isAllowed(dir);
 }
 
+void InvertMask::computePixelRanges(std::size_t nside,
+                                    tPixelRanges &ranges) const {
+	ranges = complementRanges(*mask->getPixelRanges(nside), nside2npix(nside));
+}
+
 /* MaskList class */
 MaskList::MaskList() {}
 
 void MaskList::addMask(const std::shared_ptr<SkymapMask> &mask_) {
 	list.push_back(mask_);
+	clearPixelRanges();
+}
+
+void MaskList::computePixelRanges(std::size_t nside,
+                                  tPixelRanges &ranges) const {
+	ranges.clear();
+	appendRange(ranges, 0, nside2npix(nside));
+	for (const auto &m : list)
+		ranges = intersectRanges(ranges, *m->getPixelRanges(nside));
 }
 
 bool MaskList::isAllowed(const QDirection &dir) const {
@@ -96,6 +269,41 @@ bool RectangularWindow::isAllowed(const QDirection &dir_) const {
 	return false;
 }
 
+void RectangularWindow::computePixelRanges(std::size_t nside,
+                                           tPixelRanges &ranges) const {
+	// the allowed longitudes (phi in [0, 2pi)) as in isAngleBetween()
+	std::vector<std::pair<double, double>> arcs;
+	QAngle open = topleft[1], close = bottomright[1];
+	const bool fullCircle = (open == close);
+	QAngle normAngle =
+	    fmod(fmod(close - open, 2 * pi) + 2 * pi * 1_rad, 2 * pi);
+	if (normAngle >= pi * 1_rad) std::swap(open, close);
+	const double a = static_cast<double>(open), b = static_cast<double>(close);
+	if (a <= b) {
+		arcs.emplace_back(std::max(a, 0.), std::min(b, 2 * pi));
+	} else {
+		arcs.emplace_back(std::max(a, 0.), 2 * pi);
+		arcs.emplace_back(0., std::min(b, 2 * pi));
+	}
+
+	collectRings(
+	    nside,
+	    [&](unsigned int iring, tPixelRanges &out) {
+		    const Ring ring(nside, iring);
+		    if (!isAngleBetween(ring.theta * 1_rad, topleft[0], bottomright[0]))
+			    return;
+		    if (fullCircle) {
+			    appendRange(out, ring.start, ring.start + ring.n);
+			    return;
+		    }
+		    for (const auto &arc : arcs)
+			    if (arc.first <= arc.second)
+				    appendRingArc(nside, iring, arc.first - ring.dphi,
+				                  arc.second + ring.dphi, out);
+	    },
+	    ranges);
+}
+
 /* CircularWindows class */
 CircularWindow::CircularWindow(const QDirection &centre_,
                                const QAngle &aperature_)
@@ -111,4 +319,54 @@ bool CircularWindow::isAllowed(const QDirection &dir) const {
 	return false;
 }
 
+void CircularWindow::computePixelRanges(std::size_t nside,
+                                        tPixelRanges &ranges) const {
+	// from the vector, which normalises centres given beyond the poles
+	const double thetaC = static_cast<double>(v_centre.getTheta());
+	const double phiC = static_cast<double>(v_centre.getPhi());
+	const double radius = static_cast<double>(aperature);
+	// margin for the round-off of isAllowed(); the arcs are trimmed to
+	// the allowed pixels anyway
+	const double eps = 1e-6;
+
+	collectRings(
+	    nside,
+	    [&](unsigned int iring, tPixelRanges &out) {
+		    const Ring ring(nside, iring);
+		    if (std::fabs(ring.theta - thetaC) > radius + eps) return;
+
+		    // half-width of the arc: cos(radius) = cos(theta) cos(thetaC) +
+		    // sin(theta) sin(thetaC) cos(halfWidth)
+		    double halfWidth = pi;
+		    const double s = std::sin(ring.theta) * std::sin(thetaC);
+		    if (s > eps) {
+			    const double x =
+			        (std::cos(radius) - std::cos(ring.theta) * std::cos(thetaC)) / s;
+			    if (x > -1) halfWidth = std::acos(std::min(x, 1.));
+		    }
+		    if (halfWidth + ring.dphi < pi) {
+			    appendRingArc(nside, iring, phiC - halfWidth - ring.dphi,
+			                  phiC + halfWidth + ring.dphi, out);
+			    return;
+		    }
+
+		    // (almost) the whole ring: find the excluded pixels around the
+		    // point opposite to the centre, the farthest from it
+		    const long far = std::lround((phiC + pi - ring.phi0) / ring.dphi);
+		    if (ring.isAllowed(*this, far)) {
+			    appendRange(out, ring.start, ring.start + ring.n);
+			    return;
+		    }
+		    long lo = far, hi = far;
+		    while (hi - lo + 1 < static_cast<long>(ring.n) &&
+		           !ring.isAllowed(*this, hi + 1))
+			    ++hi;
+		    while (hi - lo + 1 < static_cast<long>(ring.n) &&
+		           !ring.isAllowed(*this, lo - 1))
+			    --lo;
+		    appendCircular(out, ring, hi + 1, ring.n - (hi - lo + 1));
+	    },
+	    ranges);
+}
+
 }  // namespace hermes
@@ -0,0 +1,196 @@
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "hermes.h"
+
+namespace hermes {
+
+class BinaryCacheTest : public ::testing::Test {
+  protected:
+	std::string source = "testBinaryCacheSource.txt";
+
+	void SetUp() override {
+		setenv("HERMES_CACHE_PATH", ".", 1);
+		writeSource("first version");
+	}
+	void TearDown() override {
+		unsetenv("HERMES_CACHE_PATH");
+		std::remove(source.c_str());
+	}
+	void writeSource(const std::string &content) {
+		std::ofstream out(source);
+		out << content;
+	}
+};
+
+TEST_F(BinaryCacheTest, storeAndLoad) {
+	std::vector<float> values = {1.5, 2.5, 3.5, -4};
+	{
+		BinaryCache cache("test", {fileContentHash(source)});
+		ASSERT_TRUE(cache.isEnabled());
+		EXPECT_FALSE(cache.load());
+		EXPECT_TRUE(cache.store({42, 0.5}, values.data(), values.size() * sizeof(float)));
+	}
+
+	BinaryCache cache("test", {fileContentHash(source)});
+	ASSERT_TRUE(cache.load());
+	EXPECT_EQ(cache.getMetadata(), std::vector<double>({42, 0.5}));
+	ASSERT_EQ(cache.getPayloadSize(), values.size() * sizeof(float));
+	// the payload is mapped with the alignment of a grid row
+	EXPECT_EQ(reinterpret_cast<std::uintptr_t>(cache.getPayload()) % 64, 0);
+	const float *mapped = static_cast<const float *>(cache.getPayload());
+	for (std::size_t i = 0; i < values.size(); ++i) EXPECT_EQ(mapped[i], values[i]);
+
+	std::remove(cache.getFilename().c_str());
+}
+
+TEST_F(BinaryCacheTest, keyedBySourceContent) {
+	std::vector<double> values = {1, 2, 3};
+	BinaryCache cache("test", {fileContentHash(source)});
+	cache.store({}, values.data(), values.size() * sizeof(double));
+
+	writeSource("second version");
+	BinaryCache changed("test", {fileContentHash(source)});
+	EXPECT_NE(changed.getFilename(), cache.getFilename());
+	EXPECT_FALSE(changed.load());
+
+	BinaryCache otherTag("other", {fileContentHash(source)});
+	EXPECT_NE(otherTag.getFilename(), changed.getFilename());
+
+	std::remove(cache.getFilename().c_str());
+}
+
+TEST_F(BinaryCacheTest, manifestHash) {
+	std::uint64_t first = fileManifestHash(source);
+	EXPECT_EQ(fileManifestHash(source), first);
+	writeSource("a longer second version");
+	EXPECT_NE(fileManifestHash(source), first);
+	EXPECT_NE(fileManifestHash("./" + source), fileManifestHash(source));
+	EXPECT_THROW(fileManifestHash("testBinaryCacheMissing.txt"), std::runtime_error);
+}
+
+TEST_F(BinaryCacheTest, disabledWithoutCachePath) {
+	unsetenv("HERMES_CACHE_PATH");
+	BinaryCache cache("test", {fileContentHash(source)});
+	EXPECT_FALSE(cache.isEnabled());
+	EXPECT_FALSE(cache.load());
+	EXPECT_FALSE(cache.store({}, nullptr, 0));
+}
+
+TEST_F(BinaryCacheTest, zeroCopySpectralGrid) {
+	const std::size_t N = 3, NE = 4;
+	Vector3d origin(0, 0, 0), spacing(1, 1, 1);
+	SpectralGridQPDensityPerEnergy grid(origin, N, N, N, spacing, NE);
+	for (std::size_t i = 0; i < N; ++i)
+		for (std::size_t iE = 0; iE < NE; ++iE) grid.addValue(i, 1, 2, iE, QPDensityPerEnergy(i + 10. * iE));
+
+	{
+		BinaryCache cache("grid", {fileContentHash(source)});
+		cache.store({}, grid.data(), grid.getGridSize() * sizeof(QPDensityPerEnergy));
+	}
+
+	auto cache = std::make_shared<BinaryCache>("grid", std::vector<std::uint64_t>{fileContentHash(source)});
+	ASSERT_TRUE(cache->load());
+	SpectralGridQPDensityPerEnergy mapped(origin, N, N, N, spacing, NE, cache,
+	                                      static_cast<const QPDensityPerEnergy *>(cache->getPayload()));
+	EXPECT_EQ(mapped.data(), cache->getPayload());
+
+	std::vector<QPDensityPerEnergy> a, b;
+	Vector3d pos(1.3, 1.9, 2.2);
+	grid.interpolateSpectrum(pos, a);
+	mapped.interpolateSpectrum(pos, b);
+	for (std::size_t iE = 0; iE < NE; ++iE) EXPECT_EQ(static_cast<double>(a[iE]), static_cast<double>(b[iE]));
+
+	// the mapped values are read-only
+	EXPECT_FALSE(grid.isAttached());
+	EXPECT_TRUE(mapped.isAttached());
+	EXPECT_THROW(mapped.setValue(0, 0, 0, 0, QPDensityPerEnergy(1)), std::runtime_error);
+	EXPECT_THROW(mapped.addValue(0, 0, 0, 0, QPDensityPerEnergy(1)), std::runtime_error);
+	EXPECT_THROW(mapped.getGrid(), std::runtime_error);
+
+	std::remove(cache->getFilename().c_str());
+}
+
+TEST_F(BinaryCacheTest, cacheTableStore) {
+	Grid<QPiZeroIntegral> table(Vector3QLength(-1_kpc), 3, 3, 2, Vector3QLength(1_kpc));
+	auto fill = [&table](double offset) {
+		for (std::size_t i = 0; i < table.getGridSize(); ++i) table.get(i) = QPiZeroIntegral(offset + i);
+	};
+
+	CacheTableStore store("testCacheTable");
+	store.addKey("model").addKey(std::vector<QEnergy>{1_GeV, 2_GeV}).addGrid(table);
+	ASSERT_TRUE(store.isEnabled());
+	EXPECT_FALSE(store.load(1_GeV, table));
+
+	// several energies share one entry
+	fill(10);
+	EXPECT_TRUE(store.store(1_GeV, table));
+	fill(20);
+	EXPECT_TRUE(store.store(2_GeV, table));
+	fill(30);
+	EXPECT_TRUE(store.store(1_GeV, table));
+	EXPECT_EQ(store.getEnergies().size(), 2);
+
+	ASSERT_TRUE(store.load(2_GeV, table));
+	EXPECT_EQ(static_cast<double>(table.get(5)), 25);
+	ASSERT_TRUE(store.load(1_GeV, table));
+	EXPECT_EQ(static_cast<double>(table.get(5)), 35);
+	EXPECT_FALSE(store.load(3_GeV, table));
+
+	// a different configuration has its own entry
+	CacheTableStore other("testCacheTable");
+	other.addKey("other model").addKey(std::vector<QEnergy>{1_GeV, 2_GeV}).addGrid(table);
+	EXPECT_NE(other.getFilename(), store.getFilename());
+	EXPECT_FALSE(other.load(1_GeV, table));
+
+	// so has the same model read from a different file
+	CacheTableStore otherSource("testCacheTable");
+	otherSource.addKey("model").addKey(std::vector<std::uint64_t>{fileContentHash(source)});
+	otherSource.addKey(std::vector<QEnergy>{1_GeV, 2_GeV}).addGrid(table);
+	EXPECT_NE(otherSource.getFilename(), store.getFilename());
+
+	std::remove(store.getFilename().c_str());
+	std::remove((store.getFilename() + ".lock").c_str());
+}
+
+TEST_F(BinaryCacheTest, cacheTableStoreConcurrentWriters) {
+	// writers with their own stores, as separate processes would have,
+	// keep each other's tables
+	Grid<QPiZeroIntegral> shape(Vector3QLength(-1_kpc), 2, 2, 2, Vector3QLength(1_kpc));
+	const std::size_t nWriters = 4, nTables = 8;
+	std::vector<std::thread> writers;
+	for (std::size_t w = 0; w < nWriters; ++w)
+		writers.emplace_back([&shape, w]() {
+			CacheTableStore store("testConcurrentCacheTable");
+			store.addKey("model").addGrid(shape);
+			Grid<QPiZeroIntegral> table(Vector3QLength(-1_kpc), 2, 2, 2, Vector3QLength(1_kpc));
+			for (std::size_t i = 0; i < nTables; ++i) {
+				for (std::size_t j = 0; j < table.getGridSize(); ++j)
+					table.get(j) = QPiZeroIntegral(100. * w + i);
+				store.store((w * nTables + i + 1) * 1_GeV, table);
+			}
+		});
+	for (auto &t : writers) t.join();
+
+	CacheTableStore store("testConcurrentCacheTable");
+	store.addKey("model").addGrid(shape);
+	EXPECT_EQ(store.getEnergies().size(), nWriters * nTables);
+	ASSERT_TRUE(store.load(2 * nTables * 1_GeV, shape));
+	EXPECT_EQ(static_cast<double>(shape.get(3)), 107);
+
+	std::remove(store.getFilename().c_str());
+	std::remove((store.getFilename() + ".lock").c_str());
+}
+
+int main(int argc, char **argv) {
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
+
+}  // namespace hermes
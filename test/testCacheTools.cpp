@@ -1,6 +1,8 @@
+#include <atomic>
 #include <chrono>
 #include <iostream>
 #include <memory>
+#include <vector>
 
 #include "gtest/gtest.h"
 #include "hermes.h"
@@ -8,6 +10,7 @@
 namespace hermes {
 
 typedef CacheStorageWith2Args<QLength, QLength, QArea> CacheStorageTest;
+typedef CacheStorageTableWith2Args<QLength, QLength, QArea> CacheStorageTableTest;
 
 TEST(CacheTools, getValue) {
 	auto cache = std::make_shared<CacheStorageTest>(CacheStorageTest());
@@ -96,6 +99,111 @@ TEST(CacheTools, BremsstrahlungGALPROP) {
 	EXPECT_GT(milliseconds_noncached.count(), milliseconds_cached.count());
 }
 
+TEST(CacheTools, concurrentGetValue) {
+	CacheStorageTest cache;
+	std::atomic<int> calls(0);
+	cache.setFunction([&calls](const QLength &a, const QLength &b) {
+		calls++;
+		return a * b;
+	});
+
+	ThreadPool pool(4);
+	pool.parallelFor(4000, [&cache](std::size_t i) {
+		QLength a = static_cast<double>(i % 50) * 1_m, b = 2_m;
+		EXPECT_DOUBLE_EQ(static_cast<double>(cache.getValue(a, b)), static_cast<double>(a * b));
+	});
+	// every key is evaluated at least once, but far less often than looked up
+	EXPECT_GE(calls, 50);
+	EXPECT_LT(calls, 4000);
+}
+
+TEST(CacheTools, tableOnAndOffGrid) {
+	std::vector<QLength> axis1, axis2;
+	for (int i = 1; i <= 20; ++i) axis1.push_back(i * 1_m);
+	for (int j = 1; j <= 10; ++j) axis2.push_back(j * 0.1_m);
+
+	std::atomic<int> calls(0);
+	CacheStorageTableTest table(axis1, axis2);
+	table.setFunction([&calls](const QLength &a, const QLength &b) {
+		calls++;
+		return a * b;
+	});
+	EXPECT_EQ(table.size(), 200);
+	EXPECT_EQ(calls, 200);
+
+	// on-grid keys are read from the table
+	for (auto a : axis1)
+		for (auto b : axis2)
+			EXPECT_DOUBLE_EQ(static_cast<double>(table.getValue(a, b)), static_cast<double>(a * b));
+	EXPECT_EQ(calls, 200);
+
+	// off-grid keys are evaluated once per thread
+	EXPECT_DOUBLE_EQ(static_cast<double>(table.getValue(1.5_m, 0.1_m)), 0.15);
+	EXPECT_DOUBLE_EQ(static_cast<double>(table.getValue(1.5_m, 0.1_m)), 0.15);
+	EXPECT_EQ(calls, 201);
+
+	CacheStorageTableTest eager(axis1, axis2, false);
+	eager.setFunction([&calls](const QLength &a, const QLength &b) {
+		calls++;
+		return a * b;
+	});
+	calls = 0;
+	eager.getValue(1.5_m, 0.1_m);
+	eager.getValue(1.5_m, 0.1_m);
+	EXPECT_EQ(calls, 2);
+}
+
+TEST(CacheTools, tableWith3Args) {
+	std::vector<QLength> axis = {1_m, 2_m, 3_m};
+	CacheStorageTableWith3Args<QLength, QLength, QLength, QVolume> table(axis, axis, axis);
+	table.setFunction([](const QLength &a, const QLength &b, const QLength &c) { return a * b * c; });
+	EXPECT_EQ(table.size(), 27);
+	EXPECT_DOUBLE_EQ(static_cast<double>(table.getValue(2_m, 3_m, 1_m)), 6);
+	EXPECT_DOUBLE_EQ(static_cast<double>(table.getValue(2_m, 3_m, 1.5_m)), 9);
+}
+
+TEST(CacheTools, tableVersusHashMap) {
+	// lookups of a typical (E_cr, E_gamma) grid from all threads return
+	// the same values from the precomputed table and from the hash map
+	std::vector<QEnergy> energiesCR, energiesGamma;
+	for (QEnergy E = 1_GeV; E < 1_PeV; E = E * 1.1) energiesCR.push_back(E);
+	for (QEnergy E = 1_GeV; E < 1_TeV; E = E * 1.5) energiesGamma.push_back(E);
+	auto f = [](QEnergy E_cr, QEnergy E_gamma) { return QDiffCrossSection(static_cast<double>(E_gamma / E_cr)); };
+
+	CacheStorageCrossSection hashMap;
+	hashMap.setFunction(f);
+	CacheStorageCrossSectionTable table(energiesCR, energiesGamma);
+	table.setFunction(f);
+
+	std::atomic<std::size_t> mismatches(0);
+	getThreadPool()->parallelFor(energiesGamma.size(), [&](std::size_t k) {
+		for (auto E_cr : energiesCR)
+			if (table.getValue(E_cr, energiesGamma[k]) != hashMap.getValue(E_cr, energiesGamma[k])) mismatches++;
+	});
+	EXPECT_EQ(mismatches, 0u);
+
+	// off the grid, the values are memoised by the table itself
+	EXPECT_EQ(static_cast<double>(table.getValue(1.5_GeV, 2.5_GeV)), static_cast<double>(f(1.5_GeV, 2.5_GeV)));
+	EXPECT_EQ(static_cast<double>(table.getValue(1.5_GeV, 2.5_GeV)), static_cast<double>(f(1.5_GeV, 2.5_GeV)));
+}
+
+TEST(CacheTools, Kamae06GammaTable) {
+	auto f_kn = std::make_shared<interactions::Kamae06Gamma>();
+	std::vector<QEnergy> energiesProton, energiesGamma;
+	for (QEnergy E = 10_GeV; E < 10_TeV; E = E * 1.5) energiesProton.push_back(E);
+	for (QEnergy E = 1_GeV; E < 1_TeV; E = E * 2) energiesGamma.push_back(E);
+	// as the integrators do, through the base class
+	std::shared_ptr<interactions::DifferentialCrossSection> base = f_kn;
+	base->setCacheTable(energiesProton, energiesGamma);
+
+	for (auto E_proton : energiesProton)
+		for (auto E_gamma : energiesGamma)
+			EXPECT_DOUBLE_EQ(static_cast<double>(f_kn->getDiffCrossSection(E_proton, E_gamma)),
+			                 static_cast<double>(f_kn->getDiffCrossSectionDirectly(E_proton, E_gamma)));
+	EXPECT_DOUBLE_EQ(static_cast<double>(f_kn->getDiffCrossSection(1_TeV, 3_GeV)),
+	                 static_cast<double>(f_kn->getDiffCrossSectionDirectly(1_TeV, 3_GeV)));
+}
+
 int main(int argc, char **argv) {
 	::testing::InitGoogleTest(&argc, argv);
 	return RUN_ALL_TESTS();
@@ -30,6 +30,62 @@ TEST(CosmicRays, Dragon3D) {
 	            static_cast<double>(3217355.3), 1);
 }
 
+TEST(CosmicRays, Dragon3DSpectrum) {
+	auto cr_proton = std::make_shared<cosmicrays::Dragon3D>(Proton);
+	std::vector<QPDensityPerEnergy> spectrum;
+
+	for (auto pos : {Vector3QLength(8.3_kpc, 0, 0), Vector3QLength(-3_kpc, 2.1_kpc, 0.3_kpc),
+	                 Vector3QLength(100_kpc, 0, 0)}) {
+		cr_proton->getDensitySpectrum(pos, spectrum);
+		ASSERT_EQ(spectrum.size(), cr_proton->getEnergyAxis().size());
+		for (std::size_t iE = 0; iE < spectrum.size(); ++iE)
+			EXPECT_NEAR(static_cast<double>(spectrum[iE]),
+			            static_cast<double>(cr_proton->getDensityPerEnergy(iE, pos)),
+			            1e-12 * std::fabs(static_cast<double>(spectrum[iE])));
+	}
+}
+
+TEST(SpectralGrid, agreesWithGridPerEnergy) {
+	const std::size_t Nx = 5, Ny = 4, Nz = 3, NE = 7;
+	Vector3d origin(-2, -1, -0.5), spacing(1, 0.5, 0.25);
+
+	SpectralGridQPDensityPerEnergy spectral(origin, Nx, Ny, Nz, spacing, NE);
+	std::vector<std::unique_ptr<ScalarGridQPDensityPerEnergy>> grids;
+	for (std::size_t iE = 0; iE < NE; ++iE)
+		grids.push_back(std::make_unique<ScalarGridQPDensityPerEnergy>(origin, Nx, Ny, Nz, spacing));
+
+	for (std::size_t ix = 0; ix < Nx; ++ix)
+		for (std::size_t iy = 0; iy < Ny; ++iy)
+			for (std::size_t iz = 0; iz < Nz; ++iz)
+				for (std::size_t iE = 0; iE < NE; ++iE) {
+					QPDensityPerEnergy value(1. + ix + 10. * iy + 100. * iz + 1000. * iE);
+					spectral.addValue(ix, iy, iz, iE, value);
+					grids[iE]->addValue(ix, iy, iz, value);
+				}
+
+	std::vector<QPDensityPerEnergy> spectrum;
+	for (auto pos : {Vector3d(0.1, 0.2, 0.05), Vector3d(-1.7, 0.9, 0.3), Vector3d(2.4, -0.8, -0.4)}) {
+		spectral.interpolateSpectrum(pos, spectrum);
+		ASSERT_EQ(spectrum.size(), NE);
+		for (std::size_t iE = 0; iE < NE; ++iE) {
+			double expected = static_cast<double>(grids[iE]->interpolate(pos));
+			EXPECT_NEAR(static_cast<double>(spectrum[iE]), expected, 1e-12 * expected);
+			EXPECT_NEAR(static_cast<double>(spectral.interpolate(pos, iE)), expected, 1e-12 * expected);
+		}
+	}
+}
+
+TEST(CosmicRays, defaultDensitySpectrum) {
+	auto cr = std::make_shared<cosmicrays::SimpleCR>();
+	Vector3QLength pos(5_kpc, 1_kpc, 0.1_kpc);
+	std::vector<QPDensityPerEnergy> spectrum;
+	cr->getDensitySpectrum(pos, spectrum);
+
+	auto energies = cr->getEnergyAxis();
+	ASSERT_EQ(spectrum.size(), energies.size());
+	for (std::size_t iE = 0; iE < energies.size(); ++iE)
+		EXPECT_EQ(static_cast<double>(spectrum[iE]), static_cast<double>(cr->getDensityPerEnergy(energies[iE], pos)));
+}
 
 int main(int argc, char **argv) {
 	::testing::InitGoogleTest(&argc, argv);
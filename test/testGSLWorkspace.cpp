@@ -0,0 +1,66 @@
+#include <thread>
+
+#include "gtest/gtest.h"
+#include "hermes.h"
+
+namespace hermes {
+
+TEST(GSLWorkspace, reusedOnTheSameThread) {
+	gsl_integration_workspace *first;
+	{
+		GSLWorkspace w(1000);
+		first = w.get();
+		EXPECT_EQ(w.getLimit(), 1000u);
+	}
+	const std::size_t allocations = GSLWorkspace::getNumberOfAllocations();
+	for (int i = 0; i < 10; ++i) {
+		GSLWorkspace w(1000);
+		EXPECT_EQ(w.get(), first);
+	}
+	EXPECT_EQ(GSLWorkspace::getNumberOfAllocations(), allocations);
+	EXPECT_EQ(GSLWorkspace::getPoolSize(), 1u);
+}
+
+TEST(GSLWorkspace, distinctWhenNestedOrOfOtherLimit) {
+	GSLWorkspace outer(1000);
+	{
+		GSLWorkspace inner(1000);
+		GSLWorkspace other(100);
+		EXPECT_NE(inner.get(), outer.get());
+		EXPECT_NE(other.get(), outer.get());
+		EXPECT_NE(other.get(), inner.get());
+	}
+	GSLWorkspace again(1000);
+	EXPECT_NE(again.get(), outer.get());
+}
+
+TEST(GSLWorkspace, distinctAcrossThreads) {
+	GSLWorkspace w(1000);
+	gsl_integration_workspace *fromThread = nullptr;
+	std::size_t allocationsInThread = 0;
+	std::thread t([&]() {
+		for (int i = 0; i < 3; ++i) {
+			GSLWorkspace v(1000);
+			fromThread = v.get();
+		}
+		allocationsInThread = GSLWorkspace::getNumberOfAllocations();
+	});
+	t.join();
+	EXPECT_NE(fromThread, w.get());
+	EXPECT_EQ(allocationsInThread, 1u);
+}
+
+TEST(GSLWorkspace, integration) {
+	auto f = [](QLength x) { return static_cast<double>(x) * static_cast<double>(x); };
+	for (int i = 0; i < 3; ++i) {
+		auto r = gslQAGIntegration<QNumber, double>(f, 0_m, 3_m, 100);
+		EXPECT_NEAR(static_cast<double>(r), 9., 1e-6);
+	}
+}
+
+int main(int argc, char **argv) {
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
+
+}  // namespace hermes
@@ -1,3 +1,6 @@
+#include <algorithm>
+#include <vector>
+
 #include "gtest/gtest.h"
 #include "hermes.h"
 
@@ -38,6 +41,51 @@ TEST(HEALPix, pix2ang) {
 	EXPECT_NEAR(static_cast<double>(thetaphi[1]), 0.7853, 0.001);
 }
 
+TEST(HEALPix, nestedScheme) {
+	// see fig. 4 in The HEALPix Primer
+	EXPECT_EQ(nest2ring(2, 0), 13);
+	EXPECT_EQ(nest2ring(2, 3), 0);
+	EXPECT_EQ(ring2nest(2, 47), 44);
+
+	for (unsigned int nside = 1; nside <= 64; nside *= 2) {
+		std::vector<bool> seen(nside2npix(nside), false);
+		for (unsigned int ipix = 0; ipix < nside2npix(nside); ++ipix) {
+			unsigned int iring = nest2ring(nside, ipix);
+			ASSERT_LT(iring, nside2npix(nside));
+			EXPECT_FALSE(seen[iring]);
+			seen[iring] = true;
+			EXPECT_EQ(ring2nest(nside, iring), ipix);
+		}
+	}
+	EXPECT_THROW(nest2ring(3, 0), std::runtime_error);
+}
+
+TEST(HEALPix, nestedChildren) {
+	// the centres of the children 4p ... 4p+3 lie in the parent pixel p
+	unsigned int nside = 16;
+	for (unsigned int parent = 0; parent < nside2npix(nside); ++parent)
+		for (unsigned int k = 0; k < 4; ++k)
+			EXPECT_EQ(ring2nest(nside, ang2pix_ring(nside, pix2ang_nest(2 * nside, 4 * parent + k))), parent);
+}
+
+TEST(HEALPix, ringInfo) {
+	// the rings cover the map in order, with the pixels of a ring at one theta
+	for (unsigned int nside : {1, 2, 8, 13}) {
+		unsigned int next = 0;
+		for (unsigned int iring = 1; iring < 4 * nside; ++iring) {
+			unsigned int startpix, ringpix;
+			ring_info(nside, iring, startpix, ringpix);
+			EXPECT_EQ(startpix, next);
+			EXPECT_EQ(ringpix, std::min(std::min(iring, 4 * nside - iring), nside) * 4);
+			for (unsigned int i = 1; i < ringpix; ++i)
+				EXPECT_DOUBLE_EQ(static_cast<double>(pix2ang_ring(nside, startpix + i)[0]),
+				                 static_cast<double>(pix2ang_ring(nside, startpix)[0]));
+			next = startpix + ringpix;
+		}
+		EXPECT_EQ(next, nside2npix(nside));
+	}
+}
+
 int main(int argc, char **argv) {
 	::testing::InitGoogleTest(&argc, argv);
 	return RUN_ALL_TESTS();
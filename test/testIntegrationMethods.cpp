@@ -1,6 +1,9 @@
 #include <gsl/gsl_integration.h>
 
+#include <chrono>
+#include <functional>
 #include <memory>
+#include <vector>
 
 #include "gtest/gtest.h"
 #include "hermes.h"
@@ -41,6 +44,119 @@ TEST(IntegrationMethods, gslQAGIntegration) {
 	EXPECT_NEAR(static_cast<double>(result), integral_result, 1e-7);
 }
 
+TEST(IntegrationMethods, simpsonIntegrationBatch) {
+	auto batch = [](const QLength *dist, double *values, std::size_t n) {
+		for (std::size_t i = 0; i < n; ++i) values[i] = integrand(dist[i]);
+	};
+	auto result = simpsonIntegrationBatch<QLength, double>(batch, 1_m, 1000_m, 4000);
+
+	EXPECT_NEAR(static_cast<double>(result), integral_result, 1e-5);
+	EXPECT_NEAR(static_cast<double>(result),
+	            static_cast<double>(simpsonIntegration<QLength, double>(integrand, 1_m, 1000_m, 4000)), 1e-12);
+}
+
+TEST(IntegrationMethods, doubleIntegrand) {
+	// a double returned by the integrand is taken as INTTYPE, which gives
+	// the same result as INTTYPE = double
+	auto f = [](const QLength &dist) { return integrand(dist); };
+
+	auto sum = sumIntegration<QNumber, QInverseLength>(f, 1_m, 1000_m, 450000);
+	EXPECT_NEAR(static_cast<double>(sum), integral_result, 1e-3);
+	EXPECT_DOUBLE_EQ(static_cast<double>(sum),
+	                 static_cast<double>(sumIntegration<QLength, double>(f, 1_m, 1000_m, 450000)));
+
+	auto trapesoid = trapesoidIntegration<QNumber, QInverseLength>(f, 1_m, 1000_m, 20000);
+	EXPECT_NEAR(static_cast<double>(trapesoid), integral_result, 1e-4);
+	EXPECT_DOUBLE_EQ(static_cast<double>(trapesoid),
+	                 static_cast<double>(trapesoidIntegration<QLength, double>(f, 1_m, 1000_m, 20000)));
+
+	auto simpson = simpsonIntegration<QNumber, QInverseLength>(f, 1_m, 1000_m, 4000);
+	EXPECT_NEAR(static_cast<double>(simpson), integral_result, 1e-5);
+
+	auto gauss = gaussIntegration<QNumber, QInverseLength>(f, 1_m, 2_m);
+	EXPECT_DOUBLE_EQ(static_cast<double>(gauss),
+	                 static_cast<double>(gaussIntegration<QLength, double>(f, 1_m, 2_m)));
+
+	auto adaptive = adaptiveSimpsonIntegration<QNumber, QInverseLength>(f, 1_m, 1000_m, QNumber(1e-7));
+	EXPECT_NEAR(static_cast<double>(adaptive), integral_result, 1e-5);
+}
+
+// Per-pixel time of the former std::function call path (an integrand
+// wrapped in a lambda wrapped in std::function) against the templated
+// callable and the batch form, for synchrotron and free-free emission
+TEST(IntegrationMethods, callableBenchmark) {
+	typedef std::chrono::high_resolution_clock Clock;
+	auto ms = [](Clock::time_point a, Clock::time_point b) {
+		return std::chrono::duration<double, std::milli>(b - a).count();
+	};
+	const Vector3QLength observer(8.5_kpc, 0, 0);
+	const QFrequency freq = 1_GHz;
+	std::vector<QDirection> pixels;
+	for (unsigned int ipix = 0; ipix < nside2npix(4); ++ipix) pixels.push_back(pix2ang_ring(4, ipix));
+
+	auto synchro = std::make_shared<SynchroIntegrator>(std::make_shared<magneticfields::JF12>(),
+	                                                   std::make_shared<cosmicrays::WMAP07>());
+	double tFunction = 0, tTemplate = 0;
+	for (const auto &dir : pixels) {
+		const QLength stop = distanceToGalBorder(observer, dir);
+		auto f = [&](const QLength &dist) {
+			return synchro->integrateOverEnergy(getGalacticPosition(observer, dist, dir), freq);
+		};
+		std::function<QEmissivity(QLength)> wrapped = [f](QLength dist) { return f(dist); };
+
+		auto t0 = Clock::now();
+		QIntensity a = simpsonIntegration<QIntensity, QEmissivity>(wrapped, 0, stop, 100);
+		auto t1 = Clock::now();
+		QIntensity b = simpsonIntegration<QIntensity, QEmissivity>(f, 0, stop, 100);
+		auto t2 = Clock::now();
+		EXPECT_EQ(static_cast<double>(a), static_cast<double>(b));
+		tFunction += ms(t0, t1);
+		tTemplate += ms(t1, t2);
+	}
+	std::cout << "Synchro per pixel: std::function " << tFunction / pixels.size() << " ms, template "
+	          << tTemplate / pixels.size() << " ms" << std::endl;
+	// the integrand dominates, the call path must not add to it
+	EXPECT_LE(tTemplate, 1.5 * tFunction);
+
+	auto gdensity = std::make_shared<ionizedgas::YMW16>();
+	auto freefree = std::make_shared<FreeFreeIntegrator>(gdensity);
+	const QTemperature T = gdensity->getTemperature();
+	double tBatch = 0;
+	tFunction = tTemplate = 0;
+	for (const auto &dir : pixels) {
+		const QLength stop = distanceToGalBorder(observer, dir);
+		auto f = [&](const QLength &dist) {
+			return freefree->spectralEmissivity(getGalacticPosition(observer, dist, dir), freq);
+		};
+		std::function<QEmissivity(QLength)> wrapped = [f](QLength dist) { return f(dist); };
+		auto batch = [&](const QLength *dist, QEmissivity *values, std::size_t n) {
+			std::vector<Vector3QLength> pos;
+			for (std::size_t i = 0; i < n; ++i) pos.push_back(getGalacticPosition(observer, dist[i], dir));
+			std::vector<QPDensity> density;
+			gdensity->getDensity(pos, density);
+			for (std::size_t i = 0; i < n; ++i)
+				values[i] = freefree->spectralEmissivityExplicit(density[i], density[i], freq, T, 1);
+		};
+
+		auto t0 = Clock::now();
+		QIntensity a = simpsonIntegration<QIntensity, QEmissivity>(wrapped, 0, stop, 500);
+		auto t1 = Clock::now();
+		QIntensity b = simpsonIntegration<QIntensity, QEmissivity>(f, 0, stop, 500);
+		auto t2 = Clock::now();
+		QIntensity c = simpsonIntegrationBatch<QIntensity, QEmissivity>(batch, 0, stop, 500);
+		auto t3 = Clock::now();
+		EXPECT_EQ(static_cast<double>(a), static_cast<double>(b));
+		EXPECT_NEAR(static_cast<double>(c), static_cast<double>(a), 1e-9 * std::fabs(static_cast<double>(a)));
+		tFunction += ms(t0, t1);
+		tTemplate += ms(t1, t2);
+		tBatch += ms(t2, t3);
+	}
+	std::cout << "FreeFree per pixel: std::function " << tFunction / pixels.size() << " ms, template "
+	          << tTemplate / pixels.size() << " ms, batch " << tBatch / pixels.size() << " ms" << std::endl;
+	EXPECT_LE(tTemplate, 1.5 * tFunction);
+	EXPECT_LE(tBatch, tTemplate);
+}
+
 int main(int argc, char **argv) {
 	::testing::InitGoogleTest(&argc, argv);
 	return RUN_ALL_TESTS();
@@ -1,4 +1,7 @@
+#include <atomic>
 #include <chrono>
+#include <cstdio>
+#include <cstdlib>
 #include <memory>
 
 #include "gtest/gtest.h"
@@ -80,6 +83,47 @@ TEST(InverseComptonIntegrator, integrateOverEnergy) {
 	            static_cast<double>(5e-16 * c_light / 4_pi), 1e-7);
 }
 
+/* The precomputed kernel reproduces the nested integration */
+TEST(InverseComptonIntegrator, kernel) {
+	auto simpleModel = std::make_shared<cosmicrays::SimpleCR>(
+	    cosmicrays::SimpleCR());
+	auto kleinnishina = std::make_shared<interactions::KleinNishina>(
+	    interactions::KleinNishina());
+	auto photonField = std::make_shared<photonfields::CMB>(photonfields::CMB());
+	auto intIC = std::make_shared<InverseComptonIntegrator>(
+	    InverseComptonIntegrator(simpleModel, photonField, kleinnishina));
+
+	std::vector<Vector3QLength> positions = {Vector3QLength(8.5_kpc, 0, 0),
+	                                         Vector3QLength(3_kpc, 2_kpc, 0.2_kpc),
+	                                         Vector3QLength(12_kpc, 0, -1_kpc)};
+	QEnergy Egamma = 10_GeV;
+	auto batch = intIC->integrateOverEnergy(positions, Egamma);
+	ASSERT_EQ(batch.size(), positions.size());
+
+	for (std::size_t p = 0; p < positions.size(); ++p) {
+		QGREmissivity expected(0);
+		for (auto itE = simpleModel->begin(); itE != simpleModel->end(); ++itE)
+			expected += intIC->integrateOverPhotonEnergy(positions[p], Egamma,
+			                                             *itE) *
+			            simpleModel->getDensityPerEnergy(*itE, positions[p]) *
+			            (*itE) * c_light;
+		expected = expected * log(simpleModel->getEnergyScaleFactor());
+
+		auto single = intIC->integrateOverEnergy(positions[p], Egamma);
+		EXPECT_NEAR(static_cast<double>(single / expected), 1, 1e-9);
+		EXPECT_NEAR(static_cast<double>(batch[p] / single), 1, 1e-12);
+	}
+
+	// the CMB is uniform, so its table is exact
+	EXPECT_FALSE(intIC->hasPhotonFieldTable());
+	auto before = intIC->integrateOverEnergy(positions[1], Egamma);
+	intIC->setupPhotonFieldTable();
+	EXPECT_TRUE(intIC->hasPhotonFieldTable());
+	EXPECT_NEAR(static_cast<double>(
+	                intIC->integrateOverEnergy(positions[1], Egamma) / before),
+	            1, 1e-12);
+}
+
 /* Check consistency of different integration methods */
 TEST(InverseComptonIntegrator, compareLOSIntegrations) {
 	auto simpleModel = std::make_shared<cosmicrays::SimpleCR>(
@@ -111,6 +155,34 @@ TEST(InverseComptonIntegrator, compareLOSIntegrations) {
 	            1e-5);
 }
 
+/* The fixed-node Simpson rule of the multi-energy LOS integration agrees
+ * with the adaptive QAG of the single-energy one to 0.1% (the relative
+ * tolerance of gslQAGIntegration) */
+TEST(InverseComptonIntegrator, integrateOverLOSEnergies) {
+	auto simpleModel = std::make_shared<cosmicrays::SimpleCR>(
+	    cosmicrays::SimpleCR());
+	auto kleinnishina = std::make_shared<interactions::KleinNishina>(
+	    interactions::KleinNishina());
+	auto photonField = std::make_shared<photonfields::CMB>(photonfields::CMB());
+	auto intIC = std::make_shared<InverseComptonIntegrator>(
+	    InverseComptonIntegrator(simpleModel, photonField, kleinnishina));
+
+	// the batch uses Simpson's rule on fixed nodes, the single energy QAG
+	std::vector<QEnergy> Egammas = {1_GeV, 30_GeV, 1_TeV};
+	for (QDirection dir : {QDirection{pi / 2 * 1_rad, 0_rad},
+	                       QDirection{pi / 2 * 1_rad, 0.02_rad},
+	                       QDirection{pi / 2 * 1_rad, pi / 3 * 1_rad},
+	                       QDirection{0.1_rad, 0_rad},
+	                       QDirection{pi / 4 * 1_rad, pi * 1_rad}}) {
+		auto batch = intIC->integrateOverLOS(dir, Egammas);
+		ASSERT_EQ(batch.size(), Egammas.size());
+		for (std::size_t k = 0; k < Egammas.size(); ++k)
+			EXPECT_NEAR(static_cast<double>(
+			                batch[k] / intIC->integrateOverLOS(dir, Egammas[k])),
+			            1, 1e-3);
+	}
+}
+
 /*
 TEST(InverseComptonIntegrator, integrateOverLOS) {
     auto simpleModel = std::make_shared<SimpleCR>(SimpleCR());
@@ -179,6 +251,67 @@ TEST(InverseComptonIntegrator, initCacheTable) {
 	            static_cast<double>(res2_withcache), 10);
 }
 
+// counts the densities requested from SimpleCR
+class CountingCR : public cosmicrays::SimpleCR {
+  public:
+	mutable std::atomic<std::size_t> calls{0};
+
+	QPDensityPerEnergy getDensityPerEnergy(
+	    const QEnergy &E_, const Vector3QLength &pos_) const override {
+		++calls;
+		return cosmicrays::SimpleCR::getDensityPerEnergy(E_, pos_);
+	}
+};
+
+TEST(InverseComptonIntegrator, persistentCacheTable) {
+	auto crModel = std::make_shared<CountingCR>();
+	auto kleinnishina = std::make_shared<interactions::KleinNishina>(
+	    interactions::KleinNishina());
+	auto photonField = std::make_shared<photonfields::CMB>(photonfields::CMB());
+	Vector3QLength pos(3_kpc, 1_kpc, 0.3_kpc);
+
+	setenv("HERMES_CACHE_PATH", ".", 1);
+	auto makeIntegrator = [&]() {
+		auto intIC = std::make_shared<InverseComptonIntegrator>(
+		    InverseComptonIntegrator(crModel, photonField, kleinnishina));
+		intIC->setupCacheTable(6, 6, 2);
+		return intIC;
+	};
+	std::remove(makeIntegrator()->getCacheTableStore().getFilename().c_str());
+
+	// the densities needed for the key of the store only
+	crModel->calls = 0;
+	makeIntegrator()->getCacheTableStore();
+	const std::size_t keyCalls = crModel->calls;
+
+	std::vector<QGREmissivity> computed;
+	for (auto Egamma : {1_GeV, 10_GeV}) {
+		auto intIC = makeIntegrator();
+		intIC->setSkymapParameter(Egamma);
+		crModel->calls = 0;
+		intIC->initCacheTable();
+		EXPECT_GT(crModel->calls, keyCalls);
+		computed.push_back(intIC->integrateOverEnergy(pos, Egamma));
+	}
+
+	// a new integrator of the same configuration loads both tables
+	// without evaluating the model on the grid
+	auto intIC = makeIntegrator();
+	std::size_t i = 0;
+	for (auto Egamma : {1_GeV, 10_GeV}) {
+		intIC->setSkymapParameter(Egamma);
+		crModel->calls = 0;
+		intIC->initCacheTable();
+		EXPECT_EQ(crModel->calls, keyCalls);
+		EXPECT_TRUE(intIC->isCacheTableInitialized());
+		EXPECT_EQ(static_cast<double>(intIC->integrateOverEnergy(pos, Egamma)),
+		          static_cast<double>(computed[i++]));
+	}
+	std::remove(intIC->getCacheTableStore().getFilename().c_str());
+	std::remove((intIC->getCacheTableStore().getFilename() + ".lock").c_str());
+	unsetenv("HERMES_CACHE_PATH");
+}
+
 TEST(InverseComptonIntegrator, GammaSkymapRange) {
 	auto gammaskymap_range = std::make_shared<GammaSkymapRange>(
 	    GammaSkymapRange(4, 1_GeV, 100_TeV, 10));
@@ -0,0 +1,134 @@
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "hermes.h"
+
+namespace hermes {
+
+class DiscIonizedGasDensity : public ionizedgas::IonizedGasDensity {
+  public:
+	QPDensity getDensity(const Vector3QLength &pos) const override {
+		return 0.05 / 1_cm3 * std::exp(-static_cast<double>(fabs(pos.z) / 1_kpc)) *
+		       std::exp(-static_cast<double>(pos.getR() / 10_kpc));
+	}
+};
+
+class LOSSampleStoreTest : public ::testing::Test {
+  protected:
+	std::shared_ptr<magneticfields::MagneticField> mfield;
+	std::shared_ptr<ionizedgas::IonizedGasDensity> gdensity;
+	std::shared_ptr<cosmicrays::CosmicRayDensity> crdensity;
+	std::vector<QDirection> directions;
+
+	void SetUp() override {
+		mfield = std::make_shared<magneticfields::UniformMagneticField>(Vector3QMField(1_muG, 2_muG, 0.5_muG));
+		gdensity = std::make_shared<DiscIonizedGasDensity>();
+		crdensity = std::make_shared<cosmicrays::SimpleCR>(Electron, 1_GeV, 100_GeV, 10);
+		for (std::size_t ipix = 0; ipix < 48; ipix += 5) directions.push_back(pix2ang_ring(2, ipix));
+	}
+};
+
+TEST_F(LOSSampleStoreTest, sharedBetweenIntegrators) {
+	auto store = std::make_shared<LOSSampleStore>(Vector3QLength(8.5_kpc, 0, 0), 500);
+	auto rm = std::make_shared<RotationMeasureIntegrator>(mfield, gdensity);
+	auto dm = std::make_shared<DispersionMeasureIntegrator>(gdensity);
+	auto ff = std::make_shared<FreeFreeIntegrator>(gdensity);
+
+	std::vector<QRotationMeasure> rmReference;
+	std::vector<QTemperature> ffReference;
+	for (const auto &dir : directions) {
+		rmReference.push_back(rm->integrateOverLOS(dir));
+		ffReference.push_back(ff->integrateOverLOS(dir, 1_GHz));
+	}
+
+	rm->setSampleStore(store);
+	dm->setSampleStore(store);
+	ff->setSampleStore(store);
+	EXPECT_EQ(store->getMagneticField(), mfield);
+	EXPECT_EQ(store->getIonizedGasDensity(), gdensity);
+
+	for (std::size_t i = 0; i < directions.size(); ++i) {
+		// the same Simpson nodes as without the store
+		EXPECT_NEAR(static_cast<double>(rm->integrateOverLOS(directions[i])), static_cast<double>(rmReference[i]),
+		            1e-9 * std::fabs(static_cast<double>(rmReference[i])) + 1e-30);
+		EXPECT_NEAR(static_cast<double>(ff->integrateOverLOS(directions[i], 1_GHz)),
+		            static_cast<double>(ffReference[i]), 1e-9 * static_cast<double>(ffReference[i]));
+		// QAG versus Simpson on the nodes of the store
+		QDispersionMeasure withStore = dm->integrateOverLOS(directions[i]);
+		dm->setSampleStore(nullptr);
+		QDispersionMeasure withoutStore = dm->integrateOverLOS(directions[i]);
+		dm->setSampleStore(store);
+		EXPECT_NEAR(static_cast<double>(withStore), static_cast<double>(withoutStore),
+		            1e-3 * static_cast<double>(withoutStore));
+	}
+
+	// every LOS was evaluated only once
+	EXPECT_EQ(store->getMisses(), directions.size());
+	EXPECT_EQ(store->getHits(), 2 * directions.size());
+	EXPECT_EQ(store->getNumberOfEntries(), directions.size());
+}
+
+TEST_F(LOSSampleStoreTest, synchrotronSpectra) {
+	auto store = std::make_shared<LOSSampleStore>(Vector3QLength(8.5_kpc, 0, 0), 100);
+	auto synchro = std::make_shared<SynchroIntegrator>(mfield, crdensity);
+	std::vector<QFrequency> freqs = {100_MHz, 1_GHz};
+
+	QDirection dir = directions[3];
+	QTemperature reference = synchro->integrateOverLOS(dir, 408_MHz);
+	EXPECT_GT(static_cast<double>(reference), 0);
+	auto referenceRange = synchro->integrateOverLOS(dir, freqs);
+
+	synchro->setSampleStore(store);
+	EXPECT_NEAR(static_cast<double>(synchro->integrateOverLOS(dir, 408_MHz)), static_cast<double>(reference),
+	            1e-9 * static_cast<double>(reference));
+	auto range = synchro->integrateOverLOS(dir, freqs);
+	for (std::size_t k = 0; k < freqs.size(); ++k)
+		EXPECT_NEAR(static_cast<double>(range[k]), static_cast<double>(referenceRange[k]),
+		            1e-9 * static_cast<double>(referenceRange[k]));
+	EXPECT_EQ(store->getMisses(), 1);
+
+	// another observer does not use the store
+	synchro->setObsPosition(Vector3QLength(8_kpc, 0, 0));
+	synchro->integrateOverLOS(dir, 408_MHz);
+	EXPECT_EQ(store->getMisses() + store->getHits(), 2);
+}
+
+TEST_F(LOSSampleStoreTest, memoryBudget) {
+	auto store = std::make_shared<LOSSampleStore>(Vector3QLength(8.5_kpc, 0, 0), 100);
+	store->setIonizedGasDensity(gdensity);
+	auto first = store->getSamples(directions[0]);
+	const std::size_t entrySize = first->getMemoryUsage();
+
+	store->setMemoryBudget(3 * entrySize);
+	for (const auto &dir : directions) store->getSamples(dir);
+	EXPECT_EQ(store->getNumberOfEntries(), 3);
+	EXPECT_LE(store->getMemoryUsage(), 3 * entrySize);
+	EXPECT_EQ(store->getEvictions(), directions.size() - 3);
+
+	// evicted samples stay valid for their holders
+	EXPECT_EQ(first->ionizedGasDensity.size(), 101);
+	// the least recently used entry was evicted
+	store->getSamples(directions.back());
+	EXPECT_EQ(store->getMisses(), directions.size());
+	store->getSamples(directions.front());
+	EXPECT_EQ(store->getMisses(), directions.size() + 1);
+}
+
+TEST_F(LOSSampleStoreTest, differentModelIsAnError) {
+	auto store = std::make_shared<LOSSampleStore>(Vector3QLength(8.5_kpc, 0, 0));
+	auto dm = std::make_shared<DispersionMeasureIntegrator>(gdensity);
+	dm->setSampleStore(store);
+
+	auto other = std::make_shared<DispersionMeasureIntegrator>(std::make_shared<DiscIonizedGasDensity>());
+	EXPECT_THROW(other->setSampleStore(store), std::runtime_error);
+	EXPECT_THROW(LOSSampleStore(Vector3QLength(8.5_kpc, 0, 0), 101), std::runtime_error);
+}
+
+int main(int argc, char **argv) {
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
+
+}  // namespace hermes
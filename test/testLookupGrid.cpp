@@ -0,0 +1,140 @@
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "hermes.h"
+
+namespace hermes {
+
+TEST(LookupGrid, axes) {
+	auto x = uniformAxis(-2_kpc, 2_kpc, 5);
+	ASSERT_EQ(x.size(), 5);
+	EXPECT_DOUBLE_EQ(static_cast<double>(x.front()), static_cast<double>(-2_kpc));
+	EXPECT_DOUBLE_EQ(static_cast<double>(x[2]), 0);
+	EXPECT_DOUBLE_EQ(static_cast<double>(x.back()), static_cast<double>(2_kpc));
+
+	auto z = sinhAxis(3_kpc, 41, 50_pc);
+	ASSERT_EQ(z.size(), 41);
+	EXPECT_NEAR(static_cast<double>(z.front() / 1_kpc), -3, 1e-12);
+	EXPECT_NEAR(static_cast<double>(z.back() / 1_kpc), 3, 1e-12);
+	EXPECT_NEAR(static_cast<double>(z[20]), 0, 1e-6);
+	// denser around the plane
+	EXPECT_LT(z[21] - z[20], z[40] - z[39]);
+
+	LookupGrid<double> grid(x, x, z);
+	EXPECT_TRUE(grid.isUniform(0));
+	EXPECT_FALSE(grid.isUniform(2));
+	EXPECT_THROW(LookupGrid<double>(x, x, {1_kpc}), std::runtime_error);
+	EXPECT_THROW(LookupGrid<double>(x, x, {1_kpc, 0_kpc}), std::runtime_error);
+}
+
+TEST(LookupGrid, trilinearIsExact) {
+	// trilinear functions are reproduced exactly, also on non-uniform axes
+	auto f = [](const Vector3d &p) { return 1 + 2 * p.x - p.y * p.z + 0.5 * p.x * p.y * p.z; };
+	LookupGrid<double> grid(uniformAxis(-2_m, 2_m, 5), uniformAxis(-1_m, 3_m, 3), sinhAxis(2_m, 9, 0.1_m));
+	grid.fill([f](const Vector3d *pos, double *out, std::size_t n) {
+		for (std::size_t i = 0; i < n; ++i) out[i] = f(pos[i]);
+	});
+
+	auto accuracy = grid.measureAccuracy(f, 1000);
+	EXPECT_EQ(accuracy.nSamples, 1000);
+	EXPECT_LT(accuracy.maxError, 1e-12);
+	EXPECT_GT(accuracy.rmsValue, 0);
+	EXPECT_TRUE(grid.contains(Vector3d(2, 3, -2)));
+	EXPECT_FALSE(grid.contains(Vector3d(2.1, 0, 0)));
+}
+
+TEST(GriddedIonizedGasDensity, interpolatesModel) {
+	auto model = std::make_shared<ionizedgas::NE2001Simple>();
+	auto coarse = std::make_shared<ionizedgas::GriddedIonizedGasDensity>(
+	    model, uniformAxis(-10_kpc, 10_kpc, 21), uniformAxis(-10_kpc, 10_kpc, 21), sinhAxis(2_kpc, 21, 100_pc));
+	auto fine = std::make_shared<ionizedgas::GriddedIonizedGasDensity>(
+	    model, uniformAxis(-10_kpc, 10_kpc, 81), uniformAxis(-10_kpc, 10_kpc, 81), sinhAxis(2_kpc, 41, 100_pc));
+
+	// nodes are exact, positions outside are passed to the model
+	Vector3QLength node(5_kpc, -3_kpc, 0_kpc);
+	EXPECT_NEAR(static_cast<double>(coarse->getDensity(node)), static_cast<double>(model->getDensity(node)),
+	            1e-9 * static_cast<double>(model->getDensity(node)));
+	Vector3QLength outside(12.3_kpc, 0_kpc, 0.1_kpc);
+	EXPECT_EQ(static_cast<double>(fine->getDensity(outside)), static_cast<double>(model->getDensity(outside)));
+	EXPECT_EQ(static_cast<double>(fine->getTemperature()), static_cast<double>(model->getTemperature()));
+
+	auto coarseAccuracy = coarse->getAccuracy(2000);
+	auto fineAccuracy = fine->getAccuracy(2000);
+	EXPECT_LT(fineAccuracy.getRelativeError(), coarseAccuracy.getRelativeError());
+	EXPECT_LT(fineAccuracy.getRelativeError(), 0.2);
+}
+
+TEST(GriddedMagneticField, interpolatesModel) {
+	auto uniform = std::make_shared<magneticfields::UniformMagneticField>(Vector3QMField(1_muG, -2_muG, 3_muG));
+	magneticfields::GriddedMagneticField gridded(uniform, uniformAxis(-1_kpc, 1_kpc, 3),
+	                                             uniformAxis(-1_kpc, 1_kpc, 3), sinhAxis(1_kpc, 5, 100_pc));
+	Vector3QMField B = gridded.getField(Vector3QLength(0.3_kpc, -0.7_kpc, 0.05_kpc));
+	EXPECT_NEAR(static_cast<double>(B.y / 1_muG), -2, 1e-12);
+	EXPECT_LT(gridded.getAccuracy(100).maxError, 1e-20);
+
+	auto jf12 = std::make_shared<magneticfields::JF12>();
+	magneticfields::GriddedMagneticField griddedJF12(jf12, uniformAxis(-20_kpc, 20_kpc, 81),
+	                                                 uniformAxis(-20_kpc, 20_kpc, 81), sinhAxis(5_kpc, 41, 200_pc));
+	auto accuracy = griddedJF12.getAccuracy(2000);
+	EXPECT_LT(accuracy.getRelativeError(), 0.5);
+}
+
+// counts the densities requested from the wrapped model
+class CountingDensity : public ionizedgas::IonizedGasDensity {
+	std::shared_ptr<ionizedgas::IonizedGasDensity> model;
+
+  public:
+	mutable std::atomic<std::size_t> calls{0};
+
+	explicit CountingDensity(const std::shared_ptr<ionizedgas::IonizedGasDensity> &model)
+	    : ionizedgas::IonizedGasDensity(model->getTemperature()), model(model) {}
+	QPDensity getDensity(const Vector3QLength &pos) const override {
+		++calls;
+		return model->getDensity(pos);
+	}
+	void getDensity(const Vector3QLength *pos, QPDensity *density, std::size_t n) const override {
+		calls += n;
+		model->getDensity(pos, density, n);
+	}
+};
+
+TEST(GriddedIonizedGasDensity, binaryCache) {
+	setenv("HERMES_CACHE_PATH", ".", 1);
+	auto model = std::make_shared<CountingDensity>(std::make_shared<ionizedgas::NE2001Simple>());
+	auto x = uniformAxis(-10_kpc, 10_kpc, 11);
+	auto z = sinhAxis(2_kpc, 11, 100_pc);
+
+	const std::string filename =
+	    BinaryCache("GriddedIonizedGasDensity_testLookupGrid", LookupGrid<double>(x, x, z).getCacheKeys())
+	        .getFilename();
+	std::remove(filename.c_str());
+
+	ionizedgas::GriddedIonizedGasDensity first(model, x, x, z, "testLookupGrid");
+	EXPECT_EQ(model->calls, 11 * 11 * 11);
+	EXPECT_TRUE(std::ifstream(filename).good());
+
+	// the second grid is loaded, the model is not evaluated again
+	model->calls = 0;
+	ionizedgas::GriddedIonizedGasDensity second(model, x, x, z, "testLookupGrid");
+	EXPECT_EQ(model->calls, 0);
+	EXPECT_EQ(first.getGrid().getGrid(), second.getGrid().getGrid());
+
+	unsetenv("HERMES_CACHE_PATH");
+
+	Vector3QLength pos(1.234_kpc, -2.5_kpc, 0.07_kpc);
+	EXPECT_DOUBLE_EQ(static_cast<double>(first.getDensity(pos)), static_cast<double>(second.getDensity(pos)));
+	std::remove(filename.c_str());
+}
+
+int main(int argc, char **argv) {
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
+
+}  // namespace hermes
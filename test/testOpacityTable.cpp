@@ -0,0 +1,128 @@
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "hermes.h"
+
+namespace hermes {
+
+// power law above a threshold, as the pair-production opacity
+QInverseLength powerLawKappa(const QEnergy &E) {
+	if (E < 50_TeV) return QInverseLength(0);
+	return 1e-20 / 1_m * std::pow(static_cast<double>(E / 50_TeV), 1.5);
+}
+
+TEST(OpacityTable, energyAxis) {
+	OpacityTable table(10_TeV, 10_EeV, 121);
+	auto axis = table.getEnergyAxis();
+	EXPECT_EQ(axis.size(), 121u);
+	EXPECT_NEAR(static_cast<double>(axis.front() / 10_TeV), 1., 1e-12);
+	EXPECT_DOUBLE_EQ(static_cast<double>(axis.back() / 10_EeV), 1.);
+	EXPECT_NEAR(static_cast<double>(axis[40] / 1_PeV), 1., 1e-12);
+	EXPECT_TRUE(table.contains(10_TeV));
+	EXPECT_TRUE(table.contains(10_EeV));
+	EXPECT_FALSE(table.contains(1_TeV));
+
+	EXPECT_THROW(OpacityTable(10_TeV, 1_TeV, 10), std::runtime_error);
+}
+
+TEST(OpacityTable, interpolation) {
+	OpacityTable table(10_TeV, 10_EeV, 121);
+	table.fill(powerLawKappa);
+
+	// log-log interpolation of a power law is exact
+	for (QEnergy E = 60_TeV; E < 10_EeV; E = E * 1.37)
+		EXPECT_NEAR(static_cast<double>(table.getAbsorptionCoefficient(E) / powerLawKappa(E)), 1., 1e-10);
+	// below the threshold and in the interval containing it
+	EXPECT_EQ(static_cast<double>(table.getAbsorptionCoefficient(20_TeV)), 0.);
+	auto k = table.getAbsorptionCoefficient(49_TeV);
+	EXPECT_GE(static_cast<double>(k), 0.);
+	EXPECT_LT(k, powerLawKappa(60_TeV));
+}
+
+TEST(OpacityTable, binaryCache) {
+	setenv("HERMES_CACHE_PATH", ".", 1);
+	std::atomic<int> calls{0};
+	auto counted = [&calls](const QEnergy &E) {
+		++calls;
+		return powerLawKappa(E);
+	};
+	{
+		OpacityTable table(10_TeV, 10_EeV, 31);
+		table.fillCached("testOpacityTable", counted);
+	}
+	EXPECT_EQ(calls, 31);
+	OpacityTable table(10_TeV, 10_EeV, 31);
+	table.fillCached("testOpacityTable", counted);
+	EXPECT_EQ(calls, 31);
+	EXPECT_DOUBLE_EQ(static_cast<double>(table.getTableValue(30)), static_cast<double>(powerLawKappa(10_EeV)));
+	unsetenv("HERMES_CACHE_PATH");
+	std::system("rm -f ./testOpacityTable-*.bin");
+}
+
+// starlight-like field, linear in r and exponential in |z|
+class TestPhotonField : public photonfields::PhotonField {
+  public:
+	TestPhotonField() {
+		for (QEnergy E = 0.1_eV; E < 10_eV; E = E * 1.8) energyRange.push_back(E);
+	}
+	QEnergyDensity getEnergyDensity(const Vector3QLength &pos, const QEnergy &E) const override {
+		const double r = static_cast<double>(pos.getRho() / 1_kpc);
+		const double z = std::fabs(static_cast<double>(pos.z / 1_kpc));
+		return (1 + r) * std::exp(-z) * std::exp(-static_cast<double>(E / 1_eV)) * 1_eV / 1_cm3;
+	}
+	QEnergyDensity getEnergyDensity(const Vector3QLength &pos, std::size_t iE) const override {
+		return getEnergyDensity(pos, energyRange[iE]);
+	}
+};
+
+TEST(OpacityGrid, positionDependence) {
+	auto field = std::make_shared<TestPhotonField>();
+	std::vector<QLength> r = {0_kpc, 2_kpc, 4_kpc}, z = {0_kpc, 1_kpc};
+	OpacityGrid grid(field, r, z, 1_TeV, 1_PeV, 4);
+
+	// a node is the sum over the photon energies
+	interactions::BreitWheeler bw;
+	auto eps = field->getEnergyAxis();
+	QInverseLength expected(0);
+	for (std::size_t j = 1; j < eps.size(); ++j)
+		expected += field->getEnergyDensity(Vector3QLength(2_kpc, 0_m, 1_kpc), j) / eps[j] *
+		            bw.integratedOverTheta(100_TeV, eps[j]) * std::log(static_cast<double>(eps[j] / eps[j - 1]));
+	EXPECT_GT(static_cast<double>(expected), 0.);
+	EXPECT_NEAR(static_cast<double>(grid.getTableValue(1, 1, 2) / expected), 1., 1e-12);
+
+	// linear in r, exp(-|z|)
+	EXPECT_NEAR(static_cast<double>(grid.getTableValue(2, 0, 3) / grid.getTableValue(0, 0, 3)), 5., 1e-12);
+	EXPECT_NEAR(static_cast<double>(grid.getTableValue(2, 1, 3) / grid.getTableValue(2, 0, 3)), std::exp(-1.),
+	            1e-12);
+
+	// bilinear interpolation in (r, |z|) is exact in r, symmetric in z,
+	// and the boundary is extended
+	Vector3QLength pos(0_kpc, 3_kpc, -1_kpc);
+	EXPECT_NEAR(static_cast<double>(grid.getAbsorptionCoefficient(pos, 1_PeV) / grid.getTableValue(2, 1, 3)), 4. / 5.,
+	            1e-12);
+	EXPECT_NEAR(static_cast<double>(grid.getAbsorptionCoefficient(Vector3QLength(9_kpc, 0_m, 5_kpc), 1_PeV) /
+	                                grid.getTableValue(2, 1, 3)),
+	            1., 1e-12);
+
+	std::vector<QInverseLength> all;
+	grid.getAbsorptionCoefficients(pos, {1_TeV, 100_TeV, 1_PeV}, all);
+	EXPECT_EQ(all.size(), 3u);
+	EXPECT_GT(static_cast<double>(all[0]), 0.);
+	EXPECT_EQ(all[2], grid.getAbsorptionCoefficient(pos, 1_PeV));
+
+	// no absorption below the table
+	grid.getAbsorptionCoefficients(pos, {1_GeV, 0.9_TeV}, all);
+	EXPECT_EQ(static_cast<double>(all[0]), 0.);
+	EXPECT_EQ(static_cast<double>(all[1]), 0.);
+}
+
+int main(int argc, char **argv) {
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
+
+}  // namespace hermes
@@ -1,4 +1,7 @@
+#include <cstdlib>
+#include <filesystem>
 #include <fstream>
+#include <vector>
 
 #include "gtest/gtest.h"
 #include "hermes.h"
@@ -51,6 +54,82 @@ TEST(CMB, ISRF) {
 	*/
 }
 
+TEST(CMB, getSpectrum) {
+	auto field = std::make_shared<photonfields::CMB>(photonfields::CMB());
+	std::vector<QEnergyDensity> spectrum;
+	Vector3QLength pos(8.5_kpc, 0, 0);
+	field->getSpectrum(pos, spectrum);
+
+	ASSERT_EQ(spectrum.size(), field->getEnergyAxis().size());
+	for (std::size_t i = 0; i < spectrum.size(); ++i)
+		EXPECT_EQ(static_cast<double>(spectrum[i]),
+		          static_cast<double>(field->getEnergyDensity(pos, i)));
+}
+
+TEST(ISRF, getSpectrum) {
+	auto field = std::make_shared<photonfields::ISRF>(photonfields::ISRF());
+	std::vector<QEnergyDensity> spectrum;
+
+	for (const auto &pos :
+	     {Vector3QLength(8.5_kpc, 0, 0), Vector3QLength(3_kpc, 2_kpc, 0.35_kpc),
+	      Vector3QLength(0, 0, -1.1_kpc), Vector3QLength(30_kpc, 0, 30_kpc)}) {
+		field->getSpectrum(pos, spectrum);
+		ASSERT_EQ(spectrum.size(), field->getEnergyAxis().size());
+		std::size_t i = 0;
+		for (auto itE = field->begin(); itE != field->end(); ++itE, ++i) {
+			double expected =
+			    static_cast<double>(field->getEnergyDensity(pos, *itE));
+			EXPECT_NEAR(static_cast<double>(spectrum[i]), expected,
+			            1e-9 * std::fabs(expected));
+			EXPECT_NEAR(static_cast<double>(field->getEnergyDensity(pos, i)),
+			            expected, 1e-9 * std::fabs(expected));
+		}
+	}
+
+	// the uniform resampling reproduces the data at its nodes
+	field->resampleUniform(61, 301);
+	EXPECT_TRUE(field->isResampled());
+	Vector3QLength node(8.5_kpc, 0, 0.2_kpc);
+	field->getSpectrum(node, spectrum);
+	std::size_t i = 0;
+	for (auto itE = field->begin(); itE != field->end(); ++itE, ++i) {
+		double expected = static_cast<double>(field->getEnergyDensity(node, *itE));
+		EXPECT_NEAR(static_cast<double>(spectrum[i]), expected,
+		            1e-9 * std::fabs(expected));
+	}
+}
+
+TEST(ISRF, binaryCache) {
+	auto parsed = std::make_shared<photonfields::ISRF>(photonfields::ISRF());
+
+	// a fresh cache directory, removed afterwards
+	const auto dir = std::filesystem::temp_directory_path() / "hermes_testPhotonField";
+	std::filesystem::remove_all(dir);
+	std::filesystem::create_directory(dir);
+	setenv("HERMES_CACHE_PATH", dir.c_str(), 1);
+
+	auto stored = std::make_shared<photonfields::ISRF>(photonfields::ISRF());
+	std::vector<std::filesystem::path> entries(std::filesystem::directory_iterator(dir), {});
+	ASSERT_EQ(entries.size(), 1u);
+	const auto written = std::filesystem::last_write_time(entries.front());
+
+	// a hit maps the entry; a miss would parse the files and rewrite it
+	auto loaded = std::make_shared<photonfields::ISRF>(photonfields::ISRF());
+	EXPECT_EQ(std::filesystem::last_write_time(entries.front()), written);
+
+	unsetenv("HERMES_CACHE_PATH");
+	std::filesystem::remove_all(dir);
+
+	for (const auto &pos :
+	     {Vector3QLength(8.5_kpc, 0, 0), Vector3QLength(3_kpc, 2_kpc, 0.35_kpc)})
+		for (std::size_t i = 0; i < parsed->getEnergyAxis().size(); ++i) {
+			EXPECT_EQ(static_cast<double>(parsed->getEnergyDensity(pos, i)),
+			          static_cast<double>(stored->getEnergyDensity(pos, i)));
+			EXPECT_EQ(static_cast<double>(parsed->getEnergyDensity(pos, i)),
+			          static_cast<double>(loaded->getEnergyDensity(pos, i)));
+		}
+}
+
 int main(int argc, char **argv) {
 	::testing::InitGoogleTest(&argc, argv);
 	return RUN_ALL_TESTS();
@@ -103,6 +103,47 @@ TEST(PiZeroIntegrator, ChannelsRatio) {
 	            static_cast<double>(res_total), 1e-22);
 }
 
+TEST(PiZeroIntegrator, energyKernel) {
+	auto cr_proton = std::make_shared<cosmicrays::SimpleCR>(
+	    cosmicrays::SimpleCR(Proton));
+	auto kamae = std::make_shared<interactions::Kamae06Gamma>(
+	    interactions::Kamae06Gamma());
+	auto ringModel = std::make_shared<neutralgas::RingModel>(
+	    neutralgas::RingModel(neutralgas::GasType::HI));
+	auto intPiZero = std::make_shared<PiZeroIntegrator>(
+	    PiZeroIntegrator(cr_proton, ringModel, kamae));
+
+	Vector3QLength pos(6_kpc, 1_kpc, 0.1_kpc);
+	std::vector<QEnergy> Egammas = {1_GeV, 10_GeV, 100_GeV, 10_TeV};
+	auto res = intPiZero->integrateOverEnergy(pos, Egammas);
+
+	for (std::size_t k = 0; k < Egammas.size(); ++k) {
+		// sum over the CR energies without the precomputed kernel
+		QPiZeroIntegral expected(0);
+		for (auto itE = cr_proton->beginAfterEnergy(Egammas[k]);
+		     itE != cr_proton->end(); ++itE)
+			for (const auto &gas : ringModel->getAbundanceFractions())
+				expected += c_light * cr_proton->getDensityPerEnergy(*itE, pos) *
+				            (*itE) * gas.second *
+				            kamae->getDiffCrossSection(Proton, gas.first, *itE,
+				                                       Egammas[k]);
+		expected *= std::log(cr_proton->getEnergyScaleFactor());
+
+		EXPECT_NEAR(static_cast<double>(res[k]) / static_cast<double>(expected),
+		            1, 1e-9);
+	}
+
+	// the kernels prepared for the skymaps give the same results
+	intPiZero->prepareSkymapParameters(Egammas);
+	auto prepared = intPiZero->integrateOverEnergy(pos, Egammas);
+	for (std::size_t k = 0; k < Egammas.size(); ++k) {
+		EXPECT_EQ(static_cast<double>(prepared[k]), static_cast<double>(res[k]));
+		EXPECT_EQ(static_cast<double>(res[k]),
+		          static_cast<double>(
+		              intPiZero->integrateOverEnergy(pos, Egammas[k])));
+	}
+}
+
 TEST(PiZeroIntegrator, PiZeroLOS) {
 	// auto crdensity =
 	// std::make_shared<TestCRDensity>(TestCRDensity(1_MHz));
@@ -141,6 +182,67 @@ TEST(PiZeroIntegrator, PiZeroLOS) {
 	// EXPECT_NEAR(emissivity.getValue(), 3.915573e-55, 2e-56); // J/m^3
 }
 
+// homogeneous photon field around 1 eV
+class UniformPhotonField : public photonfields::PhotonField {
+  public:
+	UniformPhotonField() {
+		for (QEnergy E = 0.5_eV; E < 2_eV; E = E * 1.5) energyRange.push_back(E);
+	}
+	QEnergyDensity getEnergyDensity(const Vector3QLength &pos, const QEnergy &E) const override {
+		return 1e3_eV / 1_cm3;
+	}
+	QEnergyDensity getEnergyDensity(const Vector3QLength &pos, std::size_t iE) const override {
+		return 1e3_eV / 1_cm3;
+	}
+};
+
+TEST(PiZeroAbsorptionIntegrator, pairProductionThreshold) {
+	auto simpleModel = std::make_shared<cosmicrays::SimpleCR>(cosmicrays::SimpleCR());
+	auto kamae = std::make_shared<interactions::Kamae06Gamma>(interactions::Kamae06Gamma());
+	auto ringModel = std::make_shared<neutralgas::RingModel>(neutralgas::RingModel(neutralgas::GasType::HI));
+	auto integrator = std::make_shared<PiZeroAbsorptionIntegrator>(simpleModel, ringModel, kamae);
+
+	// the default table is built on construction and starts at the threshold
+	const QEnergy threshold = PiZeroAbsorptionIntegrator::getPairProductionThreshold();
+	EXPECT_NEAR(static_cast<double>(threshold / 1_TeV), 52.2, 0.1);
+	auto table = integrator->getOpacityTable();
+	ASSERT_NE(table, nullptr);
+	EXPECT_NEAR(static_cast<double>(table->getEnergyAxis().front() / threshold), 1., 1e-12);
+	EXPECT_EQ(static_cast<double>(integrator->absorptionCoefficient(1_TeV)), 0.);
+	EXPECT_EQ(static_cast<double>(integrator->absorptionCoefficient(0.99 * threshold)), 0.);
+	EXPECT_GT(static_cast<double>(integrator->absorptionCoefficient(1_PeV)), 0.);
+}
+
+TEST(PiZeroAbsorptionIntegrator, opacityGrid) {
+	auto simpleModel = std::make_shared<cosmicrays::SimpleCR>(cosmicrays::SimpleCR());
+	auto kamae = std::make_shared<interactions::Kamae06Gamma>(interactions::Kamae06Gamma());
+	auto ringModel = std::make_shared<neutralgas::RingModel>(neutralgas::RingModel(neutralgas::GasType::HI));
+	auto integrator = std::make_shared<PiZeroAbsorptionIntegrator>(simpleModel, ringModel, kamae);
+
+	// a homogeneous field on the grid and in the table gives the same
+	// absorption: accumulated along the LOS and exp(-kappa * dist)
+	auto grid = std::make_shared<OpacityGrid>(std::make_shared<UniformPhotonField>(),
+	                                          std::vector<QLength>{0_kpc, 30_kpc},
+	                                          std::vector<QLength>{0_kpc, 30_kpc}, 100_TeV, 1_PeV, 2);
+	auto table = std::make_shared<OpacityTable>(100_TeV, 1_PeV, 2);
+	table->fill([grid](const QEnergy &E) { return grid->getAbsorptionCoefficient(Vector3QLength(0_m), E); });
+	EXPECT_GT(table->getTableValue(1), QInverseLength(0));
+
+	QDirection dir = {90_deg, 10_deg};
+	std::vector<QEnergy> energies = {100_TeV, 300_TeV};
+	integrator->setOpacityTable(table);
+	auto homogeneous = integrator->integrateOverLOS(dir, energies);
+	integrator->setOpacityGrid(grid);
+	auto accumulated = integrator->integrateOverLOS(dir, energies);
+	auto single = integrator->integrateOverLOS(dir, 300_TeV);
+
+	for (std::size_t k = 0; k < energies.size(); ++k) {
+		EXPECT_GT(static_cast<double>(homogeneous[k]), 0.);
+		EXPECT_NEAR(static_cast<double>(accumulated[k] / homogeneous[k]), 1., 1e-9);
+	}
+	EXPECT_NEAR(static_cast<double>(single / accumulated[1]), 1., 1e-12);
+}
+
 int main(int argc, char **argv) {
 	::testing::InitGoogleTest(&argc, argv);
 	return RUN_ALL_TESTS();
@@ -191,6 +191,42 @@ TEST(PerformanceTest, DarkMatterIntegrator) {
 	EXPECT_LE(time, 100);  // ms
 }
 
+TEST(PerformanceTest, CrossSectionTable) {
+	// lookups of a typical (E_cr, E_gamma) grid from all threads, from the
+	// precomputed table and from the hash map
+	std::vector<QEnergy> energiesCR, energiesGamma;
+	for (QEnergy E = 1_GeV; E < 1_PeV; E = E * 1.1) energiesCR.push_back(E);
+	for (QEnergy E = 1_GeV; E < 1_TeV; E = E * 1.5) energiesGamma.push_back(E);
+	auto f = [](QEnergy E_cr, QEnergy E_gamma) { return QDiffCrossSection(static_cast<double>(E_gamma / E_cr)); };
+
+	CacheStorageCrossSection hashMap;
+	hashMap.setFunction(f);
+	CacheStorageCrossSectionTable table(energiesCR, energiesGamma);
+	table.setFunction(f);
+
+	for (auto E_gamma : energiesGamma)
+		for (auto E_cr : energiesCR)
+			EXPECT_DOUBLE_EQ(static_cast<double>(table.getValue(E_cr, E_gamma)),
+			                 static_cast<double>(hashMap.getValue(E_cr, E_gamma)));
+
+	auto sweep = [&](CacheStorageCrossSectionBase &cache) {
+		std::chrono::time_point<std::chrono::system_clock> start = std::chrono::system_clock::now();
+		getThreadPool()->parallelFor(200, [&](std::size_t) {
+			for (auto E_gamma : energiesGamma)
+				for (auto E_cr : energiesCR) cache.getValue(E_cr, E_gamma);
+		});
+		std::chrono::time_point<std::chrono::system_clock> stop = std::chrono::system_clock::now();
+		return std::chrono::duration<double, std::milli>(stop - start).count();
+	};
+
+	sweep(hashMap);  // warm up the hash map
+	double tHashMap = sweep(hashMap);
+	double tTable = sweep(table);
+	std::cerr << "Cross-section lookups" << std::endl
+	          << "hash map: " << tHashMap << " ms, table: " << tTable << " ms" << std::endl;
+	EXPECT_LE(tTable, tHashMap);
+}
+
 int main(int argc, char **argv) {
 	::testing::InitGoogleTest(&argc, argv);
 	return RUN_ALL_TESTS();
@@ -0,0 +1,108 @@
+#include <cmath>
+#include <memory>
+
+#include "gtest/gtest.h"
+#include "hermes.h"
+
+namespace hermes {
+
+class ConstantIonizedGasDensity : public ionizedgas::IonizedGasDensity {
+  public:
+	ConstantIonizedGasDensity() : ionizedgas::IonizedGasDensity(1e4_K) {}
+	QPDensity getDensity(const Vector3QLength &pos) const { return 1.0 / 1_cm3; }
+};
+
+void expectNear(const Vector3QLength &a, const Vector3QLength &b) {
+	EXPECT_NEAR(static_cast<double>(a.x), static_cast<double>(b.x), 1e-9 * static_cast<double>(1_kpc));
+	EXPECT_NEAR(static_cast<double>(a.y), static_cast<double>(b.y), 1e-9 * static_cast<double>(1_kpc));
+	EXPECT_NEAR(static_cast<double>(a.z), static_cast<double>(b.z), 1e-9 * static_cast<double>(1_kpc));
+}
+
+TEST(RayTable, matchesGalacticPosition) {
+	const Vector3QLength observer(8.3_kpc, 0, 0.1_kpc);
+	const std::size_t nside = 8;
+	RayTable table(nside, observer);
+	ASSERT_EQ(table.size(), nside2npix(nside));
+	EXPECT_GT(table.getMemoryUsage(), table.size() * sizeof(QDirection));
+
+	for (std::size_t ipix = 0; ipix < table.size(); ++ipix) {
+		const QDirection dir = pix2ang_ring(nside, ipix);
+		EXPECT_EQ(table.getDirection(ipix), dir);
+		const LOSRay ray = table.getRay(ipix);
+		EXPECT_NEAR(ray.direction.getR(), 1., 1e-12);
+		EXPECT_DOUBLE_EQ(static_cast<double>(ray.maxDistance),
+		                 static_cast<double>(distanceToGalBorder(observer, dir)));
+		for (QLength dist : {0_kpc, 1.5_kpc, 20_kpc})
+			expectNear(ray.getPosition(dist), getGalacticPosition(observer, dist, dir));
+	}
+
+	const QDirection dir = fromGalCoord(QDirection({12_deg, 34_deg}));
+	const LOSRay ray = makeLOSRay(observer, dir);
+	expectNear(ray.getPosition(7_kpc), getGalacticPosition(observer, 7_kpc, dir));
+	std::vector<QLength> dist = {0_kpc, 1_kpc, 2_kpc};
+	std::vector<Vector3QLength> positions;
+	ray.getPositions(dist.data(), dist.size(), positions);
+	ASSERT_EQ(positions.size(), dist.size());
+	for (std::size_t i = 0; i < dist.size(); ++i) expectNear(positions[i], ray.getPosition(dist[i]));
+}
+
+TEST(RayTable, findRay) {
+	const std::size_t nside = 16;
+	RayTable table(nside, Vector3QLength(8.5_kpc, 0, 0));
+	LOSRay ray;
+	for (std::size_t ipix : {0u, 100u, 1500u, 3071u}) {
+		EXPECT_TRUE(table.findRay(pix2ang_ring(nside, ipix), ray));
+		EXPECT_EQ(ray.maxDistance, table.getRay(ipix).maxDistance);
+	}
+
+	// not the centre of a pixel of the table
+	QDirection dir = pix2ang_ring(nside, 100);
+	dir[1] += 1e-3_rad;
+	EXPECT_FALSE(table.findRay(dir, ray));
+	EXPECT_FALSE(table.findRay(pix2ang_ring(2 * nside, 101), ray));
+}
+
+TEST(RayTable, isShared) {
+	const Vector3QLength observer(8.5_kpc, 0, 0);
+	auto a = getRayTable(8, observer);
+	EXPECT_EQ(a, getRayTable(8, observer));
+	EXPECT_NE(a, getRayTable(16, observer));
+	EXPECT_NE(a, getRayTable(8, Vector3QLength(8.0_kpc, 0, 0)));
+	EXPECT_EQ(a->getNside(), 8u);
+}
+
+TEST(RayTable, integrator) {
+	const int nside = 8;
+	auto gdensity = std::make_shared<ConstantIonizedGasDensity>(ConstantIonizedGasDensity());
+	auto integrator = std::make_shared<DispersionMeasureIntegrator>(DispersionMeasureIntegrator(gdensity));
+	EXPECT_EQ(integrator->getRayTable(), nullptr);
+
+	auto other = getRayTable(nside, Vector3QLength(8.0_kpc, 0, 0));
+	EXPECT_THROW(integrator->setRayTable(other), std::runtime_error);
+
+	// the values do not change with the table
+	std::vector<QDispersionMeasure> expected;
+	for (int ipix = 0; ipix < 12 * nside * nside; ++ipix)
+		expected.push_back(integrator->integrateOverLOS(pix2ang_ring(nside, ipix)));
+
+	auto skymap = std::make_shared<DispersionMeasureSkymap>(DispersionMeasureSkymap(nside));
+	skymap->setIntegrator(integrator);
+	skymap->compute();
+	ASSERT_NE(integrator->getRayTable(), nullptr);
+	EXPECT_EQ(integrator->getRayTable(), getRayTable(nside, integrator->getObsPosition()));
+	for (int ipix = 0; ipix < 12 * nside * nside; ++ipix)
+		EXPECT_NEAR(static_cast<double>(skymap->getPixel(ipix)), static_cast<double>(expected[ipix]),
+		            1e-9 * static_cast<double>(expected[ipix]));
+
+	integrator->setObsPosition(Vector3QLength(8.0_kpc, 0, 0));
+	EXPECT_EQ(integrator->getRayTable(), nullptr);
+	const QDirection dir = pix2ang_ring(nside, 42);
+	EXPECT_EQ(integrator->getMaxDistance(dir), distanceToGalBorder(Vector3QLength(8.0_kpc, 0, 0), dir));
+}
+
+int main(int argc, char **argv) {
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
+
+}  // namespace hermes
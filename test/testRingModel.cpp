@@ -6,6 +6,38 @@
 
 namespace hermes {
 
+TEST(Ring, getCrossings) {
+	neutralgas::Ring ring(0, nullptr, 2_kpc, 3_kpc);
+	auto near = [](QLength a, double b_kpc) { return std::fabs(static_cast<double>(a / 1_kpc) - b_kpc) < 1e-9; };
+
+	// through the centre: in and out on both sides
+	auto c = ring.getCrossings(Vector3QLength(8.5_kpc, 0_kpc, 0_kpc), Vector3d(-1, 0, 0), 30_kpc);
+	ASSERT_EQ(c.size(), 2u);
+	EXPECT_TRUE(near(c[0].first, 5.5) && near(c[0].second, 6.5));
+	EXPECT_TRUE(near(c[1].first, 10.5) && near(c[1].second, 11.5));
+	c = ring.getCrossings(Vector3QLength(8.5_kpc, 0_kpc, 0_kpc), Vector3d(-1, 0, 0), 11_kpc);
+	ASSERT_EQ(c.size(), 2u);
+	EXPECT_TRUE(near(c[1].second, 11));
+
+	// starting inside, missing the hole; vertical; missing the ring
+	c = ring.getCrossings(Vector3QLength(2.5_kpc, 0_kpc, 0_kpc), Vector3d(0, 0.6, 0.8), 30_kpc);
+	ASSERT_EQ(c.size(), 1u);
+	EXPECT_TRUE(near(c[0].first, 0) && near(c[0].second, std::sqrt(2.75) / 0.6));
+	c = ring.getCrossings(Vector3QLength(2.5_kpc, 0_kpc, 1_kpc), Vector3d(0, 0, -1), 30_kpc);
+	ASSERT_EQ(c.size(), 1u);
+	EXPECT_TRUE(near(c[0].first, 0) && near(c[0].second, 30));
+	EXPECT_TRUE(ring.getCrossings(Vector3QLength(8.5_kpc, 0_kpc, 0_kpc), Vector3d(0, 1, 0), 30_kpc).empty());
+
+	// the nodes of an interval are inside
+	c = ring.getCrossings(Vector3QLength(8.5_kpc, 0_kpc, 0_kpc), Vector3d(-0.96, 0.28, 0), 30_kpc);
+	ASSERT_FALSE(c.empty());
+	for (const auto &interval : c)
+		for (double f : {0.01, 0.5, 0.99}) {
+			QLength s = interval.first + (interval.second - interval.first) * f;
+			EXPECT_TRUE(ring.isInside(Vector3QLength(8.5_kpc - 0.96 * s, 0.28 * s, 0_kpc)));
+		}
+}
+
 class RingModel : public ::testing::Test {
   protected:
 	// void SetUp() override { }
@@ -1,3 +1,13 @@
+#include <dirent.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
 #include "gtest/gtest.h"
 #include "hermes.h"
 
@@ -69,6 +79,324 @@ TEST(Skymap, computePixel) {
 	EXPECT_EQ(static_cast<double>(skymap->getPixel(gnPixel)), -1);
 }
 
+class DummyGammaIntegrator : public GammaIntegratorTemplate {
+  public:
+	mutable std::atomic<int> batchedCalls{0};
+
+	DummyGammaIntegrator() : GammaIntegratorTemplate("DummyGammaIntegrator"){};
+	QDiffIntensity integrateOverLOS(const QDirection &direction) const override {
+		return integrateOverLOS(direction, 1_GeV);
+	}
+	QDiffIntensity integrateOverLOS(const QDirection &direction,
+	                                const QEnergy &E) const override {
+		return static_cast<double>(direction[0] * E / 1_GeV) /
+		       (1_GeV * 1_m2 * 1_s * 1_sr);
+	}
+	std::vector<QDiffIntensity> integrateOverLOS(
+	    const QDirection &direction,
+	    const std::vector<QEnergy> &energies) const override {
+		batchedCalls++;
+		return GammaIntegratorTemplate::integrateOverLOS(direction, energies);
+	}
+};
+
+TEST(Skymap, computeRangeInOnePass) {
+	int nside = 4;
+	auto integrator = std::make_shared<DummyGammaIntegrator>();
+	auto range = std::make_shared<GammaSkymapRange>(
+	    GammaSkymapRange(nside, 1_GeV, 100_GeV, 5));
+	range->setIntegrator(integrator);
+	range->setMask(std::make_shared<CircularWindow>(
+	    CircularWindow(QDirection{0_deg, 0_deg}, 40_deg)));
+	range->compute();
+
+	// one LOS walk per unmasked pixel for all energies
+	auto unmasked = (*range)[0].getUnmaskedPixelCount();
+	EXPECT_EQ(integrator->batchedCalls, unmasked);
+
+	for (const auto &map : *range) {
+		GammaSkymap single(nside, map.getEnergy());
+		single.setIntegrator(integrator);
+		single.setMask(std::make_shared<CircularWindow>(
+		    CircularWindow(QDirection{0_deg, 0_deg}, 40_deg)));
+		single.compute();
+		for (std::size_t i = 0; i < single.size(); ++i)
+			EXPECT_DOUBLE_EQ(static_cast<double>(map[i]),
+			                 static_cast<double>(single[i]));
+	}
+}
+
+class InterruptingIntegrator : public SimpleIntegrator {
+  public:
+	mutable std::atomic<int> calls{0};
+	int interruptAt;
+
+	InterruptingIntegrator(int interruptAt_)
+	    : SimpleIntegrator("InterruptingIntegrator"), interruptAt(interruptAt_){};
+	QNumber integrateOverLOS(const QDirection &direction) const override {
+		if (++calls == interruptAt) std::raise(SIGINT);
+		return QNumber(static_cast<double>(direction[0] + 2 * direction[1]));
+	};
+	QNumber integrateOverLOS(const QDirection &direction,
+	                         const QFrequency &f) const override {
+		return integrateOverLOS(direction);
+	}
+	tLOSProfile getLOSProfile(const QDirection &direction,
+	                          int Nsteps) const override {
+		return tLOSProfile();
+	}
+};
+
+volatile std::sig_atomic_t testSignalReceived = 0;
+void testSignalHandler(int sig) { testSignalReceived = sig; }
+
+TEST(Skymap, interruptAndResumeFromCheckpoint) {
+	int nside = 8;
+	const std::string filename = "testSkymapCheckpoint.bin";
+	std::remove(filename.c_str());
+
+	auto integrator = std::make_shared<InterruptingIntegrator>(100);
+	SimpleSkymap skymap(nside);
+	skymap.setIntegrator(integrator);
+	skymap.setCheckpointFile(filename);
+
+	// SIGINT stops compute() and is passed on to the previous handler
+	auto oldHandler = std::signal(SIGINT, testSignalHandler);
+	testSignalReceived = 0;
+	skymap.compute();
+	EXPECT_EQ(testSignalReceived, SIGINT);
+	EXPECT_EQ(std::signal(SIGINT, oldHandler), testSignalHandler);
+
+	std::size_t stored;
+	{
+		SkymapCheckpoint checkpoint(filename, nside, 0, true);
+		stored = checkpoint.getDoneCount();
+	}
+	EXPECT_GE(stored, 99);
+	EXPECT_LT(stored, skymap.getNpix());
+
+	// only the missing pixels are computed
+	int callsBefore = integrator->calls;
+	SimpleSkymap resumed(nside);
+	resumed.setIntegrator(integrator);
+	resumed.setCheckpointFile(filename);
+	resumed.compute(true);
+	EXPECT_EQ(integrator->calls - callsBefore, skymap.getNpix() - stored);
+
+	auto reference = std::make_shared<InterruptingIntegrator>(-1);
+	SimpleSkymap full(nside);
+	full.setIntegrator(reference);
+	full.compute();
+	for (std::size_t i = 0; i < full.size(); ++i)
+		EXPECT_DOUBLE_EQ(static_cast<double>(resumed[i]),
+		                 static_cast<double>(full[i]));
+
+	// a checkpoint of another skymap is rejected
+	SimpleSkymap other(4);
+	other.setIntegrator(reference);
+	other.setCheckpointFile(filename);
+	EXPECT_THROW(other.compute(true), std::runtime_error);
+
+	std::remove(filename.c_str());
+}
+
+std::size_t countOpenFiles() {
+	std::size_t n = 0;
+	DIR *dir = opendir("/proc/self/fd");
+	if (dir == nullptr) return 0;
+	while (readdir(dir) != nullptr) ++n;
+	closedir(dir);
+	return n;
+}
+
+TEST(SkymapCheckpoint, closeOnError) {
+	const std::string filename = "testSkymapCheckpointError.bin";
+	{ SkymapCheckpoint checkpoint(filename, 4, 1); }
+
+	// every check throws after the file is opened or mapped
+	const std::size_t before = countOpenFiles();
+	for (int i = 0; i < 10; ++i) {
+		EXPECT_THROW(SkymapCheckpoint(filename, 8, 1, true), std::runtime_error);
+		EXPECT_THROW(SkymapCheckpoint(filename, 4, 2, true), std::runtime_error);
+	}
+	FILE *f = std::fopen(filename.c_str(), "w");
+	std::fputs("not a checkpoint", f);
+	std::fclose(f);
+	for (int i = 0; i < 10; ++i) EXPECT_THROW(SkymapCheckpoint{filename}, std::runtime_error);
+	EXPECT_EQ(countOpenFiles(), before);
+
+	std::remove(filename.c_str());
+}
+
+TEST(Skymap, resumeInMemory) {
+	int nside = 4;
+	auto integrator = std::make_shared<InterruptingIntegrator>(20);
+	SimpleSkymap skymap(nside);
+	skymap.setIntegrator(integrator);
+
+	auto oldHandler = std::signal(SIGINT, testSignalHandler);
+	skymap.compute();
+	std::signal(SIGINT, oldHandler);
+
+	int callsBefore = integrator->calls;
+	skymap.compute(true);
+	EXPECT_LT(integrator->calls - callsBefore, skymap.getNpix());
+	for (std::size_t i = 0; i < skymap.size(); ++i)
+		EXPECT_NE(static_cast<double>(skymap[i]), UNSEEN);
+}
+
+class InterruptingGammaIntegrator : public DummyGammaIntegrator {
+  public:
+	mutable std::atomic<int> calls{0};
+	int interruptAt;
+
+	InterruptingGammaIntegrator(int interruptAt_) : interruptAt(interruptAt_){};
+	QDiffIntensity integrateOverLOS(const QDirection &direction,
+	                                const QEnergy &E) const override {
+		if (++calls == interruptAt) std::raise(SIGINT);
+		return DummyGammaIntegrator::integrateOverLOS(direction, E);
+	}
+};
+
+TEST(Skymap, interruptRangeBetweenMaps) {
+	// with an integrator per map, the maps are computed one after another
+	int nside = 4;
+	GammaSkymapRange range(nside, 1_GeV, 100_GeV, 3);
+	std::vector<std::shared_ptr<InterruptingGammaIntegrator>> integrators;
+	for (auto it = range.begin(); it != range.end(); ++it) {
+		integrators.push_back(std::make_shared<InterruptingGammaIntegrator>(
+		    integrators.empty() ? 10 : -1));
+		it->setIntegrator(integrators.back());
+	}
+
+	auto oldHandler = std::signal(SIGINT, testSignalHandler);
+	testSignalReceived = 0;
+	range.compute();
+	EXPECT_EQ(testSignalReceived, SIGINT);
+	EXPECT_EQ(std::signal(SIGINT, oldHandler), testSignalHandler);
+
+	// the maps after the interrupted one are not started
+	EXPECT_LT(integrators[0]->calls, static_cast<int>(range[0].getNpix()));
+	EXPECT_EQ(integrators[1]->calls, 0);
+	EXPECT_EQ(integrators[2]->calls, 0);
+}
+
+TEST(Skymap, computeShardsAndMerge) {
+	int nside = 8;
+	const std::size_t nShards = 4;
+	auto integrator = std::make_shared<InterruptingIntegrator>(-1);
+	auto mask = std::make_shared<InvertMask>(InvertMask(
+	    std::make_shared<CircularWindow>(CircularWindow(QDirection{60_deg, 0_deg}, 20_deg))));
+
+	// every shard is computed by its own skymap, as in separate processes
+	std::vector<std::string> filenames;
+	std::vector<double> shardCosts;
+	std::size_t next = 0;
+	for (std::size_t k = 0; k < nShards; ++k) {
+		filenames.push_back("testSkymapShard" + std::to_string(k) + ".bin");
+		SimpleSkymap shard(nside);
+		shard.setIntegrator(integrator);
+		shard.setMask(mask);
+		auto range = shard.getShardRange(k, nShards);
+		EXPECT_EQ(range.first, next);
+		next = range.second;
+
+		double cost = 0;
+		for (std::size_t i = range.first; i < range.second; ++i)
+			if (shard.getMask()[i]) cost += integrator->getLOSCostEstimate(pix2ang_ring(nside, i));
+		shardCosts.push_back(cost);
+
+		int callsBefore = integrator->calls;
+		shard.computeShard(k, nShards, filenames.back());
+		std::size_t unmasked = 0;
+		for (std::size_t i = range.first; i < range.second; ++i) unmasked += shard.getMask()[i];
+		EXPECT_EQ(integrator->calls - callsBefore, unmasked);
+	}
+	EXPECT_EQ(next, nside2npix(nside));
+
+	// balanced by cost, hence more pixels at high latitudes than in the plane
+	for (auto cost : shardCosts) EXPECT_NEAR(cost / shardCosts[0], 1, 0.05);
+	SimpleSkymap probe(nside);
+	probe.setIntegrator(integrator);
+	probe.setMask(mask);
+	auto north = probe.getShardRange(0, nShards), plane = probe.getShardRange(1, nShards);
+	EXPECT_GT(north.second - north.first, plane.second - plane.first);
+
+	SimpleSkymap full(nside), merged(nside);
+	full.setIntegrator(integrator);
+	full.setMask(mask);
+	full.compute();
+	merged.setMask(mask);
+	merged.mergeShards(filenames);
+	for (std::size_t i = 0; i < full.size(); ++i)
+		EXPECT_DOUBLE_EQ(static_cast<double>(merged[i]), static_cast<double>(full[i]));
+
+	// a missing shard or a shard of another skymap is an error
+	SimpleSkymap incomplete(nside);
+	incomplete.setMask(mask);
+	EXPECT_THROW(incomplete.mergeShards({filenames[0], filenames[1], filenames[3]}), std::runtime_error);
+	SimpleSkymap other(4);
+	EXPECT_THROW(other.mergeShards(filenames), std::runtime_error);
+
+	for (const auto &filename : filenames) std::remove(filename.c_str());
+}
+
+class SmoothIntegrator : public SimpleIntegrator {
+  public:
+	mutable std::atomic<int> calls{0};
+	SmoothIntegrator() : SimpleIntegrator("SmoothIntegrator"){};
+	// smooth at high latitudes, sharp along the galactic plane
+	QNumber integrateOverLOS(const QDirection &direction) const override {
+		++calls;
+		double b = static_cast<double>(90_deg - direction[0]);
+		return QNumber(1 + 0.1 * std::cos(static_cast<double>(direction[1])) + std::exp(-b * b / 0.001));
+	};
+	QNumber integrateOverLOS(const QDirection &direction, const QFrequency &f) const override {
+		return integrateOverLOS(direction);
+	}
+	tLOSProfile getLOSProfile(const QDirection &direction, int Nsteps) const override { return tLOSProfile(); }
+};
+
+TEST(Skymap, computeAdaptive) {
+	int nside = 64;
+	auto integrator = std::make_shared<SmoothIntegrator>();
+	SimpleSkymap full(nside), adaptive(nside);
+	full.setIntegrator(integrator);
+	adaptive.setIntegrator(integrator);
+	full.compute();
+
+	integrator->calls = 0;
+	integrator->setRayTable(nullptr);
+	std::size_t evaluations = adaptive.computeAdaptive(8, 0.01);
+	EXPECT_EQ(evaluations, integrator->calls);
+	// the rays of the target nside are shared as in compute()
+	EXPECT_EQ(integrator->getRayTable(), getRayTable(nside, integrator->getObsPosition()));
+	EXPECT_LT(evaluations, full.getNpix() / 2);
+
+	double maxError = 0;
+	for (std::size_t i = 0; i < full.size(); ++i)
+		maxError = std::max(maxError, std::fabs(static_cast<double>(adaptive[i] / full[i]) - 1));
+	EXPECT_LT(maxError, 0.05);
+
+	// the leaves cover the sky once
+	std::size_t covered = 0;
+	for (auto uniq : adaptive.getMultiOrderUniq()) {
+		unsigned int order = (log2(uniq / 4) / 2);
+		covered += std::size_t(1) << (2 * (6 - order));
+	}
+	EXPECT_EQ(covered, full.getNpix());
+	EXPECT_EQ(adaptive.getMultiOrderUniq().size(), adaptive.getMultiOrderValues().size());
+
+	// masked pixels are neither computed nor filled
+	auto mask = std::make_shared<RectangularWindow>(RectangularWindow({30_deg, -30_deg}, {30_deg, 60_deg}));
+	adaptive.setMask(mask);
+	EXPECT_LT(adaptive.computeAdaptive(8, 0.01), evaluations);
+	for (std::size_t i = 0; i < adaptive.size(); ++i)
+		EXPECT_EQ(static_cast<double>(adaptive[i]) == UNSEEN, adaptive.getMask()[i] == false);
+
+	EXPECT_THROW(adaptive.computeAdaptive(6, 0.01), std::runtime_error);
+}
+
 TEST(SkymapMask, RectangularWindow) {
 	int nside = 32;
 	long int pixel_1, pixel_2, pixel_3;
@@ -158,6 +486,88 @@ TEST(SkymapMask, CombinationOfMasks) {
 	EXPECT_FALSE(mask->isAllowed(fromGalCoord(dir3)));
 }
 
+void expectRangesMatchScan(const std::shared_ptr<SkymapMask> &mask,
+                           std::size_t nside) {
+	const auto ranges = mask->getPixelRanges(nside);
+	std::vector<bool> expected(nside2npix(nside));
+	for (std::size_t i = 0; i < expected.size(); ++i)
+		expected[i] = mask->isAllowed(pix2ang_ring(nside, i));
+
+	std::vector<bool> fromRanges(expected.size(), false);
+	std::size_t last = 0;
+	for (const auto &r : *ranges) {
+		EXPECT_LT(r.first, r.second);
+		EXPECT_LE(last, r.first);
+		last = r.second;
+		for (std::size_t i = r.first; i < r.second; ++i) fromRanges[i] = true;
+	}
+	EXPECT_LE(last, expected.size());
+	std::size_t mismatches = 0;
+	for (std::size_t i = 0; i < expected.size(); ++i)
+		mismatches += (expected[i] != fromRanges[i]);
+	EXPECT_EQ(mismatches, 0u) << "nside " << nside;
+	EXPECT_EQ(SkymapMask::countPixels(*ranges),
+	          static_cast<std::size_t>(
+	              std::count(expected.begin(), expected.end(), true)));
+}
+
+TEST(SkymapMask, pixelRangesMatchScan) {
+	std::vector<std::shared_ptr<SkymapMask>> masks;
+	masks.push_back(std::make_shared<SkymapMask>());
+	masks.push_back(std::make_shared<CircularWindow>(
+	    CircularWindow(QDirection{-20_deg, 0_deg}, 15_deg)));
+	// contains the north pole
+	masks.push_back(std::make_shared<CircularWindow>(
+	    CircularWindow(QDirection{10_deg, 45_deg}, 25_deg)));
+	masks.push_back(std::make_shared<CircularWindow>(
+	    CircularWindow(QDirection{90_deg, -30_deg}, 100_deg)));
+	masks.push_back(std::make_shared<CircularWindow>(
+	    CircularWindow(QDirection{-80_deg, 200_deg}, 3_deg)));
+	// contains the south pole
+	masks.push_back(std::make_shared<CircularWindow>(
+	    CircularWindow(QDirection{-88_deg, 10_deg}, 5_deg)));
+	// wraps around l = 0
+	masks.push_back(std::make_shared<RectangularWindow>(
+	    RectangularWindow({5_deg, -5_deg}, {355_deg, 5_deg})));
+	masks.push_back(std::make_shared<RectangularWindow>(
+	    RectangularWindow({40_deg, -30_deg}, {30_deg, 60_deg})));
+	masks.push_back(std::make_shared<RectangularWindow>(
+	    RectangularWindow({90_deg, 60_deg}, {0_deg, 360_deg})));
+	masks.push_back(std::make_shared<InvertMask>(InvertMask(masks[1])));
+	auto list = std::make_shared<MaskList>(MaskList());
+	list->addMask(masks[9]);
+	list->addMask(masks[7]);
+	masks.push_back(list);
+
+	for (std::size_t m = 0; m < masks.size(); ++m) {
+		SCOPED_TRACE("mask " + std::to_string(m));
+		for (std::size_t nside : {1, 4, 16, 64, 13})
+			expectRangesMatchScan(masks[m], nside);
+	}
+}
+
+TEST(SkymapMask, pixelRangesAreShared) {
+	auto mask = std::make_shared<CircularWindow>(
+	    CircularWindow(QDirection{0_deg, 30_deg}, 10_deg));
+	auto list = std::make_shared<MaskList>(MaskList());
+	list->addMask(mask);
+	const auto before = list->getPixelRanges(16);
+	EXPECT_EQ(before, list->getPixelRanges(16));
+	EXPECT_EQ(*before, *mask->getPixelRanges(16));
+
+	SimpleSkymap a(16), b(16);
+	a.setMask(list);
+	b.setMask(list);
+	EXPECT_EQ(&a.getUnmaskedRanges(), &b.getUnmaskedRanges());
+	EXPECT_EQ(a.getUnmaskedPixelCount(), SkymapMask::countPixels(*before));
+
+	// a changed list computes its ranges again
+	list->addMask(std::make_shared<RectangularWindow>(
+	    RectangularWindow({20_deg, 0_deg}, {0_deg, 360_deg})));
+	EXPECT_NE(before, list->getPixelRanges(16));
+	expectRangesMatchScan(list, 16);
+}
+
 int main(int argc, char **argv) {
 	::testing::InitGoogleTest(&argc, argv);
 	return RUN_ALL_TESTS();
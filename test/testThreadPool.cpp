@@ -0,0 +1,171 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "hermes.h"
+
+namespace hermes {
+
+TEST(ThreadPool, visitsEveryIndexOnce) {
+	ThreadPool pool(4);
+	const std::size_t n = 10007;
+	std::vector<std::atomic<int>> visits(n);
+	for (auto &v : visits) v = 0;
+
+	auto stats = pool.parallelFor(n, [&](std::size_t i) { visits[i]++; });
+
+	for (std::size_t i = 0; i < n; ++i) EXPECT_EQ(visits[i], 1);
+	EXPECT_EQ(stats.getTotalTasks(), n);
+	EXPECT_EQ(stats.busyTime.size(), 4);
+}
+
+TEST(ThreadPool, reusedAcrossRuns) {
+	ThreadPool pool(3);
+	for (int run = 0; run < 20; ++run) {
+		std::atomic<std::size_t> sum(0);
+		pool.parallelFor(100, [&](std::size_t i) { sum += i; });
+		EXPECT_EQ(sum, 4950);
+	}
+}
+
+TEST(ThreadPool, stealsFromOverloadedWorker) {
+	ThreadPool pool(4);
+	// all expensive tasks land in the initial block of the first worker
+	const std::size_t n = 64;
+	auto stats = pool.parallelFor(
+	    n,
+	    [](std::size_t i) {
+		    if (i < n / 4) std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	    },
+	    1);
+
+	EXPECT_GT(stats.getTotalSteals(), 0);
+	// a static split would need >= 16 x 5 ms on the first worker
+	EXPECT_LT(stats.getImbalance(), 2.5);
+}
+
+TEST(ThreadPool, nestedCallRunsInline) {
+	ThreadPool pool(2);
+	std::atomic<std::size_t> count(0);
+	pool.parallelFor(8, [&](std::size_t) {
+		pool.parallelFor(8, [&](std::size_t) { count++; });
+	});
+	EXPECT_EQ(count, 64);
+}
+
+TEST(ThreadPool, exceptionIsRethrown) {
+	ThreadPool pool(2);
+	EXPECT_THROW(pool.parallelFor(100,
+	                              [](std::size_t i) {
+		                              if (i == 42) throw std::runtime_error("task failed");
+	                              }),
+	             std::runtime_error);
+	// the pool stays usable afterwards
+	std::atomic<std::size_t> count(0);
+	pool.parallelFor(10, [&](std::size_t) { count++; });
+	EXPECT_EQ(count, 10);
+}
+
+TEST(ThreadPool, pinnedWorkers) {
+	ThreadPool pool(2, true);
+	EXPECT_TRUE(pool.isPinned());
+	std::atomic<std::size_t> sum(0);
+	pool.parallelFor(100, [&](std::size_t i) { sum += i; });
+	EXPECT_EQ(sum, 4950);
+
+	// the shared pool follows the setting
+	setThreadPinning(true);
+	EXPECT_TRUE(getThreadPool()->isPinned());
+	setThreadPinning(false);
+	EXPECT_FALSE(getThreadPool()->isPinned());
+}
+
+TEST(MemoryPlacement, placedGrid) {
+	setHugePages(true);
+	setNumaInterleave(true);
+	// 4 MB, large enough to be placed
+	Grid<double> grid(Vector3d(0.), 64, 64, 128, 1.);
+	EXPECT_EQ(grid.getGridSize(), 64 * 64 * 128);
+	for (std::size_t i = 0; i < grid.getGridSize(); ++i) EXPECT_EQ(grid.get(i), 0);
+	grid.get(12345) = 1;
+	EXPECT_EQ(grid.get(12345), 1);
+	setHugePages(false);
+	setNumaInterleave(false);
+}
+
+TEST(ProgressBar, countsAndMetrics) {
+	const std::string filename = "testProgressMetrics.json";
+	const std::size_t n = 5000;
+	auto pool = getThreadPool();
+
+	ProgressBar bar(n);
+	bar.setMetricsFile(filename);
+	bar.setReportInterval(0.01);
+	bar.start("Progress test");
+	pool->parallelFor(n, [&](std::size_t i) {
+		bar.update();
+		if (i % 1000 == 0) std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	});
+	bar.stop();
+
+	EXPECT_EQ(bar.getCount(), n);
+	std::size_t sum = 0;
+	for (auto c : bar.getThreadCounts()) sum += c;
+	EXPECT_EQ(sum, n);
+	EXPECT_EQ(bar.getThreadCounts().size(), getThreadsNumber() + 1);
+
+	std::ifstream in(filename);
+	std::stringstream json;
+	json << in.rdbuf();
+	EXPECT_NE(json.str().find("\"title\": \"Progress test\""), std::string::npos);
+	EXPECT_NE(json.str().find("\"done\": 5000"), std::string::npos);
+	EXPECT_NE(json.str().find("\"finished\": true"), std::string::npos);
+	EXPECT_NE(json.str().find("\"threads\": ["), std::string::npos);
+	std::remove(filename.c_str());
+
+	// text snapshot of an unfinished run
+	const std::string textname = "testProgressMetrics.txt";
+	ProgressBar partial(10);
+	partial.setMetricsFile(textname);
+	partial.start("Partial");
+	for (int i = 0; i < 4; ++i) partial.update();
+	partial.stop();
+	std::ifstream text(textname);
+	std::string line;
+	std::getline(text, line);
+	EXPECT_EQ(line, "title Partial");
+	std::getline(text, line);
+	EXPECT_EQ(line, "done 4");
+	std::remove(textname.c_str());
+}
+
+TEST(ProgressBar, stoppedByGuardOnException) {
+	auto bar = std::make_shared<ProgressBar>(100);
+	bar->start("Throwing loop");
+	EXPECT_TRUE(bar->isRunning());
+	EXPECT_THROW(
+	    {
+		    ProgressBarGuard guard(bar);
+		    getThreadPool()->parallelFor(100, [&](std::size_t i) {
+			    bar->update();
+			    if (i == 50) throw std::runtime_error("task failed");
+		    });
+	    },
+	    std::runtime_error);
+	EXPECT_FALSE(bar->isRunning());
+}
+
+int main(int argc, char **argv) {
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
+
+}  // namespace hermes
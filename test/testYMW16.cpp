@@ -1,4 +1,6 @@
 #include <memory>
+#include <random>
+#include <vector>
 
 #include "gtest/gtest.h"
 #include "hermes.h"
@@ -30,6 +32,39 @@ TEST(YMW16, compareValues) {
 	            static_cast<double>(gdensity->getDensity(Vector3QLength(0_pc, -10_kpc, 3_kpc))), 1);
 }
 
+TEST(YMW16, batchAgreesWithScalar) {
+	auto gdensity = std::make_shared<ionizedgas::YMW16>();
+
+	std::vector<Vector3QLength> pos;
+	// lines of sight from the Sun, crossing the disk, the arms, the
+	// local structures and the Magellanic Clouds
+	Vector3QLength sun(8.3_kpc, 0, 6_pc);
+	for (int ipix = 0; ipix < 192; ++ipix) {
+		QDirection dir = pix2ang_ring(4, ipix);
+		for (int i = 0; i < 200; ++i)
+			pos.push_back(getGalacticPosition(sun, i * 0.4_kpc, dir));
+		for (int i = 1; i < 60; ++i) pos.push_back(getGalacticPosition(sun, i * 10_pc, dir));
+	}
+	std::mt19937 gen(42);
+	std::uniform_real_distribution<double> u(-1, 1);
+	for (int i = 0; i < 5000; ++i) pos.push_back(Vector3QLength(20_kpc * u(gen), 20_kpc * u(gen), 2_kpc * u(gen)));
+	pos.push_back(Vector3QLength(0));
+	pos.push_back(Vector3QLength(8.3_kpc, 0, 6_pc));
+
+	std::vector<QPDensity> batch;
+	gdensity->getDensity(pos, batch);
+	ASSERT_EQ(batch.size(), pos.size());
+
+	// batch equals scalar element by element
+	std::size_t nonzero = 0;
+	for (std::size_t i = 0; i < pos.size(); ++i) {
+		double scalar = static_cast<double>(gdensity->getDensity(pos[i]));
+		EXPECT_NEAR(static_cast<double>(batch[i]), scalar, 1e-9 * scalar + 1e-12) << "at position " << i;
+		if (scalar > 0) ++nonzero;
+	}
+	EXPECT_GT(nonzero, pos.size() / 3);
+}
+
 int main(int argc, char **argv) {
 	::testing::InitGoogleTest(&argc, argv);
 	return RUN_ALL_TESTS();